@@ -312,6 +312,7 @@ void AnimationWindow::Create(EditorComponent* _editor)
 					AnimationDataComponent* animation_data = scene.animation_datas.GetComponent(sam.data);
 					if (animation_data != nullptr)
 					{
+						animation_data->Decompress(); // keyframes can only be edited in uncompressed form
 						// Search for leftmost keyframe:
 						int keyFirst = 0;
 						float timeFirst = std::numeric_limits<float>::max();
@@ -507,6 +508,7 @@ void AnimationWindow::Create(EditorComponent* _editor)
 						AnimationDataComponent* animation_data = scene.animation_datas.GetComponent(animation->samplers[channel.samplerIndex].data);
 						if (animation_data != nullptr)
 						{
+							animation_data->Decompress(); // keyframes can only be edited in uncompressed form
 							animation_data->keyframe_times.push_back(current_time);
 
 							switch (channel.path)
@@ -312,7 +312,7 @@ void GeneralWindow::Create(EditorComponent* _editor)
 	AddWidget(&saveModeComboBox);
 
 	saveCompressionCheckBox.Create("Save compressed: ");
-	saveCompressionCheckBox.SetTooltip("Set whether to enable compression when saving WISCENE files.\nNote that compressed WISCENE with embedded resources will have higher RAM usage when loaded to support streaming.");
+	saveCompressionCheckBox.SetTooltip("Set whether to enable compression when saving WISCENE files.\nCompressed WISCENE is split into chunks, so it can be decompressed in parallel and embedded resources can be streamed from it.");
 	if (editor->main->config.GetSection("options").Has("save_compressed"))
 	{
 		saveCompressionCheckBox.SetCheck(editor->main->config.GetSection("options").GetBool("save_compressed"));
@@ -95,6 +95,21 @@ void ScriptWindow::Create(EditorComponent* _editor)
 	});
 	AddWidget(&playstopButton);
 
+	independentCheckBox.Create("Independent: ");
+	independentCheckBox.SetTooltip("Independent scripts are run in parallel on multiple threads.\nThey can't depend on other scripts, only a subset of the scripting API is available to them, and scene structure changes are applied after all of them finished.");
+	independentCheckBox.SetSize(XMFLOAT2(hei, hei));
+	independentCheckBox.OnClick([=](wi::gui::EventArgs args) {
+		wi::scene::Scene& scene = editor->GetCurrentScene();
+		for (auto& x : editor->translator.selected)
+		{
+			ScriptComponent* script = scene.scripts.GetComponent(x.entity);
+			if (script == nullptr)
+				continue;
+			script->SetIndependent(args.bValue);
+		}
+	});
+	AddWidget(&independentCheckBox);
+
 	SetMinimized(true);
 	SetVisible(false);
 }
@@ -117,6 +132,7 @@ void ScriptWindow::SetEntity(wi::ecs::Entity entity)
 			fileButton.SetText("Open File...");
 		}
 		playonceCheckBox.SetCheck(script->IsPlayingOnlyOnce());
+		independentCheckBox.SetCheck(script->IsIndependent());
 	}
 	else
 	{
@@ -159,10 +175,14 @@ void ScriptWindow::ResizeLayout()
 
 		playonceCheckBox.SetVisible(true);
 		playonceCheckBox.SetPos(XMFLOAT2(playstopButton.GetPos().x - playonceCheckBox.GetSize().x - 4, playstopButton.GetPos().y));
+
+		independentCheckBox.SetVisible(true);
+		independentCheckBox.SetPos(XMFLOAT2(playstopButton.GetPos().x + 20, playstopButton.GetPos().y + playstopButton.GetSize().y + 4));
 	}
 	else
 	{
 		playstopButton.SetVisible(false);
 		playonceCheckBox.SetVisible(false);
+		independentCheckBox.SetVisible(false);
 	}
 }
@@ -13,6 +13,7 @@ public:
 	wi::gui::Button fileButton;
 	wi::gui::CheckBox playonceCheckBox;
 	wi::gui::Button playstopButton;
+	wi::gui::CheckBox independentCheckBox;
 
 	void Update(const wi::Canvas& canvas, float dt) override;
 	void ResizeLayout() override;
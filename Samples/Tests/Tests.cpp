@@ -27,6 +27,12 @@ enum TEST_TYPE
 	INVERSEKINEMATICSTEST,
 	INSTANCESTEST,
 	CONTAINERPERF,
+	CULLINGPERF,
+	BVHPERF,
+	ANIMATIONCOMPRESSION,
+	ARCHIVEPERF,
+	FONTATLASPERF,
+	ENTITYLOOKUPPERF,
 };
 
 // Controller Test UI Data, info down below will be using Xbox Controller as reference
@@ -161,6 +167,12 @@ void TestsRenderer::Load()
 	testSelector.AddItem("Inverse Kinematics", INVERSEKINEMATICSTEST);
 	testSelector.AddItem("65k Instances", INSTANCESTEST);
 	testSelector.AddItem("Container perf", CONTAINERPERF);
+	testSelector.AddItem("Culling perf", CULLINGPERF);
+	testSelector.AddItem("BVH perf", BVHPERF);
+	testSelector.AddItem("Animation compression", ANIMATIONCOMPRESSION);
+	testSelector.AddItem("Archive perf", ARCHIVEPERF);
+	testSelector.AddItem("Font atlas perf", FONTATLASPERF);
+	testSelector.AddItem("Entity lookup perf", ENTITYLOOKUPPERF);
 	testSelector.SetMaxVisibleItemCount(10);
 	testSelector.OnSelect([=](wi::gui::EventArgs args) {
 
@@ -421,6 +433,30 @@ void TestsRenderer::Load()
 			ContainerTest();
 			break;
 
+		case CULLINGPERF:
+			CullingTest();
+			break;
+
+		case BVHPERF:
+			BVHTest();
+			break;
+
+		case ANIMATIONCOMPRESSION:
+			AnimationCompressionTest();
+			break;
+
+		case ARCHIVEPERF:
+			ArchiveTest();
+			break;
+
+		case FONTATLASPERF:
+			FontAtlasTest();
+			break;
+
+		case ENTITYLOOKUPPERF:
+			EntityLookupTest();
+			break;
+
 		default:
 			assert(0);
 			break;
@@ -690,6 +726,39 @@ void TestsRenderer::RunJobSystemTest()
 		ss += "wi::jobsystem::Dispatch() took " + std::to_string(time) + " milliseconds\n";
 	}
 
+	ss += "\n3) Work stealing vs mutex queues test:\n";
+
+	// Many small jobs with nested submissions, this stresses the job queues instead of the workload:
+	{
+		const bool work_stealing = wi::jobsystem::IsWorkStealingEnabled();
+		for (int mode = 0; mode < 2; ++mode)
+		{
+			wi::jobsystem::SetWorkStealingEnabled(mode == 1);
+			std::atomic<uint32_t> sum{ 0 };
+			timer.record();
+			for (int frame = 0; frame < 100; ++frame)
+			{
+				for (int i = 0; i < 64; ++i)
+				{
+					wi::jobsystem::Dispatch(ctx, 256, 1, [&](wi::jobsystem::JobArgs args) {
+						sum.fetch_add(1, std::memory_order_relaxed);
+					});
+					wi::jobsystem::Execute(ctx, [&](wi::jobsystem::JobArgs args) {
+						wi::jobsystem::context inner;
+						wi::jobsystem::Dispatch(inner, 64, 1, [&](wi::jobsystem::JobArgs args) {
+							sum.fetch_add(1, std::memory_order_relaxed);
+						});
+						wi::jobsystem::Wait(inner);
+					});
+				}
+				wi::jobsystem::Wait(ctx);
+			}
+			double time = timer.elapsed();
+			ss += std::string(mode == 1 ? "Work stealing deques" : "Mutex queues") + " took " + std::to_string(time) + " milliseconds\n";
+		}
+		wi::jobsystem::SetWorkStealingEnabled(work_stealing);
+	}
+
 	static wi::SpriteFont font;
 	font = wi::SpriteFont(ss);
 	font.params.posX = GetLogicalWidth() / 2;
@@ -1259,3 +1328,553 @@ void TestsRenderer::ContainerTest()
 	font.params.size = 24;
 	this->AddFont(&font);
 }
+
+void TestsRenderer::CullingTest()
+{
+	wi::Timer timer;
+
+	// A camera in the middle of the object field, looking forward with 60 degree field of view:
+	const float range = 1000;
+	XMMATRIX V = XMMatrixLookToLH(XMVectorZero(), XMVectorSet(0, 0, 1, 0), XMVectorSet(0, 1, 0, 0));
+	XMMATRIX P = XMMatrixPerspectiveFovLH(XM_PI / 3.0f, 16.0f / 9.0f, range, 0.1f); // reversed depth
+	wi::primitive::Frustum frustum;
+	frustum.Create(V * P);
+
+	std::string ss = "Frustum culling test (linear culling vs object BVH):\n";
+
+	const uint32_t counts[] = { 10000, 100000, 1000000 };
+	for (uint32_t count : counts)
+	{
+		wi::random::RNG rng(count);
+		wi::vector<wi::primitive::AABB> aabbs(count);
+		for (auto& aabb : aabbs)
+		{
+			const XMFLOAT3 center = XMFLOAT3(rng.next_float(-range, range), rng.next_float(-range, range), rng.next_float(-range, range));
+			const float size = rng.next_float(0.5f, 4.0f);
+			aabb = wi::primitive::AABB(XMFLOAT3(center.x - size, center.y - size, center.z - size), XMFLOAT3(center.x + size, center.y + size, center.z + size));
+		}
+
+		ss += "\n" + std::to_string(count) + " objects:\n";
+
+		uint32_t visible_linear = 0;
+		timer.record();
+		for (auto& aabb : aabbs)
+		{
+			if (frustum.CheckBoxFast(aabb))
+			{
+				visible_linear++;
+			}
+		}
+		ss += "\tlinear: " + std::to_string(timer.elapsed_milliseconds()) + " ms, visible: " + std::to_string(visible_linear) + "\n";
+
+		wi::BVH bvh;
+		timer.record();
+		bvh.Build(aabbs.data(), count);
+		ss += "\tBVH build: " + std::to_string(timer.elapsed_milliseconds()) + " ms";
+
+		timer.record();
+		bvh.Update(aabbs.data(), count);
+		ss += ", refit: " + std::to_string(timer.elapsed_milliseconds()) + " ms\n";
+
+		uint32_t visible_bvh = 0;
+		timer.record();
+		bvh.IntersectsFrustum(frustum, [&](uint32_t index, bool inside) {
+			if (inside || frustum.CheckBoxFast(aabbs[index]))
+			{
+				visible_bvh++;
+			}
+		});
+		ss += "\tBVH: " + std::to_string(timer.elapsed_milliseconds()) + " ms, visible: " + std::to_string(visible_bvh) + "\n";
+	}
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 24;
+	this->AddFont(&font);
+}
+
+void TestsRenderer::BVHTest()
+{
+	wi::Timer timer;
+
+	const char* models[] = {
+		CONTENT_DIR "models/teapot.wiscene",
+		CONTENT_DIR "models/suzanne.wiscene",
+		CONTENT_DIR "models/shadows_test.wiscene",
+		CONTENT_DIR "models/vehicle_test.wiscene",
+		CONTENT_DIR "models/lightmap_bake_test.wiscene",
+	};
+	const wi::BVH::BuildMode modes[] = { wi::BVH::BuildMode::Midpoint, wi::BVH::BuildMode::SAH };
+	const char* mode_names[] = { "Midpoint", "SAH" };
+	const uint32_t ray_count = 100000;
+
+	std::string ss = "BVH build and ray query test (mesh triangle BVHs of sample models, " + std::to_string(ray_count) + " rays per mesh):\n";
+
+	for (const char* model : models)
+	{
+		Scene scene;
+		wi::scene::LoadModel(scene, model);
+
+		uint32_t triangle_count = 0;
+		double build_times[arraysize(modes)] = {};
+		double query_times[arraysize(modes)] = {};
+		uint32_t hit_counts[arraysize(modes)] = {};
+		for (size_t meshIndex = 0; meshIndex < scene.meshes.GetCount(); ++meshIndex)
+		{
+			MeshComponent& mesh = scene.meshes[meshIndex];
+			mesh.BuildBVH(); // fills bvh_leaf_aabbs
+			const uint32_t leaf_count = (uint32_t)mesh.bvh_leaf_aabbs.size();
+			if (leaf_count == 0)
+				continue;
+			triangle_count += leaf_count;
+
+			wi::primitive::AABB bounds;
+			for (auto& aabb : mesh.bvh_leaf_aabbs)
+			{
+				bounds = wi::primitive::AABB::Merge(bounds, aabb);
+			}
+			const XMFLOAT3 center = bounds.getCenter();
+			const float radius = std::max(0.001f, bounds.getRadius());
+
+			// Rays are shot from a sphere around the mesh towards random points inside the mesh bounds:
+			wi::random::RNG rng(meshIndex);
+			wi::vector<wi::primitive::Ray> rays(ray_count);
+			for (auto& ray : rays)
+			{
+				const XMVECTOR dir = XMVector3Normalize(XMVectorSet(rng.next_float(-1, 1), rng.next_float(-1, 1), rng.next_float(-1, 1), 0));
+				const XMVECTOR origin = XMLoadFloat3(&center) + dir * radius * 2;
+				const XMVECTOR target = XMVectorSet(rng.next_float(bounds._min.x, bounds._max.x), rng.next_float(bounds._min.y, bounds._max.y), rng.next_float(bounds._min.z, bounds._max.z), 1);
+				ray = wi::primitive::Ray(origin, XMVector3Normalize(target - origin));
+			}
+
+			for (size_t mode = 0; mode < arraysize(modes); ++mode)
+			{
+				wi::BVH bvh;
+				timer.record();
+				bvh.Build(mesh.bvh_leaf_aabbs.data(), leaf_count, modes[mode]);
+				build_times[mode] += timer.elapsed_milliseconds();
+
+				timer.record();
+				for (auto& ray : rays)
+				{
+					const XMVECTOR rayOrigin = XMLoadFloat3(&ray.origin);
+					const XMVECTOR rayDirection = XMLoadFloat3(&ray.direction);
+					bool hit = false;
+					bvh.IntersectsFirst(ray, [&](uint32_t index) {
+						const wi::primitive::AABB& leaf = mesh.bvh_leaf_aabbs[index];
+						const MeshComponent::MeshSubset& subset = mesh.subsets[leaf.userdata];
+						const uint32_t indexOffset = subset.indexOffset + leaf.layerMask * 3;
+						const XMVECTOR p0 = XMLoadFloat3(&mesh.vertex_positions[mesh.indices[indexOffset + 0]]);
+						const XMVECTOR p1 = XMLoadFloat3(&mesh.vertex_positions[mesh.indices[indexOffset + 1]]);
+						const XMVECTOR p2 = XMLoadFloat3(&mesh.vertex_positions[mesh.indices[indexOffset + 2]]);
+						float distance;
+						XMFLOAT2 bary;
+						hit = wi::math::RayTriangleIntersects(rayOrigin, rayDirection, p0, p1, p2, distance, bary);
+						return hit;
+					});
+					if (hit)
+					{
+						hit_counts[mode]++;
+					}
+				}
+				query_times[mode] += timer.elapsed_milliseconds();
+			}
+		}
+
+		ss += "\n" + wi::helper::GetFileNameFromPath(model) + " (" + std::to_string(triangle_count) + " triangles):\n";
+		for (size_t mode = 0; mode < arraysize(modes); ++mode)
+		{
+			const double mrays = query_times[mode] > 0 ? double(scene.meshes.GetCount() * ray_count) / (query_times[mode] * 1000.0) : 0;
+			ss += "\t" + std::string(mode_names[mode]) + ": build " + std::to_string(build_times[mode]) + " ms, rays " + std::to_string(query_times[mode]) + " ms (" + std::to_string(mrays) + " Mrays/s, hits: " + std::to_string(hit_counts[mode]) + ")\n";
+		}
+	}
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 20;
+	this->AddFont(&font);
+}
+
+void TestsRenderer::AnimationCompressionTest()
+{
+	wi::Timer timer;
+
+	const char* models[] = {
+		CONTENT_DIR "scripts/character_controller/assets/character.wiscene",
+		CONTENT_DIR "models/animation_test.wiscene",
+		CONTENT_DIR "models/morph_target_animation_test.wiscene",
+		CONTENT_DIR "models/emitter_skinned.wiscene",
+	};
+	const float max_error = 0.0005f;
+
+	std::string ss = "Animation compression test (max error: " + std::to_string(max_error) + "):\n";
+
+	// Samples compressed animation data with linear interpolation:
+	wi::vector<float> left;
+	wi::vector<float> right;
+	auto sample = [&](const AnimationDataComponent& data, float time, float* result) {
+		const uint32_t components = data.compressed_components;
+		const size_t key = std::upper_bound(data.keyframe_times.begin(), data.keyframe_times.end(), time) - data.keyframe_times.begin();
+		const size_t keyLeft = key > 0 ? key - 1 : 0;
+		const size_t keyRight = std::min(key, data.keyframe_times.size() - 1);
+		left.resize(components);
+		right.resize(components);
+		data.DecodeKeyframe(keyLeft, left.data());
+		data.DecodeKeyframe(keyRight, right.data());
+		const float timeLeft = data.keyframe_times[keyLeft];
+		const float timeRight = data.keyframe_times[keyRight];
+		const float t = timeRight > timeLeft ? saturate((time - timeLeft) / (timeRight - timeLeft)) : 0;
+		if (data._flags & AnimationDataComponent::COMPRESSED_ROTATION)
+		{
+			const XMVECTOR Q = XMQuaternionNormalize(XMQuaternionSlerp(XMLoadFloat4((const XMFLOAT4*)left.data()), XMLoadFloat4((const XMFLOAT4*)right.data()), t));
+			XMStoreFloat4((XMFLOAT4*)result, Q);
+			return;
+		}
+		for (uint32_t c = 0; c < components; ++c)
+		{
+			result[c] = wi::math::Lerp(left[c], right[c], t);
+		}
+	};
+
+	for (const char* model : models)
+	{
+		Scene scene;
+		wi::scene::LoadModel(scene, model);
+
+		// Keep the original data to measure the error after compression:
+		wi::unordered_map<wi::ecs::Entity, AnimationDataComponent> originals;
+		for (size_t i = 0; i < scene.animation_datas.GetCount(); ++i)
+		{
+			originals[scene.animation_datas.GetEntity(i)] = scene.animation_datas[i];
+		}
+
+		timer.record();
+		const uint32_t compressed_count = scene.CompressAnimations(max_error);
+		const double compression_time = timer.elapsed_milliseconds();
+
+		ss += "\n" + wi::helper::GetFileNameFromPath(model) + " (" + std::to_string(compressed_count) + " of " + std::to_string(scene.animation_datas.GetCount()) + " animation datas compressed in " + std::to_string(compression_time) + " ms):\n";
+
+		size_t decoded_count = 0;
+		double decode_time = 0;
+		for (size_t i = 0; i < scene.animations.GetCount(); ++i)
+		{
+			const AnimationComponent& animation = scene.animations[i];
+			const wi::ecs::Entity entity = scene.animations.GetEntity(i);
+			const NameComponent* name = scene.names.GetComponent(entity);
+
+			size_t size_before = 0;
+			size_t size_after = 0;
+			float error = 0;
+			wi::unordered_set<wi::ecs::Entity> visited;
+			wi::vector<float> value;
+			for (const AnimationComponent::AnimationSampler& sampler : animation.samplers)
+			{
+				if (visited.count(sampler.data) > 0)
+					continue;
+				visited.insert(sampler.data);
+				const AnimationDataComponent* data = scene.animation_datas.GetComponent(sampler.data);
+				if (data == nullptr)
+					continue;
+				const AnimationDataComponent& original = originals[sampler.data];
+				size_before += original.GetMemorySizeInBytes();
+				size_after += data->GetMemorySizeInBytes();
+				if (!data->IsCompressed())
+					continue;
+
+				// The error is measured at every original keyframe time:
+				const uint32_t components = data->compressed_components;
+				value.resize(components);
+				for (size_t key = 0; key < original.keyframe_times.size(); ++key)
+				{
+					sample(*data, original.keyframe_times[key], value.data());
+					const float* expected = &original.keyframe_data[key * components];
+					if (data->_flags & AnimationDataComponent::COMPRESSED_ROTATION)
+					{
+						// q and -q are the same rotation:
+						float e0 = 0;
+						float e1 = 0;
+						for (uint32_t c = 0; c < 4; ++c)
+						{
+							e0 = std::max(e0, std::abs(value[c] - expected[c]));
+							e1 = std::max(e1, std::abs(value[c] + expected[c]));
+						}
+						error = std::max(error, std::min(e0, e1));
+					}
+					else
+					{
+						for (uint32_t c = 0; c < components; ++c)
+						{
+							error = std::max(error, std::abs(value[c] - expected[c]));
+						}
+					}
+				}
+
+				timer.record();
+				for (size_t key = 0; key < data->keyframe_times.size(); ++key)
+				{
+					data->DecodeKeyframe(key, value.data());
+				}
+				decode_time += timer.elapsed_milliseconds();
+				decoded_count += data->keyframe_times.size();
+			}
+
+			ss += "\t" + (name == nullptr ? std::to_string(entity) : name->name) + ": " + std::to_string(size_before / 1024.0) + " KB -> " + std::to_string(size_after / 1024.0) + " KB";
+			ss += " (" + std::to_string(size_after > 0 ? double(size_before) / double(size_after) : 0.0) + "x), max error: " + std::to_string(error) + "\n";
+		}
+		if (decode_time > 0)
+		{
+			ss += "\tdecoding: " + std::to_string(double(decoded_count) / (decode_time * 1000.0)) + " M keyframes/s\n";
+		}
+	}
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 20;
+	this->AddFont(&font);
+}
+
+void TestsRenderer::ArchiveTest()
+{
+	wi::Timer timer;
+
+	// A scene with a large mesh, the vertex streams dominate the archive size:
+	Scene scene;
+	scene.Entity_CreateSphere("sphere", 1, 1024, 1024);
+	const MeshComponent& mesh = scene.meshes[0];
+
+	std::string ss = "Archive serialization test (mesh with " + std::to_string(mesh.vertex_positions.size()) + " vertices, " + std::to_string(mesh.indices.size() / 3) + " triangles):\n";
+
+	auto throughput = [](size_t bytes, double milliseconds) {
+		return std::to_string(milliseconds > 0 ? double(bytes) / (milliseconds * 1000.0) : 0.0) + " MB/s";
+	};
+
+	// The vertex streams written and read element by element (the format is the same as the bulk path):
+	{
+		auto write_elements = [](wi::Archive& archive, const auto& data) {
+			archive << data.size();
+			for (const auto& x : data)
+			{
+				archive << x;
+			}
+		};
+		auto read_elements = [](wi::Archive& archive, auto& data) {
+			size_t count = 0;
+			archive >> count;
+			data.resize(count);
+			for (auto& x : data)
+			{
+				archive >> x;
+			}
+		};
+
+		wi::Archive archive;
+		timer.record();
+		write_elements(archive, mesh.vertex_positions);
+		write_elements(archive, mesh.vertex_normals);
+		write_elements(archive, mesh.vertex_uvset_0);
+		write_elements(archive, mesh.indices);
+		const double write_time = timer.elapsed_milliseconds();
+		const size_t size = archive.GetPos();
+
+		MeshComponent loaded;
+		archive.SetReadModeAndResetPos(true);
+		timer.record();
+		read_elements(archive, loaded.vertex_positions);
+		read_elements(archive, loaded.vertex_normals);
+		read_elements(archive, loaded.vertex_uvset_0);
+		read_elements(archive, loaded.indices);
+		const double read_time = timer.elapsed_milliseconds();
+
+		ss += "\nVertex streams, per element: write " + throughput(size, write_time) + ", read " + throughput(size, read_time) + "\n";
+	}
+	{
+		wi::Archive archive;
+		timer.record();
+		archive << mesh.vertex_positions;
+		archive << mesh.vertex_normals;
+		archive << mesh.vertex_uvset_0;
+		archive << mesh.indices;
+		const double write_time = timer.elapsed_milliseconds();
+		const size_t size = archive.GetPos();
+
+		MeshComponent loaded;
+		archive.SetReadModeAndResetPos(true);
+		timer.record();
+		archive >> loaded.vertex_positions;
+		archive >> loaded.vertex_normals;
+		archive >> loaded.vertex_uvset_0;
+		archive >> loaded.indices;
+		const double read_time = timer.elapsed_milliseconds();
+
+		ss += "Vertex streams, bulk: write " + throughput(size, write_time) + ", read " + throughput(size, read_time) + "\n";
+	}
+
+	// Whole scene save and load through Scene::Serialize:
+	{
+		wi::Archive archive;
+		timer.record();
+		scene.Serialize(archive);
+		const double save_time = timer.elapsed_milliseconds();
+		const size_t size = archive.GetPos();
+
+		Scene loaded;
+		archive.SetReadModeAndResetPos(true);
+		timer.record();
+		loaded.Serialize(archive);
+		const double load_time = timer.elapsed_milliseconds();
+
+		ss += "\nScene (" + std::to_string(size / (1024.0 * 1024.0)) + " MB): save " + std::to_string(save_time) + " ms (" + throughput(size, save_time) + "), load " + std::to_string(load_time) + " ms (" + throughput(size, load_time) + ")\n";
+		ss += "Note: scene load includes creating the GPU buffers of the mesh\n";
+	}
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 20;
+	this->AddFont(&font);
+}
+
+void TestsRenderer::FontAtlasTest()
+{
+	wi::Timer timer;
+
+	std::string ss = "Font atlas test (" + std::to_string(wi::jobsystem::GetThreadCount()) + " threads):\n";
+
+	// The CJK Unified Ideographs block needs a font that contains it, otherwise the glyphs would fall back to the default font and the test would measure those:
+	static const std::string cjk_font = "yumin.ttf";
+	if (!wi::helper::FileExists(cjk_font))
+	{
+		ss += "\nSkipped, the CJK font " + cjk_font + " was not found next to the executable.\n";
+	}
+	else
+	{
+		wi::font::Params params;
+		params.style = wi::font::AddFontStyle(cjk_font);
+		params.size = 12;
+		params.disableSDFRendering(); // SDF glyphs are rendered at a fixed size which wouldn't fit this many into the atlas
+
+		std::wstring cjk;
+		for (wchar_t code = 0x4E00; code <= 0x9FFF; ++code)
+		{
+			cjk.push_back(code);
+		}
+
+		// Measuring the text requests all of its glyphs, they are rasterized and packed in the next atlas update:
+		wi::font::TextWidth(cjk, params);
+		timer.record();
+		wi::font::UpdateAtlas(GetDPIScaling());
+		const double cjk_time = timer.elapsed_milliseconds();
+		const wi::graphics::TextureDesc& desc = wi::font::GetAtlas()->GetDesc();
+		ss += "\nCJK basic range (" + std::to_string(cjk.size()) + " glyphs): " + std::to_string(cjk_time) + " ms, atlas: " + std::to_string(desc.width) + "x" + std::to_string(desc.height) + "\n";
+
+		// A few new glyphs afterwards are packed into the free space and only their region is uploaded:
+		params.size = 13;
+		wi::font::TextWidth("The quick brown fox jumps over the lazy dog", params);
+		timer.record();
+		wi::font::UpdateAtlas(GetDPIScaling());
+		ss += "Incremental update (latin, new size): " + std::to_string(timer.elapsed_milliseconds()) + " ms\n";
+	}
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 20;
+	this->AddFont(&font);
+}
+
+void TestsRenderer::EntityLookupTest()
+{
+	wi::Timer timer;
+
+	const size_t elements = 1000000;
+	const size_t lookups = 10000000;
+
+	wi::vector<Entity> entities(elements);
+	for (auto& entity : entities)
+	{
+		entity = CreateEntity();
+	}
+
+	// Lookups are made in a scattered order, like GetComponent() calls from systems that follow entity references:
+	wi::vector<Entity> queries(lookups);
+	for (size_t i = 0; i < lookups; ++i)
+	{
+		queries[i] = entities[(i * 345734667877ull) % elements];
+	}
+
+	std::string ss = "Entity lookup test for " + std::to_string(elements) + " components, " + std::to_string(lookups) + " GetComponent() calls:\n";
+
+	auto test = [&](auto lookup_type, const char* name) {
+		wi::ecs::ComponentManager<LayerComponent, decltype(lookup_type)> components;
+
+		timer.record();
+		for (Entity entity : entities)
+		{
+			components.Create(entity);
+		}
+		const double create_time = timer.elapsed_milliseconds();
+
+		timer.record();
+		uint32_t sum = 0;
+		for (Entity entity : queries)
+		{
+			const LayerComponent* component = components.GetComponent(entity);
+			sum += component != nullptr ? component->layerMask : 0;
+		}
+		const double lookup_time = timer.elapsed_milliseconds();
+		const double throughput = lookup_time > 0 ? double(lookups) / (lookup_time * 1000.0) : 0.0;
+
+		ss += "\n" + std::string(name) + ": create " + std::to_string(create_time) + " ms, lookup " + std::to_string(lookup_time) + " ms (" + std::to_string(throughput) + " M/s)";
+		if (sum == 0)
+		{
+			ss += " !"; // keeps the lookups from being optimized away
+		}
+	};
+	test(wi::ecs::lookup::Straight(), "LOOKUP_STRAIGHT");
+	test(wi::ecs::lookup::Sparse(), "LOOKUP_SPARSE");
+	test(wi::ecs::lookup::BucketHash(), "LOOKUP_BUCKET_HASH");
+	test(wi::ecs::lookup::Hash(), "LOOKUP_HASH");
+	test(wi::ecs::lookup::SparseSet(), "LOOKUP_SPARSE_SET");
+
+	// Recycled entities reuse the same indices with a new generation, so the sparse set stays the same size:
+	for (Entity& entity : entities)
+	{
+		DestroyEntity(entity);
+		entity = CreateEntity();
+	}
+	for (size_t i = 0; i < lookups; ++i)
+	{
+		queries[i] = entities[(i * 345734667877ull) % elements];
+	}
+	ss += "\n\nAfter recycling every entity (generation " + std::to_string(wi::ecs::GetEntityGeneration(entities.front())) + "):";
+	test(wi::ecs::lookup::BucketHash(), "LOOKUP_BUCKET_HASH");
+	test(wi::ecs::lookup::SparseSet(), "LOOKUP_SPARSE_SET");
+	// The entities are not destroyed at the end, so the next run starts with fresh indices for the straight lookups
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 20;
+	this->AddFont(&font);
+}
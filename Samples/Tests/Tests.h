@@ -15,6 +15,12 @@ public:
 	void RunSpriteTest();
 	void RunNetworkTest();
 	void ContainerTest();
+	void CullingTest();
+	void BVHTest();
+	void AnimationCompressionTest();
+	void ArchiveTest();
+	void FontAtlasTest();
+	void EntityLookupTest();
 };
 
 class Tests : public wi::Application
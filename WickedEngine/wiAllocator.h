@@ -11,9 +11,215 @@
 #include <cassert>
 #include <algorithm>
 #include <deque>
+#include <type_traits>
+
+// Tagged memory accounting can be removed at compile time by defining this as 0:
+#ifndef WI_MEMORY_TRACKING
+#define WI_MEMORY_TRACKING 1
+#endif // WI_MEMORY_TRACKING
 
 namespace wi::allocator
 {
+	// The engine subsystems whose allocations are accounted separately
+	enum class MemoryTag : uint8_t
+	{
+		Untagged,
+		Scene,		// entity-component storage of scenes
+		Mesh,		// mesh components
+		Animation,	// animation and animation data components
+		TextureCPU,	// CPU-side copies of texture data
+		Resource,	// resource manager entries
+		Audio,		// sound data
+		Physics,	// physics engine allocations
+		Lua,		// Lua script states
+
+		Count
+	};
+	constexpr const char* GetMemoryTagName(MemoryTag tag)
+	{
+		switch (tag)
+		{
+		case MemoryTag::Untagged: return "Untagged";
+		case MemoryTag::Scene: return "Scene";
+		case MemoryTag::Mesh: return "Mesh";
+		case MemoryTag::Animation: return "Animation";
+		case MemoryTag::TextureCPU: return "Texture-CPU";
+		case MemoryTag::Resource: return "Resource";
+		case MemoryTag::Audio: return "Audio";
+		case MemoryTag::Physics: return "Physics";
+		case MemoryTag::Lua: return "Lua";
+		default: return "";
+		}
+	}
+
+	// The memory tag that the shared_ptr, block and component allocations of a type are accounted with
+	//	A type can declare it with a static constexpr MemoryTag memory_tag member, or this can be specialized for it
+	template<typename T, typename = void>
+	struct memory_tag
+	{
+		static constexpr MemoryTag value = MemoryTag::Untagged;
+	};
+	template<typename T>
+	struct memory_tag<T, std::void_t<decltype(T::memory_tag)>>
+	{
+		static constexpr MemoryTag value = T::memory_tag;
+	};
+	template<typename T>
+	inline constexpr MemoryTag memory_tag_v = memory_tag<T>::value;
+
+	struct MemoryTagStats
+	{
+		int64_t current = 0; // bytes that are currently allocated
+		int64_t peak = 0; // the most bytes that were allocated at the same time
+		int64_t allocations = 0; // number of live allocations
+	};
+
+#if WI_MEMORY_TRACKING
+	struct MemoryTagCounters
+	{
+		std::atomic<int64_t> current{ 0 };
+		std::atomic<int64_t> peak{ 0 };
+		std::atomic<int64_t> allocations{ 0 };
+	};
+	inline MemoryTagCounters memory_tag_counters[size_t(MemoryTag::Count)];
+
+	// Account an allocation of size bytes with a tag
+	//	count: the number of allocations this adds, it can be 0 when an existing allocation grows
+	inline void TrackAllocation(MemoryTag tag, size_t size, int64_t count = 1)
+	{
+		MemoryTagCounters& counters = memory_tag_counters[size_t(tag)];
+		const int64_t current = counters.current.fetch_add((int64_t)size, std::memory_order_relaxed) + (int64_t)size;
+		int64_t peak = counters.peak.load(std::memory_order_relaxed);
+		while (peak < current && !counters.peak.compare_exchange_weak(peak, current, std::memory_order_relaxed));
+		counters.allocations.fetch_add(count, std::memory_order_relaxed);
+	}
+	// Account freeing of an allocation of size bytes with a tag
+	//	count: the number of allocations this removes, it can be 0 when an existing allocation shrinks
+	inline void TrackFree(MemoryTag tag, size_t size, int64_t count = 1)
+	{
+		MemoryTagCounters& counters = memory_tag_counters[size_t(tag)];
+		counters.current.fetch_sub((int64_t)size, std::memory_order_relaxed);
+		counters.allocations.fetch_sub(count, std::memory_order_relaxed);
+	}
+	inline MemoryTagStats GetMemoryTagStats(MemoryTag tag)
+	{
+		const MemoryTagCounters& counters = memory_tag_counters[size_t(tag)];
+		MemoryTagStats stats;
+		stats.current = counters.current.load(std::memory_order_relaxed);
+		stats.peak = counters.peak.load(std::memory_order_relaxed);
+		stats.allocations = counters.allocations.load(std::memory_order_relaxed);
+		return stats;
+	}
+	// Restarts the peak tracking from the current values
+	inline void ResetMemoryTagPeaks()
+	{
+		for (auto& counters : memory_tag_counters)
+		{
+			counters.peak.store(counters.current.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		}
+	}
+
+	// STL compatible allocator that accounts its allocations with a memory tag
+	template<typename T, MemoryTag tag>
+	struct TaggedAllocator
+	{
+		using value_type = T;
+		template<typename U>
+		struct rebind
+		{
+			using other = TaggedAllocator<U, tag>;
+		};
+
+		TaggedAllocator() = default;
+		template<typename U>
+		constexpr TaggedAllocator(const TaggedAllocator<U, tag>&) noexcept {}
+
+		inline T* allocate(size_t n)
+		{
+			T* ptr = std::allocator<T>().allocate(n);
+			TrackAllocation(tag, n * sizeof(T));
+			return ptr;
+		}
+		inline void deallocate(T* ptr, size_t n)
+		{
+			TrackFree(tag, n * sizeof(T));
+			std::allocator<T>().deallocate(ptr, n);
+		}
+
+		template<typename U>
+		constexpr bool operator==(const TaggedAllocator<U, tag>&) const noexcept { return true; }
+		template<typename U>
+		constexpr bool operator!=(const TaggedAllocator<U, tag>&) const noexcept { return false; }
+	};
+
+	// Accounts memory with a tag when it can't be allocated with a TaggedAllocator (for example a wi::vector that is used by public interfaces)
+	//	The owner reports its current size with set(), the remaining size is freed when the owner is destroyed
+	//	Copying the owner also copies the memory, so the copy accounts the same size again
+	template<MemoryTag tag>
+	struct TrackedSize
+	{
+		size_t size = 0;
+
+		TrackedSize() = default;
+		TrackedSize(const TrackedSize& other) { set(other.size); }
+		TrackedSize(TrackedSize&& other) noexcept : size(other.size) { other.size = 0; }
+		TrackedSize& operator=(const TrackedSize& other) { set(other.size); return *this; }
+		TrackedSize& operator=(TrackedSize&& other) noexcept
+		{
+			if (this != &other)
+			{
+				set(0);
+				size = other.size;
+				other.size = 0;
+			}
+			return *this;
+		}
+		~TrackedSize() { set(0); }
+
+		inline void set(size_t new_size)
+		{
+			if (new_size == size)
+				return;
+			if (size == 0)
+			{
+				TrackAllocation(tag, new_size);
+			}
+			else if (new_size == 0)
+			{
+				TrackFree(tag, size);
+			}
+			else if (new_size > size)
+			{
+				TrackAllocation(tag, new_size - size, 0);
+			}
+			else
+			{
+				TrackFree(tag, size - new_size, 0);
+			}
+			size = new_size;
+		}
+	};
+#else
+	constexpr void TrackAllocation(MemoryTag tag, size_t size, int64_t count = 1) {}
+	constexpr void TrackFree(MemoryTag tag, size_t size, int64_t count = 1) {}
+	constexpr MemoryTagStats GetMemoryTagStats(MemoryTag tag) { return {}; }
+	constexpr void ResetMemoryTagPeaks() {}
+
+	// Without memory tracking this is the default allocator:
+	template<typename T, MemoryTag tag>
+	using TaggedAllocator = std::allocator<T>;
+
+	template<MemoryTag tag>
+	struct TrackedSize
+	{
+		constexpr void set(size_t new_size) {}
+	};
+#endif // WI_MEMORY_TRACKING
+
+	// Vector whose allocations are accounted with a memory tag
+	template<typename T, MemoryTag tag>
+	using tagged_vector = wi::vector<T, TaggedAllocator<T, tag>>;
+
 	// Allocation of consecutive bytes, but no freeing, instead the whole allocator can be reset
 	struct LinearAllocator
 	{
@@ -29,7 +235,7 @@ namespace wi::allocator
 		}
 		constexpr uint8_t* allocate(size_t size)
 		{
-			if (offset + size >= capacity)
+			if (offset + size > capacity)
 				return nullptr;
 			uint8_t* ptr = data + offset;
 			offset += size;
@@ -46,6 +252,291 @@ namespace wi::allocator
 		}
 	};
 
+	// Linear allocation that grows by adding pages instead of failing when the current page is exhausted
+	//	Freeing must happen in the reverse order of allocations, or the allocator can be rewound to a marker, or the whole allocator can be reset
+	//	When reset, the pages that were used are merged into one which fits the high-water mark, so the steady state is a single page
+	struct GrowingLinearAllocator
+	{
+		struct Page
+		{
+			wi::vector<uint8_t> mem;
+			LinearAllocator allocator;
+		};
+		wi::vector<Page> pages;
+		size_t current = 0; // the page that is allocated from
+		size_t page_size = 0;
+		size_t alignment = 16;
+		size_t used = 0; // bytes that are currently allocated
+		size_t high_water_mark = 0; // the most bytes that were allocated at the same time since init()
+
+		void init(size_t page_size, size_t alignment = 16)
+		{
+			assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+			this->page_size = page_size;
+			this->alignment = alignment;
+			pages.clear();
+			current = 0;
+			used = 0;
+			high_water_mark = 0;
+		}
+		uint8_t* allocate(size_t size)
+		{
+			if (size == 0)
+				return nullptr;
+			size = align(size, alignment);
+			if (!pages.empty())
+			{
+				uint8_t* ptr = pages[current].allocator.allocate(size);
+				if (ptr == nullptr && current + 1 < pages.size() && pages[current + 1].allocator.capacity >= size)
+				{
+					// the following page was kept from before, it can be reused:
+					current++;
+					ptr = pages[current].allocator.allocate(size);
+				}
+				if (ptr != nullptr)
+				{
+					used += size;
+					high_water_mark = std::max(high_water_mark, used);
+					return ptr;
+				}
+				current++;
+			}
+			pages.resize(current + 1); // the pages after current are too small for this request, they are replaced
+			add_page(pages[current], std::max(page_size, size));
+			uint8_t* ptr = pages[current].allocator.allocate(size);
+			used += size;
+			high_water_mark = std::max(high_water_mark, used);
+			return ptr;
+		}
+		void free(size_t size)
+		{
+			if (size == 0 || pages.empty())
+				return;
+			size = align(size, alignment);
+			assert(pages[current].allocator.offset >= size); // not freed in reverse order of allocations
+			pages[current].allocator.free(size);
+			used -= std::min(used, size);
+			while (current > 0 && pages[current].allocator.offset == 0)
+			{
+				current--;
+			}
+		}
+		void reset()
+		{
+			assert(used == 0 || pages.size() < 2); // merging pages would invalidate live allocations
+			if (pages.size() > 1 || (!pages.empty() && pages[0].allocator.capacity < high_water_mark))
+			{
+				pages.resize(1);
+				add_page(pages[0], std::max(page_size, high_water_mark));
+			}
+			for (auto& page : pages)
+			{
+				page.allocator.reset();
+			}
+			current = 0;
+			used = 0;
+		}
+		// Position of the allocator, rewinding to it frees everything that was allocated after it
+		struct Marker
+		{
+			size_t page = 0;
+			size_t offset = 0;
+			size_t used = 0;
+		};
+		Marker get_marker() const
+		{
+			Marker marker;
+			if (!pages.empty())
+			{
+				marker.page = current;
+				marker.offset = pages[current].allocator.offset;
+			}
+			marker.used = used;
+			return marker;
+		}
+		void rewind(const Marker& marker)
+		{
+			if (pages.empty() || marker.page > current)
+				return; // everything after the marker was already freed
+			for (size_t i = marker.page + 1; i <= current; ++i)
+			{
+				pages[i].allocator.reset();
+			}
+			current = marker.page;
+			pages[current].allocator.offset = std::min(pages[current].allocator.offset, marker.offset);
+			used = std::min(used, marker.used);
+		}
+		// Frees the allocation only if it was the last one, returns whether it was freed
+		bool free_last(const void* ptr, size_t size)
+		{
+			if (size == 0 || pages.empty())
+				return false;
+			size = align(size, alignment);
+			const LinearAllocator& allocator = pages[current].allocator;
+			if (allocator.offset < size || (const uint8_t*)ptr != allocator.data + allocator.offset - size)
+				return false;
+			free(size);
+			return true;
+		}
+		// Returns the total number of bytes that are reserved by the pages:
+		size_t reserved_size() const
+		{
+			size_t size = 0;
+			for (auto& page : pages)
+			{
+				size += page.allocator.capacity;
+			}
+			return size;
+		}
+
+	private:
+		void add_page(Page& page, size_t size)
+		{
+			page.mem.clear();
+			page.mem.shrink_to_fit();
+			page.mem.resize(size + alignment);
+			page.allocator.init((void*)align((uintptr_t)page.mem.data(), (uintptr_t)alignment), size);
+		}
+	};
+
+	// Per-thread linear memory arena for temporary allocations
+	//	Every thread has its own arena, so allocations don't need locking
+	//	Allocations can only be made while a ScratchScope is open on the thread, and they are freed when that scope is closed
+	struct ScratchArena;
+	inline constexpr size_t scratch_arena_page_size = 256 * 1024;
+	inline std::atomic<size_t> scratch_high_water_mark{ 0 };
+	inline wi::SpinLock scratch_locker;
+	inline wi::vector<ScratchArena*> scratch_arenas; // every thread's arena, for reporting
+
+	struct ScratchArena
+	{
+		GrowingLinearAllocator allocator;
+		uint32_t depth = 0; // the number of open scopes
+		std::atomic<size_t> peak{ 0 }; // the most bytes that were allocated at the same time since the last UpdateScratchHighWaterMark()
+
+		ScratchArena()
+		{
+			allocator.init(scratch_arena_page_size);
+			std::scoped_lock lck(scratch_locker);
+			scratch_arenas.push_back(this);
+		}
+		~ScratchArena()
+		{
+			std::scoped_lock lck(scratch_locker);
+			scratch_arenas.erase(std::remove(scratch_arenas.begin(), scratch_arenas.end(), this), scratch_arenas.end());
+		}
+
+		// Allocates 16 byte aligned memory that is valid until the innermost open scope is closed
+		inline uint8_t* allocate(size_t size)
+		{
+			assert(depth > 0); // allocation without an open ScratchScope
+			uint8_t* ptr = allocator.allocate(size);
+			if (allocator.used > peak.load(std::memory_order_relaxed))
+			{
+				peak.store(allocator.used, std::memory_order_relaxed);
+			}
+			return ptr;
+		}
+		// Only the last allocation can be reclaimed immediately (for example when a vector grows), the rest is freed when the scope is closed
+		inline void deallocate(const void* ptr, size_t size)
+		{
+			allocator.free_last(ptr, size);
+		}
+	};
+
+	// Returns the scratch arena of the calling thread
+	inline ScratchArena& GetScratchArena()
+	{
+		static thread_local ScratchArena arena;
+		return arena;
+	}
+
+	// Opens a scope for scratch allocations on the calling thread, everything allocated inside it is freed when the scope is destroyed
+	//	Scopes live on the stack, so they are always closed in reverse order, even when wi::jobsystem::Wait() executes other jobs on the
+	//	same thread in the meantime. This makes the arena safe to use in any job, including long running ones
+	struct ScratchScope
+	{
+		ScratchArena& arena;
+		GrowingLinearAllocator::Marker marker;
+		uint32_t depth = 0;
+
+		ScratchScope() : arena(GetScratchArena())
+		{
+			marker = arena.allocator.get_marker();
+			depth = ++arena.depth;
+		}
+		~ScratchScope()
+		{
+			assert(arena.depth == depth); // scopes must be closed in reverse order
+			arena.allocator.rewind(marker);
+			arena.depth--;
+			if (arena.depth == 0)
+			{
+				// Nothing is allocated at this point, so the pages can be merged:
+				arena.allocator.used = 0;
+				arena.allocator.reset();
+			}
+		}
+		ScratchScope(const ScratchScope&) = delete;
+		ScratchScope& operator=(const ScratchScope&) = delete;
+	};
+
+	// Gathers the sum of the per-thread scratch high-water marks since the last call, wi::Application calls it at the beginning of every frame
+	inline void UpdateScratchHighWaterMark()
+	{
+		size_t high_water_mark = 0;
+		std::scoped_lock lck(scratch_locker);
+		for (ScratchArena* arena : scratch_arenas)
+		{
+			high_water_mark += arena->peak.exchange(0, std::memory_order_relaxed);
+		}
+		scratch_high_water_mark.store(high_water_mark, std::memory_order_relaxed);
+	}
+
+	// Returns the sum of the per-thread scratch high-water marks of the previous frame in bytes
+	inline size_t GetScratchHighWaterMark()
+	{
+		return scratch_high_water_mark.load(std::memory_order_relaxed);
+	}
+
+	// STL compatible allocator that allocates from the scratch arena of the thread and scope where it was created
+	//	A container using it must be created inside the innermost open scope of the thread, and it must only be resized on that thread
+	template<typename T>
+	struct ScratchAllocator
+	{
+		using value_type = T;
+
+		ScratchArena* arena = nullptr;
+		uint32_t depth = 0;
+
+		ScratchAllocator() : arena(&GetScratchArena()), depth(arena->depth)
+		{
+			assert(depth > 0); // no ScratchScope is open
+		}
+		template<typename U>
+		constexpr ScratchAllocator(const ScratchAllocator<U>& other) noexcept : arena(other.arena), depth(other.depth) {}
+
+		inline T* allocate(size_t n)
+		{
+			static_assert(alignof(T) <= 16, "Scratch allocations are only 16 byte aligned!");
+			assert(arena == &GetScratchArena() && arena->depth == depth); // resized on a different thread, or inside a nested scope
+			return (T*)arena->allocate(n * sizeof(T));
+		}
+		inline void deallocate(T* ptr, size_t n)
+		{
+			arena->deallocate(ptr, n * sizeof(T));
+		}
+
+		template<typename U>
+		constexpr bool operator==(const ScratchAllocator<U>& other) const noexcept { return arena == other.arena && depth == other.depth; }
+		template<typename U>
+		constexpr bool operator!=(const ScratchAllocator<U>& other) const noexcept { return !(*this == other); }
+	};
+
+	// Vector that allocates from the calling thread's scratch arena, for temporary arrays that don't outlive the current ScratchScope:
+	template<typename T>
+	using scratch_vector = wi::vector<T, ScratchAllocator<T>>;
+
 	// Allocation and freeing of single elements of the same size
 	template<typename T, size_t block_size = 256>
 	struct BlockAllocator
@@ -77,11 +568,13 @@ namespace wi::allocator
 			}
 			T* ptr = free_list.back();
 			free_list.pop_back();
+			TrackAllocation(memory_tag_v<T>, sizeof(T));
 			return new (ptr) T(std::forward<ARG>(args)...);
 		}
 		inline void free(T* ptr)
 		{
 			ptr->~T();
+			TrackFree(memory_tag_v<T>, sizeof(T));
 			free_list.push_back(ptr);
 		}
 
@@ -293,6 +786,7 @@ namespace wi::allocator
 			assert((uint64_t)ptr == ((uint64_t)ptr & (~0ull << 8ull))); // The pointer lower 8 bits must be 0, it will be used as allocator index
 			free_list.pop_back();
 			locker.unlock();
+			TrackAllocation(memory_tag_v<T>, sizeof(RawStruct));
 
 			// Construction can be outside of lock, this structure wasn't shared yet:
 			new (ptr) T(std::forward<ARG>(args)...);
@@ -304,6 +798,7 @@ namespace wi::allocator
 
 		void reclaim(void* ptr)
 		{
+			TrackFree(memory_tag_v<T>, sizeof(RawStruct));
 			std::scoped_lock lck(locker);
 			free_list.push_back((RawStruct*)ptr);
 		}
@@ -379,6 +874,7 @@ namespace wi::allocator
 		inline shared_ptr<T> allocate(ARG&&... args)
 		{
 			RawStruct* ptr = new RawStruct;
+			TrackAllocation(memory_tag_v<T>, sizeof(RawStruct));
 			new (ptr) T(std::forward<ARG>(args)...);
 			init_refcount(ptr);
 			shared_ptr<T> allocation;
@@ -388,6 +884,7 @@ namespace wi::allocator
 
 		void reclaim(void* ptr)
 		{
+			TrackFree(memory_tag_v<T>, sizeof(RawStruct));
 			delete static_cast<RawStruct*>(ptr);
 		}
 
@@ -15,6 +15,7 @@
 #include "wiFont.h"
 #include "wiImage.h"
 #include "wiEventHandler.h"
+#include "wiAllocator.h"
 #include "wiPlatform.h"
 
 #if defined(PLATFORM_PS5)
@@ -25,6 +26,7 @@
 #include "wiGraphicsDevice_DX12.h"
 #include "wiGraphicsDevice_Vulkan.h"
 #endif // PLATFORM_PS5
+#include "wiGraphicsDevice_Null.h"
 
 #include <string>
 #include <algorithm>
@@ -265,6 +267,7 @@ namespace wi
 			return;
 		}
 
+		wi::allocator::UpdateScratchHighWaterMark();
 		wi::profiler::BeginFrame();
 
 		deltaTime = float(timer.record_elapsed_seconds());
@@ -759,62 +762,70 @@ namespace wi
 				preference = GPUPreference::Intel;
 			}
 
+			if (wi::arguments::HasArgument("nulldevice"))
+			{
+				// Headless device, useful for running the CPU side of the engine without a GPU:
+				graphicsDevice = std::make_unique<GraphicsDevice_Null>(validationMode);
+			}
+			else
+			{
 #ifdef PLATFORM_PS5
-			wi::renderer::SetShaderPath(wi::renderer::GetShaderPath() + "ps5/");
-			graphicsDevice = std::make_unique<GraphicsDevice_PS5>(validationMode);
+				wi::renderer::SetShaderPath(wi::renderer::GetShaderPath() + "ps5/");
+				graphicsDevice = std::make_unique<GraphicsDevice_PS5>(validationMode);
 #elif defined(PLATFORM_APPLE)
-			wi::renderer::SetShaderPath(wi::renderer::GetShaderPath() + "metal/");
-			graphicsDevice = std::make_unique<GraphicsDevice_Metal>(validationMode, preference);
+				wi::renderer::SetShaderPath(wi::renderer::GetShaderPath() + "metal/");
+				graphicsDevice = std::make_unique<GraphicsDevice_Metal>(validationMode, preference);
 
 #else
-			bool use_dx12 = wi::arguments::HasArgument("dx12");
-			bool use_vulkan = wi::arguments::HasArgument("vulkan");
+				bool use_dx12 = wi::arguments::HasArgument("dx12");
+				bool use_vulkan = wi::arguments::HasArgument("vulkan");
 
 #ifndef WICKEDENGINE_BUILD_DX12
-			if (use_dx12) {
-				wi::helper::messageBox("The engine was built without DX12 support!", "Error");
-				use_dx12 = false;
-			}
+				if (use_dx12) {
+					wi::helper::messageBox("The engine was built without DX12 support!", "Error");
+					use_dx12 = false;
+				}
 #endif // WICKEDENGINE_BUILD_DX12
 #ifndef WICKEDENGINE_BUILD_VULKAN
-			if (use_vulkan) {
-				wi::helper::messageBox("The engine was built without Vulkan support!", "Error");
-				use_vulkan = false;
-			}
+				if (use_vulkan) {
+					wi::helper::messageBox("The engine was built without Vulkan support!", "Error");
+					use_vulkan = false;
+				}
 #endif // WICKEDENGINE_BUILD_VULKAN
 
-			if (!use_dx12 && !use_vulkan)
-			{
+				if (!use_dx12 && !use_vulkan)
+				{
 #if defined(WICKEDENGINE_BUILD_DX12)
-				use_dx12 = true;
+					use_dx12 = true;
 #elif defined(WICKEDENGINE_BUILD_VULKAN)
-				use_vulkan = true;
+					use_vulkan = true;
 #else
-				wi::backlog::post("No rendering backend is enabled! Please enable at least one so we can use it as default", wi::backlog::LogLevel::Error);
-				assert(false);
+					wi::backlog::post("No rendering backend is enabled! Please enable at least one so we can use it as default", wi::backlog::LogLevel::Error);
+					assert(false);
 #endif
-			}
-			assert(use_dx12 || use_vulkan);
+				}
+				assert(use_dx12 || use_vulkan);
 
-			if (use_vulkan)
-			{
+				if (use_vulkan)
+				{
 #ifdef WICKEDENGINE_BUILD_VULKAN
-				wi::renderer::SetShaderPath(wi::renderer::GetShaderPath() + "spirv/");
-				graphicsDevice = std::make_unique<GraphicsDevice_Vulkan>(window, validationMode, preference);
+					wi::renderer::SetShaderPath(wi::renderer::GetShaderPath() + "spirv/");
+					graphicsDevice = std::make_unique<GraphicsDevice_Vulkan>(window, validationMode, preference);
 #endif
-			}
-			else if (use_dx12)
-			{
+				}
+				else if (use_dx12)
+				{
 #ifdef WICKEDENGINE_BUILD_DX12
 #ifdef PLATFORM_XBOX
-				wi::renderer::SetShaderPath(wi::renderer::GetShaderPath() + "hlsl6_xs/");
+					wi::renderer::SetShaderPath(wi::renderer::GetShaderPath() + "hlsl6_xs/");
 #else
-				wi::renderer::SetShaderPath(wi::renderer::GetShaderPath() + "hlsl6/");
+					wi::renderer::SetShaderPath(wi::renderer::GetShaderPath() + "hlsl6/");
 #endif // PLATFORM_XBOX
-				graphicsDevice = std::make_unique<GraphicsDevice_DX12>(validationMode, preference);
+					graphicsDevice = std::make_unique<GraphicsDevice_DX12>(validationMode, preference);
 #endif
-			}
+				}
 #endif // PLATFORM_PS5
+			}
 		}
 		wi::graphics::GetDevice() = graphicsDevice.get();
 
@@ -1,6 +1,8 @@
 #include "wiArchive.h"
 #include "wiHelper.h"
 #include "wiTextureHelper.h"
+#include "wiJobSystem.h"
+#include "wiBacklog.h"
 
 #include "Utility/stb_image.h"
 
@@ -11,29 +13,74 @@
 // - Thumbnail data [optional] (offset = sizeof(Header), size = header.properties.bits.thumbnail_data_size)
 //		- JPEG compressed image if header.properties.bits.thumbnail_data_size > 0
 // - Data [optionally compressed] (offset = sizeof(Header) + header.properties.bits.thumbnail_data_size, size = remaining)
+//		- if header.properties.bits.chunked, the compressed data is:
+//			- ChunkTable
+//			- uint64_t offsets[chunk_count + 1] of the compressed chunks, relative to the end of the offsets
+//			- compressed chunks, each of them decompresses to chunk_size bytes, except the last one which can be smaller
 
 namespace wi
 {
 	// this should always be only INCREMENTED and only if a new serialization is implemeted somewhere!
-	static constexpr uint64_t __archiveVersion = 93;
+	static constexpr uint64_t __archiveVersion = 94;
 	// this is the version number of which below the archive is not compatible with the current version
 	static constexpr uint64_t __archiveVersionBarrier = 22;
 
 	// version history is logged in ArchiveVersionHistory.txt file!
 
+	struct ChunkTable
+	{
+		uint64_t chunk_size = 0; // uncompressed size of one chunk
+		uint64_t uncompressed_size = 0; // uncompressed size of all chunks
+		uint64_t chunk_count = 0;
+	};
+	static_assert(sizeof(ChunkTable) == sizeof(uint64_t) * 3);
+
+	// Validates the chunk table at the beginning of chunked compressed data, returns the size of the table with the offsets
+	static size_t ParseChunkTable(const uint8_t* data, size_t size, ChunkTable& table, wi::vector<uint64_t>& offsets)
+	{
+		if (size < sizeof(ChunkTable))
+			return 0;
+		std::memcpy(&table, data, sizeof(ChunkTable));
+		if (table.chunk_count >= size / sizeof(uint64_t))
+			return 0;
+		if (table.chunk_size == 0 || table.chunk_count != (table.uncompressed_size + table.chunk_size - 1) / table.chunk_size)
+			return 0;
+		const size_t table_size = sizeof(ChunkTable) + (table.chunk_count + 1) * sizeof(uint64_t);
+		if (size < table_size)
+			return 0;
+		offsets.resize(table.chunk_count + 1);
+		std::memcpy(offsets.data(), data + sizeof(ChunkTable), offsets.size() * sizeof(uint64_t));
+		for (size_t i = 0; i < table.chunk_count; ++i)
+		{
+			if (offsets[i] > offsets[i + 1])
+				return 0;
+		}
+		if (offsets[0] != 0 || offsets.back() > size - table_size)
+			return 0;
+		return table_size;
+	}
+
 	Archive::Archive()
 	{
 		CreateEmpty();
 	}
-	Archive::Archive(const std::string& fileName, bool readMode)
-		: readMode(readMode), fileName(fileName)
+	Archive::Archive(const std::string& fileName, bool readMode, bool lazyDecompression)
+		: readMode(readMode), lazy_decompression(lazyDecompression), fileName(fileName)
 	{
 		if (!fileName.empty())
 		{
 			directory = wi::helper::GetDirectoryFromPath(fileName);
 			if (readMode)
 			{
-				if (wi::helper::FileRead(fileName, DATA))
+				size_t mapped_size = 0;
+				mapped_file = wi::helper::FileMap(fileName, mapped_size);
+				if (mapped_file != nullptr)
+				{
+					data_ptr = mapped_file.get();
+					data_ptr_size = mapped_size;
+					SetReadModeAndResetPos(true);
+				}
+				else if (wi::helper::FileRead(fileName, DATA))
 				{
 					data_ptr = DATA.data();
 					data_ptr_size = DATA.size();
@@ -47,6 +94,38 @@ namespace wi
 		}
 	}
 
+	Archive::Archive(const Archive& other)
+	{
+		*this = other;
+	}
+
+	Archive& Archive::operator=(const Archive& other)
+	{
+		if (this == &other)
+			return *this;
+		header = other.header;
+		readMode = other.readMode;
+		pos = other.pos;
+		DATA = other.DATA;
+		// data_ptr is either memory mapped (shared between copies) or points into DATA which is owned by each copy:
+		data_ptr = other.data_ptr == other.DATA.data() ? DATA.data() : other.data_ptr;
+		data_ptr_size = other.data_ptr_size;
+		mapped_file = other.mapped_file;
+		data_already_decompressed = other.data_already_decompressed;
+		compression_chunk_size = other.compression_chunk_size;
+		lazy_decompression = other.lazy_decompression;
+		chunk_frames = other.chunk_frames; // points into mapped_file, which is shared
+		chunk_offsets = other.chunk_offsets;
+		chunk_resident = other.chunk_resident;
+		chunk_size = other.chunk_size;
+		chunk_data_offset = other.chunk_data_offset;
+		chunks_pending = other.chunks_pending;
+		fileName = other.fileName;
+		directory = other.directory;
+		thumbnail_data_ptr_write = other.thumbnail_data_ptr_write;
+		return *this;
+	}
+
 	Archive::Archive(const uint8_t* data, size_t size)
 	{
 		data_ptr = data;
@@ -102,7 +181,16 @@ namespace wi
 				size_t data_offset = 0;
 				data_offset += sizeof(Header);
 				data_offset += header.properties.bits.thumbnail_data_size;
-				if (data_ptr_size > data_offset)
+				if (header.properties.bits.chunked)
+				{
+					if (!OpenChunkedData(data_offset))
+					{
+						wi::backlog::post("Archive chunked data is corrupted: " + fileName, wi::backlog::LogLevel::Error);
+						Close();
+						return;
+					}
+				}
+				else if (data_ptr_size > data_offset)
 				{
 					size_t data_size = data_ptr_size - data_offset;
 					wi::vector<uint8_t> decompressed_part;
@@ -121,6 +209,7 @@ namespace wi
 					data_ptr = DATA.data();
 					data_ptr_size = DATA.size();
 					data_already_decompressed = true; // indicate that next call to SetReadModeAndResetPos() doesn't need to decompress data
+					mapped_file.reset(); // the compressed source is no longer referenced
 				}
 			}
 		}
@@ -142,9 +231,129 @@ namespace wi
 			SaveFile(fileName);
 		}
 		DATA.clear();
+		mapped_file.reset();
+		chunk_frames = nullptr;
+		chunk_offsets.clear();
+		chunk_resident.clear();
+		chunks_pending = 0;
 		data_ptr = nullptr;
 	}
 
+	bool Archive::OpenChunkedData(size_t data_offset)
+	{
+		if (data_ptr_size < data_offset)
+			return false;
+		ChunkTable table;
+		wi::vector<uint64_t> offsets;
+		const size_t table_size = ParseChunkTable(data_ptr + data_offset, data_ptr_size - data_offset, table, offsets);
+		if (table_size == 0)
+			return false;
+
+		// The uncompressed archive has the same header and thumbnail as the source:
+		wi::vector<uint8_t> final_data(data_offset + table.uncompressed_size);
+		std::memcpy(final_data.data(), data_ptr, data_offset);
+
+		if (mapped_file == nullptr && data_ptr == DATA.data())
+		{
+			// The source is owned by DATA which will be replaced, so it is moved to shared storage to keep it alive for lazy decompression:
+			auto source = std::make_shared<wi::vector<uint8_t>>(std::move(DATA));
+			mapped_file = std::shared_ptr<const uint8_t>(source, source->data());
+		}
+		const bool source_owned = mapped_file != nullptr; // borrowed source memory can't be used for lazy decompression because its lifetime is unknown
+
+		chunk_frames = data_ptr + data_offset + table_size;
+		chunk_offsets = std::move(offsets);
+		chunk_size = (size_t)table.chunk_size;
+		chunk_data_offset = data_offset;
+		chunk_resident.clear();
+		chunk_resident.resize(table.chunk_count);
+
+		std::swap(DATA, final_data);
+		data_ptr = DATA.data();
+		data_ptr_size = DATA.size();
+		data_already_decompressed = true; // indicate that next call to SetReadModeAndResetPos() doesn't need to decompress data
+		chunks_pending = (size_t)table.chunk_count;
+
+		if (!lazy_decompression || !source_owned)
+		{
+			return DecompressChunks(data_offset, (size_t)table.uncompressed_size);
+		}
+		return true;
+	}
+
+	bool Archive::DecompressChunks(size_t offset, size_t size)
+	{
+		if (size == 0 || offset + size <= chunk_data_offset)
+			return true;
+		const size_t chunk_count = chunk_resident.size();
+		const size_t uncompressed_size = data_ptr_size - chunk_data_offset;
+		const size_t first = (std::max(offset, chunk_data_offset) - chunk_data_offset) / chunk_size;
+		const size_t last = std::min(chunk_count - 1, (offset + size - 1 - chunk_data_offset) / chunk_size);
+
+		auto decompress = [&](size_t chunk) {
+			const size_t chunk_offset = chunk * chunk_size;
+			return wi::helper::Decompress(
+				chunk_frames + chunk_offsets[chunk],
+				size_t(chunk_offsets[chunk + 1] - chunk_offsets[chunk]),
+				DATA.data() + chunk_data_offset + chunk_offset,
+				std::min(chunk_size, uncompressed_size - chunk_offset)
+			);
+		};
+
+		size_t pending_in_range = 0;
+		for (size_t chunk = first; chunk <= last; ++chunk)
+		{
+			pending_in_range += chunk_resident[chunk] ? 0 : 1;
+		}
+		if (pending_in_range == 0)
+			return true;
+
+		std::atomic<bool> success{ true };
+		if (pending_in_range == 1)
+		{
+			for (size_t chunk = first; chunk <= last; ++chunk)
+			{
+				if (!chunk_resident[chunk] && !decompress(chunk))
+				{
+					success.store(false);
+				}
+			}
+		}
+		else
+		{
+			// The chunks are independent, so they are decompressed in parallel:
+			wi::jobsystem::context ctx;
+			wi::jobsystem::Dispatch(ctx, uint32_t(last - first + 1), 1, [&](wi::jobsystem::JobArgs args) {
+				const size_t chunk = first + args.jobIndex;
+				if (!chunk_resident[chunk] && !decompress(chunk))
+				{
+					success.store(false);
+				}
+			});
+			wi::jobsystem::Wait(ctx);
+		}
+		if (!success.load())
+		{
+			wi::backlog::post("Archive chunk decompression failed: " + fileName, wi::backlog::LogLevel::Error);
+			// the chunks are still marked as resident, so they are not retried on every read
+		}
+		for (size_t chunk = first; chunk <= last; ++chunk)
+		{
+			chunk_resident[chunk] = 1;
+		}
+		chunks_pending -= pending_in_range;
+
+		if (chunks_pending == 0)
+		{
+			// Everything is decompressed, the compressed source is no longer needed:
+			mapped_file.reset();
+			chunk_frames = nullptr;
+			chunk_offsets.clear();
+			chunk_resident.clear();
+		}
+		return success.load();
+	}
+
 	bool Archive::SaveFile(const std::string& fileName)
 	{
 		if (IsCompressionEnabled())
@@ -263,12 +472,45 @@ namespace wi
 	{
 		Header _header = header;
 		_header.properties.bits.compressed = 1; // force write compressed header
+		_header.properties.bits.chunked = compression_chunk_size > 0 ? 1 : 0;
 		size_t data_offset = 0;
 		data_offset += sizeof(Header);
 		data_offset += _header.properties.bits.thumbnail_data_size;
 		size_t data_size = pos - data_offset;
 		wi::vector<uint8_t> compressed_part;
-		wi::helper::Compress(data_ptr + data_offset, data_size, compressed_part, 9);
+		if (_header.properties.bits.chunked)
+		{
+			// The chunks are compressed independently in parallel, and written after the chunk table:
+			ChunkTable table;
+			table.chunk_size = compression_chunk_size;
+			table.uncompressed_size = data_size;
+			table.chunk_count = (data_size + compression_chunk_size - 1) / compression_chunk_size;
+			wi::vector<wi::vector<uint8_t>> chunks(table.chunk_count);
+			wi::jobsystem::context ctx;
+			wi::jobsystem::Dispatch(ctx, (uint32_t)table.chunk_count, 1, [&](wi::jobsystem::JobArgs args) {
+				const size_t chunk_offset = size_t(args.jobIndex) * compression_chunk_size;
+				wi::helper::Compress(data_ptr + data_offset + chunk_offset, std::min(compression_chunk_size, data_size - chunk_offset), chunks[args.jobIndex], 9);
+			});
+			wi::jobsystem::Wait(ctx);
+
+			wi::vector<uint64_t> offsets(table.chunk_count + 1);
+			for (size_t i = 0; i < chunks.size(); ++i)
+			{
+				offsets[i + 1] = offsets[i] + chunks[i].size();
+			}
+			const size_t table_size = sizeof(ChunkTable) + offsets.size() * sizeof(uint64_t);
+			compressed_part.resize(table_size + offsets.back());
+			std::memcpy(compressed_part.data(), &table, sizeof(ChunkTable));
+			std::memcpy(compressed_part.data() + sizeof(ChunkTable), offsets.data(), offsets.size() * sizeof(uint64_t));
+			for (size_t i = 0; i < chunks.size(); ++i)
+			{
+				std::memcpy(compressed_part.data() + table_size + offsets[i], chunks[i].data(), chunks[i].size());
+			}
+		}
+		else
+		{
+			wi::helper::Compress(data_ptr + data_offset, data_size, compressed_part, 9);
+		}
 		final_data.resize(data_offset + compressed_part.size());
 		size_t _offset = 0;
 		std::memcpy(final_data.data() + _offset, &_header, sizeof(Header));
@@ -281,4 +523,81 @@ namespace wi
 		std::memcpy(final_data.data() + _offset, compressed_part.data(), compressed_part.size());
 	}
 
+	bool Archive::ReadFileRange(const std::string& fileName, size_t offset, size_t size, wi::vector<uint8_t>& data)
+	{
+		Header file_header;
+		wi::vector<uint8_t> header_data;
+		if (!wi::helper::FileRead(fileName, header_data, sizeof(Header)) || header_data.size() < sizeof(Header))
+			return false;
+		std::memcpy(&file_header, header_data.data(), sizeof(Header));
+		const bool has_properties = file_header.version >= 92;
+		if (!has_properties || !file_header.properties.bits.compressed)
+		{
+			// Uncompressed archive, the range is the same in the file:
+			return wi::helper::FileRead(fileName, data, size, offset);
+		}
+
+		const size_t data_offset = sizeof(Header) + file_header.properties.bits.thumbnail_data_size;
+		if (!file_header.properties.bits.chunked || offset < data_offset)
+		{
+			// Not seekable, the whole archive needs to be decompressed:
+			wi::Archive archive(fileName);
+			if (!archive.IsOpen() || offset >= archive.GetSize())
+				return false;
+			size = std::min(size, archive.GetSize() - offset);
+			data.resize(size);
+			std::memcpy(data.data(), archive.GetData() + offset, size);
+			return true;
+		}
+
+		// Read the chunk table, then only the compressed chunks that overlap the requested range:
+		ChunkTable table;
+		wi::vector<uint8_t> table_data;
+		if (!wi::helper::FileRead(fileName, table_data, sizeof(ChunkTable), data_offset) || table_data.size() < sizeof(ChunkTable))
+			return false;
+		std::memcpy(&table, table_data.data(), sizeof(ChunkTable));
+		const size_t compressed_size = wi::helper::FileSize(fileName) - data_offset;
+		if (table.chunk_count >= compressed_size / sizeof(uint64_t))
+			return false;
+		const size_t table_size = sizeof(ChunkTable) + (table.chunk_count + 1) * sizeof(uint64_t);
+		if (!wi::helper::FileRead(fileName, table_data, table_size, data_offset) || table_data.size() != table_size)
+			return false;
+		wi::vector<uint64_t> offsets;
+		if (ParseChunkTable(table_data.data(), compressed_size, table, offsets) != table_size)
+			return false;
+
+		const size_t relative_offset = offset - data_offset;
+		if (relative_offset >= table.uncompressed_size)
+			return false;
+		size = std::min(size, size_t(table.uncompressed_size - relative_offset));
+		if (size == 0)
+		{
+			data.clear();
+			return true;
+		}
+		const size_t first = relative_offset / table.chunk_size;
+		const size_t last = (relative_offset + size - 1) / table.chunk_size;
+
+		wi::vector<uint8_t> compressed;
+		if (!wi::helper::FileRead(fileName, compressed, size_t(offsets[last + 1] - offsets[first]), data_offset + table_size + offsets[first]))
+			return false;
+		if (compressed.size() != offsets[last + 1] - offsets[first])
+			return false;
+
+		data.resize(size);
+		wi::vector<uint8_t> chunk_data;
+		for (size_t chunk = first; chunk <= last; ++chunk)
+		{
+			const size_t chunk_offset = chunk * table.chunk_size;
+			const size_t chunk_uncompressed_size = std::min(size_t(table.chunk_size), size_t(table.uncompressed_size - chunk_offset));
+			chunk_data.resize(chunk_uncompressed_size);
+			if (!wi::helper::Decompress(compressed.data() + offsets[chunk] - offsets[first], size_t(offsets[chunk + 1] - offsets[chunk]), chunk_data.data(), chunk_data.size()))
+				return false;
+			const size_t copy_begin = std::max(relative_offset, chunk_offset);
+			const size_t copy_end = std::min(relative_offset + size, chunk_offset + chunk_uncompressed_size);
+			std::memcpy(data.data() + copy_begin - relative_offset, chunk_data.data() + copy_begin - chunk_offset, copy_end - copy_begin);
+		}
+		return true;
+	}
+
 }
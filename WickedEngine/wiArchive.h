@@ -6,9 +6,41 @@
 #include "wiGraphics.h"
 
 #include <string>
+#include <memory>
+#include <type_traits>
 
 namespace wi
 {
+	namespace archive_internal
+	{
+		// Maps the types that have a fixed size serialized form to the type that the Archive writes for them
+		//	This allows vectors of them to be serialized in bulk, it must match the corresponding operator<< and operator>>
+		template<typename T> struct wire { using type = void; };
+		template<> struct wire<char> { using type = int8_t; };
+		template<> struct wire<short> { using type = int16_t; };
+		template<> struct wire<unsigned char> { using type = uint8_t; };
+		template<> struct wire<unsigned short> { using type = uint16_t; };
+		template<> struct wire<int> { using type = int64_t; };
+		template<> struct wire<unsigned int> { using type = uint64_t; };
+		template<> struct wire<long> { using type = int64_t; };
+		template<> struct wire<unsigned long> { using type = uint64_t; };
+		template<> struct wire<long long> { using type = int64_t; };
+		template<> struct wire<unsigned long long> { using type = uint64_t; };
+		template<> struct wire<float> { using type = float; };
+		template<> struct wire<double> { using type = double; };
+		template<> struct wire<XMFLOAT2> { using type = XMFLOAT2; };
+		template<> struct wire<XMFLOAT3> { using type = XMFLOAT3; };
+		template<> struct wire<XMFLOAT4> { using type = XMFLOAT4; };
+		template<> struct wire<XMFLOAT3X3> { using type = XMFLOAT3X3; };
+		template<> struct wire<XMFLOAT4X3> { using type = XMFLOAT4X3; };
+		template<> struct wire<XMFLOAT4X4> { using type = XMFLOAT4X4; };
+		template<> struct wire<XMUINT2> { using type = XMUINT2; };
+		template<> struct wire<XMUINT3> { using type = XMUINT3; };
+		template<> struct wire<XMUINT4> { using type = XMUINT4; };
+		template<> struct wire<wi::Color> { using type = wi::Color; }; // only contains the rgba value
+		static_assert(sizeof(wi::Color) == sizeof(uint32_t));
+	}
+
 	// This is a data container used for serialization purposes.
 	//	It can be used to READ or WRITE data, but not both at the same time.
 	//	An archive that was created in WRITE mode can be changed to read mode and vica-versa
@@ -25,7 +57,8 @@ namespace wi
 				{
 					uint64_t thumbnail_data_size : 32;
 					uint64_t compressed : 1;
-					uint64_t reserved : 31;
+					uint64_t chunked : 1; // compressed data is split into independently compressed chunks with a seek table
+					uint64_t reserved : 30;
 				} bits;
 				uint64_t raw = 0;
 			} properties;
@@ -39,7 +72,18 @@ namespace wi
 		wi::vector<uint8_t> DATA; // data suitable for read/write operations
 		const uint8_t* data_ptr = nullptr; // this can either be a memory mapped pointer (read only), or the DATA's pointer
 		size_t data_ptr_size = 0;
+		std::shared_ptr<const uint8_t> mapped_file; // keeps the source file data alive if the archive was opened from a memory mapped file or it is decompressed lazily
 		bool data_already_decompressed = false;
+		size_t compression_chunk_size = 2 * 1024 * 1024;
+		bool lazy_decompression = false;
+
+		// Lazy decompression state of chunked archives, the chunks are decompressed when they are first read:
+		const uint8_t* chunk_frames = nullptr; // compressed chunks in the source data, kept alive by mapped_file
+		wi::vector<uint64_t> chunk_offsets; // compressed offsets relative to chunk_frames, chunk count + 1 entries
+		wi::vector<uint8_t> chunk_resident; // whether a chunk is decompressed already
+		size_t chunk_size = 0;
+		size_t chunk_data_offset = 0; // start of the chunked data in the uncompressed archive
+		size_t chunks_pending = 0;
 
 		std::string fileName; // save to this file on closing if not empty
 		std::string directory; // the directory part from the fileName
@@ -48,23 +92,30 @@ namespace wi
 		constexpr const uint8_t* get_thumbnail_data() const { return data_ptr + sizeof(Header); }
 
 		void WriteCompressedData(wi::vector<uint8_t>& final_data) const;
+		bool OpenChunkedData(size_t data_offset);
+		bool DecompressChunks(size_t offset, size_t size);
 
 		void CreateEmpty(); // creates new archive in write mode
 
 	public:
 		// Create empty archive for writing
 		Archive();
-		Archive(const Archive&) = default;
+		// The copy has its own DATA, so data_ptr is rebased if it pointed into the source's DATA:
+		Archive(const Archive& other);
 		Archive(Archive&&) = default;
 		// Create archive from a file.
 		//	If readMode == true, the whole file will be loaded into the archive in read mode
+		//		Where supported, the file is memory mapped instead of copied, so MapVector() returns pointers into the mapping
+		//		The mapping stays alive for the lifetime of the archive (and its copies)
 		//	If readMode == false, the file will be written when the archive is destroyed or Close() is called
-		Archive(const std::string& fileName, bool readMode = true);
+		//	If lazyDecompression == true and the file has chunked compression, chunks are only decompressed when they are read
+		//		Otherwise the whole data is decompressed in parallel when the archive is opened
+		Archive(const std::string& fileName, bool readMode = true, bool lazyDecompression = false);
 		// Creates a memory mapped archive in read mode
 		Archive(const uint8_t* data, size_t size);
 		~Archive() { Close(); }
 
-		Archive& operator=(const Archive&) = default;
+		Archive& operator=(const Archive& other);
 		Archive& operator=(Archive&&) = default;
 
 		void WriteData(wi::vector<uint8_t>& dest) const;
@@ -99,12 +150,23 @@ namespace wi
 
 		// Set whether the archive should be compressed upon saving
 		//	Note that in memory, the archive is uncompressed
-		//	Note that compressed archive will not work with streaming!
+		//	Note that compressed archive will only work with streaming if it is chunked (see SetCompressionChunkSize())
 		constexpr void SetCompressionEnabled(bool value) { header.properties.bits.compressed = value; }
 		// Returns true if the archive data is originating from compressed data
 		//	Note that even if the archive was opened from compressed data source, the archive is always uncompressed in memory
-		//	Note that compressed archive will not work with streaming!
 		constexpr bool IsCompressionEnabled() const { return header.properties.bits.compressed; }
+		// Set the uncompressed size of the chunks that are compressed independently upon saving
+		//	Chunked data can be decompressed in parallel and parts of it can be read without decompressing everything (see ReadFileRange())
+		//	0 : the whole data is compressed as one block, this is slightly smaller but not seekable
+		constexpr void SetCompressionChunkSize(size_t value) { compression_chunk_size = value; }
+		// Returns true if the archive data is compressed in chunks
+		//	In read mode, this means that the source data was chunked, in write mode that it will be saved as chunked
+		constexpr bool IsCompressionChunked() const { return IsCompressionEnabled() && (readMode ? header.properties.bits.chunked : compression_chunk_size > 0); }
+
+		// Reads a range of the archive data from an archive file without opening the whole archive
+		//	offset, size : the range in the uncompressed archive, the same as positions returned by GetPos()
+		//	For chunked compressed archives, only the chunks that overlap the range are read and decompressed
+		static bool ReadFileRange(const std::string& fileName, size_t offset, size_t size, wi::vector<uint8_t>& data);
 
 		// If Archive contains thumbnail image data, then creates a Texture from it:
 		wi::graphics::Texture CreateThumbnailTexture() const;
@@ -137,6 +199,7 @@ namespace wi
 		}
 		// Modifies the current archive offset
 		//	It can be used in conjunction with WriteUnknownJumpPosition() and PatchUnknownJumpPosition()
+		//	This doesn't decompress anything with lazy decompression, the chunks are decompressed by the reads after the jump
 		void Jump(uint64_t jump_pos)
 		{
 			pos = jump_pos;
@@ -146,6 +209,10 @@ namespace wi
 		inline void MapVector(const uint8_t*& data, size_t& size)
 		{
 			(*this) >> size;
+			if (chunks_pending > 0)
+			{
+				DecompressChunks(pos, size);
+			}
 			data = data_ptr + pos;
 			pos += size;
 		}
@@ -279,25 +346,34 @@ namespace wi
 			}
 			return *this;
 		}
-		template<typename T>
-		inline Archive& operator<<(const wi::vector<T>& data)
+		template<typename T, typename A>
+		inline Archive& operator<<(const wi::vector<T, A>& data)
 		{
-			// Here we will use the << operator so that non-specified types will have compile error!
 			(*this) << data.size();
-			for (const T& x : data)
+			using wire_type = typename archive_internal::wire<T>::type;
+			if constexpr (std::is_void_v<wire_type>)
 			{
-				(*this) << x;
+				// Here we will use the << operator so that non-specified types will have compile error!
+				for (const T& x : data)
+				{
+					(*this) << x;
+				}
+			}
+			else
+			{
+				// Fixed size types are written in one operation, the result is the same as writing them one by one:
+				_write_array<wire_type>(data.data(), data.size());
 			}
 			return *this;
 		}
 		inline Archive& operator<<(const wi::Archive& other)
 		{
-			// Here we will use the << operator so that non-specified types will have compile error!
 			//	Note: version and thumbnail data is skipped, only data is appended
+			assert(other.chunks_pending == 0);
 			const size_t start = sizeof(uint64_t) * 2; // version and thumbnail size
-			for (size_t i = start; i < other.pos; ++i)
+			if (other.pos > start)
 			{
-				(*this) << other.data_ptr[i];
+				_write_array<uint8_t>(other.data_ptr + start, other.pos - start);
 			}
 			return *this;
 		}
@@ -456,16 +532,25 @@ namespace wi
 			}
 			return *this;
 		}
-		template<typename T>
-		inline Archive& operator>>(wi::vector<T>& data)
+		template<typename T, typename A>
+		inline Archive& operator>>(wi::vector<T, A>& data)
 		{
-			// Here we will use the >> operator so that non-specified types will have compile error!
 			size_t count;
 			(*this) >> count;
 			data.resize(count);
-			for (size_t i = 0; i < count; ++i)
+			using wire_type = typename archive_internal::wire<T>::type;
+			if constexpr (std::is_void_v<wire_type>)
 			{
-				(*this) >> data[i];
+				// Here we will use the >> operator so that non-specified types will have compile error!
+				for (size_t i = 0; i < count; ++i)
+				{
+					(*this) >> data[i];
+				}
+			}
+			else
+			{
+				// Fixed size types are read in one operation, the result is the same as reading them one by one:
+				_read_array<wire_type>(data.data(), count);
 			}
 			return *this;
 		}
@@ -502,8 +587,74 @@ namespace wi
 			assert(readMode);
 			assert(data_ptr != nullptr);
 			assert(pos < data_ptr_size);
+			if (chunks_pending > 0)
+			{
+				DecompressChunks(pos, sizeof(data));
+			}
 			std::memcpy(&data, data_ptr + pos, sizeof(data));
 			pos += (size_t)(sizeof(data));
 		}
+
+		// Write an array of elements as an array of wire type W with a single size check
+		template<typename W, typename T>
+		inline void _write_array(const T* data, size_t count)
+		{
+			assert(!readMode);
+			assert(!DATA.empty());
+			if (count == 0)
+				return;
+			const size_t _right = pos + sizeof(W) * count;
+			if (_right > DATA.size())
+			{
+				DATA.resize(_right * 2);
+				data_ptr = DATA.data();
+				data_ptr_size = DATA.size();
+			}
+			uint8_t* dst = DATA.data() + pos;
+			if constexpr (std::is_same_v<W, T>)
+			{
+				std::memcpy(dst, data, sizeof(W) * count);
+			}
+			else
+			{
+				// The wire type is different (eg. int is written as int64_t), so convert one by one, but without the size checks:
+				for (size_t i = 0; i < count; ++i)
+				{
+					const W value = (W)data[i];
+					std::memcpy(dst + i * sizeof(W), &value, sizeof(W));
+				}
+			}
+			pos = _right;
+		}
+
+		// Read an array of elements that was written as an array of wire type W
+		template<typename W, typename T>
+		inline void _read_array(T* data, size_t count)
+		{
+			assert(readMode);
+			assert(data_ptr != nullptr);
+			if (count == 0)
+				return;
+			assert(pos + sizeof(W) * count <= data_ptr_size);
+			if (chunks_pending > 0)
+			{
+				DecompressChunks(pos, sizeof(W) * count);
+			}
+			const uint8_t* src = data_ptr + pos;
+			if constexpr (std::is_same_v<W, T>)
+			{
+				std::memcpy(data, src, sizeof(W) * count);
+			}
+			else
+			{
+				for (size_t i = 0; i < count; ++i)
+				{
+					W value;
+					std::memcpy(&value, src + i * sizeof(W), sizeof(W));
+					data[i] = (T)value;
+				}
+			}
+			pos += sizeof(W) * count;
+		}
 	};
 }
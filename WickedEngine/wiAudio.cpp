@@ -209,9 +209,10 @@ namespace wi::audio
 
 	struct SoundInternal
 	{
+		static constexpr wi::allocator::MemoryTag memory_tag = wi::allocator::MemoryTag::Audio;
 		wi::allocator::shared_ptr<AudioInternal> audio;
 		WAVEFORMATEX wfx = {};
-		wi::vector<uint8_t> audioData;
+		wi::allocator::tagged_vector<uint8_t, wi::allocator::MemoryTag::Audio> audioData;
 	};
 	struct SoundInstanceInternal final : public IXAudio2VoiceCallback
 	{
@@ -881,9 +882,10 @@ namespace wi::audio
 	}
 
 	struct SoundInternal{
+		static constexpr wi::allocator::MemoryTag memory_tag = wi::allocator::MemoryTag::Audio;
 		wi::allocator::shared_ptr<AudioInternal> audio;
 		FAudioWaveFormatEx wfx = {};
-		wi::vector<uint8_t> audioData;
+		wi::allocator::tagged_vector<uint8_t, wi::allocator::MemoryTag::Audio> audioData;
 	};
 	struct SoundInstanceInternal{
 		wi::allocator::shared_ptr<AudioInternal> audio;
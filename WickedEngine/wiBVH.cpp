@@ -0,0 +1,303 @@
+#include "wiBVH.h"
+#include "wiJobSystem.h"
+
+using namespace wi::primitive;
+
+namespace wi
+{
+	static constexpr uint32_t SAH_BIN_COUNT = 16;
+	static constexpr uint32_t SAH_MAX_LEAF_COUNT = 4; // a node with more items than this will be always split
+	static constexpr uint32_t SAH_PARALLEL_THRESHOLD = 4096; // subtrees with more items than this will be built on a separate job
+
+	void BVH::BuildSAH(const AABB* aabbs, uint32_t aabb_count)
+	{
+		node_count = 0;
+
+		if (aabb_count == 0)
+		{
+			nodes.clear();
+			leaf_indices.clear();
+			return;
+		}
+
+		nodes.resize(aabb_count * 2 - 1);
+		leaf_indices.resize(aabb_count);
+
+		// The split planes are chosen based on the leaf centers, they are precomputed once:
+		wi::vector<XMFLOAT3> centers(aabb_count);
+
+		Node& node = nodes[0];
+		node = {};
+		node.count = aabb_count;
+		for (uint32_t i = 0; i < aabb_count; ++i)
+		{
+			node.aabb = AABB::Merge(node.aabb, aabbs[i]);
+			leaf_indices[i] = i;
+			centers[i] = aabbs[i].getCenter();
+		}
+
+		std::atomic<uint32_t> allocator{ 1 };
+		wi::jobsystem::context ctx;
+		SubdivideSAH(0, aabbs, centers.data(), allocator, ctx);
+		wi::jobsystem::Wait(ctx);
+
+		node_count = allocator.load();
+	}
+
+	void BVH::SubdivideSAH(uint32_t nodeIndex, const AABB* leaf_aabb_data, const XMFLOAT3* centers, std::atomic<uint32_t>& allocator, wi::jobsystem::context& ctx)
+	{
+		Node& node = nodes[nodeIndex];
+		if (node.count <= 2)
+			return;
+
+		XMFLOAT3 center_min = XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX);
+		XMFLOAT3 center_max = XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+		for (uint32_t i = 0; i < node.count; ++i)
+		{
+			const XMFLOAT3& center = centers[leaf_indices[node.offset + i]];
+			center_min = wi::math::Min(center_min, center);
+			center_max = wi::math::Max(center_max, center);
+		}
+
+		// Fill the bins of every axis in a single pass over the items:
+		struct Bin
+		{
+			XMFLOAT3 _min = XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX);
+			XMFLOAT3 _max = XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+			uint32_t count = 0;
+		};
+		Bin bins[3][SAH_BIN_COUNT];
+		float scales[3] = {};
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			const float extent = ((const float*)&center_max)[axis] - ((const float*)&center_min)[axis];
+			scales[axis] = extent > 0 ? SAH_BIN_COUNT / extent : 0;
+		}
+		for (uint32_t i = 0; i < node.count; ++i)
+		{
+			const uint32_t index = leaf_indices[node.offset + i];
+			const AABB& aabb = leaf_aabb_data[index];
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				const float value = ((const float*)&centers[index])[axis] - ((const float*)&center_min)[axis];
+				Bin& bin = bins[axis][std::min(SAH_BIN_COUNT - 1, uint32_t(value * scales[axis]))];
+				bin._min = wi::math::Min(bin._min, aabb._min);
+				bin._max = wi::math::Max(bin._max, aabb._max);
+				bin.count++;
+			}
+		}
+
+		// Evaluate the SAH cost of the split planes between bins on every axis, keep the cheapest:
+		float best_cost = FLT_MAX;
+		int best_axis = -1;
+		uint32_t best_split = 0;
+		AABB best_left;
+		AABB best_right;
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			if (scales[axis] == 0)
+				continue;
+
+			// Sweep from both sides to gather the areas and counts of the split candidates:
+			Bin lefts[SAH_BIN_COUNT - 1];
+			Bin rights[SAH_BIN_COUNT - 1];
+			Bin left;
+			Bin right;
+			for (uint32_t i = 0; i < SAH_BIN_COUNT - 1; ++i)
+			{
+				const Bin& left_bin = bins[axis][i];
+				left.count += left_bin.count;
+				left._min = wi::math::Min(left._min, left_bin._min);
+				left._max = wi::math::Max(left._max, left_bin._max);
+				lefts[i] = left;
+
+				const Bin& right_bin = bins[axis][SAH_BIN_COUNT - 1 - i];
+				right.count += right_bin.count;
+				right._min = wi::math::Min(right._min, right_bin._min);
+				right._max = wi::math::Max(right._max, right_bin._max);
+				rights[SAH_BIN_COUNT - 2 - i] = right;
+			}
+			for (uint32_t i = 0; i < SAH_BIN_COUNT - 1; ++i)
+			{
+				if (lefts[i].count == 0 || rights[i].count == 0)
+					continue;
+				const AABB left_aabb = AABB(lefts[i]._min, lefts[i]._max);
+				const AABB right_aabb = AABB(rights[i]._min, rights[i]._max);
+				const float cost = lefts[i].count * SurfaceArea(left_aabb) + rights[i].count * SurfaceArea(right_aabb);
+				if (cost < best_cost)
+				{
+					best_cost = cost;
+					best_axis = axis;
+					best_split = i + 1; // bins below this go to the left side
+					best_left = left_aabb;
+					best_right = right_aabb;
+				}
+			}
+		}
+
+		int leftCount = 0;
+		bool bounds_known = false;
+		if (best_axis < 0)
+		{
+			// All centers are in the same position, there is no good split, so just halve the range if it's too big for a leaf:
+			if (node.count <= SAH_MAX_LEAF_COUNT)
+				return;
+			leftCount = int(node.count / 2);
+		}
+		else
+		{
+			// Splitting is not worth it if the leaf would be cheaper to intersect:
+			const float leaf_cost = node.count * SurfaceArea(node.aabb);
+			if (node.count <= SAH_MAX_LEAF_COUNT && best_cost >= leaf_cost)
+				return;
+
+			// in-place partition with the same bin mapping that was used in the cost evaluation:
+			const float bounds_min = ((const float*)&center_min)[best_axis];
+			const float scale = scales[best_axis];
+			int i = node.offset;
+			int j = i + node.count - 1;
+			while (i <= j)
+			{
+				const float value = ((const float*)&centers[leaf_indices[i]])[best_axis] - bounds_min;
+				const uint32_t bin = std::min(SAH_BIN_COUNT - 1, uint32_t(value * scale));
+				if (bin < best_split)
+				{
+					i++;
+				}
+				else
+				{
+					std::swap(leaf_indices[i], leaf_indices[j--]);
+				}
+			}
+			leftCount = i - node.offset;
+			if (leftCount == 0 || leftCount == (int)node.count)
+			{
+				leftCount = int(node.count / 2); // shouldn't happen because empty sides were not considered, but floating point precision can be tricky
+			}
+			else
+			{
+				bounds_known = true; // the partition matches the bins, so the child bounds are the ones that were evaluated
+			}
+		}
+
+		// create child nodes
+		const uint32_t left_child_index = allocator.fetch_add(2, std::memory_order_relaxed);
+		const uint32_t right_child_index = left_child_index + 1;
+		node.left = left_child_index;
+		nodes[left_child_index] = {};
+		nodes[left_child_index].offset = node.offset;
+		nodes[left_child_index].count = leftCount;
+		nodes[right_child_index] = {};
+		nodes[right_child_index].offset = node.offset + leftCount;
+		nodes[right_child_index].count = node.count - leftCount;
+		node.count = 0;
+		if (bounds_known)
+		{
+			nodes[left_child_index].aabb = best_left;
+			nodes[right_child_index].aabb = best_right;
+		}
+		else
+		{
+			UpdateNodeBounds(left_child_index, leaf_aabb_data);
+			UpdateNodeBounds(right_child_index, leaf_aabb_data);
+		}
+
+		// recurse, large right subtrees are handed to other threads:
+		if (nodes[right_child_index].count > SAH_PARALLEL_THRESHOLD)
+		{
+			wi::jobsystem::Execute(ctx, [this, right_child_index, leaf_aabb_data, centers, &allocator, &ctx](wi::jobsystem::JobArgs args) {
+				SubdivideSAH(right_child_index, leaf_aabb_data, centers, allocator, ctx);
+			});
+		}
+		else
+		{
+			SubdivideSAH(right_child_index, leaf_aabb_data, centers, allocator, ctx);
+		}
+		SubdivideSAH(left_child_index, leaf_aabb_data, centers, allocator, ctx);
+	}
+
+	void BVH::BuildWide()
+	{
+		wide_nodes.clear();
+		if (node_count == 0)
+			return;
+		wide_nodes.reserve(node_count / 2 + 1);
+		if (nodes[0].isLeaf())
+		{
+			// The wide root must be a node, so a single leaf tree is wrapped:
+			WideNode& root = wide_nodes.emplace_back();
+			root = {};
+			root.child[0] = nodes[0].offset;
+			root.count[0] = nodes[0].count;
+			root.min_x.x = nodes[0].aabb._min.x;
+			root.min_y.x = nodes[0].aabb._min.y;
+			root.min_z.x = nodes[0].aabb._min.z;
+			root.max_x.x = nodes[0].aabb._max.x;
+			root.max_y.x = nodes[0].aabb._max.y;
+			root.max_z.x = nodes[0].aabb._max.z;
+			root.child[1] = root.child[2] = root.child[3] = ~0u;
+			return;
+		}
+		CollapseWide(0);
+	}
+
+	uint32_t BVH::CollapseWide(uint32_t nodeIndex)
+	{
+		const uint32_t wideIndex = (uint32_t)wide_nodes.size();
+		wide_nodes.emplace_back();
+
+		// Pull up the grandchildren of the largest inner children until there are four children:
+		uint32_t children[4] = { nodes[nodeIndex].left, nodes[nodeIndex].left + 1 };
+		uint32_t child_count = 2;
+		while (child_count < arraysize(children))
+		{
+			int largest = -1;
+			float largest_area = -1;
+			for (uint32_t i = 0; i < child_count; ++i)
+			{
+				const Node& child = nodes[children[i]];
+				if (child.isLeaf())
+					continue;
+				const float area = SurfaceArea(child.aabb);
+				if (area > largest_area)
+				{
+					largest = int(i);
+					largest_area = area;
+				}
+			}
+			if (largest < 0)
+				break;
+			const uint32_t left = nodes[children[largest]].left;
+			children[largest] = left;
+			children[child_count++] = left + 1;
+		}
+
+		WideNode wide = {};
+		for (uint32_t i = 0; i < arraysize(children); ++i)
+		{
+			if (i >= child_count || !nodes[children[i]].aabb.IsValid())
+			{
+				wide.child[i] = ~0u;
+				continue;
+			}
+			const Node& child = nodes[children[i]];
+			((float*)&wide.min_x)[i] = child.aabb._min.x;
+			((float*)&wide.min_y)[i] = child.aabb._min.y;
+			((float*)&wide.min_z)[i] = child.aabb._min.z;
+			((float*)&wide.max_x)[i] = child.aabb._max.x;
+			((float*)&wide.max_y)[i] = child.aabb._max.y;
+			((float*)&wide.max_z)[i] = child.aabb._max.z;
+			if (child.isLeaf())
+			{
+				wide.child[i] = child.offset;
+				wide.count[i] = child.count;
+			}
+			else
+			{
+				wide.child[i] = CollapseWide(children[i]);
+			}
+		}
+		wide_nodes[wideIndex] = wide;
+		return wideIndex;
+	}
+}
@@ -1,6 +1,15 @@
 #pragma once
 #include "CommonInclude.h"
 #include "wiPrimitive.h"
+#include "wiVector.h"
+
+#include <atomic>
+#include <type_traits>
+
+namespace wi::jobsystem
+{
+	struct context;
+}
 
 namespace wi
 {
@@ -20,11 +29,42 @@ namespace wi
 		wi::vector<uint32_t> leaf_indices;
 		uint32_t node_count = 0;
 
+		// Optional collapsed 4-wide layout of the same tree, created by BuildWide()
+		//	The bounds of the four children are stored as SoA, so they are tested at once with SIMD (SSE or NEON)
+		//	The wide nodes reference the same leaf_indices as the binary nodes
+		struct alignas(16) WideNode
+		{
+			XMFLOAT4A min_x;
+			XMFLOAT4A min_y;
+			XMFLOAT4A min_z;
+			XMFLOAT4A max_x;
+			XMFLOAT4A max_y;
+			XMFLOAT4A max_z;
+			uint32_t child[4];	// index of child WideNode, or offset into leaf_indices if the child is a leaf, ~0u if the slot is empty
+			uint32_t count[4];	// number of leaf_indices if the child is a leaf, 0 otherwise
+		};
+		wi::vector<WideNode> wide_nodes;
+
 		constexpr bool IsValid() const { return node_count > 0; }
+		bool IsWide() const { return !wide_nodes.empty(); }
+
+		enum class BuildMode
+		{
+			Midpoint,	// Splits nodes in the middle of their longest axis, fastest build
+			SAH,		// Binned surface area heuristic, slower build but higher quality tree, large subtrees are built in parallel with the job system
+		};
 
 		// Completely rebuilds tree from scratch
-		void Build(const wi::primitive::AABB* aabbs, uint32_t aabb_count)
+		void Build(const wi::primitive::AABB* aabbs, uint32_t aabb_count, BuildMode mode = BuildMode::Midpoint)
 		{
+			wide_nodes.clear();
+
+			if (mode == BuildMode::SAH)
+			{
+				BuildSAH(aabbs, aabb_count);
+				return;
+			}
+
 			node_count = 0;
 
 			if (aabb_count == 0)
@@ -58,7 +98,7 @@ namespace wi
 			if (aabb_count != (uint32_t)leaf_indices.size())
 				return;
 
-			for (uint32_t i = node_count - 1; i > 0; --i)
+			for (uint32_t i = node_count; i-- > 0;) // children always come after their parents, so reverse order refits bottom-up, including the root
 			{
 				Node& node = nodes[i];
 				node.aabb = wi::primitive::AABB();
@@ -75,18 +115,38 @@ namespace wi
 					node.aabb = wi::primitive::AABB::Merge(node.aabb, nodes[node.left + 1].aabb);
 				}
 			}
+
+			if (IsWide())
+			{
+				BuildWide();
+			}
 		}
 
-		// Intersect with a primitive shape and return the closest hit
-		template <typename T>
+		// Creates the 4-wide layout from the binary tree, after this the ray, sphere and AABB queries will traverse the wide nodes
+		//	This is opt-in, because it needs additional memory. Build() discards it, Update() keeps it up to date
+		void BuildWide();
+
+		// Intersect with a primitive shape, callback is called for every leaf that intersects with it
+		template <typename T, typename F>
 		void Intersects(
 			const T& primitive,
 			uint32_t nodeIndex,
-			const std::function<void(uint32_t index)>& callback
+			F&& callback
 		) const
 		{
 			if (node_count == 0)
 				return;
+			if constexpr (IsWideSupported<T>())
+			{
+				if (nodeIndex == 0 && IsWide())
+				{
+					IntersectsWide(primitive, [&](uint32_t index, float& TMax) {
+						callback(index);
+						return false;
+					});
+					return;
+				}
+			}
 			const Node& node = nodes[nodeIndex];
 			if (!node.aabb.intersects(primitive))
 				return;
@@ -105,20 +165,29 @@ namespace wi
 		}
 
 		// Returning true from callback will immediately exit the whole search
-		template <typename T>
+		//	With the wide layout, rays visit the leaves in front-to-back order
+		template <typename T, typename F>
 		bool IntersectsFirst(
 			const T& primitive,
-			const std::function<bool(uint32_t index)>& callback
+			F&& callback
 		) const
 		{
 			if (node_count == 0)
 				return false;
-			uint32_t stack[64];
-			uint32_t count = 0;
-			stack[count++] = 0; // push node 0
-			while (count > 0 && (count < (arraysize(stack) - 1)))
+			if constexpr (IsWideSupported<T>())
 			{
-				const uint32_t nodeIndex = stack[--count];
+				if (IsWide())
+				{
+					return IntersectsWide(primitive, [&](uint32_t index, float& TMax) {
+						return callback(index);
+					});
+				}
+			}
+			TraversalStack<uint32_t> stack;
+			stack.push(0);
+			while (!stack.empty())
+			{
+				const uint32_t nodeIndex = stack.pop();
 				const Node& node = nodes[nodeIndex];
 				if (!node.aabb.intersects(primitive))
 					continue;
@@ -132,14 +201,302 @@ namespace wi
 				}
 				else
 				{
-					stack[count++] = node.left;
-					stack[count++] = node.left + 1;
+					stack.push(node.left);
+					stack.push(node.left + 1);
 				}
 			}
 			return false;
 		}
 
+		// Closest hit ray query: callback(uint32_t index, float& TMax) is called for the leaves that the ray enters before TMax
+		//	The callback can reduce TMax to the distance of a found hit, so that farther subtrees will be skipped
+		//	The distances are measured along ray.direction, so it should be normalized if TMax is compared against hit distances
+		//	Only the wide layout can skip subtrees by distance, the binary tree will just visit every intersecting leaf
+		template <typename F>
+		void IntersectsClosest(const wi::primitive::Ray& ray, F&& callback) const
+		{
+			if (node_count == 0)
+				return;
+			if (IsWide())
+			{
+				IntersectsWide(ray, [&](uint32_t index, float& TMax) {
+					callback(index, TMax);
+					return false;
+				});
+				return;
+			}
+			float TMax = ray.TMax;
+			Intersects(ray, 0, [&](uint32_t index) {
+				callback(index, TMax);
+			});
+		}
+
+		// Hierarchical frustum culling:
+		//	Subtrees fully outside the frustum are skipped, subtrees fully inside are accepted without testing their children
+		//	callback receives the leaf index, and whether it is known to be fully inside the frustum (inside = false means that the leaf's own AABB still needs to be tested)
+		template <typename F>
+		void IntersectsFrustum(const wi::primitive::Frustum& frustum, F&& callback) const
+		{
+			if (node_count == 0)
+				return;
+			struct Entry
+			{
+				uint32_t nodeIndex;
+				uint32_t planeMask;
+			};
+			Entry stack[64];
+			uint32_t count = 0;
+			stack[count++] = { 0, 0x3F };
+			while (count > 0)
+			{
+				const Entry entry = stack[--count];
+				const Node& node = nodes[entry.nodeIndex];
+				uint32_t planeMask = entry.planeMask;
+				const wi::primitive::Frustum::BoxFrustumIntersect result = frustum.CheckBoxMasked(node.aabb, planeMask);
+				if (result == wi::primitive::Frustum::BOX_FRUSTUM_OUTSIDE)
+					continue;
+				if (node.isLeaf() || result == wi::primitive::Frustum::BOX_FRUSTUM_INSIDE || count >= arraysize(stack) - 1)
+				{
+					// Note: if the stack is full, the whole subtree is returned for testing, this is conservative
+					uint32_t offset, leaf_count;
+					GetLeafRange(entry.nodeIndex, offset, leaf_count);
+					const bool inside = result == wi::primitive::Frustum::BOX_FRUSTUM_INSIDE;
+					for (uint32_t i = 0; i < leaf_count; ++i)
+					{
+						callback(leaf_indices[offset + i], inside);
+					}
+				}
+				else
+				{
+					stack[count++] = { node.left + 1, planeMask };
+					stack[count++] = { node.left, planeMask };
+				}
+			}
+		}
+
+		// Calls callback for every leaf in the nodes that intersect with the primitive (the leaves' own AABBs are not tested)
+		//	Unlike Intersects(), this is not recursive and doesn't use std::function
+		template <typename T, typename F>
+		void IntersectsLeaves(const T& primitive, F&& callback) const
+		{
+			if (node_count == 0)
+				return;
+			uint32_t stack[64];
+			uint32_t count = 0;
+			stack[count++] = 0;
+			while (count > 0)
+			{
+				const uint32_t nodeIndex = stack[--count];
+				const Node& node = nodes[nodeIndex];
+				if (!node.aabb.intersects(primitive))
+					continue;
+				if (node.isLeaf() || count >= arraysize(stack) - 1)
+				{
+					// Note: if the stack is full, the whole subtree is returned, this is conservative
+					uint32_t offset, leaf_count;
+					GetLeafRange(nodeIndex, offset, leaf_count);
+					for (uint32_t i = 0; i < leaf_count; ++i)
+					{
+						callback(leaf_indices[offset + i]);
+					}
+				}
+				else
+				{
+					stack[count++] = node.left + 1;
+					stack[count++] = node.left;
+				}
+			}
+		}
+
+		// Returns the range of leaf_indices that is contained by a node's subtree
+		void GetLeafRange(uint32_t nodeIndex, uint32_t& offset, uint32_t& count) const
+		{
+			// The leaves of a subtree are contiguous, because the tree was created by in-place partitioning:
+			offset = nodes[nodeIndex].offset;
+			while (!nodes[nodeIndex].isLeaf())
+			{
+				nodeIndex = nodes[nodeIndex].left + 1;
+			}
+			count = nodes[nodeIndex].offset + nodes[nodeIndex].count - offset;
+		}
+
+		// Returns the sum of node surface areas relative to the root's area, lower is better
+		//	This can be used to detect how much the tree degraded after Update() calls compared to the state after Build()
+		float GetCost() const
+		{
+			if (node_count == 0)
+				return 0;
+			const float root_area = SurfaceArea(nodes[0].aabb);
+			if (root_area <= 0)
+				return 0;
+			float area = 0;
+			for (uint32_t i = 0; i < node_count; ++i)
+			{
+				area += SurfaceArea(nodes[i].aabb);
+			}
+			return area / root_area;
+		}
+
+		static float SurfaceArea(const wi::primitive::AABB& aabb)
+		{
+			if (!aabb.IsValid())
+				return 0;
+			const XMFLOAT3 e = XMFLOAT3(aabb._max.x - aabb._min.x, aabb._max.y - aabb._min.y, aabb._max.z - aabb._min.z);
+			return 2 * (e.x * e.y + e.y * e.z + e.z * e.x);
+		}
+
 	private:
+		template <typename T>
+		static constexpr bool IsWideSupported()
+		{
+			return std::is_same_v<T, wi::primitive::Ray> || std::is_same_v<T, wi::primitive::Sphere> || std::is_same_v<T, wi::primitive::AABB>;
+		}
+
+		// Traversal stack in local memory, it only allocates from the heap if the tree is very deep
+		template <typename T>
+		struct TraversalStack
+		{
+			T local[64];
+			wi::vector<T> heap;
+			T* data = local;
+			uint32_t capacity = arraysize(local);
+			uint32_t count = 0;
+
+			TraversalStack() = default;
+			TraversalStack(const TraversalStack&) = delete;
+			TraversalStack& operator=(const TraversalStack&) = delete;
+
+			bool empty() const { return count == 0; }
+			T pop() { return data[--count]; }
+			void push(const T& item)
+			{
+				if (count == capacity)
+				{
+					if (heap.empty())
+					{
+						heap.assign(local, local + count);
+					}
+					capacity *= 2;
+					heap.resize(capacity);
+					data = heap.data();
+				}
+				data[count++] = item;
+			}
+		};
+
+		// Tests the four children of a wide node, returns the entry distances for rays (FLT_MAX if missed), or 0 (hit) / FLT_MAX (miss) for other shapes
+		static XMVECTOR XM_CALLCONV IntersectWideNode(const WideNode& node, const wi::primitive::Ray& ray, FXMVECTOR origin, FXMVECTOR direction_inverse, float TMax)
+		{
+			const XMVECTOR t1x = XMVectorMultiply(XMVectorSubtract(XMLoadFloat4A(&node.min_x), XMVectorSplatX(origin)), XMVectorSplatX(direction_inverse));
+			const XMVECTOR t2x = XMVectorMultiply(XMVectorSubtract(XMLoadFloat4A(&node.max_x), XMVectorSplatX(origin)), XMVectorSplatX(direction_inverse));
+			const XMVECTOR t1y = XMVectorMultiply(XMVectorSubtract(XMLoadFloat4A(&node.min_y), XMVectorSplatY(origin)), XMVectorSplatY(direction_inverse));
+			const XMVECTOR t2y = XMVectorMultiply(XMVectorSubtract(XMLoadFloat4A(&node.max_y), XMVectorSplatY(origin)), XMVectorSplatY(direction_inverse));
+			const XMVECTOR t1z = XMVectorMultiply(XMVectorSubtract(XMLoadFloat4A(&node.min_z), XMVectorSplatZ(origin)), XMVectorSplatZ(direction_inverse));
+			const XMVECTOR t2z = XMVectorMultiply(XMVectorSubtract(XMLoadFloat4A(&node.max_z), XMVectorSplatZ(origin)), XMVectorSplatZ(direction_inverse));
+			XMVECTOR tmin = XMVectorMax(XMVectorMax(XMVectorMin(t1x, t2x), XMVectorMin(t1y, t2y)), XMVectorMax(XMVectorMin(t1z, t2z), XMVectorReplicate(ray.TMin)));
+			XMVECTOR tmax = XMVectorMin(XMVectorMin(XMVectorMax(t1x, t2x), XMVectorMax(t1y, t2y)), XMVectorMin(XMVectorMax(t1z, t2z), XMVectorReplicate(TMax)));
+			return XMVectorSelect(XMVectorReplicate(FLT_MAX), tmin, XMVectorLessOrEqual(tmin, tmax));
+		}
+		static XMVECTOR XM_CALLCONV IntersectWideNode(const WideNode& node, const wi::primitive::Sphere& sphere, FXMVECTOR center, FXMVECTOR unused, float TMax)
+		{
+			// distance from the closest point of the boxes:
+			const XMVECTOR dx = XMVectorSubtract(XMVectorMax(XMVectorMin(XMVectorSplatX(center), XMLoadFloat4A(&node.max_x)), XMLoadFloat4A(&node.min_x)), XMVectorSplatX(center));
+			const XMVECTOR dy = XMVectorSubtract(XMVectorMax(XMVectorMin(XMVectorSplatY(center), XMLoadFloat4A(&node.max_y)), XMLoadFloat4A(&node.min_y)), XMVectorSplatY(center));
+			const XMVECTOR dz = XMVectorSubtract(XMVectorMax(XMVectorMin(XMVectorSplatZ(center), XMLoadFloat4A(&node.max_z)), XMLoadFloat4A(&node.min_z)), XMVectorSplatZ(center));
+			const XMVECTOR distanceSq = XMVectorMultiplyAdd(dx, dx, XMVectorMultiplyAdd(dy, dy, XMVectorMultiply(dz, dz)));
+			return XMVectorSelect(XMVectorReplicate(FLT_MAX), XMVectorZero(), XMVectorLessOrEqual(distanceSq, XMVectorReplicate(sphere.radius * sphere.radius)));
+		}
+		static XMVECTOR XM_CALLCONV IntersectWideNode(const WideNode& node, const wi::primitive::AABB& aabb, FXMVECTOR aabb_min, FXMVECTOR aabb_max, float TMax)
+		{
+			XMVECTOR overlap = XMVectorAndInt(XMVectorLessOrEqual(XMLoadFloat4A(&node.min_x), XMVectorSplatX(aabb_max)), XMVectorGreaterOrEqual(XMLoadFloat4A(&node.max_x), XMVectorSplatX(aabb_min)));
+			overlap = XMVectorAndInt(overlap, XMVectorAndInt(XMVectorLessOrEqual(XMLoadFloat4A(&node.min_y), XMVectorSplatY(aabb_max)), XMVectorGreaterOrEqual(XMLoadFloat4A(&node.max_y), XMVectorSplatY(aabb_min))));
+			overlap = XMVectorAndInt(overlap, XMVectorAndInt(XMVectorLessOrEqual(XMLoadFloat4A(&node.min_z), XMVectorSplatZ(aabb_max)), XMVectorGreaterOrEqual(XMLoadFloat4A(&node.max_z), XMVectorSplatZ(aabb_min))));
+			return XMVectorSelect(XMVectorReplicate(FLT_MAX), XMVectorZero(), overlap);
+		}
+
+		// Traverses the wide nodes, callback(uint32_t index, float& TMax) returns true to stop the traversal
+		//	Children are visited in order of their entry distance, for rays this means front-to-back order
+		template <typename T, typename F>
+		bool IntersectsWide(const T& primitive, F&& callback) const
+		{
+			XMVECTOR A;
+			XMVECTOR B;
+			float TMax = FLT_MAX;
+			if constexpr (std::is_same_v<T, wi::primitive::Ray>)
+			{
+				A = XMLoadFloat3(&primitive.origin);
+				B = XMLoadFloat3(&primitive.direction_inverse);
+				TMax = primitive.TMax;
+			}
+			else if constexpr (std::is_same_v<T, wi::primitive::Sphere>)
+			{
+				A = XMLoadFloat3(&primitive.center);
+				B = XMVectorZero();
+			}
+			else
+			{
+				if (!primitive.IsValid())
+					return false;
+				A = XMLoadFloat3(&primitive._min);
+				B = XMLoadFloat3(&primitive._max);
+			}
+
+			struct Entry
+			{
+				float distance;
+				uint32_t child;
+				uint32_t count;
+			};
+			TraversalStack<Entry> stack;
+			stack.push({ 0, 0, 0 });
+			while (!stack.empty())
+			{
+				const Entry entry = stack.pop();
+				if (entry.distance > TMax)
+					continue;
+				if (entry.count > 0)
+				{
+					for (uint32_t i = 0; i < entry.count; ++i)
+					{
+						if (callback(leaf_indices[entry.child + i], TMax))
+							return true;
+					}
+					continue;
+				}
+
+				const WideNode& node = wide_nodes[entry.child];
+				XMFLOAT4A distances;
+				XMStoreFloat4A(&distances, IntersectWideNode(node, primitive, A, B, TMax));
+
+				// Sort the hit children from far to near, so that the nearest will be popped first:
+				Entry hits[4];
+				uint32_t hit_count = 0;
+				for (uint32_t i = 0; i < 4; ++i)
+				{
+					const float distance = ((const float*)&distances)[i];
+					if (node.child[i] == ~0u || distance == FLT_MAX)
+						continue;
+					uint32_t j = hit_count++;
+					while (j > 0 && hits[j - 1].distance < distance)
+					{
+						hits[j] = hits[j - 1];
+						j--;
+					}
+					hits[j] = { distance, node.child[i], node.count[i] };
+				}
+				for (uint32_t i = 0; i < hit_count; ++i)
+				{
+					stack.push(hits[i]);
+				}
+			}
+			return false;
+		}
+
+		uint32_t CollapseWide(uint32_t nodeIndex);
+
+		void BuildSAH(const wi::primitive::AABB* aabbs, uint32_t aabb_count);
+		void SubdivideSAH(uint32_t nodeIndex, const wi::primitive::AABB* leaf_aabb_data, const XMFLOAT3* centers, std::atomic<uint32_t>& allocator, wi::jobsystem::context& ctx);
+
 		void UpdateNodeBounds(uint32_t nodeIndex, const wi::primitive::AABB* leaf_aabb_data)
 		{
 			Node& node = nodes[nodeIndex];
@@ -180,10 +180,8 @@ namespace wi::lua::backlog
 
 	void Bind()
 	{
-		static bool initialized = false;
-		if (!initialized)
+		if (wi::lua::BindOnce("backlog"))
 		{
-			initialized = true;
 			wi::lua::RegisterFunc("backlog_clear", backlog_clear);
 			wi::lua::RegisterFunc("backlog_post", backlog_post);
 			wi::lua::RegisterFunc("backlog_fontsize", backlog_fontsize);
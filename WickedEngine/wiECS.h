@@ -7,12 +7,16 @@
 #include "wiUnorderedSet.h"
 #include "wiVector.h"
 #include "wiAllocator.h"
+#include "wiSpinLock.h"
 
 #include <cstdint>
 #include <cassert>
 #include <atomic>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <tuple>
+#include <algorithm>
 
 // Entity-Component System
 namespace wi::ecs
@@ -24,11 +28,89 @@ namespace wi::ecs
 	//		this will ensure that entities still match with their components correctly after serialization
 	using Entity = uint64_t;
 	inline static constexpr Entity INVALID_ENTITY = 0;
+
+	// Generational entities: the entity is encoded as an index (low 32 bits) and a generation (high 32 bits)
+	//	DestroyEntity() recycles the index with an incremented generation, so a destroyed entity value is never returned again
+	//	This keeps the entity indices bounded by the number of live entities, which lets the lookup tables be flat arrays
+	//	If it's disabled, entities are just ever increasing numbers and DestroyEntity() does nothing
+#ifndef WI_ECS_GENERATIONAL_ENTITIES
+#define WI_ECS_GENERATIONAL_ENTITIES 1
+#endif // WI_ECS_GENERATIONAL_ENTITIES
+
+	constexpr uint32_t GetEntityIndex(Entity entity) { return uint32_t(entity & 0xFFFFFFFFull); }
+	constexpr uint32_t GetEntityGeneration(Entity entity) { return uint32_t(entity >> 32ull); }
+	constexpr Entity MakeEntity(uint32_t index, uint32_t generation) { return Entity(index) | (Entity(generation) << 32ull); }
+
+	// Allocates entity indices and keeps the free list of destroyed ones
+	struct EntityAllocator
+	{
+		std::atomic<uint32_t> next{ GetEntityIndex(INVALID_ENTITY) + 1 };
+		std::atomic<uint32_t> free_count{ 0 }; // allows skipping the lock when there is nothing to recycle
+		wi::SpinLock locker;
+		wi::vector<Entity> free_list; // destroyed entities with their generation already incremented
+		wi::vector<uint32_t> generations; // current generation of indices, only filled up to the largest destroyed index
+
+		inline Entity allocate()
+		{
+			if (free_count.load(std::memory_order_relaxed) > 0)
+			{
+				std::scoped_lock lck(locker);
+				if (!free_list.empty())
+				{
+					const Entity entity = free_list.back();
+					free_list.pop_back();
+					free_count.store(uint32_t(free_list.size()), std::memory_order_relaxed);
+					return entity;
+				}
+			}
+			const uint32_t index = next.fetch_add(1);
+			assert(index != 0); // ran out of entity indices
+			return MakeEntity(index, 0);
+		}
+		inline void free(Entity entity)
+		{
+			const uint32_t index = GetEntityIndex(entity);
+			const uint32_t generation = GetEntityGeneration(entity);
+			if (index == 0 || index >= next.load(std::memory_order_relaxed))
+				return; // not allocated by this
+			std::scoped_lock lck(locker);
+			if (generations.size() <= index)
+			{
+				generations.resize(size_t(index) + 1);
+			}
+			if (generations[index] != generation)
+				return; // already destroyed
+			if (generation == ~0u)
+				return; // the generation would wrap around, so the index is retired instead
+			generations[index] = generation + 1;
+			free_list.push_back(MakeEntity(index, generation + 1));
+			free_count.store(uint32_t(free_list.size()), std::memory_order_relaxed);
+		}
+	};
+	inline EntityAllocator& GetEntityAllocator()
+	{
+		static EntityAllocator allocator;
+		return allocator;
+	}
+
 	// Runtime can create a new entity with this
 	inline Entity CreateEntity()
 	{
+#if WI_ECS_GENERATIONAL_ENTITIES
+		return GetEntityAllocator().allocate();
+#else
 		static std::atomic<Entity> next{ INVALID_ENTITY + 1 };
 		return next.fetch_add(1);
+#endif // WI_ECS_GENERATIONAL_ENTITIES
+	}
+	// Runtime can destroy an entity with this when it's no longer used anywhere, which allows to reuse its index for a new entity
+	//	The entity should have no components left in any ComponentManager, they are not removed by this
+	//	The destroyed entity value will not be returned by CreateEntity() again, and it will not match the new entity of the same index
+	inline void DestroyEntity(Entity entity)
+	{
+#if WI_ECS_GENERATIONAL_ENTITIES
+		GetEntityAllocator().free(entity);
+#endif // WI_ECS_GENERATIONAL_ENTITIES
 	}
 	inline static constexpr size_t INVALID_INDEX = ~0ull;
 
@@ -113,6 +195,404 @@ namespace wi::ecs
 		}
 	}
 
+	// Lookup table implementations for entity -> index resolving in the ComponentManager
+	namespace lookup
+	{
+		// All lookup tables implement:
+		//	clear(), erase(entity), insert(entity, index), get(entity)
+		//	get_other_generation(entity) : returns the index that is stored for an other generation of the entity's index, or INVALID_INDEX
+		//		Tables that are indexed by the entity index can only store one generation of it at a time
+
+		// Straight lookup with memory wasting implementation:
+		// Matches Entity to index with storing every possible entity index in memory up to the max stored entity index
+		// Fastest lookup but wastes memory storing every possible entity index that was encountered before
+		// !Use it only for performance testing of minimal lookup overhead!
+		struct Straight
+		{
+			struct Item
+			{
+				uint32_t generation = 0;
+				size_t index = INVALID_INDEX;
+			};
+			wi::vector<Item> table;
+
+			inline void clear()
+			{
+				table.clear();
+			}
+			inline void erase(Entity entity)
+			{
+				const uint32_t entity_index = GetEntityIndex(entity);
+				if (table.size() <= entity_index || table[entity_index].generation != GetEntityGeneration(entity))
+					return;
+				table[entity_index].index = INVALID_INDEX;
+			}
+			inline void insert(Entity entity, size_t index)
+			{
+				const uint32_t entity_index = GetEntityIndex(entity);
+				if (table.size() <= entity_index)
+					table.resize(size_t(entity_index) + 1);
+				table[entity_index].generation = GetEntityGeneration(entity);
+				table[entity_index].index = index;
+			}
+			inline size_t get(Entity entity) const
+			{
+				const uint32_t entity_index = GetEntityIndex(entity);
+				if (table.size() <= entity_index || table[entity_index].generation != GetEntityGeneration(entity))
+					return INVALID_INDEX;
+				return table[entity_index].index;
+			}
+			inline size_t get_other_generation(Entity entity) const
+			{
+				const uint32_t entity_index = GetEntityIndex(entity);
+				if (table.size() <= entity_index || table[entity_index].generation == GetEntityGeneration(entity))
+					return INVALID_INDEX;
+				return table[entity_index].index;
+			}
+		};
+
+		// Straight lookup sparse memory manager:
+		// Similar to straight as it stores a direct mapping of entity index -> index, but unused ranges of entities will not waste as much memory
+		// The lookup is slowed by the extra block data indirection
+		// Without generational entities, the entity indices just increase forever and there is no guarantee that the minmax range doesn't get huge
+		struct Sparse
+		{
+			struct BlockData
+			{
+				struct Item
+				{
+					uint32_t generation = 0;
+					size_t index = INVALID_INDEX;
+				};
+				Item items[64];
+			};
+			struct BlockL1 // stores 64 contiguous entity indices
+			{
+				uint64_t status = 0; // one bit per item in block, if it's 0 then block can be freed and reused
+				BlockData* block_data = nullptr;
+			};
+			struct BlockL2
+			{
+				uint64_t status = 0; // bitmask of active L1 blocks
+				BlockL1 blocks_l1[64];
+			};
+			wi::vector<BlockL2*> blocks_l2;
+			wi::allocator::BlockAllocator<BlockData, 8> block_allocator; // block allocator manages memory per 8 blocks here (sizeof(BlockData) * 8 = 4 KB pages)
+			wi::allocator::BlockAllocator<BlockL2, 4> block_allocator_l2;
+
+			inline void clear()
+			{
+				blocks_l2.clear();
+				block_allocator = {};
+				block_allocator_l2 = {};
+			}
+			inline void erase(Entity entity)
+			{
+				const uint32_t entity_index = GetEntityIndex(entity);
+				const uint64_t block_index_l2 = entity_index >> 12ull; // entity_index / (64 * 64)
+				if (blocks_l2.size() <= block_index_l2)
+					return;
+
+				BlockL2* block_l2 = blocks_l2[block_index_l2];
+				if (block_l2 == nullptr)
+					return;
+
+				const uint64_t block_index_l1 = (entity_index >> 6ull) & 63ull; // (entity_index / 64) % 64
+				BlockL1& block = block_l2->blocks_l1[block_index_l1];
+				const uint64_t item_index = entity_index & 63ull; // entity_index % 64
+				if ((block.status & (1ull << item_index)) == 0 || block.block_data->items[item_index].generation != GetEntityGeneration(entity))
+					return;
+				block.block_data->items[item_index].index = INVALID_INDEX;
+				block.status &= ~(1ull << item_index);
+				if (block.status == 0)
+				{
+					// Free the block data for reuse:
+					block_allocator.free(block.block_data);
+					block.block_data = nullptr;
+
+					block_l2->status &= ~(1ull << block_index_l1);
+					if (block_l2->status == 0)
+					{
+						block_allocator_l2.free(block_l2);
+						blocks_l2[block_index_l2] = nullptr;
+					}
+				}
+			}
+			inline void insert(Entity entity, size_t index)
+			{
+				const uint32_t entity_index = GetEntityIndex(entity);
+				const uint64_t block_index_l2 = entity_index >> 12ull; // entity_index / (64 * 64)
+				if (blocks_l2.size() <= block_index_l2)
+				{
+					// Allocate new block:
+					blocks_l2.resize(block_index_l2 + 1);
+				}
+				if (blocks_l2[block_index_l2] == nullptr)
+				{
+					blocks_l2[block_index_l2] = block_allocator_l2.allocate();
+				}
+				BlockL2* block_l2 = blocks_l2[block_index_l2];
+
+				const uint64_t block_index_l1 = (entity_index >> 6ull) & 63ull; // (entity_index / 64) % 64
+				BlockL1& block = block_l2->blocks_l1[block_index_l1];
+				if (block.block_data == nullptr)
+				{
+					block.block_data = block_allocator.allocate();
+				}
+				const uint64_t item_index = entity_index & 63ull; // entity_index % 64
+				block.status |= 1ull << item_index;
+				block.block_data->items[item_index].generation = GetEntityGeneration(entity);
+				block.block_data->items[item_index].index = index;
+
+				block_l2->status |= 1ull << block_index_l1;
+			}
+			inline const BlockData::Item* get_item(Entity entity) const
+			{
+				const uint32_t entity_index = GetEntityIndex(entity);
+				const uint64_t block_index_l2 = entity_index >> 12ull; // entity_index / (64 * 64)
+				if (blocks_l2.size() > block_index_l2)
+				{
+					const BlockL2* block_l2 = blocks_l2[block_index_l2];
+					if (block_l2 != nullptr)
+					{
+						const uint64_t block_index_l1 = (entity_index >> 6ull) & 63ull; // (entity_index / 64) % 64
+						const BlockL1& block = block_l2->blocks_l1[block_index_l1];
+						const uint64_t item_index = entity_index & 63ull; // entity_index % 64
+						if (block.status & (1ull << item_index))
+						{
+							return &block.block_data->items[item_index];
+						}
+					}
+				}
+				return nullptr;
+			}
+			inline size_t get(Entity entity) const
+			{
+				const BlockData::Item* item = get_item(entity);
+				if (item == nullptr || item->generation != GetEntityGeneration(entity))
+					return INVALID_INDEX;
+				return item->index;
+			}
+			inline size_t get_other_generation(Entity entity) const
+			{
+				const BlockData::Item* item = get_item(entity);
+				if (item == nullptr || item->generation == GetEntityGeneration(entity))
+					return INVALID_INDEX;
+				return item->index;
+			}
+		};
+
+		// Implementation with hash table:
+		// Compared to standard hashing, this one hashes per 64-item bucket, resulting in less hashed entries
+		struct BucketHash
+		{
+			struct Block
+			{
+				uint64_t status = 0; // one bit per item in block, if it's 0 then whole block can be freed
+				struct Item
+				{
+					size_t index = INVALID_INDEX;
+				};
+				Item items[64];
+			};
+			wi::unordered_map<uint64_t, Block> table;
+
+			inline void clear()
+			{
+				table.clear();
+			}
+			inline void erase(Entity entity)
+			{
+				const uint64_t block_index = entity >> 6ull; // entity / 64
+				auto it = table.find(block_index);
+				if (it == table.end())
+					return;
+				Block& block = it->second;
+				if (block.status)
+				{
+					const uint64_t item_index = entity & 63ull; // entity % 64
+					block.items[item_index].index = INVALID_INDEX;
+					block.status &= ~(1ull << item_index);
+					if (block.status == 0)
+					{
+						// Free the block from hash table:
+						table.erase(block_index);
+					}
+				}
+			}
+			inline void insert(Entity entity, size_t index)
+			{
+				const uint64_t block_index = entity >> 6ull; // entity / 64
+				const uint64_t item_index = entity & 63ull; // entity % 64
+				Block& block = table[block_index];
+				block.status |= 1ull << item_index;
+				block.items[item_index].index = index;
+			}
+			inline size_t get(Entity entity) const
+			{
+				const uint64_t block_index = entity >> 6ull; // entity / 64
+				const auto it = table.find(block_index);
+				if (it == table.end())
+					return INVALID_INDEX;
+				const Block& block = it->second;
+				const uint64_t item_index = entity & 63ull; // entity % 64
+				return block.items[item_index].index;
+			}
+			inline size_t get_other_generation(Entity entity) const
+			{
+				return INVALID_INDEX; // the full entity value is hashed, so generations don't share items
+			}
+		};
+
+		// Implementation with hash table:
+		// The standard hashing method, performance depends on hashing, hash collisions
+		struct Hash
+		{
+			wi::unordered_map<Entity, size_t> table;
+
+			inline void clear()
+			{
+				table.clear();
+			}
+			inline void erase(Entity entity)
+			{
+				table.erase(entity);
+			}
+			inline void insert(Entity entity, size_t index)
+			{
+				table[entity] = index;
+			}
+			inline size_t get(Entity entity) const
+			{
+				if (table.empty())
+					return INVALID_INDEX;
+				auto it = table.find(entity);
+				if (it == table.end())
+					return INVALID_INDEX;
+				return it->second;
+			}
+			inline size_t get_other_generation(Entity entity) const
+			{
+				return INVALID_INDEX; // the full entity value is hashed, so generations don't share items
+			}
+		};
+		// Sparse set implementation:
+		// Paged array indexed directly by the entity index, the generation is stored next to the component index to reject stale entities
+		// The index range is only bounded by the number of live entities if the entities are released with DestroyEntity(), so their indices are recycled
+		//	The engine doesn't destroy the entities that it removes (for example Scene::Entity_Remove() doesn't, because undo and serialization can still refer to them),
+		//	so this should only be selected where the application releases entities itself, otherwise BucketHash uses less memory
+		// Pages are allocated only for index ranges that contain components and they are freed when they become empty
+		struct SparseSet
+		{
+			static constexpr uint32_t page_shift = 10; // 1024 items per page
+			static constexpr uint32_t page_mask = (1u << page_shift) - 1;
+			struct Page
+			{
+				uint32_t count = 0; // number of valid items, if it's 0 then the page can be freed
+				struct Item
+				{
+					uint32_t generation = 0;
+					uint32_t index = ~0u;
+				};
+				Item items[1u << page_shift];
+			};
+			wi::vector<std::unique_ptr<Page>> pages;
+
+			inline void clear()
+			{
+				pages.clear();
+			}
+			inline void erase(Entity entity)
+			{
+				const uint32_t entity_index = GetEntityIndex(entity);
+				const uint32_t page_index = entity_index >> page_shift;
+				if (pages.size() <= page_index || pages[page_index] == nullptr)
+					return;
+				Page& page = *pages[page_index];
+				Page::Item& item = page.items[entity_index & page_mask];
+				if (item.index == ~0u || item.generation != GetEntityGeneration(entity))
+					return;
+				item.index = ~0u;
+				page.count--;
+				if (page.count == 0)
+				{
+					pages[page_index] = nullptr;
+				}
+			}
+			inline void insert(Entity entity, size_t index)
+			{
+				assert(index < ~0u);
+				const uint32_t entity_index = GetEntityIndex(entity);
+				const uint32_t page_index = entity_index >> page_shift;
+				if (pages.size() <= page_index)
+				{
+					pages.resize(page_index + 1);
+				}
+				if (pages[page_index] == nullptr)
+				{
+					pages[page_index] = std::make_unique<Page>();
+				}
+				Page& page = *pages[page_index];
+				Page::Item& item = page.items[entity_index & page_mask];
+				if (item.index == ~0u)
+				{
+					page.count++;
+				}
+				else
+				{
+					assert(item.generation == GetEntityGeneration(entity)); // ComponentManager removes the component of an other generation before inserting, see get_other_generation()
+				}
+				item.generation = GetEntityGeneration(entity);
+				item.index = uint32_t(index);
+			}
+			inline size_t get(Entity entity) const
+			{
+				const uint32_t entity_index = GetEntityIndex(entity);
+				const uint32_t page_index = entity_index >> page_shift;
+				if (pages.size() <= page_index || pages[page_index] == nullptr)
+					return INVALID_INDEX;
+				const Page::Item& item = pages[page_index]->items[entity_index & page_mask];
+				if (item.index == ~0u || item.generation != GetEntityGeneration(entity))
+					return INVALID_INDEX;
+				return item.index;
+			}
+			inline size_t get_other_generation(Entity entity) const
+			{
+				const uint32_t entity_index = GetEntityIndex(entity);
+				const uint32_t page_index = entity_index >> page_shift;
+				if (pages.size() <= page_index || pages[page_index] == nullptr)
+					return INVALID_INDEX;
+				const Page::Item& item = pages[page_index]->items[entity_index & page_mask];
+				if (item.index == ~0u || item.generation == GetEntityGeneration(entity))
+					return INVALID_INDEX;
+				return item.index;
+			}
+		};
+	}
+
+//#define LOOKUP_STRAIGHT
+//#define LOOKUP_SPARSE
+//#define LOOKUP_BUCKET_HASH
+//#define LOOKUP_HASH
+//#define LOOKUP_SPARSE_SET
+
+#if !defined(LOOKUP_STRAIGHT) && !defined(LOOKUP_SPARSE) && !defined(LOOKUP_BUCKET_HASH) && !defined(LOOKUP_HASH) && !defined(LOOKUP_SPARSE_SET)
+#define LOOKUP_BUCKET_HASH
+#endif // LOOKUP_*
+
+	// The lookup table that ComponentManager uses by default, the others can be still chosen per ComponentManager with its template parameter
+#if defined(LOOKUP_STRAIGHT)
+	using DefaultLookupTable = lookup::Straight;
+#elif defined(LOOKUP_SPARSE)
+	using DefaultLookupTable = lookup::Sparse;
+#elif defined(LOOKUP_BUCKET_HASH)
+	using DefaultLookupTable = lookup::BucketHash;
+#elif defined(LOOKUP_HASH)
+	using DefaultLookupTable = lookup::Hash;
+#elif defined(LOOKUP_SPARSE_SET)
+	using DefaultLookupTable = lookup::SparseSet;
+#endif // LOOKUP_*
+
 	// This is an interface class to implement a ComponentManager,
 	// inherit this class if you want to work with ComponentLibrary
 	class ComponentManager_Interface
@@ -134,13 +614,24 @@ namespace wi::ecs
 		virtual const wi::vector<Entity>& GetEntityArray() const = 0;
 	};
 
+	// A contiguous range of component indices, returned by the change tracking queries of ComponentManager
+	struct IndexRange
+	{
+		size_t offset = 0;
+		size_t count = 0;
+	};
+
 	// The ComponentManager is a container that stores components and matches them with entities
 	//	Note: final keyword is used to indicate this is a final implementation.
 	//	This allows function inlining and avoid calls, improves performance considerably
-	template<typename Component>
+	//	LookupTable : the entity -> index lookup implementation, see the wi::ecs::lookup namespace
+	template<typename Component, typename LookupTable = DefaultLookupTable>
 	class ComponentManager final : public ComponentManager_Interface
 	{
 	public:
+		// Component storage is accounted with the memory tag of the component type, or as Scene memory by default
+		static constexpr wi::allocator::MemoryTag memory_tag = wi::allocator::memory_tag_v<Component> == wi::allocator::MemoryTag::Untagged ? wi::allocator::MemoryTag::Scene : wi::allocator::memory_tag_v<Component>;
+		using ComponentArray = wi::allocator::tagged_vector<Component, memory_tag>;
 
 		// reservedCount : how much components can be held initially before growing the container
 		ComponentManager(size_t reservedCount = 0)
@@ -160,28 +651,34 @@ namespace wi::ecs
 			components.clear();
 			entities.clear();
 			lookup.clear();
+			change_versions.clear();
+			structure_version++;
 		}
 
 		// Perform deep copy of all the contents of "other" into this
-		inline void Copy(const ComponentManager<Component>& other)
+		inline void Copy(const ComponentManager& other)
 		{
+			structure_version++;
 			components.reserve(GetCount() + other.GetCount());
 			entities.reserve(GetCount() + other.GetCount());
 			for (size_t i = 0; i < other.GetCount(); ++i)
 			{
 				Entity entity = other.entities[i];
 				assert(!Contains(entity));
+				RemoveOtherGeneration(entity);
 				entities.push_back(entity);
 				lookup.insert(entity, components.size());
 				components.push_back(other.components[i]);
 			}
+			MarkChanged(components.size() - other.GetCount(), other.GetCount());
 		}
 
 		// Merge in an other component manager of the same type to this.
 		//	The other component manager MUST NOT contain any of the same entities!
 		//	The other component manager is not retained after this operation!
-		inline void Merge(ComponentManager<Component>& other)
+		inline void Merge(ComponentManager& other)
 		{
+			structure_version++;
 			components.reserve(GetCount() + other.GetCount());
 			entities.reserve(GetCount() + other.GetCount());
 
@@ -189,22 +686,24 @@ namespace wi::ecs
 			{
 				Entity entity = other.entities[i];
 				assert(!Contains(entity));
+				RemoveOtherGeneration(entity);
 				entities.push_back(entity);
 				lookup.insert(entity, components.size());
 				components.push_back(std::move(other.components[i]));
 			}
+			MarkChanged(components.size() - other.GetCount(), other.GetCount());
 
 			other.Clear();
 		}
 
 		inline void Copy(const ComponentManager_Interface& other)
 		{
-			Copy((ComponentManager<Component>&)other);
+			Copy((const ComponentManager&)other);
 		}
 
 		inline void Merge(ComponentManager_Interface& other)
 		{
-			Merge((ComponentManager<Component>&)other);
+			Merge((ComponentManager&)other);
 		}
 
 		// Read/Write everything to an archive depending on the archive state
@@ -212,6 +711,7 @@ namespace wi::ecs
 		{
 			if (archive.IsReadMode())
 			{
+				structure_version++;
 				const size_t prev_count = components.size();
 
 				size_t count;
@@ -224,14 +724,43 @@ namespace wi::ecs
 				}
 
 				entities.resize(prev_count + count);
+				bool other_generation_found = false;
 				for (size_t i = 0; i < count; ++i)
 				{
 					// assign value to make GCC happy
 					Entity entity = INVALID_ENTITY;
 					SerializeEntity(archive, entity, seri);
 					entities[prev_count + i] = entity;
-					lookup.insert(entity, prev_count + i);
+					other_generation_found |= lookup.get_other_generation(entity) != INVALID_INDEX;
 				}
+				if (other_generation_found)
+				{
+					// Rare case: the new items are taken out and added one by one after removing the components of the other generations
+					ComponentArray new_components;
+					new_components.reserve(count);
+					for (size_t i = 0; i < count; ++i)
+					{
+						new_components.push_back(std::move(components[prev_count + i]));
+					}
+					wi::vector<Entity> new_entities(entities.begin() + prev_count, entities.end());
+					components.resize(prev_count);
+					entities.resize(prev_count);
+					for (size_t i = 0; i < count; ++i)
+					{
+						RemoveOtherGeneration(new_entities[i]);
+						lookup.insert(new_entities[i], components.size());
+						entities.push_back(new_entities[i]);
+						components.push_back(std::move(new_components[i]));
+					}
+				}
+				else
+				{
+					for (size_t i = 0; i < count; ++i)
+					{
+						lookup.insert(entities[prev_count + i], prev_count + i);
+					}
+				}
+				MarkChanged(components.size() - count, count);
 			}
 			else
 			{
@@ -287,8 +816,11 @@ namespace wi::ecs
 			// Entity count must always be the same as the number of components!
 			assert(entities.size() == components.size());
 
+			RemoveOtherGeneration(entity);
+
 			// Update the entity lookup table:
 			lookup.insert(entity, components.size());
+			structure_version++;
 
 			// New components are always pushed to the end:
 			components.emplace_back();
@@ -296,6 +828,8 @@ namespace wi::ecs
 			// Also push corresponding entity:
 			entities.push_back(entity);
 
+			MarkChanged(components.size() - 1, 1);
+
 			return components.back();
 		}
 
@@ -305,6 +839,7 @@ namespace wi::ecs
 			const size_t index = GetIndex(entity);
 			if (index != INVALID_INDEX)
 			{
+				structure_version++;
 				if (index < components.size() - 1)
 				{
 					// Swap out the dead element with the last one:
@@ -319,6 +854,9 @@ namespace wi::ecs
 				components.pop_back();
 				entities.pop_back();
 				lookup.erase(entity);
+
+				// The last element was moved into the removed one's place:
+				MarkChanged(index, index < components.size() ? 1 : 0);
 			}
 		}
 
@@ -328,6 +866,7 @@ namespace wi::ecs
 			const size_t index = GetIndex(entity);
 			if (index != INVALID_INDEX)
 			{
+				structure_version++;
 				if (index < components.size() - 1)
 				{
 					// Move every component left by one that is after this element:
@@ -347,6 +886,9 @@ namespace wi::ecs
 				components.pop_back();
 				entities.pop_back();
 				lookup.erase(entity);
+
+				// Everything after the removed element was moved:
+				MarkChanged(index, components.size() - index);
 			}
 		}
 
@@ -359,6 +901,7 @@ namespace wi::ecs
 			{
 				return;
 			}
+			structure_version++;
 
 			// Save the moved component and entity:
 			Component component = std::move(components[index_from]);
@@ -378,6 +921,8 @@ namespace wi::ecs
 			components[index_to] = std::move(component);
 			entities[index_to] = entity;
 			lookup.insert(entity, index_to);
+
+			MarkChanged(std::min(index_from, index_to), (index_from < index_to ? index_to - index_from : index_from - index_to) + 1);
 		}
 
 		// Check if a component exists for a given entity or not
@@ -387,6 +932,7 @@ namespace wi::ecs
 		}
 
 		// Retrieve a [read/write] component specified by an entity (if it exists, otherwise nullptr)
+		//	Note: this doesn't mark the component as changed even if change tracking is enabled, use MarkDirty() after modifying it
 		inline Component* GetComponent(Entity entity)
 		{
 			const size_t index = GetIndex(entity);
@@ -419,6 +965,7 @@ namespace wi::ecs
 
 		// Directly index a specific [read/write] component without indirection
 		//	0 <= index < GetCount()
+		//	Note: this doesn't mark the component as changed even if change tracking is enabled, use MarkIndexDirty() after modifying it
 		inline Component& operator[](size_t index) { return components[index]; }
 
 		// Directly index a specific [read only] component without indirection
@@ -429,258 +976,284 @@ namespace wi::ecs
 		inline const wi::vector<Entity>& GetEntityArray() const { return entities; }
 
 		// Returns the tightly packed [read only] component array
-		inline const wi::vector<Component>& GetComponentArray() const { return components; }
+		inline const ComponentArray& GetComponentArray() const { return components; }
 
 		// Returns the raw data pointer of components:
 		inline const Component* GetData() const { return components.data(); }
 		inline Component* GetData() { return components.data(); }
 
-	private:
-		// This is a linear array of alive components
-		wi::vector<Component> components;
-		// This is a linear array of entities corresponding to each alive component
-		wi::vector<Entity> entities;
-
-//#define LOOKUP_STRAIGHT
-//#define LOOKUP_SPARSE
-#define LOOKUP_BUCKET_HASH
-//#define LOOKUP_HASH
+		// Returns a number that changes whenever components are created, removed or reordered
+		//	This can be used to detect when cached component indices become invalid
+		inline uint64_t GetStructureVersion() const { return structure_version; }
 
-		// This is a lookup table for entity -> index resolving
-		struct LookupTable
+		// Change tracking stamps every component with the current change version when it is created, moved or marked with MarkDirty()
+		//	It is disabled by default. When enabled, every existing component is considered changed
+		//	Marking different components dirty from multiple threads is safe, but not concurrently with creation or removal
+		inline void SetChangeTrackingEnabled(bool value)
 		{
-
-#ifdef LOOKUP_STRAIGHT
-			// Straight lookup with memory wasting implementation:
-			// Matches Entity to index with storing every possible Entity in memory up to the max stored entity index
-			// Fastest lookup but wastes memory storing every possible entity index that was encountered before
-			// !Use it only for performance testing of minimal lookup overhead!
-			struct Item
-			{
-				size_t index = INVALID_INDEX;
-			};
-			wi::vector<Item> table;
-
-			inline void clear()
-			{
-				table.clear();
-			}
-			inline void erase(Entity entity)
+			change_tracking = value;
+			change_versions.clear();
+			if (change_tracking)
 			{
-				table[entity].index = INVALID_INDEX;
+				change_versions.resize(components.size(), change_version);
 			}
-			inline void insert(Entity entity, size_t index)
+		}
+		inline bool IsChangeTrackingEnabled() const { return change_tracking; }
+
+		// Mark a component as changed with the current change version (does nothing if change tracking is disabled)
+		inline void MarkDirty(Entity entity)
+		{
+			const size_t index = GetIndex(entity);
+			if (index != INVALID_INDEX)
 			{
-				if (table.size() <= entity)
-					table.resize(entity + 1);
-				table[entity].index = index;
+				MarkIndexDirty(index);
 			}
-			inline size_t get(Entity entity) const
+		}
+		// Same as MarkDirty(), but the component is specified by its index
+		//	0 <= index < GetCount()
+		inline void MarkIndexDirty(size_t index)
+		{
+			if (change_tracking)
 			{
-				if (table.size() <= entity)
-					return INVALID_INDEX;
-				return table[entity].index;
+				change_versions[index] = change_version;
 			}
-#endif // LOOKUP_NAIVE
+		}
 
-#ifdef LOOKUP_SPARSE
-			// Straight lookup sparse memory manager:
-			// Similar to straight as it stores a direct mapping of entity -> index, but unused ranges of entities will not waste as much memory
-			// The lookup is slowed by the extra block data indirection
-			// The problem is still that entity indices just increase forever and no guarantee that the minmax range doesn't get huge
-			struct BlockData
-			{
-				struct Item
-				{
-					size_t index = INVALID_INDEX;
-				};
-				Item items[64];
-			};
-			struct BlockL1 // stores 64 contiguous entity indices
-			{
-				uint64_t status = 0; // one bit per item in block, if it's 0 then block can be freed and reused
-				BlockData* block_data = nullptr;
-			};
-			struct BlockL2
-			{
-				uint64_t status = 0; // bitmask of active L1 blocks
-				BlockL1 blocks_l1[64];
-			};
-			wi::vector<BlockL2*> blocks_l2;
-			wi::allocator::BlockAllocator<BlockData, 8> block_allocator; // block allocator manages memory per 8 blocks here (sizeof(BlockData) * 8 = 4 KB pages)
-			wi::allocator::BlockAllocator<BlockL2, 4> block_allocator_l2;
+		// The current change version that components are stamped with, this starts from 1
+		inline uint64_t GetChangeVersion() const { return change_version; }
 
-			inline void clear()
-			{
-				blocks_l2.clear();
-				block_allocator = {};
-				block_allocator_l2 = {};
-			}
-			inline void erase(Entity entity)
-			{
-				const uint64_t block_index_l2 = entity >> 12ull; // entity / (64 * 64)
-				if (blocks_l2.size() <= block_index_l2)
-					return;
+		// Starts a new change version and returns it, the usual place to call this is at the beginning of a frame
+		//	Consumers of the changes can remember the change version when they processed the components, and query changes after it later
+		inline uint64_t AdvanceChangeVersion() { return ++change_version; }
 
-				BlockL2* block_l2 = blocks_l2[block_index_l2];
-				if (block_l2 == nullptr)
-					return;
+		// Returns whether the component was changed after the specified change version
+		//	If change tracking is disabled, every component is reported as changed
+		inline bool IsChanged(size_t index, uint64_t version) const
+		{
+			return !change_tracking || change_versions[index] > version;
+		}
 
-				const uint64_t block_index_l1 = (entity >> 6ull) & 63ull; // (entity / 64) % 64
-				BlockL1& block = block_l2->blocks_l1[block_index_l1];
-				const uint64_t item_index = entity & 63ull; // entity % 64
-				block.block_data->items[item_index].index = INVALID_INDEX;
-				block.status &= ~(1ull << item_index);
-				if (block.status == 0)
+		// Gathers the index ranges of components that were changed after the specified change version into ranges
+		//	max_gap	: changed ranges that are separated by at most this many unchanged components are merged together
+		//	If change tracking is disabled, the whole container is reported as one changed range
+		//	returns the number of components covered by the ranges
+		inline size_t GetChangedRanges(uint64_t version, wi::vector<IndexRange>& ranges, size_t max_gap = 0) const
+		{
+			ranges.clear();
+			if (!change_tracking)
+			{
+				if (!components.empty())
 				{
-					// Free the block data for reuse:
-					block_allocator.free(block.block_data);
-					block.block_data = nullptr;
-
-					block_l2->status &= ~(1ull << block_index_l1);
-					if (block_l2->status == 0)
-					{
-						block_allocator_l2.free(block_l2);
-						blocks_l2[block_index_l2] = nullptr;
-					}
+					ranges.push_back({ 0, components.size() });
 				}
+				return components.size();
 			}
-			inline void insert(Entity entity, size_t index)
+			size_t total = 0;
+			for (size_t i = 0; i < change_versions.size(); ++i)
 			{
-				const uint64_t block_index_l2 = entity >> 12ull; // entity / (64 * 64)
-				if (blocks_l2.size() <= block_index_l2)
+				if (change_versions[i] <= version)
+					continue;
+				if (!ranges.empty() && ranges.back().offset + ranges.back().count + max_gap >= i)
 				{
-					// Allocate new block:
-					blocks_l2.resize(block_index_l2 + 1);
+					total += i + 1 - (ranges.back().offset + ranges.back().count);
+					ranges.back().count = i + 1 - ranges.back().offset;
 				}
-				if (blocks_l2[block_index_l2] == nullptr)
+				else
 				{
-					blocks_l2[block_index_l2] = block_allocator_l2.allocate();
+					ranges.push_back({ i, 1 });
+					total++;
 				}
-				BlockL2* block_l2 = blocks_l2[block_index_l2];
+			}
+			return total;
+		}
 
-				const uint64_t block_index_l1 = (entity >> 6ull) & 63ull; // (entity / 64) % 64
-				BlockL1& block = block_l2->blocks_l1[block_index_l1];
-				if (block.block_data == nullptr)
-				{
-					block.block_data = block_allocator.allocate();
-				}
-				const uint64_t item_index = entity & 63ull; // entity % 64
-				block.status |= 1ull << item_index;
-				block.block_data->items[item_index].index = index;
+	private:
+		// This is a linear array of alive components
+		ComponentArray components;
+		// This is a linear array of entities corresponding to each alive component
+		wi::vector<Entity> entities;
 
-				block_l2->status |= 1ull << block_index_l1;
-			}
-			inline size_t get(Entity entity) const
+		// This is a lookup table for entity -> index resolving
+		LookupTable lookup;
+		// Incremented by every operation that changes the entity -> index mapping
+		uint64_t structure_version = 0;
+
+		// Change tracking state, change_versions is only filled when tracking is enabled:
+		bool change_tracking = false;
+		uint64_t change_version = 1;
+		wi::vector<uint64_t> change_versions;
+
+		// If an other generation of the entity's index still has a component (DestroyEntity() was called without removing its components), it is removed
+		//	Lookup tables that are indexed by the entity index can only store one generation, and the component of a destroyed entity is not reachable anymore
+		inline void RemoveOtherGeneration(Entity entity)
+		{
+			const size_t index = lookup.get_other_generation(entity);
+			if (index != INVALID_INDEX)
 			{
-				const uint64_t block_index_l2 = entity >> 12ull; // entity / (64 * 64)
-				if (blocks_l2.size() > block_index_l2)
-				{
-					const BlockL2* block_l2 = blocks_l2[block_index_l2];
-					if (block_l2 != nullptr)
-					{
-						const uint64_t block_index_l1 = (entity >> 6ull) & 63ull; // (entity / 64) % 64
-						const BlockL1& block = block_l2->blocks_l1[block_index_l1];
-						if (block.status)
-						{
-							const uint64_t item_index = entity & 63ull; // entity % 64
-							return block.block_data->items[item_index].index;
-						}
-					}
-				}
-				return INVALID_INDEX;
+				Remove(entities[index]);
 			}
-#endif // LOOKUP_SPARSE
+		}
 
-#ifdef LOOKUP_BUCKET_HASH
-			// Implementation with hash table:
-			// Compared to standard hashing, this one hashes per 64-item bucket, resulting in less hashed entries
-			struct Block
-			{
-				uint64_t status = 0; // one bit per item in block, if it's 0 then whole block can be freed
-				struct Item
-				{
-					size_t index = INVALID_INDEX;
-				};
-				Item items[64];
-			};
-			wi::unordered_map<uint64_t, Block> table;
+		// Resizes the change versions to the component count and stamps the specified range with the current change version
+		inline void MarkChanged(size_t offset, size_t count)
+		{
+			if (!change_tracking)
+				return;
+			change_versions.resize(components.size());
+			std::fill(change_versions.begin() + offset, change_versions.begin() + offset + count, change_version);
+		}
 
-			inline void clear()
-			{
-				table.clear();
-			}
-			inline void erase(Entity entity)
+		// Disallow this to be copied by mistake
+		ComponentManager(const ComponentManager&) = delete;
+	};
+
+	// Marks a component of a View that is not required, the view will provide it as a pointer that is nullptr if the entity doesn't have it
+	template<typename Component>
+	struct Optional {};
+
+	template<typename T>
+	struct ViewTraits
+	{
+		using Component = T;
+		static constexpr bool optional = false;
+	};
+	template<typename T>
+	struct ViewTraits<Optional<T>>
+	{
+		using Component = T;
+		static constexpr bool optional = true;
+	};
+
+	// The View joins multiple ComponentManagers by entity
+	//	It contains the entities that have all of the non-optional components, in the same order as the first ComponentManager
+	//	The join is made by iterating the smallest non-optional ComponentManager and looking up the entities in the others
+	//	The resolved component indices are cached, they are only rebuilt when any of the ComponentManagers changes its structure
+	//	Components are given to the iteration functions as references, or pointers for the Optional<> ones
+	//	The first component must not be Optional
+	template<typename... Components>
+	class View
+	{
+	public:
+		static constexpr size_t component_count = sizeof...(Components);
+		static_assert(component_count > 0);
+		static_assert(!ViewTraits<std::tuple_element_t<0, std::tuple<Components...>>>::optional, "The first component of a View must not be optional!");
+
+		View(ComponentManager<typename ViewTraits<Components>::Component>&... managers) : managers(&managers...) {}
+
+		// Rebuild the cached join if any of the ComponentManagers changed its structure since the last time
+		//	The iteration functions call this automatically
+		inline void Update()
+		{
+			Update(std::index_sequence_for<Components...>());
+		}
+
+		// Retrieve the number of joined entities, valid after Update()
+		inline size_t GetCount() const { return rows.size(); }
+
+		// Retrieve the entity of a joined row
+		//	0 <= i < GetCount()
+		inline Entity GetEntity(size_t i) const { return rows[i].entity; }
+
+		// Retrieve the component index of a joined row in the ComponentManager I (INVALID_INDEX for a missing optional component)
+		//	0 <= i < GetCount()
+		template<size_t I>
+		inline size_t GetIndex(size_t i) const { return rows[i].indices[I]; }
+
+		// Retrieve the component of a joined row from the ComponentManager I
+		//	Returns reference for a required component, pointer for an optional component
+		//	0 <= i < GetCount()
+		template<size_t I>
+		inline decltype(auto) Get(size_t i) const
+		{
+			using Traits = ViewTraits<std::tuple_element_t<I, std::tuple<Components...>>>;
+			auto& manager = *std::get<I>(managers);
+			const size_t index = rows[i].indices[I];
+			if constexpr (Traits::optional)
 			{
-				const uint64_t block_index = entity >> 6ull; // entity / 64
-				auto it = table.find(block_index);
-				if (it == table.end())
-					return;
-				Block& block = it->second;
-				if (block.status)
-				{
-					const uint64_t item_index = entity & 63ull; // entity % 64
-					block.items[item_index].index = INVALID_INDEX;
-					block.status &= ~(1ull << item_index);
-					if (block.status == 0)
-					{
-						// Free the block from hash table:
-						table.erase(block_index);
-					}
-				}
+				return index == INVALID_INDEX ? nullptr : &manager[index];
 			}
-			inline void insert(Entity entity, size_t index)
+			else
 			{
-				const uint64_t block_index = entity >> 6ull; // entity / 64
-				const uint64_t item_index = entity & 63ull; // entity % 64
-				Block& block = table[block_index];
-				block.status |= 1ull << item_index;
-				block.items[item_index].index = index;
+				return manager[index];
 			}
-			inline size_t get(Entity entity) const
+		}
+
+		// Iterate all joined entities on the calling thread
+		//	func : void(Entity entity, Components&/Components*...)
+		template<typename F>
+		inline void ForEach(F&& func)
+		{
+			Update();
+			for (size_t i = 0; i < rows.size(); ++i)
 			{
-				const uint64_t block_index = entity >> 6ull; // entity / 64
-				const auto it = table.find(block_index);
-				if (it == table.end())
-					return INVALID_INDEX;
-				const Block& block = it->second;
-				const uint64_t item_index = entity & 63ull; // entity % 64
-				return block.items[item_index].index;
+				Invoke(func, i, std::index_sequence_for<Components...>());
 			}
-#endif // LOOKUP_BUCKET_HASH
+		}
 
-#ifdef LOOKUP_HASH
-			// Implementation with hash table:
-			// The standard hashing method, performance depends on hashing, hash collisions
-			wi::unordered_map<Entity, size_t> table;
+		// Iterate all joined entities with the job system, similarly to wi::jobsystem::Dispatch()
+		//	func : void(Entity entity, Components&/Components*...), it will be called from multiple threads
+		//	The iteration is finished when the context is waited on
+		template<typename F>
+		inline void Dispatch(wi::jobsystem::context& ctx, uint32_t groupSize, F&& func)
+		{
+			Update();
+			wi::jobsystem::Dispatch(ctx, (uint32_t)rows.size(), groupSize, [this, func](wi::jobsystem::JobArgs args) {
+				Invoke(func, args.jobIndex, std::index_sequence_for<Components...>());
+			});
+		}
 
-			inline void clear()
-			{
-				table.clear();
-			}
-			inline void erase(Entity entity)
-			{
-				table.erase(entity);
-			}
-			inline void insert(Entity entity, size_t index)
+	private:
+		std::tuple<ComponentManager<typename ViewTraits<Components>::Component>*...> managers;
+		uint64_t structure_versions[component_count] = {};
+		bool valid = false;
+		struct Row
+		{
+			Entity entity;
+			size_t indices[component_count];
+		};
+		wi::vector<Row> rows;
+
+		template<typename F, size_t... I>
+		inline void Invoke(const F& func, size_t i, std::index_sequence<I...>) const
+		{
+			func(rows[i].entity, Get<I>(i)...);
+		}
+
+		template<size_t... I>
+		inline void Update(std::index_sequence<I...>)
+		{
+			const uint64_t versions[] = { std::get<I>(managers)->GetStructureVersion()... };
+			if (valid && std::equal(std::begin(versions), std::end(versions), std::begin(structure_versions)))
+				return;
+			std::copy(std::begin(versions), std::end(versions), std::begin(structure_versions));
+			valid = true;
+
+			// The smallest non-optional component manager limits the result, so that is iterated:
+			const size_t counts[] = { ViewTraits<Components>::optional ? ~0ull : std::get<I>(managers)->GetCount()... };
+			const size_t smallest = size_t(std::min_element(std::begin(counts), std::end(counts)) - std::begin(counts));
+			const wi::vector<Entity>* candidates = nullptr;
+			((candidates = I == smallest ? &std::get<I>(managers)->GetEntityArray() : candidates), ...);
+
+			rows.clear();
+			for (Entity entity : *candidates)
 			{
-				table[entity] = index;
+				Row row;
+				row.entity = entity;
+				const bool joined = (((row.indices[I] = std::get<I>(managers)->GetIndex(entity)) != INVALID_INDEX || ViewTraits<Components>::optional) && ...);
+				if (joined)
+				{
+					rows.push_back(row);
+				}
 			}
-			inline size_t get(Entity entity) const
+
+			if (smallest != 0)
 			{
-				if (table.empty())
-					return INVALID_INDEX;
-				auto it = table.find(entity);
-				if (it == table.end())
-					return INVALID_INDEX;
-				return it->second;
+				// Keep the order of the first component manager:
+				std::sort(rows.begin(), rows.end(), [](const Row& a, const Row& b) {
+					return a.indices[0] < b.indices[0];
+				});
 			}
-#endif // LOOKUP_HASH
-
-		} lookup;
-
-		// Disallow this to be copied by mistake
-		ComponentManager(const ComponentManager&) = delete;
+		}
 	};
 
 	// This is the class to store all component managers,
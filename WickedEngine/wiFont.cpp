@@ -10,6 +10,7 @@
 #include "wiPlatform.h"
 #include "wiEventHandler.h"
 #include "wiTimer.h"
+#include "wiJobSystem.h"
 #include "wiUnorderedMap.h"
 #include "wiUnorderedSet.h"
 #include "wiVector.h"
@@ -20,6 +21,8 @@
 
 #include <fstream>
 #include <mutex>
+#include <atomic>
+#include <string_view>
 
 using namespace wi::enums;
 using namespace wi::graphics;
@@ -52,6 +55,12 @@ namespace wi::font
 			wi::vector<uint8_t> fontBuffer; // only used if loaded from file, need to keep alive
 			stbtt_fontinfo fontInfo;
 			int ascent, descent, lineGap;
+
+			// The kerning pairs of the kern table are precomputed, because stbtt would search the table for every character pair
+			//	GPOS kerning is class based, that is still evaluated by stbtt, but with the glyph indices that are stored in the glyphs
+			wi::unordered_map<uint32_t, int> kerning_table; // (glyph1 << 16) | glyph2 -> advance (unscaled)
+			bool kerning_gpos = false;
+
 			void Create(const std::string& newName, const uint8_t* data, size_t size)
 			{
 				name = newName;
@@ -63,6 +72,36 @@ namespace wi::font
 				}
 
 				stbtt_GetFontVMetrics(&fontInfo, &ascent, &descent, &lineGap);
+
+				kerning_table.clear();
+				kerning_gpos = fontInfo.gpos != 0; // stbtt ignores the kern table if there is GPOS
+				if (!kerning_gpos)
+				{
+					const int count = stbtt_GetKerningTableLength(&fontInfo);
+					if (count > 0)
+					{
+						wi::vector<stbtt_kerningentry> entries(count);
+						stbtt_GetKerningTable(&fontInfo, entries.data(), count);
+						kerning_table.reserve(count);
+						for (auto& entry : entries)
+						{
+							kerning_table[(uint32_t(entry.glyph1) << 16u) | uint32_t(entry.glyph2 & 0xFFFF)] = entry.advance;
+						}
+					}
+				}
+			}
+			constexpr bool HasKerning() const
+			{
+				return kerning_gpos || !kerning_table.empty();
+			}
+			int GetKerning(int glyph1, int glyph2) const
+			{
+				if (kerning_gpos)
+					return stbtt_GetGlyphKernAdvance(&fontInfo, glyph1, glyph2);
+				auto it = kerning_table.find((uint32_t(glyph1) << 16u) | uint32_t(glyph2 & 0xFFFF));
+				if (it == kerning_table.end())
+					return 0;
+				return it->second;
 			}
 			void Create(const std::string& newName)
 			{
@@ -88,10 +127,12 @@ namespace wi::font
 			float tc_right;
 			float tc_top;
 			float tc_bottom;
+			float advance; // horizontal advance, scaled to the glyph's height
+			float scale; // font scaling of the glyph's height, for kerning
+			int glyphIndex;
 			const FontStyle* fontStyle = nullptr;
 		};
 		static wi::unordered_map<int32_t, Glyph> glyph_lookup;
-		static wi::unordered_map<int32_t, wi::rectpacker::Rect> rect_lookup;
 		struct Bitmap
 		{
 			int width;
@@ -100,7 +141,73 @@ namespace wi::font
 			int yoff;
 			wi::vector<uint8_t> data;
 		};
-		static wi::unordered_map<int32_t, Bitmap> bitmap_lookup;
+
+		// The atlas is packed incrementally, new glyphs are placed into the remaining free space without moving the existing ones
+		//	When it runs out of space, it grows and the previous content is kept in the top-left corner
+		struct Atlas
+		{
+			static constexpr int min_size = 512;
+			static constexpr int max_size = 4096;
+
+			stbrp_context context = {};
+			wi::vector<stbrp_node> nodes;
+			wi::allocator::tagged_vector<uint8_t, wi::allocator::MemoryTag::TextureCPU> bitmap; // CPU-side copy of the atlas texture, dirty regions are uploaded from this
+			int width = 0;
+			int height = 0;
+
+			void clear()
+			{
+				width = 0;
+				height = 0;
+				bitmap.clear();
+			}
+
+			// Doubles the smaller dimension and restarts packing with the old area reserved
+			//	returns false if the atlas can't grow anymore
+			bool grow()
+			{
+				const int prev_width = width;
+				const int prev_height = height;
+				int new_width = std::max(min_size, width);
+				int new_height = std::max(min_size, height);
+				if (prev_width > 0)
+				{
+					if (new_height < new_width)
+					{
+						new_height *= 2;
+					}
+					else
+					{
+						new_width *= 2;
+					}
+				}
+				if (new_width > max_size || new_height > max_size)
+					return false;
+
+				nodes.resize(new_width);
+				stbrp_init_target(&context, new_width, new_height, nodes.data(), int(nodes.size()));
+				if (prev_width > 0)
+				{
+					// The first rect of an empty target is placed at the origin:
+					stbrp_rect reserved = {};
+					reserved.w = prev_width;
+					reserved.h = prev_height;
+					stbrp_pack_rects(&context, &reserved, 1);
+					assert(reserved.was_packed && reserved.x == 0 && reserved.y == 0);
+				}
+
+				decltype(bitmap) new_bitmap(size_t(new_width) * size_t(new_height));
+				for (int row = 0; row < prev_height; ++row)
+				{
+					std::memcpy(new_bitmap.data() + row * new_width, bitmap.data() + row * prev_width, prev_width);
+				}
+				std::swap(bitmap, new_bitmap);
+				width = new_width;
+				height = new_height;
+				return true;
+			}
+		};
+		static Atlas atlas;
 		union GlyphHash
 		{
 			struct
@@ -114,7 +221,11 @@ namespace wi::font
 		};
 		static_assert(sizeof(GlyphHash) == sizeof(uint32_t));
 		static wi::unordered_set<uint32_t> pendingGlyphs;
+		static wi::unordered_set<uint32_t> failedGlyphs; // glyphs that didn't fit into the largest atlas, they are not rasterized again until the atlas is invalidated
 		static std::mutex locker;
+		static std::atomic<uint64_t> atlas_generation{ 0 }; // incremented when glyph placements change, which invalidates the cached layouts
+		static uint64_t atlas_invalidation = 0; // incremented by InvalidateAtlas(), protected by locker
+		static std::atomic<uint64_t> frame_counter{ 0 };
 
 		struct ParseStatus
 		{
@@ -122,10 +233,12 @@ namespace wi::font
 			uint32_t quadCount = 0;
 			size_t last_word_begin = 0;
 			bool start_new_word = false;
+			bool complete = true; // false if some glyphs were not available yet
 		};
 
 		static thread_local wi::vector<FontVertex> vertexList;
-		ParseStatus ParseText(const wchar_t* text, size_t text_length, const Params& params)
+		static thread_local const wi::vector<FontVertex>* parsedVertices = &vertexList; // either vertexList or a cached layout
+		ParseStatus LayoutText(const wchar_t* text, size_t text_length, const Params& params)
 		{
 			ParseStatus status;
 			status.cursor = params.cursor;
@@ -154,21 +267,27 @@ namespace wi::font
 				}
 			};
 
+			GlyphHash hash;
+			hash.bits.height = params.size;
+			hash.bits.style = (uint32_t)params.style;
+			hash.bits.sdf = params.isSDFRenderingEnabled() ? 1 : 0;
+
 			status.cursor.size.y = status.cursor.position.y + linebreak_size;
 			for (size_t i = 0; i < text_length; ++i)
 			{
 				int code = (int)text[i];
-				GlyphHash hash;
 				hash.bits.code = text[i];
-				hash.bits.height = params.size;
-				hash.bits.style = (uint32_t)params.style;
-				hash.bits.sdf = params.isSDFRenderingEnabled() ? 1 : 0;
 
-				if (glyph_lookup.count(hash.raw) == 0)
+				auto it = glyph_lookup.find(hash.raw);
+				if (it == glyph_lookup.end())
 				{
 					// glyph not packed yet, so add to pending list:
 					std::scoped_lock lck(locker);
-					pendingGlyphs.insert(hash.raw);
+					if (failedGlyphs.count(hash.raw) == 0)
+					{
+						pendingGlyphs.insert(hash.raw);
+						status.complete = false;
+					}
 					continue;
 				}
 
@@ -193,12 +312,11 @@ namespace wi::font
 				}
 				else
 				{
-					const Glyph& glyph = glyph_lookup.at(hash.raw);
+					const Glyph& glyph = it->second;
 					const float glyphWidth = glyph.width;
 					const float glyphHeight = glyph.height;
 					const float glyphOffsetX = glyph.x;
 					const float glyphOffsetY = glyph.y;
-					const float fontScale = stbtt_ScaleForPixelHeight(&glyph.fontStyle->fontInfo, (float)params.size);
 
 					const size_t vertexID = size_t(status.quadCount) * 4;
 					vertexList.resize(vertexID + 4);
@@ -237,17 +355,22 @@ namespace wi::font
 					vertexList[vertexID + 2].uv = float2(tc_left, tc_bottom);
 					vertexList[vertexID + 3].uv = float2(tc_right, tc_bottom);
 
-					int advance, lsb;
-					stbtt_GetCodepointHMetrics(&glyph.fontStyle->fontInfo, code, &advance, &lsb);
-					status.cursor.position.x += advance * fontScale;
+					status.cursor.position.x += glyph.advance;
 
 					status.cursor.position.x += params.spacingX;
 
-					if (text_length > 1 && i < text_length - 1 && text[i + 1])
+					if (text_length > 1 && i < text_length - 1 && text[i + 1] && glyph.fontStyle->HasKerning())
 					{
+						// The next glyph's index is taken from the glyph cache if it's from the same font, otherwise it needs to be searched in this font:
 						int code_next = (int)text[i + 1];
-						int kern = stbtt_GetCodepointKernAdvance(&glyph.fontStyle->fontInfo, code, code_next);
-						status.cursor.position.x += kern * fontScale;
+						GlyphHash hash_next = hash;
+						hash_next.bits.code = code_next;
+						auto it_next = glyph_lookup.find(hash_next.raw);
+						const int glyphIndex_next = it_next != glyph_lookup.end() && it_next->second.fontStyle == glyph.fontStyle ?
+							it_next->second.glyphIndex :
+							stbtt_FindGlyphIndex(&glyph.fontStyle->fontInfo, code_next);
+						int kern = glyph.fontStyle->GetKerning(glyph.glyphIndex, glyphIndex_next);
+						status.cursor.position.x += kern * glyph.scale;
 					}
 				}
 
@@ -262,17 +385,110 @@ namespace wi::font
 
 		thread_local static std::string char_temp_buffer;
 		thread_local static std::wstring wchar_temp_buffer;
-		ParseStatus ParseText(const char* text, size_t text_length, const Params& params)
+		ParseStatus LayoutText(const char* text, size_t text_length, const Params& params)
 		{
 			// the temp buffers are used to avoid allocations of string objects:
 			char_temp_buffer = text;
 			wi::helper::StringConvert(char_temp_buffer, wchar_temp_buffer);
-			return ParseText(wchar_temp_buffer.c_str(), wchar_temp_buffer.length(), params);
+			return LayoutText(wchar_temp_buffer.c_str(), wchar_temp_buffer.length(), params);
+		}
+
+		// The finished layouts are cached, so drawing or measuring unchanged text only needs a lookup
+		//	Only the parameters that change glyph placement are part of the key, the rest are applied at draw time
+		struct LayoutKey
+		{
+			int size = 0;
+			int style = 0;
+			float spacingX = 0;
+			float spacingY = 0;
+			float h_wrap = 0;
+			Cursor cursor;
+			uint32_t flags = 0;
+			uint32_t char_size = 0;
+		};
+		struct LayoutCacheEntry
+		{
+			LayoutKey key;
+			std::string text; // raw bytes of the text, to rule out hash collisions
+			ParseStatus status;
+			wi::vector<FontVertex> vertices;
+			uint64_t generation = 0;
+			uint64_t last_used_frame = 0;
+		};
+		static constexpr uint64_t LAYOUT_CACHE_MAX_UNUSED_FRAMES = 60;
+		struct LayoutCache
+		{
+			wi::unordered_map<size_t, LayoutCacheEntry> entries;
+			uint64_t last_cleanup_frame = 0;
+		};
+		static thread_local LayoutCache layout_cache; // per thread, so it doesn't need locking
+
+		template<typename T>
+		ParseStatus ParseText(const T* text, size_t text_length, const Params& params)
+		{
+			LayoutKey key;
+			key.size = params.size;
+			key.style = params.style;
+			key.spacingX = params.spacingX;
+			key.spacingY = params.spacingY;
+			key.h_wrap = params.h_wrap;
+			key.cursor = params.cursor;
+			key.flags = params._flags & (Params::SDF_RENDERING | Params::FLIP_HORIZONTAL | Params::FLIP_VERTICAL);
+			key.char_size = sizeof(T);
+			static_assert(sizeof(LayoutKey) == sizeof(int) * 2 + sizeof(float) * 3 + sizeof(Cursor) + sizeof(uint32_t) * 2); // no padding, memcmp is used
+
+			const std::string_view bytes((const char*)text, text_length * sizeof(T));
+			size_t hash = std::hash<std::string_view>{}(bytes);
+			wi::helper::hash_combine(hash, std::hash<std::string_view>{}(std::string_view((const char*)&key, sizeof(key))));
+
+			const uint64_t frame = frame_counter.load(std::memory_order_relaxed);
+			const uint64_t generation = atlas_generation.load(std::memory_order_relaxed);
+			if (frame - layout_cache.last_cleanup_frame > LAYOUT_CACHE_MAX_UNUSED_FRAMES)
+			{
+				layout_cache.last_cleanup_frame = frame;
+				for (auto it = layout_cache.entries.begin(); it != layout_cache.entries.end();)
+				{
+					if (frame - it->second.last_used_frame > LAYOUT_CACHE_MAX_UNUSED_FRAMES || it->second.generation != generation)
+					{
+						it = layout_cache.entries.erase(it);
+					}
+					else
+					{
+						++it;
+					}
+				}
+			}
+
+			auto it = layout_cache.entries.find(hash);
+			if (it != layout_cache.entries.end())
+			{
+				LayoutCacheEntry& entry = it->second;
+				if (entry.generation == generation && std::memcmp(&entry.key, &key, sizeof(key)) == 0 && entry.text == bytes)
+				{
+					entry.last_used_frame = frame;
+					parsedVertices = &entry.vertices;
+					return entry.status;
+				}
+			}
+
+			ParseStatus status = LayoutText(text, text_length, params);
+			parsedVertices = &vertexList;
+			if (status.complete)
+			{
+				LayoutCacheEntry& entry = layout_cache.entries[hash];
+				entry.key = key;
+				entry.text = bytes;
+				entry.status = status;
+				entry.vertices = vertexList;
+				entry.generation = generation;
+				entry.last_used_frame = frame;
+			}
+			return status;
 		}
 
 		void CommitText(void* vertexList_GPU)
 		{
-			std::memcpy(vertexList_GPU, vertexList.data(), sizeof(FontVertex) * vertexList.size());
+			std::memcpy(vertexList_GPU, parsedVertices->data(), sizeof(FontVertex) * parsedVertices->size());
 		}
 
 	}
@@ -349,14 +565,17 @@ namespace wi::font
 
 	void InvalidateAtlas()
 	{
+		atlas_generation.fetch_add(1);
+		atlas_invalidation++;
 		texture = {};
 		glyph_lookup.clear();
-		rect_lookup.clear();
-		bitmap_lookup.clear();
+		failedGlyphs.clear();
+		atlas.clear();
 	}
 	void UpdateAtlas(float upscaling)
 	{
-		std::scoped_lock lck(locker);
+		std::unique_lock lck(locker);
+		frame_counter.fetch_add(1, std::memory_order_relaxed);
 
 		upscaling = std::max(1.5f, upscaling); // add some minimum upscaling, especially for SDF
 		static float upscaling_prev = 1;
@@ -369,34 +588,51 @@ namespace wi::font
 			upscaling_prev = upscaling;
 		}
 
-		// If there are pending glyphs, render them and repack the atlas:
+		// If there are pending glyphs, render them and pack them into the atlas:
 		if (!pendingGlyphs.empty())
 		{
-			for (int32_t raw : pendingGlyphs)
+			// The lock is not held while rasterizing, because Wait() can execute other jobs on this thread, which could parse text and lock it again
+			//	The pending glyphs and the font styles are copied for the jobs instead:
+			wi::vector<uint32_t> pending(pendingGlyphs.begin(), pendingGlyphs.end());
+			pendingGlyphs.clear();
+			wi::vector<const FontStyle*> styles(fontStyles.size());
+			for (size_t i = 0; i < fontStyles.size(); ++i)
 			{
+				styles[i] = fontStyles[i].get();
+			}
+			const uint64_t invalidation = atlas_invalidation;
+			lck.unlock();
+
+			wi::vector<Bitmap> bitmaps(pending.size());
+			wi::vector<Glyph> glyphs(pending.size());
+
+			// The glyphs are rasterized in parallel, stbtt only reads the font info here:
+			wi::jobsystem::context ctx;
+			wi::jobsystem::Dispatch(ctx, (uint32_t)pending.size(), 8, [&](wi::jobsystem::JobArgs args) {
 				GlyphHash hash;
-				hash.raw = raw;
+				hash.raw = pending[args.jobIndex];
 				const int code = (int)hash.bits.code;
 				const float height = (float)hash.bits.height;
 				const bool is_sdf = hash.bits.sdf ? true : false;
 				uint32_t style = hash.bits.style;
-				FontStyle* fontStyle = fontStyles[style].get();
+				const FontStyle* fontStyle = styles[style];
 				int glyphIndex = stbtt_FindGlyphIndex(&fontStyle->fontInfo, code);
 				if (glyphIndex == 0)
 				{
 					// Try fallback to an other font style that has this character:
 					style = 0;
-					while (glyphIndex == 0 && style < fontStyles.size())
+					while (glyphIndex == 0 && style < styles.size())
 					{
-						fontStyle = fontStyles[style].get();
+						fontStyle = styles[style];
 						glyphIndex = stbtt_FindGlyphIndex(&fontStyle->fontInfo, code);
 						style++;
 					}
 				}
 
 				float fontScaling = stbtt_ScaleForPixelHeight(&fontStyle->fontInfo, height * upscaling);
+				const float layoutScaling = stbtt_ScaleForPixelHeight(&fontStyle->fontInfo, height);
 
-				Bitmap& bitmap = bitmap_lookup[hash.raw];
+				Bitmap& bitmap = bitmaps[args.jobIndex];
 				bitmap.width = 0;
 				bitmap.height = 0;
 				bitmap.xoff = 0;
@@ -437,65 +673,123 @@ namespace wi::font
 					stbtt_FreeBitmap(data, nullptr);
 				}
 
-				wi::rectpacker::Rect rect = {};
-				rect.w = bitmap.width + 2;
-				rect.h = bitmap.height + 2;
-				rect.id = hash.raw;
-				rect_lookup[hash.raw] = rect;
-
-				Glyph& glyph = glyph_lookup[hash.raw];
+				Glyph& glyph = glyphs[args.jobIndex];
 				glyph.x = float(bitmap.xoff) * upscaling_rcp;
 				glyph.y = (float(bitmap.yoff) + float(fontStyle->ascent) * fontScaling) * upscaling_rcp;
 				glyph.width = float(bitmap.width) * upscaling_rcp;
 				glyph.height = float(bitmap.height) * upscaling_rcp;
 				glyph.fontStyle = fontStyle;
+				glyph.glyphIndex = glyphIndex;
+				glyph.scale = layoutScaling;
+				int advance, lsb;
+				stbtt_GetGlyphHMetrics(&fontStyle->fontInfo, glyphIndex, &advance, &lsb);
+				glyph.advance = advance * layoutScaling;
+			});
+			wi::jobsystem::Wait(ctx);
+
+			lck.lock();
+			if (invalidation != atlas_invalidation)
+			{
+				// The atlas was invalidated while rasterizing (for example a font style was added), so these glyphs are rendered again later:
+				pendingGlyphs.insert(pending.begin(), pending.end());
+				return;
 			}
-			pendingGlyphs.clear();
 
-			// Setup packer, this will allocate memory if needed:
-			static thread_local wi::rectpacker::State packer;
-			packer.clear();
-			for (auto& it : rect_lookup)
+			static thread_local wi::vector<wi::rectpacker::Rect> rects;
+			rects.resize(pending.size());
+			for (size_t i = 0; i < pending.size(); ++i)
+			{
+				wi::rectpacker::Rect& rect = rects[i];
+				rect = {};
+				rect.w = bitmaps[i].width + 2;
+				rect.h = bitmaps[i].height + 2;
+				rect.id = int(i);
+			}
+
+			// Pack only the new glyphs, grow the atlas if they don't fit into the free space:
+			const int prev_width = atlas.width;
+			const int prev_height = atlas.height;
+			bool success = atlas.width > 0 || atlas.grow();
+			bool packed = success && stbrp_pack_rects(&atlas.context, rects.data(), int(rects.size()));
+			while (success && !packed)
+			{
+				// When the atlas can't grow anymore, the rects that were packed in the last attempt are kept, because their space is already allocated:
+				if (!atlas.grow())
+					break;
+				for (auto& rect : rects)
+				{
+					rect.was_packed = 0;
+				}
+				packed = stbrp_pack_rects(&atlas.context, rects.data(), int(rects.size()));
+			}
+			if (success && !packed)
 			{
-				packer.add_rect(it.second);
+				// The glyphs that didn't fit are remembered, so they are not rasterized again every frame:
+				for (auto& rect : rects)
+				{
+					if (!rect.was_packed)
+					{
+						failedGlyphs.insert(pending[rect.id]);
+					}
+				}
+				static bool logged = false;
+				if (!logged)
+				{
+					logged = true;
+					wi::backlog::post("wi::font atlas is full (" + std::to_string(atlas.width) + "x" + std::to_string(atlas.height) + "), some glyphs will not be displayed", wi::backlog::LogLevel::Warning);
+				}
 			}
 
-			// Perform packing and process the result if successful:
-			if (packer.pack(4096))
+			if (success)
 			{
-				// Retrieve texture atlas dimensions:
-				const int atlasWidth = packer.width;
-				const int atlasHeight = packer.height;
-				const float inv_width = 1.0f / atlasWidth;
-				const float inv_height = 1.0f / atlasHeight;
-
-				// Create the CPU-side texture atlas and fill with transparency (0):
-				wi::vector<uint8_t> atlas(size_t(atlasWidth) * size_t(atlasHeight));
-				std::fill(atlas.begin(), atlas.end(), 0);
-
-				// Iterate all packed glyph rectangles:
-				for (auto& rect : packer.rects)
+				const bool resized = atlas.width != prev_width || atlas.height != prev_height;
+				const float inv_width = 1.0f / atlas.width;
+				const float inv_height = 1.0f / atlas.height;
+
+				if (resized)
 				{
+					// Existing glyphs keep their pixel positions, but the normalized texture coordinates change:
+					const float scale_x = float(prev_width) * inv_width;
+					const float scale_y = float(prev_height) * inv_height;
+					for (auto& it : glyph_lookup)
+					{
+						Glyph& glyph = it.second;
+						glyph.tc_left *= scale_x;
+						glyph.tc_right *= scale_x;
+						glyph.tc_top *= scale_y;
+						glyph.tc_bottom *= scale_y;
+					}
+					atlas_generation.fetch_add(1); // cached layouts contain the previous texture coordinates
+				}
+
+				int dirty_left = atlas.width;
+				int dirty_top = atlas.height;
+				int dirty_right = 0;
+				int dirty_bottom = 0;
+				for (auto& rect : rects)
+				{
+					if (!rect.was_packed)
+						continue;
+					dirty_left = std::min(dirty_left, rect.x);
+					dirty_top = std::min(dirty_top, rect.y);
+					dirty_right = std::max(dirty_right, rect.x + rect.w);
+					dirty_bottom = std::max(dirty_bottom, rect.y + rect.h);
+
 					rect.x += 1;
 					rect.y += 1;
 					rect.w -= 2;
 					rect.h -= 2;
 
-					const int32_t hash = rect.id;
-					//const wchar_t code = codefromhash(hash);
-					//const int style = stylefromhash(hash);
-					//const float height = (float)heightfromhash(hash);
-					Glyph& glyph = glyph_lookup[hash];
-					Bitmap& bitmap = bitmap_lookup[hash];
-
+					const Bitmap& bitmap = bitmaps[rect.id];
 					for (int row = 0; row < bitmap.height; ++row)
 					{
-						uint8_t* dst = atlas.data() + rect.x + (rect.y + row) * atlasWidth;
-						uint8_t* src = bitmap.data.data() + row * bitmap.width;
+						uint8_t* dst = atlas.bitmap.data() + rect.x + (rect.y + row) * atlas.width;
+						const uint8_t* src = bitmap.data.data() + row * bitmap.width;
 						std::memcpy(dst, src, bitmap.width);
 					}
 
 					// Compute texture coordinates for the glyph:
+					Glyph& glyph = glyphs[rect.id];
 					glyph.tc_left = float(rect.x);
 					glyph.tc_right = glyph.tc_left + float(rect.w);
 					glyph.tc_top = float(rect.y);
@@ -505,15 +799,51 @@ namespace wi::font
 					glyph.tc_right *= inv_width;
 					glyph.tc_top *= inv_height;
 					glyph.tc_bottom *= inv_height;
+
+					glyph_lookup[pending[rect.id]] = glyph;
 				}
 
-				// Upload the CPU-side texture atlas bitmap to the GPU:
-				wi::texturehelper::CreateTexture(texture, atlas.data(), atlasWidth, atlasHeight, Format::R8_UNORM);
-				GetDevice()->SetName(&texture, "wi::font::texture");
+				GraphicsDevice* device = GetDevice();
+				if (resized || !texture.IsValid())
+				{
+					// Upload the whole CPU-side texture atlas bitmap to the GPU:
+					wi::texturehelper::CreateTexture(texture, atlas.bitmap.data(), atlas.width, atlas.height, Format::R8_UNORM);
+					device->SetName(&texture, "wi::font::texture");
+				}
+				else if (dirty_right > dirty_left && dirty_bottom > dirty_top)
+				{
+					// Only the region of the new glyphs is uploaded, through a staging texture:
+					const int dirty_width = dirty_right - dirty_left;
+					const int dirty_height = dirty_bottom - dirty_top;
+					wi::vector<uint8_t> region(size_t(dirty_width) * size_t(dirty_height));
+					for (int row = 0; row < dirty_height; ++row)
+					{
+						std::memcpy(region.data() + row * dirty_width, atlas.bitmap.data() + dirty_left + (dirty_top + row) * atlas.width, dirty_width);
+					}
+					Texture staging;
+					wi::texturehelper::CreateTexture(staging, region.data(), dirty_width, dirty_height, Format::R8_UNORM);
+					device->SetName(&staging, "wi::font::staging");
+
+					CommandList cmd = device->BeginCommandList();
+					{
+						GPUBarrier barriers[] = {
+							GPUBarrier::Image(&texture, ResourceState::SHADER_RESOURCE, ResourceState::COPY_DST),
+							GPUBarrier::Image(&staging, ResourceState::SHADER_RESOURCE, ResourceState::COPY_SRC),
+						};
+						device->Barrier(barriers, arraysize(barriers), cmd);
+					}
+					device->CopyTexture(&texture, dirty_left, dirty_top, 0, 0, 0, &staging, 0, 0, cmd);
+					{
+						GPUBarrier barriers[] = {
+							GPUBarrier::Image(&texture, ResourceState::COPY_DST, ResourceState::SHADER_RESOURCE),
+						};
+						device->Barrier(barriers, arraysize(barriers), cmd);
+					}
+				}
 			}
 			else
 			{
-				assert(0); // rect packing failure
+				assert(0); // the atlas couldn't be created
 			}
 		}
 
@@ -0,0 +1,338 @@
+#include "wiGraphicsDevice_Null.h"
+#include "wiBacklog.h"
+
+#include <cstring>
+#include <algorithm>
+
+namespace wi::graphics
+{
+
+namespace null_internal
+{
+	struct Resource_Null
+	{
+		wi::vector<uint8_t> memory;
+		uint8_t* data = nullptr; // points into memory, or into the memory of an aliased resource
+		size_t size = 0;
+		wi::allocator::shared_ptr<void> alias_owner; // keeps aliased memory alive
+		wi::vector<SubresourceData> mapped_subresources;
+		int subresource_counts[4] = {}; // per SubresourceType
+	};
+	struct QueryHeap_Null
+	{
+		wi::vector<uint64_t> results;
+	};
+	struct Object_Null
+	{
+		// Used for all objects that don't need any state (shaders, samplers, pipelines)
+	};
+
+	Resource_Null* to_internal(const GPUResource* param)
+	{
+		return static_cast<Resource_Null*>(param->internal_state.get());
+	}
+	QueryHeap_Null* to_internal(const GPUQueryHeap* param)
+	{
+		return static_cast<QueryHeap_Null*>(param->internal_state.get());
+	}
+
+	// Allocates host memory for a resource, or references the memory of the alias resource if it's specified
+	void AllocateResourceMemory(Resource_Null* internal_state, size_t size, const GPUResource* alias, uint64_t alias_offset)
+	{
+		if (alias != nullptr && alias->IsValid())
+		{
+			Resource_Null* alias_internal = to_internal(alias);
+			if (alias_internal->data != nullptr && alias_offset + size <= alias_internal->size)
+			{
+				internal_state->alias_owner = alias->internal_state;
+				internal_state->data = alias_internal->data + alias_offset;
+				internal_state->size = size;
+				return;
+			}
+		}
+		internal_state->memory.resize(size);
+		internal_state->data = internal_state->memory.data();
+		internal_state->size = size;
+	}
+}
+using namespace null_internal;
+
+	GraphicsDevice_Null::GraphicsDevice_Null(ValidationMode validationMode_)
+	{
+		validationMode = validationMode_;
+
+		TIMESTAMP_FREQUENCY = 1000000ull; // microseconds
+		VARIABLE_RATE_SHADING_TILE_SIZE = 0;
+		SHADER_IDENTIFIER_SIZE = 32;
+		TOPLEVEL_ACCELERATION_STRUCTURE_INSTANCE_SIZE = 64;
+		capabilities = GraphicsDeviceCapability::NONE;
+		adapterType = AdapterType::Cpu;
+		adapterName = "Null";
+		driverDescription = "Headless device without GPU";
+
+		wi::backlog::post("Created GraphicsDevice_Null (headless, no GPU)");
+	}
+
+	bool GraphicsDevice_Null::CreateSwapChain(const SwapChainDesc* desc, wi::platform::window_type window, SwapChain* swapchain) const
+	{
+		if (!swapchain->IsValid())
+		{
+			swapchain->internal_state = wi::allocator::make_shared<Resource_Null>();
+		}
+		swapchain->desc = *desc;
+		return true;
+	}
+	bool GraphicsDevice_Null::CreateBuffer2(const GPUBufferDesc* desc, const std::function<void(void*)>& init_callback, GPUBuffer* buffer, const GPUResource* alias, uint64_t alias_offset) const
+	{
+		auto internal_state = wi::allocator::make_shared<Resource_Null>();
+		buffer->internal_state = internal_state;
+		buffer->type = GPUResource::Type::BUFFER;
+		buffer->mapped_data = nullptr;
+		buffer->mapped_size = 0;
+		buffer->desc = *desc;
+
+		// All buffers get host memory, so that GPU copies can be emulated:
+		AllocateResourceMemory(internal_state.get(), (size_t)desc->size, alias, alias_offset);
+
+		if (init_callback != nullptr && internal_state->data != nullptr)
+		{
+			init_callback(internal_state->data);
+		}
+
+		if (desc->usage == Usage::UPLOAD || desc->usage == Usage::READBACK)
+		{
+			buffer->mapped_data = internal_state->data;
+			buffer->mapped_size = internal_state->size;
+		}
+
+		return true;
+	}
+	bool GraphicsDevice_Null::CreateTexture(const TextureDesc* desc, const SubresourceData* initial_data, Texture* texture, const GPUResource* alias, uint64_t alias_offset) const
+	{
+		auto internal_state = wi::allocator::make_shared<Resource_Null>();
+		texture->internal_state = internal_state;
+		texture->type = GPUResource::Type::TEXTURE;
+		texture->mapped_data = nullptr;
+		texture->mapped_size = 0;
+		texture->mapped_subresources = nullptr;
+		texture->mapped_subresource_count = 0;
+		texture->sparse_properties = nullptr;
+		texture->desc = *desc;
+
+		if (texture->desc.mip_levels == 0)
+		{
+			texture->desc.mip_levels = GetMipCount(texture->desc.width, texture->desc.height, texture->desc.depth);
+		}
+
+		// Only textures with CPU access get host memory, GPU textures are never read back on the CPU directly:
+		if (texture->desc.usage == Usage::UPLOAD || texture->desc.usage == Usage::READBACK)
+		{
+			AllocateResourceMemory(internal_state.get(), ComputeTextureMemorySizeInBytes(texture->desc), alias, alias_offset);
+			CreateTextureSubresourceDatas(texture->desc, internal_state->data, internal_state->mapped_subresources);
+			texture->mapped_data = internal_state->data;
+			texture->mapped_size = internal_state->size;
+			texture->mapped_subresources = internal_state->mapped_subresources.data();
+			texture->mapped_subresource_count = internal_state->mapped_subresources.size();
+
+			if (initial_data != nullptr)
+			{
+				for (size_t i = 0; i < internal_state->mapped_subresources.size(); ++i)
+				{
+					const SubresourceData& src = initial_data[i];
+					const SubresourceData& dst = internal_state->mapped_subresources[i];
+					if (src.data_ptr == nullptr || dst.row_pitch == 0)
+						continue;
+					const uint32_t mip = uint32_t(i % texture->desc.mip_levels);
+					const uint32_t depth = std::max(1u, texture->desc.depth >> mip);
+					const uint32_t rows = dst.slice_pitch / dst.row_pitch;
+					const uint32_t row_size = std::min(src.row_pitch, dst.row_pitch);
+					for (uint32_t z = 0; z < depth; ++z)
+					{
+						for (uint32_t y = 0; y < rows; ++y)
+						{
+							std::memcpy(
+								(uint8_t*)dst.data_ptr + z * dst.slice_pitch + y * dst.row_pitch,
+								(const uint8_t*)src.data_ptr + z * src.slice_pitch + y * src.row_pitch,
+								row_size
+							);
+						}
+					}
+				}
+			}
+		}
+
+		return true;
+	}
+	bool GraphicsDevice_Null::CreateShader(ShaderStage stage, const void* shadercode, size_t shadercode_size, Shader* shader) const
+	{
+		shader->internal_state = wi::allocator::make_shared<Object_Null>();
+		shader->stage = stage;
+		return true;
+	}
+	bool GraphicsDevice_Null::CreateSampler(const SamplerDesc* desc, Sampler* sampler) const
+	{
+		sampler->internal_state = wi::allocator::make_shared<Object_Null>();
+		sampler->desc = *desc;
+		return true;
+	}
+	bool GraphicsDevice_Null::CreateQueryHeap(const GPUQueryHeapDesc* desc, GPUQueryHeap* queryheap) const
+	{
+		auto internal_state = wi::allocator::make_shared<QueryHeap_Null>();
+		internal_state->results.resize(desc->query_count);
+		queryheap->internal_state = internal_state;
+		queryheap->desc = *desc;
+		return true;
+	}
+	bool GraphicsDevice_Null::CreatePipelineState(const PipelineStateDesc* desc, PipelineState* pso, const RenderPassInfo* renderpass_info) const
+	{
+		pso->internal_state = wi::allocator::make_shared<Object_Null>();
+		pso->desc = *desc;
+		return true;
+	}
+
+	int GraphicsDevice_Null::CreateSubresource(Texture* texture, SubresourceType type, uint32_t firstSlice, uint32_t sliceCount, uint32_t firstMip, uint32_t mipCount, const Format* format_change, const ImageAspect* aspect, const Swizzle* swizzle, float min_lod_clamp) const
+	{
+		Resource_Null* internal_state = to_internal(texture);
+		return internal_state->subresource_counts[(int)type]++;
+	}
+	int GraphicsDevice_Null::CreateSubresource(GPUBuffer* buffer, SubresourceType type, uint64_t offset, uint64_t size, const Format* format_change, const uint32_t* structuredbuffer_stride_change) const
+	{
+		Resource_Null* internal_state = to_internal(buffer);
+		return internal_state->subresource_counts[(int)type]++;
+	}
+
+	void GraphicsDevice_Null::DeleteSubresources(GPUResource* resource)
+	{
+		Resource_Null* internal_state = to_internal(resource);
+		for (int& count : internal_state->subresource_counts)
+		{
+			count = 0;
+		}
+	}
+
+	CommandList GraphicsDevice_Null::BeginCommandList(QUEUE_TYPE queue)
+	{
+		cmd_locker.lock();
+		uint32_t cmd_current = cmd_count++;
+		if (cmd_current >= commandlists.size())
+		{
+			commandlists.push_back(std::make_unique<CommandList_Null>());
+		}
+		CommandList cmd;
+		cmd.internal_state = commandlists[cmd_current].get();
+		cmd_locker.unlock();
+
+		CommandList_Null& commandlist = GetCommandList(cmd);
+		commandlist.frame_allocators[GetBufferIndex()].reset();
+		commandlist.renderpass_info = {};
+		commandlist.queue = queue;
+		commandlist.id = cmd_current;
+
+		return cmd;
+	}
+	void GraphicsDevice_Null::SubmitCommandLists()
+	{
+		// Commands were already executed on the CPU while recording (copies, query writes), nothing to submit:
+		cmd_locker.lock();
+		cmd_count = 0;
+		cmd_locker.unlock();
+
+		FRAMECOUNT++;
+	}
+
+	Texture GraphicsDevice_Null::GetBackBuffer(const SwapChain* swapchain) const
+	{
+		Texture result;
+		result.type = GPUResource::Type::TEXTURE;
+		result.internal_state = swapchain->internal_state;
+		result.desc.type = TextureDesc::Type::TEXTURE_2D;
+		result.desc.width = swapchain->desc.width;
+		result.desc.height = swapchain->desc.height;
+		result.desc.format = swapchain->desc.format;
+		result.desc.layout = ResourceState::SWAPCHAIN;
+		result.desc.bind_flags = BindFlag::SHADER_RESOURCE | BindFlag::RENDER_TARGET;
+		return result;
+	}
+
+	void GraphicsDevice_Null::RenderPassBegin(const SwapChain* swapchain, CommandList cmd)
+	{
+		GetCommandList(cmd).renderpass_info = RenderPassInfo::from(swapchain->desc);
+	}
+	void GraphicsDevice_Null::RenderPassBegin(const RenderPassImage* images, uint32_t image_count, CommandList cmd, RenderPassFlags flags)
+	{
+		GetCommandList(cmd).renderpass_info = RenderPassInfo::from(images, image_count);
+	}
+	void GraphicsDevice_Null::RenderPassEnd(CommandList cmd)
+	{
+		GetCommandList(cmd).renderpass_info = {};
+	}
+	void GraphicsDevice_Null::CopyResource(const GPUResource* pDst, const GPUResource* pSrc, CommandList cmd)
+	{
+		if (pDst == nullptr || pSrc == nullptr || !pDst->IsValid() || !pSrc->IsValid())
+			return;
+		Resource_Null* dst_internal = to_internal(pDst);
+		Resource_Null* src_internal = to_internal(pSrc);
+		if (dst_internal->data == nullptr || src_internal->data == nullptr || dst_internal->data == src_internal->data)
+			return;
+		std::memcpy(dst_internal->data, src_internal->data, std::min(dst_internal->size, src_internal->size));
+	}
+	void GraphicsDevice_Null::CopyBuffer(const GPUBuffer* pDst, uint64_t dst_offset, const GPUBuffer* pSrc, uint64_t src_offset, uint64_t size, CommandList cmd)
+	{
+		if (pDst == nullptr || pSrc == nullptr || !pDst->IsValid() || !pSrc->IsValid())
+			return;
+		Resource_Null* dst_internal = to_internal(pDst);
+		Resource_Null* src_internal = to_internal(pSrc);
+		if (dst_internal->data == nullptr || src_internal->data == nullptr)
+			return;
+		if (dst_offset + size > dst_internal->size || src_offset + size > src_internal->size)
+		{
+			assert(0); // out of bounds copy
+			return;
+		}
+		std::memmove(dst_internal->data + dst_offset, src_internal->data + src_offset, (size_t)size);
+	}
+	void GraphicsDevice_Null::QueryEnd(const GPUQueryHeap* heap, uint32_t index, CommandList cmd)
+	{
+		QueryHeap_Null* internal_state = to_internal(heap);
+		if (index >= internal_state->results.size())
+			return;
+		switch (heap->desc.type)
+		{
+		case GpuQueryType::TIMESTAMP:
+			// Deterministic clock that advances by a fixed 60 Hz frame time for every submitted frame:
+			internal_state->results[index] = FRAMECOUNT * (TIMESTAMP_FREQUENCY / 60);
+			break;
+		case GpuQueryType::OCCLUSION:
+		case GpuQueryType::OCCLUSION_BINARY:
+			// Everything is reported visible, so occlusion culling never hides anything:
+			internal_state->results[index] = 1;
+			break;
+		default:
+			break;
+		}
+	}
+	void GraphicsDevice_Null::QueryResolve(const GPUQueryHeap* heap, uint32_t index, uint32_t count, const GPUBuffer* dest, uint64_t dest_offset, CommandList cmd)
+	{
+		QueryHeap_Null* internal_state = to_internal(heap);
+		Resource_Null* dest_internal = to_internal(dest);
+		if (dest_internal->data == nullptr)
+			return;
+		count = std::min(count, uint32_t(internal_state->results.size()) - std::min(index, uint32_t(internal_state->results.size())));
+		const size_t size = count * sizeof(uint64_t);
+		if (dest_offset + size > dest_internal->size)
+			return;
+		std::memcpy(dest_internal->data + dest_offset, internal_state->results.data() + index, size);
+	}
+	void GraphicsDevice_Null::ClearUAV(const GPUResource* resource, uint32_t value, CommandList cmd)
+	{
+		if (resource == nullptr || !resource->IsValid())
+			return;
+		Resource_Null* internal_state = to_internal(resource);
+		if (internal_state->data == nullptr)
+			return;
+		const size_t count = internal_state->size / sizeof(uint32_t);
+		uint32_t* dst = (uint32_t*)internal_state->data;
+		std::fill(dst, dst + count, value);
+	}
+
+}
@@ -5,6 +5,7 @@
 #include "wiMath.h"
 #include "wiImage.h"
 #include "wiRenderer.h"
+#include "wiAllocator.h"
 
 #include "Utility/lodepng.h"
 #include "Utility/dds.h"
@@ -44,6 +45,13 @@
 #include <sys/sysinfo.h>
 #endif // PLATFORM_LINUX
 
+#if defined(PLATFORM_LINUX) || defined(PLATFORM_APPLE)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif // defined(PLATFORM_LINUX) || defined(PLATFORM_APPLE)
+
 #ifdef PLATFORM_WINDOWS_DESKTOP
 #include <comdef.h> // com_error
 #endif // PLATFORM_WINDOWS_DESKTOP
@@ -1306,6 +1314,36 @@ namespace wi::helper
 	}
 #endif // WI_VECTOR_TYPE
 
+	std::shared_ptr<const uint8_t> FileMap(const std::string& fileName, size_t& size)
+	{
+		size = 0;
+#if defined(PLATFORM_LINUX) || defined(PLATFORM_APPLE)
+		std::string filepath = fileName;
+		std::replace(filepath.begin(), filepath.end(), '\\', '/'); // Linux cannot handle backslash in file path, need to convert it to forward slash
+		int fd = open(filepath.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd < 0)
+			return nullptr;
+		struct stat st = {};
+		if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0)
+		{
+			close(fd);
+			return nullptr;
+		}
+		const size_t mapped_size = (size_t)st.st_size;
+		void* mapped = mmap(nullptr, mapped_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd); // the mapping keeps its own reference to the file
+		if (mapped == MAP_FAILED)
+			return nullptr;
+		madvise(mapped, mapped_size, MADV_WILLNEED); // start reading ahead the whole file asynchronously
+		size = mapped_size;
+		return std::shared_ptr<const uint8_t>((const uint8_t*)mapped, [mapped_size](const uint8_t* ptr) {
+			munmap((void*)ptr, mapped_size);
+		});
+#else
+		return nullptr;
+#endif // defined(PLATFORM_LINUX) || defined(PLATFORM_APPLE)
+	}
+
 	bool FileWrite(const std::string& fileName, const uint8_t* data, size_t size)
 	{
 		if (size <= 0)
@@ -2099,6 +2137,39 @@ namespace wi::helper
 		return mem;
 	}
 
+	std::string GetMemoryTagReport()
+	{
+#if WI_MEMORY_TRACKING
+		std::stringstream ss;
+		ss << std::left << std::setw(14) << "Tag" << std::setw(12) << "Current" << std::setw(12) << "Peak" << "Allocations" << std::endl;
+		for (size_t i = 0; i < size_t(wi::allocator::MemoryTag::Count); ++i)
+		{
+			const wi::allocator::MemoryTag tag = wi::allocator::MemoryTag(i);
+			const wi::allocator::MemoryTagStats stats = wi::allocator::GetMemoryTagStats(tag);
+			ss << std::setw(14) << wi::allocator::GetMemoryTagName(tag);
+			ss << std::setw(12) << GetMemorySizeText(size_t(std::max(int64_t(0), stats.current)));
+			ss << std::setw(12) << GetMemorySizeText(size_t(std::max(int64_t(0), stats.peak)));
+			ss << stats.allocations << std::endl;
+		}
+		return ss.str();
+#else
+		return "Memory tag tracking is disabled (WI_MEMORY_TRACKING 0)\n";
+#endif // WI_MEMORY_TRACKING
+	}
+
+	void DumpMemoryTagReport(const std::string& filename)
+	{
+		const std::string report = GetMemoryTagReport();
+		if (filename.empty())
+		{
+			wi::backlog::post("Memory tag report:\n" + report);
+		}
+		else if (FileWrite(filename, (const uint8_t*)report.data(), report.size()))
+		{
+			wi::backlog::post("Memory tag report written to " + filename);
+		}
+	}
+
 	std::string GetMemorySizeText(size_t sizeInBytes)
 	{
 		std::stringstream ss;
@@ -2188,6 +2259,12 @@ namespace wi::helper
 		return ZSTD_isError(res) == 0;
 	}
 
+	bool Decompress(const uint8_t* src_data, size_t src_size, uint8_t* dst_data, size_t dst_size)
+	{
+		size_t res = ZSTD_decompress(dst_data, dst_size, src_data, src_size);
+		return ZSTD_isError(res) == 0 && res == dst_size;
+	}
+
 	size_t HashByteData(const uint8_t* data, size_t size)
 	{
 		size_t hash = 0;
@@ -6,6 +6,7 @@
 
 #include <string>
 #include <functional>
+#include <memory>
 
 #if WI_VECTOR_TYPE
 namespace std
@@ -128,6 +129,11 @@ namespace wi::helper
 	bool FileRead(const std::string& fileName, std::vector<uint8_t>& data, size_t max_read = ~0ull, size_t offset = 0);
 #endif // WI_VECTOR_TYPE
 
+	// Maps the whole file into memory for reading without copying it
+	//	The mapping stays alive while any copy of the returned pointer is alive
+	//	Returns nullptr if the file couldn't be mapped or memory mapping is not supported on the platform, FileRead() can be used as a fallback
+	std::shared_ptr<const uint8_t> FileMap(const std::string& fileName, size_t& size);
+
 	bool FileWrite(const std::string& fileName, const uint8_t* data, size_t size);
 
 	bool FileExists(const std::string& fileName);
@@ -219,6 +225,13 @@ namespace wi::helper
 	};
 	MemoryUsage GetMemoryUsage();
 
+	// Returns a table of the current, peak memory and live allocation counts of every wi::allocator::MemoryTag
+	//	It only contains a note when the engine was compiled with WI_MEMORY_TRACKING 0
+	std::string GetMemoryTagReport();
+
+	// Writes the memory tag report to the backlog, or to a file if filename is not empty
+	void DumpMemoryTagReport(const std::string& filename = "");
+
 	// Returns a good looking memory size string as either bytes, KB, MB or GB
 	std::string GetMemorySizeText(size_t sizeInBytes);
 
@@ -234,6 +247,9 @@ namespace wi::helper
 	// Lossless decompression of byte array that was compressed with wi::helper::Compress()
 	bool Decompress(const uint8_t* src_data, size_t src_size, wi::vector<uint8_t>& dst_data);
 
+	// Lossless decompression into existing memory, the dst_size must be exactly the decompressed size
+	bool Decompress(const uint8_t* src_data, size_t src_size, uint8_t* dst_data, size_t dst_size);
+
 	// Hash the contents of a file:
 	size_t HashByteData(const uint8_t* data, size_t size);
 
@@ -302,10 +302,8 @@ namespace wi::lua
 
 	void Input_BindLua::Bind()
 	{
-		static bool initialized = false;
-		if (!initialized)
+		if (wi::lua::BindOnce("Input"))
 		{
-			initialized = true;
 			Luna<Input_BindLua>::Register(wi::lua::GetLuaState());
 
 			wi::lua::RunText(R"(
@@ -488,10 +486,8 @@ CURSOR_CROSS = 9
 
 	void Touch_BindLua::Bind()
 	{
-		static bool initialized = false;
-		if (!initialized)
+		if (wi::lua::BindOnce("Touch"))
 		{
-			initialized = true;
 			Luna<Touch_BindLua>::Register(wi::lua::GetLuaState());
 		}
 	}
@@ -562,10 +558,8 @@ CURSOR_CROSS = 9
 
 	void ControllerFeedback_BindLua::Bind()
 	{
-		static bool initialized = false;
-		if (!initialized)
+		if (wi::lua::BindOnce("ControllerFeedback"))
 		{
-			initialized = true;
 			Luna<ControllerFeedback_BindLua>::Register(wi::lua::GetLuaState());
 		}
 	}
@@ -4,6 +4,7 @@
 #include "wiPlatform.h"
 #include "wiTimer.h"
 #include "wiAllocator.h"
+#include "wiRandom.h"
 
 #include <memory>
 #include <algorithm>
@@ -11,6 +12,7 @@
 #include <thread>
 #include <mutex>
 #include <condition_variable>
+#include <functional>
 
 #ifdef _WIN32
 #include <malloc.h> // alloca
@@ -132,11 +134,180 @@ namespace wi::jobsystem
 			return true;
 		}
 	};
+	// Lock-free work-stealing deque (Chase-Lev), based on: "Correct and Efficient Work-Stealing for Weak Memory Models" by Le et al.
+	//	Only the owner thread can push_bottom() and pop_bottom() (LIFO), any other thread can steal() from the top (FIFO)
+	//	It stores pointers to pooled jobs, so a thief never copies a job that could be overwritten concurrently
+	struct WorkStealingDeque
+	{
+		struct Array
+		{
+			int64_t capacity = 0;
+			std::unique_ptr<std::atomic<Job*>[]> items;
+
+			Array(int64_t capacity) : capacity(capacity), items(new std::atomic<Job*>[capacity]) {}
+			inline Job* get(int64_t index) const { return items[index & (capacity - 1)].load(std::memory_order_relaxed); }
+			inline void put(int64_t index, Job* job) { items[index & (capacity - 1)].store(job, std::memory_order_relaxed); }
+		};
+		alignas(64) std::atomic<int64_t> top{ 0 };
+		alignas(64) std::atomic<int64_t> bottom{ 0 };
+		alignas(64) std::atomic<Array*> array{ nullptr };
+		wi::vector<std::unique_ptr<Array>> arrays; // old arrays are retained after growing, because thieves might still read from them
+		std::atomic_bool owned{ false }; // whether a thread is owning this deque currently
+
+		WorkStealingDeque()
+		{
+			arrays.emplace_back(new Array(256));
+			array.store(arrays.back().get(), std::memory_order_relaxed);
+		}
+
+		// Approximation, for early exit in job stealing scenario
+		inline bool empty() const
+		{
+			return bottom.load(std::memory_order_relaxed) <= top.load(std::memory_order_relaxed);
+		}
+
+		// Owner thread only
+		inline void push_bottom(Job* job)
+		{
+			const int64_t b = bottom.load(std::memory_order_relaxed);
+			const int64_t t = top.load(std::memory_order_acquire);
+			Array* a = array.load(std::memory_order_relaxed);
+			if (b - t > a->capacity - 1)
+			{
+				// We ran out of space, so we need to allocate a bigger array:
+				Array* grown = arrays.emplace_back(new Array(a->capacity * 2)).get();
+				for (int64_t i = t; i < b; ++i)
+				{
+					grown->put(i, a->get(i));
+				}
+				array.store(grown, std::memory_order_release);
+				a = grown;
+			}
+			a->put(b, job);
+			bottom.store(b + 1, std::memory_order_release); // publishes the job to thieves
+		}
+
+		// Owner thread only, returns nullptr if empty
+		inline Job* pop_bottom()
+		{
+			const int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+			Array* a = array.load(std::memory_order_relaxed);
+			bottom.store(b, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			int64_t t = top.load(std::memory_order_relaxed);
+			Job* job = nullptr;
+			if (t <= b)
+			{
+				job = a->get(b);
+				if (t == b)
+				{
+					// This is the last item, thieves could be racing for it:
+					if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+					{
+						job = nullptr;
+					}
+					bottom.store(b + 1, std::memory_order_relaxed);
+				}
+			}
+			else
+			{
+				bottom.store(b + 1, std::memory_order_relaxed);
+			}
+			return job;
+		}
+
+		// Any thread, returns nullptr if empty or if an other thread won the race for the item
+		inline Job* steal()
+		{
+			int64_t t = top.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			const int64_t b = bottom.load(std::memory_order_acquire);
+			if (t < b)
+			{
+				Array* a = array.load(std::memory_order_acquire);
+				Job* job = a->get(t);
+				if (top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+				{
+					return job;
+				}
+			}
+			return nullptr;
+		}
+	};
+
+	// Jobs that are used by the work-stealing deques are pooled
+	//	Every thread has a local cache of free jobs (see ThreadLocalState), and exchanges batches with this pool only when needed
+	struct JobPool
+	{
+		static constexpr size_t batch_size = 256;
+		std::mutex locker;
+		wi::vector<std::unique_ptr<Job[]>> blocks;
+		wi::vector<Job*> free_list;
+
+		void acquire_batch(wi::vector<Job*>& dest)
+		{
+			std::scoped_lock lock(locker);
+			if (free_list.empty())
+			{
+				Job* block = blocks.emplace_back(new Job[batch_size]).get();
+				for (size_t i = 0; i < batch_size; ++i)
+				{
+					free_list.push_back(block + i);
+				}
+			}
+			const size_t count = std::min(batch_size, free_list.size());
+			dest.insert(dest.end(), free_list.end() - count, free_list.end());
+			free_list.resize(free_list.size() - count);
+		}
+		void release_batch(wi::vector<Job*>& src, size_t count)
+		{
+			std::scoped_lock lock(locker);
+			count = std::min(count, src.size());
+			free_list.insert(free_list.end(), src.end() - count, src.end());
+			src.resize(src.size() - count);
+		}
+	} static job_pool;
+
+	struct ThreadLocalState
+	{
+		wi::vector<Job*> free_jobs;
+		int deques[int(Priority::Count)] = { -1, -1, -1 }; // index of the work-stealing deque that this thread owns per priority, -1 if none
+		uint32_t generation = 0; // job system generation that the deque indices are valid for
+		wi::random::RNG rng = wi::random::RNG(std::hash<std::thread::id>{}(std::this_thread::get_id()) | 1ull);
+
+		~ThreadLocalState();
+
+		inline Job* allocate_job()
+		{
+			if (free_jobs.empty())
+			{
+				job_pool.acquire_batch(free_jobs);
+			}
+			Job* job = free_jobs.back();
+			free_jobs.pop_back();
+			return job;
+		}
+		inline void free_job(Job* job)
+		{
+			job->task = {}; // release the captured state
+			free_jobs.push_back(job);
+			if (free_jobs.size() > JobPool::batch_size * 4)
+			{
+				// Jobs that were allocated by other threads accumulate here, so give some of them back:
+				job_pool.release_batch(free_jobs, JobPool::batch_size * 2);
+			}
+		}
+	};
+	static thread_local ThreadLocalState tls;
+
 	struct PriorityResources
 	{
 		uint32_t numThreads = 0;
 		wi::vector<std::thread> threads;
-		std::unique_ptr<JobQueue[]> jobQueuePerThread;
+		std::unique_ptr<JobQueue[]> jobQueuePerThread; // used when work stealing is disabled, or when a thread couldn't get its own deque
+		std::unique_ptr<WorkStealingDeque[]> deques; // [0, numThreads) are owned by workers, [numThreads, numDeques) can be owned by any other thread that submits jobs
+		uint32_t numDeques = 0;
+		std::atomic<uint32_t> numDequesActive{ 0 }; // deques after this were never owned, so they don't need to be searched for stealing
 		std::atomic<uint8_t> nextQueue{ 0 };
 		std::condition_variable sleepingCondition; // for workers that are sleeping
 		std::mutex sleepingMutex; // for workers that are sleeping
@@ -160,26 +331,90 @@ namespace wi::jobsystem
 			return jobQueuePerThread[next_queue_index()];
 		}
 
-		// Start working on a job queue
-		//	After the job queue is finished, it can switch to an other queue and steal jobs from there
-		inline void work(uint32_t startingQueue)
+		// Returns the work-stealing deque owned by the current thread
+		//	If claim is true, a free deque will be claimed if the thread doesn't have one yet
+		//	Returns nullptr if the thread doesn't own a deque
+		WorkStealingDeque* local_deque(int prio, bool claim);
+
+		// Tries to take a job from other threads' deques, with randomized victim selection
+		inline Job* steal(const WorkStealingDeque* local)
 		{
+			const uint32_t count = numDequesActive.load(std::memory_order_acquire);
+			if (count == 0)
+				return nullptr;
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				WorkStealingDeque& victim = deques[tls.rng.next_uint() % count];
+				if (&victim == local || victim.empty())
+					continue;
+				Job* job = victim.steal();
+				if (job != nullptr)
+					return job;
+			}
+			// Random selection didn't find anything, so check all the deques before giving up:
+			const uint32_t offset = uint32_t(tls.rng.next_uint() % count);
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				WorkStealingDeque& victim = deques[(offset + i) % count];
+				if (&victim == local)
+					continue;
+				while (!victim.empty())
+				{
+					Job* job = victim.steal();
+					if (job != nullptr)
+						return job;
+				}
+			}
+			return nullptr;
+		}
+
+		inline void execute(Job& job)
+		{
+			uint32_t progress_before = job.execute();
+			if (progress_before == 1)
+			{
+				// This is likely the last job because the counter was 1 before it was decremented in execute()
+				//	So wake up the waiting threads here
+				std::unique_lock<std::mutex> lock(waitingMutex);
+				waitingCondition.notify_all();
+			}
+		}
+
+		// Start working on the job queues
+		//	First the own deque is processed (LIFO), then jobs are stolen from other deques (FIFO)
+		//	After that the mutex protected queues are processed starting from startingQueue, switching to other queues when one is finished
+		inline void work(uint32_t startingQueue, int prio)
+		{
+			WorkStealingDeque* local = local_deque(prio, false);
 			Job job;
-			for (uint32_t i = 0; i < numThreads; ++i)
+			bool executed = true;
+			while (executed)
 			{
-				JobQueue& job_queue = jobQueuePerThread[constrain_queue_index(startingQueue)];
-				while (job_queue.pop_front(job))
+				executed = false;
+
+				Job* job_ptr = local == nullptr ? nullptr : local->pop_bottom();
+				if (job_ptr == nullptr)
+				{
+					job_ptr = steal(local);
+				}
+				if (job_ptr != nullptr)
+				{
+					execute(*job_ptr);
+					tls.free_job(job_ptr);
+					executed = true;
+					continue;
+				}
+
+				for (uint32_t i = 0; i < numThreads; ++i)
 				{
-					uint32_t progress_before = job.execute();
-					if (progress_before == 1)
+					JobQueue& job_queue = jobQueuePerThread[constrain_queue_index(startingQueue)];
+					while (job_queue.pop_front(job))
 					{
-						// This is likely the last job because the counter was 1 before it was decremented in execute()
-						//	So wake up the waiting threads here
-						std::unique_lock<std::mutex> lock(waitingMutex);
-						waitingCondition.notify_all();
+						execute(job);
+						executed = true;
 					}
+					startingQueue++; // go to next queue
 				}
-				startingQueue++; // go to next queue
 			}
 		}
 	};
@@ -191,11 +426,14 @@ namespace wi::jobsystem
 		uint32_t numCores = 0;
 		PriorityResources resources[int(Priority::Count)];
 		std::atomic_bool alive{ true };
+		std::atomic_bool work_stealing{ true };
+		std::atomic<uint32_t> generation{ 0 }; // incremented for every Initialize() and ShutDown(), invalidates deque ownership of threads
 		void ShutDown()
 		{
 			if (IsShuttingDown())
 				return;
 			alive.store(false); // indicate that new jobs cannot be started from this point
+			generation.fetch_add(1);
 			bool wake_loop = true;
 			std::thread waker([&] {
 				while (wake_loop)
@@ -218,6 +456,9 @@ namespace wi::jobsystem
 			for (auto& x : resources)
 			{
 				x.jobQueuePerThread.reset();
+				x.deques.reset();
+				x.numDeques = 0;
+				x.numDequesActive.store(0);
 				x.threads.clear();
 				x.numThreads = 0;
 			}
@@ -229,6 +470,56 @@ namespace wi::jobsystem
 		}
 	} static internal_state;
 
+	WorkStealingDeque* PriorityResources::local_deque(int prio, bool claim)
+	{
+		const uint32_t generation = internal_state.generation.load(std::memory_order_relaxed);
+		if (tls.generation != generation)
+		{
+			for (auto& x : tls.deques)
+			{
+				x = -1;
+			}
+			tls.generation = generation;
+		}
+		int index = tls.deques[prio];
+		if (index >= 0)
+			return &deques[index];
+		if (!claim || deques == nullptr)
+			return nullptr;
+		for (uint32_t i = numThreads; i < numDeques; ++i)
+		{
+			bool expected = false;
+			if (deques[i].owned.compare_exchange_strong(expected, true, std::memory_order_acquire))
+			{
+				tls.deques[prio] = int(i);
+				uint32_t active = numDequesActive.load(std::memory_order_relaxed);
+				while (active < i + 1 && !numDequesActive.compare_exchange_weak(active, i + 1, std::memory_order_release)) {}
+				return &deques[i];
+			}
+		}
+		return nullptr; // all deques are taken, the mutex protected queues will be used by this thread
+	}
+
+	ThreadLocalState::~ThreadLocalState()
+	{
+		// Deques that are not owned by worker threads are given back, so that other threads can reuse them:
+		if (generation == internal_state.generation.load())
+		{
+			for (int prio = 0; prio < int(Priority::Count); ++prio)
+			{
+				PriorityResources& res = internal_state.resources[prio];
+				if (deques[prio] >= int(res.numThreads) && res.deques != nullptr)
+				{
+					res.deques[deques[prio]].owned.store(false, std::memory_order_release);
+				}
+			}
+		}
+		if (!free_jobs.empty())
+		{
+			job_pool.release_batch(free_jobs, free_jobs.size());
+		}
+	}
+
 	void Initialize(uint32_t maxThreadCount)
 	{
 		if (internal_state.numCores > 0)
@@ -239,6 +530,8 @@ namespace wi::jobsystem
 
 		// Retrieve the number of hardware threads in this system:
 		internal_state.numCores = std::thread::hardware_concurrency();
+		internal_state.alive.store(true);
+		const uint32_t generation = internal_state.generation.fetch_add(1) + 1;
 
 		for (int prio = 0; prio < int(Priority::Count); ++prio)
 		{
@@ -263,6 +556,15 @@ namespace wi::jobsystem
 			}
 			res.numThreads = clamp(res.numThreads, 1u, maxThreadCount);
 			res.jobQueuePerThread.reset(new JobQueue[res.numThreads]);
+
+			// Every worker owns a deque, and additional deques are created for other threads that submit jobs (main thread, workers of other priorities):
+			res.numDeques = res.numThreads + internal_state.numCores + 16;
+			res.deques.reset(new WorkStealingDeque[res.numDeques]);
+			for (uint32_t i = 0; i < res.numThreads; ++i)
+			{
+				res.deques[i].owned.store(true);
+			}
+			res.numDequesActive.store(res.numThreads);
 			res.threads.reserve(res.numThreads);
 
 			// Precompute lookup table of modulos to avoid divs at runtime:
@@ -273,7 +575,10 @@ namespace wi::jobsystem
 
 			for (uint32_t threadID = 0; threadID < res.numThreads; ++threadID)
 			{
-				std::thread& worker = res.threads.emplace_back([threadID, priority, &res] {
+				std::thread& worker = res.threads.emplace_back([threadID, priority, generation, &res] {
+
+					tls.generation = generation;
+					tls.deques[int(priority)] = int(threadID);
 
 #if defined(__FREEBSD__)
 // TODO: FreeBSD's setpriority is incompatible with the expected Linux non-standard behavior
@@ -310,7 +615,7 @@ namespace wi::jobsystem
 
 					while (internal_state.alive.load(std::memory_order_relaxed))
 					{
-						res.work(threadID);
+						res.work(threadID, int(priority));
 
 						// finished with jobs, put to sleep
 						std::unique_lock<std::mutex> lock(res.sleepingMutex);
@@ -423,6 +728,16 @@ namespace wi::jobsystem
 		return internal_state.alive.load(std::memory_order_relaxed) == false;
 	}
 
+	void SetWorkStealingEnabled(bool value)
+	{
+		internal_state.work_stealing.store(value);
+	}
+
+	bool IsWorkStealingEnabled()
+	{
+		return internal_state.work_stealing.load(std::memory_order_relaxed);
+	}
+
 	uint32_t GetThreadCount(Priority priority)
 	{
 		return internal_state.resources[int(priority)].numThreads;
@@ -450,7 +765,17 @@ namespace wi::jobsystem
 			return;
 		}
 
-		res.next_queue().push_back(job);
+		WorkStealingDeque* local = IsWorkStealingEnabled() ? res.local_deque(int(ctx.priority), true) : nullptr;
+		if (local != nullptr)
+		{
+			Job* job_ptr = tls.allocate_job();
+			*job_ptr = std::move(job);
+			local->push_bottom(job_ptr);
+		}
+		else
+		{
+			res.next_queue().push_back(job);
+		}
 		res.sleepingCondition.notify_one();
 	}
 
@@ -472,6 +797,8 @@ namespace wi::jobsystem
 		job.task = task;
 		job.sharedmemory_size = (uint32_t)sharedmemory_size;
 
+		WorkStealingDeque* local = (res.numThreads > 0 && IsWorkStealingEnabled()) ? res.local_deque(int(ctx.priority), true) : nullptr;
+
 		for (uint32_t groupID = 0; groupID < groupCount; ++groupID)
 		{
 			// For each group, generate one real job:
@@ -484,6 +811,12 @@ namespace wi::jobsystem
 				// If job system is not yet initialized, job will be executed immediately here instead of thread:
 				job.execute();
 			}
+			else if (local != nullptr)
+			{
+				Job* job_ptr = tls.allocate_job();
+				*job_ptr = job;
+				local->push_bottom(job_ptr);
+			}
 			else
 			{
 				res.next_queue().push_back(job);
@@ -518,7 +851,7 @@ namespace wi::jobsystem
 			res.sleepingCondition.notify_all();
 
 			// work() will pick up any jobs that are on standby and execute them on this thread:
-			res.work(res.next_queue_index());
+			res.work(res.next_queue_index(), int(ctx.priority));
 
 			while (IsBusy(ctx))
 			{
@@ -537,4 +870,115 @@ namespace wi::jobsystem
 	{
 		return ctx.counter.load(std::memory_order_relaxed);
 	}
+
+	void TaskGraph::Clear()
+	{
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			Node& node = nodes[i];
+			node.name = nullptr;
+			node.task = {};
+			node.successors.clear();
+			node.dependencyCount = 0;
+			node.time = 0;
+		}
+		count = 0;
+	}
+	TaskGraph::Task TaskGraph::Add(const char* name, const job_function_type& task, std::initializer_list<Task> dependencies)
+	{
+		const Task index = count++;
+		if (nodes.size() < count)
+		{
+			nodes.emplace_back();
+		}
+		Node& node = nodes[index];
+		node.name = name;
+		node.task = task;
+		for (Task dependency : dependencies)
+		{
+			AddDependency(index, dependency);
+		}
+		return index;
+	}
+	void TaskGraph::AddDependency(Task task, Task dependency)
+	{
+		assert(task < count);
+		assert(dependency < task); // only previously added tasks can be dependencies
+		nodes[dependency].successors.push_back(task);
+		nodes[task].dependencyCount++;
+	}
+	void TaskGraph::Run(context& ctx)
+	{
+		if (remaining_capacity < count)
+		{
+			remaining_capacity = std::max(count, remaining_capacity * 2);
+			remaining.reset(new std::atomic<uint32_t>[remaining_capacity]);
+		}
+		// All counters must be reset before starting anything, because tasks will start their successors:
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			remaining[i].store(nodes[i].dependencyCount, std::memory_order_relaxed);
+		}
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			if (nodes[i].dependencyCount == 0)
+			{
+				Start(ctx, i);
+			}
+		}
+	}
+	void TaskGraph::Start(context& ctx, Task task)
+	{
+		// The successors are started from within the job, so the context counter can't reach zero until the last task finished
+		Execute(ctx, [this, &ctx, task](JobArgs args) {
+			Node& node = nodes[task];
+			wi::Timer timer;
+			node.task(args);
+			node.time = (float)timer.elapsed();
+			for (Task successor : node.successors)
+			{
+				if (remaining[successor].fetch_sub(1, std::memory_order_acq_rel) == 1)
+				{
+					Start(ctx, successor);
+				}
+			}
+		});
+	}
+	float TaskGraph::GetCriticalPathTime(wi::vector<Task>* path) const
+	{
+		// Nodes are in topological order, because dependencies must precede the tasks that use them
+		//	The longest finishing time of each node is propagated forward to its successors:
+		wi::vector<float> finish(count, 0.0f);
+		wi::vector<Task> predecessor(count, ~0u);
+		float critical_time = 0;
+		Task critical_task = ~0u;
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			const Node& node = nodes[i];
+			finish[i] += node.time;
+			if (finish[i] > critical_time || critical_task == ~0u)
+			{
+				critical_time = finish[i];
+				critical_task = i;
+			}
+			for (Task successor : node.successors)
+			{
+				if (finish[i] > finish[successor])
+				{
+					finish[successor] = finish[i];
+					predecessor[successor] = i;
+				}
+			}
+		}
+		if (path != nullptr)
+		{
+			path->clear();
+			for (Task i = critical_task; i != ~0u; i = predecessor[i])
+			{
+				path->push_back(i);
+			}
+			std::reverse(path->begin(), path->end());
+		}
+		return critical_time;
+	}
 }
@@ -10,7 +10,11 @@
 #include <functional>
 #endif // JOB_SYSTEM_FIXED_SIZE_FUNCTION
 
+#include "wiVector.h"
+
 #include <atomic>
+#include <memory>
+#include <initializer_list>
 
 namespace wi::jobsystem
 {
@@ -54,6 +58,13 @@ namespace wi::jobsystem
 
 	uint32_t GetThreadCount(Priority priority = Priority::High);
 
+	// Enable or disable lock-free work-stealing job queues (enabled by default)
+	//	When enabled, every thread pushes jobs to its own deque and idle threads steal from randomly selected other deques
+	//	When disabled, jobs are distributed round-robin to mutex protected per-thread queues
+	//	It can be toggled at any time, jobs that are already submitted will be finished either way
+	void SetWorkStealingEnabled(bool value);
+	bool IsWorkStealingEnabled();
+
 	// Add a task to execute asynchronously. Any idle thread will execute this.
 	void Execute(context& ctx, const job_function_type& task);
 
@@ -76,4 +87,54 @@ namespace wi::jobsystem
 
 	// Returns the number of remaining jobs
 	uint32_t GetRemainingJobCount(const context& ctx);
+
+	// A set of tasks with dependencies between them
+	//	Tasks without dependencies are started immediately when the graph is run
+	//	When a task finishes, every task that depended on it is started automatically once all of its dependencies finished
+	//	Compared to issuing workloads separated by Wait() barriers, this lets independent tasks overlap with long running ones
+	//	A task can only depend on tasks that were added before it, so the graph can't contain cycles
+	struct TaskGraph
+	{
+		using Task = uint32_t;
+
+		// Remove all tasks, but keep allocations for reuse
+		void Clear();
+
+		// Add a task that will start after all dependencies finished
+		//	name	: used for debugging and profiling, the string must outlive the graph (for example a string literal)
+		//	task	: the task receives JobArgs with jobIndex = 0, it can issue and wait on additional jobs
+		Task Add(const char* name, const job_function_type& task, std::initializer_list<Task> dependencies = {});
+
+		// Make a task depend on an other task that was added before it
+		void AddDependency(Task task, Task dependency);
+
+		// Start executing the graph. The ctx will be waitable until all tasks have finished
+		//	The graph must not be modified while it is executing
+		void Run(context& ctx);
+
+		// The following are valid after the graph execution finished:
+		uint32_t GetTaskCount() const { return count; }
+		const char* GetTaskName(Task task) const { return nodes[task].name; }
+		// Execution time of a task in milliseconds
+		float GetTaskTime(Task task) const { return nodes[task].time; }
+		// The longest chain of dependent tasks in milliseconds, this is the shortest possible execution time of the graph with unlimited threads
+		//	path	: if not nullptr, it will be filled with the tasks along the critical path in execution order
+		float GetCriticalPathTime(wi::vector<Task>* path = nullptr) const;
+
+	private:
+		struct Node
+		{
+			const char* name = nullptr;
+			job_function_type task;
+			wi::vector<Task> successors;
+			uint32_t dependencyCount = 0;
+			float time = 0;
+		};
+		wi::vector<Node> nodes; // nodes are kept after Clear() to reuse their allocations
+		uint32_t count = 0;
+		std::unique_ptr<std::atomic<uint32_t>[]> remaining; // remaining dependency counts while executing
+		uint32_t remaining_capacity = 0;
+
+		void Start(context& ctx, Task task);
+	};
 }
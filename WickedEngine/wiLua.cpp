@@ -28,22 +28,85 @@
 #include "wiAsync_BindLua.h"
 #include "wiTimer.h"
 #include "wiVector.h"
+#include "wiAllocator.h"
 #include "wiVersion.h"
+#include "wiJobSystem.h"
 
 #include <memory>
+#include <functional>
+#include <mutex>
+#include <atomic>
+#include <cstring>
+#include <string_view>
 
 namespace wi::lua
 {
 	static constexpr const char* WILUA_ERROR_PREFIX = "[Lua Error] ";
+
+#if WI_MEMORY_TRACKING
+	// The default allocator of Lua states is wrapped to account script memory, every state counts as one allocation:
+	static lua_Alloc default_lua_alloc = nullptr;
+	static void* TrackedLuaAlloc(void* ud, void* ptr, size_t osize, size_t nsize)
+	{
+		const size_t old_size = ptr != nullptr ? osize : 0; // when ptr is null, osize is the type of the new object
+		void* result = default_lua_alloc(ud, ptr, osize, nsize);
+		if (nsize == 0 || result != nullptr)
+		{
+			if (nsize > old_size)
+			{
+				wi::allocator::TrackAllocation(wi::allocator::MemoryTag::Lua, nsize - old_size, 0);
+			}
+			else if (nsize < old_size)
+			{
+				wi::allocator::TrackFree(wi::allocator::MemoryTag::Lua, old_size - nsize, 0);
+			}
+		}
+		return result;
+	}
+#endif // WI_MEMORY_TRACKING
+
+	static lua_State* NewState()
+	{
+		lua_State* L = luaL_newstate();
+#if WI_MEMORY_TRACKING
+		if (L != nullptr)
+		{
+			void* ud = nullptr;
+			default_lua_alloc = lua_getallocf(L, &ud);
+			const size_t size = size_t(lua_gc(L, LUA_GCCOUNT, 0)) * 1024 + size_t(lua_gc(L, LUA_GCCOUNTB, 0));
+			wi::allocator::TrackAllocation(wi::allocator::MemoryTag::Lua, size);
+			lua_setallocf(L, TrackedLuaAlloc, ud);
+		}
+#endif // WI_MEMORY_TRACKING
+		return L;
+	}
+	static void CloseState(lua_State* L)
+	{
+		lua_close(L);
+		wi::allocator::TrackFree(wi::allocator::MemoryTag::Lua, 0); // the memory of the state was already accounted by the allocator
+	}
+
 	struct LuaInternal
 	{
 		lua_State* m_luaState = NULL;
 
+		struct WorkerState
+		{
+			lua_State* L = nullptr;
+			WorkerState* prev = nullptr; // the state that was current on the thread before this one was begun
+			wi::vector<std::function<void()>> deferred_commands;
+		};
+		wi::vector<WorkerState> workers;
+
 		~LuaInternal()
 		{
+			for (auto& worker : workers)
+			{
+				CloseState(worker.L);
+			}
 			if (m_luaState != NULL)
 			{
-				lua_close(m_luaState);
+				CloseState(m_luaState);
 			}
 		}
 	};
@@ -52,6 +115,143 @@ namespace wi::lua
 		static LuaInternal luainternal;
 		return luainternal;
 	}
+	static thread_local LuaInternal::WorkerState* current_worker = nullptr;
+
+	static constexpr size_t BYTECODE_CACHE_MIN_TEXT_SIZE = 1024; // RunText() uses the bytecode cache above this source size
+	static constexpr size_t BYTECODE_CACHE_MEMORY_BUDGET = 16ull * 1024ull * 1024ull; // in-memory entries are evicted above this size
+	struct BytecodeCache
+	{
+		// The cache files store the source next to the bytecode, so an entry is only used if the source is exactly the same, not just the hash:
+		struct FileHeader
+		{
+			uint32_t magic = 0;
+			uint32_t lua_version = 0;
+			uint64_t source_hash = 0;
+			uint64_t source_size = 0;
+			uint64_t bytecode_size = 0;
+		};
+		static constexpr uint32_t magic = 0x32554C57; // "WLU2"
+
+		struct Entry
+		{
+			std::string source;
+			wi::vector<uint8_t> bytecode;
+		};
+
+		std::atomic_bool enabled{ true };
+		std::atomic<uint32_t> hits{ 0 };
+		std::atomic<uint32_t> misses{ 0 };
+		std::mutex locker;
+		wi::unordered_map<uint64_t, Entry> entries; // source hash -> entry
+		size_t entries_size = 0; // memory used by entries
+
+		// 64-bit FNV-1a, unlike std::hash this is the same on every platform and build, so it can be used for file names:
+		static uint64_t Hash(std::string_view source)
+		{
+			uint64_t hash = 0xcbf29ce484222325ull;
+			for (char c : source)
+			{
+				hash ^= (uint8_t)c;
+				hash *= 0x100000001b3ull;
+			}
+			return hash;
+		}
+
+		static std::string GetFileName(uint64_t source_hash)
+		{
+			static const std::string directory = [] {
+				std::string dir = wi::helper::GetCacheDirectoryPath() + "/WickedEngine/lua_bytecode/";
+				wi::helper::DirectoryCreate(dir);
+				return dir;
+			}();
+			char name[32] = {};
+			snprintf(name, sizeof(name), "%016llx.luac", (unsigned long long)source_hash);
+			return directory + name;
+		}
+
+		// Must be called with locker held
+		void Insert(uint64_t source_hash, std::string_view source, const wi::vector<uint8_t>& bytecode)
+		{
+			const size_t size = source.size() + bytecode.size();
+			if (size > BYTECODE_CACHE_MEMORY_BUDGET)
+				return;
+			auto it = entries.find(source_hash);
+			if (it != entries.end())
+			{
+				entries_size -= it->second.source.size() + it->second.bytecode.size();
+				entries.erase(it);
+			}
+			while (entries_size + size > BYTECODE_CACHE_MEMORY_BUDGET && !entries.empty())
+			{
+				it = entries.begin();
+				entries_size -= it->second.source.size() + it->second.bytecode.size();
+				entries.erase(it);
+			}
+			Entry& entry = entries[source_hash];
+			entry.source = source;
+			entry.bytecode = bytecode;
+			entries_size += size;
+		}
+
+		bool Load(uint64_t source_hash, std::string_view source, wi::vector<uint8_t>& dst)
+		{
+			{
+				std::scoped_lock lck(locker);
+				auto it = entries.find(source_hash);
+				if (it != entries.end() && it->second.source == source)
+				{
+					dst = it->second.bytecode;
+					return true;
+				}
+			}
+
+			// The file is invalidated if it was made from a different source or with a different Lua version:
+			wi::vector<uint8_t> filedata;
+			if (!wi::helper::FileRead(GetFileName(source_hash), filedata) || filedata.size() < sizeof(FileHeader))
+				return false;
+			FileHeader header;
+			std::memcpy(&header, filedata.data(), sizeof(header));
+			if (
+				header.magic != magic ||
+				header.lua_version != LUA_VERSION_RELEASE_NUM ||
+				header.source_hash != source_hash ||
+				header.source_size != source.size() ||
+				filedata.size() < sizeof(header) + source.size() ||
+				header.bytecode_size != filedata.size() - sizeof(header) - source.size() ||
+				std::memcmp(filedata.data() + sizeof(header), source.data(), source.size()) != 0
+				)
+				return false;
+			dst.assign(filedata.begin() + sizeof(header) + source.size(), filedata.end());
+
+			std::scoped_lock lck(locker);
+			Insert(source_hash, source, dst);
+			return true;
+		}
+
+		void Store(uint64_t source_hash, std::string_view source, const wi::vector<uint8_t>& bytecode)
+		{
+			{
+				std::scoped_lock lck(locker);
+				auto it = entries.find(source_hash);
+				if (it != entries.end() && it->second.source == source)
+					return; // another thread already compiled and stored the same source
+				Insert(source_hash, source, bytecode);
+			}
+
+			FileHeader header;
+			header.magic = magic;
+			header.lua_version = LUA_VERSION_RELEASE_NUM;
+			header.source_hash = source_hash;
+			header.source_size = source.size();
+			header.bytecode_size = bytecode.size();
+			wi::vector<uint8_t> filedata(sizeof(header) + source.size() + bytecode.size());
+			std::memcpy(filedata.data(), &header, sizeof(header));
+			std::memcpy(filedata.data() + sizeof(header), source.data(), source.size());
+			std::memcpy(filedata.data() + sizeof(header) + source.size(), bytecode.data(), bytecode.size());
+			wi::helper::FileWrite(GetFileName(source_hash), filedata.data(), filedata.size());
+		}
+	};
+	static BytecodeCache bytecode_cache;
 
 	wi::Application* editorApplication = nullptr;
 	wi::RenderPath* editorRenderPath = nullptr;
@@ -65,9 +265,12 @@ namespace wi::lua
 	{
 		if (editorApplication != nullptr && editorRenderPath != nullptr)
 		{
-			KillProcesses();
-			editorApplication->ActivatePath(editorRenderPath);
-			wi::input::ResetCursors();
+			// Switching the render path is not thread safe, so a script running in parallel will do it after the parallel phase:
+			DeferCommand([] {
+				KillProcesses();
+				editorApplication->ActivatePath(editorRenderPath);
+				wi::input::ResetCursors();
+			});
 		}
 		return 0;
 	}
@@ -90,7 +293,7 @@ namespace wi::lua
 
 	void PostErrorMsg()
 	{
-		PostErrorMsg(lua_internal().m_luaState);
+		PostErrorMsg(GetLuaState());
 	}
 
 	uint32_t GeneratePID()
@@ -121,7 +324,14 @@ namespace wi::lua
 
 		std::string dynamic_inject = "--[[" + filepath + "--]]";
 		dynamic_inject += "local function script_file() return \"" + filepath + "\" end;";
-		dynamic_inject += "local function script_pid() return \"" + std::to_string(PID) + "\" end;";
+		if (PID == SCRIPT_PID_ARGUMENT)
+		{
+			dynamic_inject += "local script_pid_value = ...; local function script_pid() return script_pid_value end;";
+		}
+		else
+		{
+			dynamic_inject += "local function script_pid() return \"" + std::to_string(PID) + "\" end;";
+		}
 		dynamic_inject += "local function script_dir() return \"" + wi::helper::GetDirectoryFromPath(filepath) + "\" end;";
 		dynamic_inject += persistent_inject;
 		script = dynamic_inject + customparameters_prepend + script + customparameters_append;
@@ -264,15 +474,10 @@ namespace wi::lua
 		return 1;
 	}
 
-	void Initialize()
+	// Sets up the standard libraries and the global functions of the current lua state:
+	void InitializeStateCommon()
 	{
-		if (lua_internal().m_luaState != nullptr)
-			return; // already initialized
-
-		wi::Timer timer;
-
-		lua_internal().m_luaState = luaL_newstate();
-		luaL_openlibs(lua_internal().m_luaState);
+		luaL_openlibs(GetLuaState());
 		RegisterFunc("dofile", Internal_DoFile);
 		RegisterFunc("dobinaryfile", Internal_DoBinaryFile);
 		RegisterFunc("compilebinaryfile", Internal_CompileBinaryFile);
@@ -288,6 +493,17 @@ namespace wi::lua
 		RegisterFunc("GetVersionString", GetVersionString);
 		RegisterFunc("GetCreditsString", GetCreditsString);
 		RegisterFunc("GetSupportersString", GetSupportersString);
+	}
+
+	void Initialize()
+	{
+		if (lua_internal().m_luaState != nullptr)
+			return; // already initialized
+
+		wi::Timer timer;
+
+		lua_internal().m_luaState = NewState();
+		InitializeStateCommon();
 
 		Vector_BindLua::Bind();
 		Matrix_BindLua::Bind();
@@ -322,12 +538,97 @@ namespace wi::lua
 
 	lua_State* GetLuaState()
 	{
+		if (current_worker != nullptr)
+			return current_worker->L;
 		return lua_internal().m_luaState;
 	}
 
+	uint32_t GetWorkerStateCount()
+	{
+		LuaInternal& internal = lua_internal();
+		if (internal.workers.empty() && internal.m_luaState != nullptr)
+		{
+			wi::Timer timer;
+
+			internal.workers.resize(std::max(1u, wi::jobsystem::GetThreadCount()));
+			for (uint32_t i = 0; i < (uint32_t)internal.workers.size(); ++i)
+			{
+				internal.workers[i].L = NewState();
+				BeginWorkerState(i);
+				InitializeStateCommon();
+
+				// Only the bindings which are safe to use from multiple threads:
+				Vector_BindLua::Bind();
+				Matrix_BindLua::Bind();
+				scene::Bind();
+				Input_BindLua::Bind();
+				backlog::Bind();
+				primitive::Bind();
+
+				EndWorkerState();
+			}
+
+			wilog("wi::lua worker states initialized [%d] (%d ms)", (int)internal.workers.size(), (int)std::round(timer.elapsed()));
+		}
+		return (uint32_t)internal.workers.size();
+	}
+	void BeginWorkerState(uint32_t index)
+	{
+		LuaInternal::WorkerState& worker = lua_internal().workers[index];
+		assert(worker.prev == nullptr); // a worker state must not be used by multiple threads at the same time
+		worker.prev = current_worker;
+		current_worker = &worker;
+	}
+	void EndWorkerState()
+	{
+		assert(current_worker != nullptr);
+		LuaInternal::WorkerState* worker = current_worker;
+		current_worker = worker->prev;
+		worker->prev = nullptr;
+	}
+	bool IsWorkerState()
+	{
+		return current_worker != nullptr;
+	}
+	void DeferCommand(std::function<void()>&& command)
+	{
+		if (current_worker == nullptr)
+		{
+			command();
+			return;
+		}
+		current_worker->deferred_commands.push_back(std::move(command));
+	}
+	void FlushDeferredCommands()
+	{
+		assert(current_worker == nullptr);
+		for (auto& worker : lua_internal().workers)
+		{
+			// The commands can defer further commands (eg. ReturnToEditor), those are executed immediately because this is not a worker:
+			for (size_t i = 0; i < worker.deferred_commands.size(); ++i)
+			{
+				worker.deferred_commands[i]();
+			}
+			worker.deferred_commands.clear();
+		}
+	}
+	bool BindOnce(const char* name)
+	{
+		lua_State* L = GetLuaState();
+		const std::string key = std::string("wi_bindonce_") + name;
+		lua_getfield(L, LUA_REGISTRYINDEX, key.c_str());
+		const bool bound = lua_toboolean(L, -1);
+		lua_pop(L, 1);
+		if (bound)
+			return false;
+		lua_pushboolean(L, 1);
+		lua_setfield(L, LUA_REGISTRYINDEX, key.c_str());
+		return true;
+	}
+
 	bool RunScript()
 	{
-		if(lua_pcall(lua_internal().m_luaState, 0, LUA_MULTRET, 0) != LUA_OK)
+		if(lua_pcall(GetLuaState(), 0, LUA_MULTRET, 0) != LUA_OK)
 		{
 			PostErrorMsg();
 			return false;
@@ -340,8 +641,11 @@ namespace wi::lua
 		if (wi::helper::FileRead(filename, filedata))
 		{
 			std::string script = std::string(filedata.begin(), filedata.end());
-			AttachScriptParameters(script, filename);
-			return RunText(script);
+			AttachScriptParameters(script, filename, SCRIPT_PID_ARGUMENT);
+			wi::vector<uint8_t> bytecode;
+			if (!CompileText(script, bytecode))
+				return false;
+			return RunBinaryData(bytecode.data(), bytecode.size(), filename, GeneratePID());
 		}
 		return false;
 	}
@@ -356,7 +660,13 @@ namespace wi::lua
 	}
 	bool RunText(const char* script)
 	{
-		if(luaL_loadstring(lua_internal().m_luaState, script) == LUA_OK)
+		// Large sources go through the bytecode cache, small ones are faster to parse than to look up:
+		if (IsBytecodeCacheEnabled() && strlen(script) >= BYTECODE_CACHE_MIN_TEXT_SIZE)
+		{
+			wi::vector<uint8_t> bytecode;
+			return CompileText(script, bytecode) && RunBinaryData(bytecode.data(), bytecode.size());
+		}
+		if(luaL_loadstring(GetLuaState(), script) == LUA_OK)
 		{
 			return RunScript();
 		}
@@ -366,7 +676,7 @@ namespace wi::lua
 	}
 	bool RunBinaryData(const void* data, size_t size, const char* debugname)
 	{
-		if(luaL_loadbuffer(lua_internal().m_luaState, (const char*)data, size, debugname) == LUA_OK)
+		if(luaL_loadbuffer(GetLuaState(), (const char*)data, size, debugname) == LUA_OK)
 		{
 			return RunScript();
 		}
@@ -374,18 +684,46 @@ namespace wi::lua
 		PostErrorMsg();
 		return false;
 	}
+	bool RunBinaryData(const void* data, size_t size, const char* debugname, uint32_t PID, std::initializer_list<long long> args)
+	{
+		lua_State* L = GetLuaState();
+		if(luaL_loadbuffer(L, (const char*)data, size, debugname) != LUA_OK)
+		{
+			PostErrorMsg();
+			return false;
+		}
+		SSetString(L, std::to_string(PID)); // the PID is a string, same as when it's written into the script
+		for (long long arg : args)
+		{
+			SSetLongLong(L, arg);
+		}
+		if(lua_pcall(L, 1 + (int)args.size(), LUA_MULTRET, 0) != LUA_OK)
+		{
+			PostErrorMsg();
+			return false;
+		}
+		return true;
+	}
 	void RegisterFunc(const char* name, lua_CFunction function)
 	{
-		lua_register(lua_internal().m_luaState, name, function);
+		lua_register(GetLuaState(), name, function);
 	}
 
+	inline void SetDeltaTimeHelper(lua_State* L, double dt)
+	{
+		lua_getglobal(L, "setDeltaTime");
+		SSetDouble(L, dt);
+		if(lua_pcall(L, 1, LUA_MULTRET, 0) != LUA_OK)
+		{
+			PostErrorMsg(L);
+		}
+	}
 	void SetDeltaTime(double dt)
 	{
-		lua_getglobal(lua_internal().m_luaState, "setDeltaTime");
-		SSetDouble(lua_internal().m_luaState, dt);
-		if(lua_pcall(lua_internal().m_luaState, 1, LUA_MULTRET, 0) != LUA_OK)
+		SetDeltaTimeHelper(lua_internal().m_luaState, dt);
+		for (auto& worker : lua_internal().workers)
 		{
-			PostErrorMsg();
+			SetDeltaTimeHelper(worker.L, dt);
 		}
 	}
 
@@ -395,29 +733,46 @@ namespace wi::lua
 		lua_pushstring(L, str);
 		if(lua_pcall(L, 1, LUA_MULTRET, 0) != LUA_OK)
 		{
-			PostErrorMsg();
+			PostErrorMsg(L);
+		}
+	}
+	// Signals are also sent to worker states, because independent scripts can have processes waiting on them:
+	inline void SignalAllStates(const char* str)
+	{
+		SignalHelper(lua_internal().m_luaState, str);
+		for (auto& worker : lua_internal().workers)
+		{
+			SignalHelper(worker.L, str);
 		}
 	}
 	void FixedUpdate()
 	{
-		SignalHelper(lua_internal().m_luaState, "wickedengine_fixed_update_tick");
+		SignalAllStates("wickedengine_fixed_update_tick");
 	}
 	void Update()
 	{
-		SignalHelper(lua_internal().m_luaState, "wickedengine_update_tick");
+		SignalAllStates("wickedengine_update_tick");
 	}
 	void Render()
 	{
-		SignalHelper(lua_internal().m_luaState, "wickedengine_render_tick");
+		SignalAllStates("wickedengine_render_tick");
 	}
 	void Signal(const char* name)
 	{
-		SignalHelper(lua_internal().m_luaState, name);
+		SignalAllStates(name);
 	}
 
 	void KillProcesses()
 	{
 		RunText("killProcesses();");
+		if (current_worker != nullptr)
+			return; // the other worker states could be in use by other threads
+		for (uint32_t i = 0; i < (uint32_t)lua_internal().workers.size(); ++i)
+		{
+			BeginWorkerState(i);
+			RunText("killProcesses();");
+			EndWorkerState();
+		}
 	}
 
 	const char* SGetString(lua_State* L, int stackpos)
@@ -668,22 +1023,58 @@ namespace wi::lua
 	}
 	bool CompileText(const char* script, wi::vector<uint8_t>& dst)
 	{
-		if(luaL_loadstring(lua_internal().m_luaState, script) != LUA_OK)
+		const std::string_view source = script;
+		uint64_t source_hash = 0;
+		if (IsBytecodeCacheEnabled())
+		{
+			source_hash = BytecodeCache::Hash(source);
+			if (bytecode_cache.Load(source_hash, source, dst))
+			{
+				bytecode_cache.hits.fetch_add(1);
+				return true;
+			}
+			bytecode_cache.misses.fetch_add(1);
+		}
+
+		lua_State* L = GetLuaState();
+		if(luaL_loadstring(L, script) != LUA_OK)
 		{
 			PostErrorMsg();
 			return false;
 		}
 		dst.clear();
-		if(lua_dump(lua_internal().m_luaState, writer, &dst, 0) != LUA_OK)
+		if(lua_dump(L, writer, &dst, 0) != LUA_OK)
 		{
 			PostErrorMsg();
-			lua_pop(lua_internal().m_luaState, 1); // lua_dump does not pop the dumped function from stack
+			lua_pop(L, 1); // lua_dump does not pop the dumped function from stack
 			return false;
 		}
-		lua_pop(lua_internal().m_luaState, 1); // lua_dump does not pop the dumped function from stack
+		lua_pop(L, 1); // lua_dump does not pop the dumped function from stack
+
+		if (IsBytecodeCacheEnabled())
+		{
+			bytecode_cache.Store(source_hash, source, dst);
+		}
 		return true;
 	}
 
+	void SetBytecodeCacheEnabled(bool value)
+	{
+		bytecode_cache.enabled.store(value);
+	}
+	bool IsBytecodeCacheEnabled()
+	{
+		return bytecode_cache.enabled.load();
+	}
+	uint32_t GetBytecodeCacheHitCount()
+	{
+		return bytecode_cache.hits.load();
+	}
+	uint32_t GetBytecodeCacheMissCount()
+	{
+		return bytecode_cache.misses.load();
+	}
+
 	void EnableEditorFunctionality(wi::Application* application, wi::RenderPath* renderpath)
 	{
 		editorApplication = application;
@@ -6,6 +6,7 @@
 #include "wiRenderPath.h"
 
 #include <string>
+#include <functional>
 
 extern "C"
 {
@@ -33,6 +34,8 @@ namespace wi::lua
 	inline bool RunText(const std::string& script) { return RunText(script.c_str()); }
 	//run binary script
 	bool RunBinaryData(const void* data, size_t size, const char* debugname = "");
+	//run binary script that was compiled with SCRIPT_PID_ARGUMENT (see AttachScriptParameters()), the additional integer arguments can be accessed in the script with select(2, ...)
+	bool RunBinaryData(const void* data, size_t size, const char* debugname, uint32_t PID, std::initializer_list<long long> args = {});
 	//register function to use in scripts
 	void RegisterFunc(const char* name, lua_CFunction function);
 	inline void RegisterFunc(const std::string& name, lua_CFunction function) { RegisterFunc(name.c_str(), function); }
@@ -53,9 +56,31 @@ namespace wi::lua
 	//kill every running background task (coroutine)
 	void KillProcesses();
 
+	// Worker lua states are used to run independent scripts in parallel, there is one for each job system thread
+	//	They only contain the bindings that are safe to use from multiple threads (math, scene, primitive, input, backlog)
+	//	Returns the number of worker lua states, they are created on first use (must be called from the main thread)
+	uint32_t GetWorkerStateCount();
+	// Makes the worker lua state the current one on the calling thread, the functions of wi::lua will operate on it until EndWorkerState()
+	//	A worker lua state must not be used by multiple threads at the same time
+	void BeginWorkerState(uint32_t index);
+	void EndWorkerState();
+	// Returns true if the calling thread is currently using a worker lua state
+	bool IsWorkerState();
+	// When the calling thread is using a worker lua state, the command will be executed by FlushDeferredCommands(), otherwise it is executed immediately
+	//	This is used for operations that are not thread safe, like structural scene changes
+	void DeferCommand(std::function<void()>&& command);
+	// Executes the deferred commands of all worker lua states in order (must be called from the main thread after the worker states finished)
+	void FlushDeferredCommands();
+	// Returns true when called the first time with the name on the current lua state, this lets bindings be registered once into every lua state
+	bool BindOnce(const char* name);
+
 	// Generates a unique identifier for a script instance:
 	uint32_t GeneratePID();
 
+	// If this is used as PID for AttachScriptParameters(), then the PID is not written into the script, but it must be given when running it
+	//	This way every instance of the script compiles to the same bytecode, which can be shared by the bytecode cache
+	static constexpr uint32_t SCRIPT_PID_ARGUMENT = 0; // GeneratePID() never returns this
+
 	// Adds some local management functions to the script
 	//	returns the PID
 	uint32_t AttachScriptParameters(std::string& script, const std::string& filename = "", uint32_t PID = GeneratePID(), const std::string& customparameters_prepend = "", const std::string& customparameters_append = "");
@@ -198,9 +223,18 @@ namespace wi::lua
 	bool CompileFile(const char* filename, wi::vector<uint8_t>& dst);
 	inline bool CompileFile(const std::string& filename, wi::vector<uint8_t>& dst) { return CompileFile(filename.c_str(), dst); }
 	// Compiles LUA source code text into binary LUA code
+	//	The bytecode cache is checked first if it's enabled
 	bool CompileText(const char* script, wi::vector<uint8_t>& dst);
 	inline bool CompileText(const std::string& script, wi::vector<uint8_t>& dst) { return CompileText(script.c_str(), dst); }
 
+	// The bytecode cache keeps compiled scripts in memory (up to a budget) and in the cache directory on disk
+	//	Entries are identified by a stable hash of their source and the Lua version, and are only used if the stored source is exactly the same
+	//	CompileText(), RunFile(), large RunText() sources and script components will use it to skip compilation (enabled by default)
+	void SetBytecodeCacheEnabled(bool value);
+	bool IsBytecodeCacheEnabled();
+	uint32_t GetBytecodeCacheHitCount();
+	uint32_t GetBytecodeCacheMissCount();
+
 	// With this you can enable the IsThisEditor() and ReturnToEditor() functionality in lua scripts
 	//	This allows easier script testing with editor functionality instead of managing previous render paths yourself in scripts
 	void EnableEditorFunctionality(wi::Application* application, wi::RenderPath* renderpath);
@@ -689,10 +689,8 @@ namespace wi::lua
 
 	void Vector_BindLua::Bind()
 	{
-		static bool initialized = false;
-		if (!initialized)
+		if (wi::lua::BindOnce("Vector"))
 		{
-			initialized = true;
 			Luna<Vector_BindLua>::Register(wi::lua::GetLuaState());
 			Luna<Vector_BindLua>::push_global(wi::lua::GetLuaState(), "vector");
 		}
@@ -1098,10 +1096,8 @@ namespace wi::lua
 
 	void Matrix_BindLua::Bind()
 	{
-		static bool initialized = false;
-		if (!initialized)
+		if (wi::lua::BindOnce("Matrix"))
 		{
-			initialized = true;
 			Luna<Matrix_BindLua>::Register(wi::lua::GetLuaState());
 			Luna<Matrix_BindLua>::push_global(wi::lua::GetLuaState(), "matrix");
 		}
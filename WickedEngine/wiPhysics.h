@@ -26,6 +26,16 @@ namespace wi::physics
 	void SetInterpolationEnabled(bool value);
 	bool IsInterpolationEnabled();
 
+	// Enable/disable the asynchronous simulation (default = false)
+	//	When enabled, the simulation steps run in the background after the physics update, while the frame is rendered
+	//	Their results are applied in the next physics update, so they are presented with one frame of latency
+	//	The physics functions wait for the running simulation before they access the physics objects
+	void SetAsyncSimulationEnabled(bool value);
+	bool IsAsyncSimulationEnabled();
+
+	// Waits for the asynchronous simulation of the scene to finish
+	void WaitAsyncSimulation(wi::scene::Scene& scene);
+
 	// Enable/disable debug drawing of physics objects
 	void SetDebugDrawEnabled(bool value);
 	bool IsDebugDrawEnabled();
@@ -54,6 +64,10 @@ namespace wi::physics
 	void SetCharacterCollisionTolerance(float value);
 	float GetCharacterCollisionTolerance();
 
+	// Returns the most temporary memory in bytes that a simulation step needed so far
+	//	Temporary memory is reserved to fit this, so it shows how much memory the simulation holds on to
+	size_t GetTemporaryMemoryHighWaterMark();
+
 	// Update the physics state, run simulation, etc.
 	void RunPhysicsUpdateSystem(
 		wi::jobsystem::context& ctx,
@@ -13,6 +13,8 @@ namespace wi::lua
 		lunamethod(Physics_BindLua, IsSimulationEnabled),
 		lunamethod(Physics_BindLua, SetInterpolationEnabled),
 		lunamethod(Physics_BindLua, IsInterpolationEnabled),
+		lunamethod(Physics_BindLua, SetAsyncSimulationEnabled),
+		lunamethod(Physics_BindLua, IsAsyncSimulationEnabled),
 		lunamethod(Physics_BindLua, SetDebugDrawEnabled),
 		lunamethod(Physics_BindLua, IsDebugDrawEnabled),
 		lunamethod(Physics_BindLua, SetAccuracy),
@@ -105,6 +107,22 @@ namespace wi::lua
 		wi::lua::SSetBool(L, wi::physics::IsInterpolationEnabled());
 		return 1;
 	}
+	int Physics_BindLua::SetAsyncSimulationEnabled(lua_State* L)
+	{
+		int argc = wi::lua::SGetArgCount(L);
+		if (argc > 0)
+		{
+			wi::physics::SetAsyncSimulationEnabled(wi::lua::SGetBool(L, 1));
+		}
+		else
+			wi::lua::SError(L, "SetAsyncSimulationEnabled(bool value) not enough arguments!");
+		return 0;
+	}
+	int Physics_BindLua::IsAsyncSimulationEnabled(lua_State* L)
+	{
+		wi::lua::SSetBool(L, wi::physics::IsAsyncSimulationEnabled());
+		return 1;
+	}
 	int Physics_BindLua::SetDebugDrawEnabled(lua_State* L)
 	{
 		int argc = wi::lua::SGetArgCount(L);
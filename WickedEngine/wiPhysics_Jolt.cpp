@@ -7,12 +7,14 @@
 #include "wiRenderer.h"
 #include "wiTimer.h"
 #include "wiSpinLock.h"
+#include "wiAllocator.h"
 
 #include <Jolt/Jolt.h>
 #include <Jolt/RegisterTypes.h>
 #include <Jolt/Core/Factory.h>
 #include <Jolt/Core/TempAllocator.h>
-#include <Jolt/Core/JobSystemThreadPool.h>
+#include <Jolt/Core/JobSystem.h>
+#include <Jolt/Core/FixedSizeFreeList.h>
 #include <Jolt/Physics/PhysicsSettings.h>
 #include <Jolt/Physics/PhysicsSystem.h>
 #include <Jolt/Physics/Collision/Shape/BoxShape.h>
@@ -92,6 +94,7 @@ namespace wi::physics
 		int softbodyIterationCount = 6;
 		float TIMESTEP = 1.0f / 60.0f;
 		bool INTERPOLATION = true;
+		bool ASYNC_SIMULATION = false;
 		float CHARACTER_COLLISION_TOLERANCE = 0.05f;
 		float DEBUG_MAX_DRAW_DISTANCE = 500.0f;
 		int COLLISION_STEPS = 1;
@@ -170,6 +173,159 @@ namespace wi::physics
 			return ret;
 		}
 
+		// Jolt job system that runs the physics jobs on the wi::jobsystem worker threads instead of a separate thread pool
+		//	This way physics doesn't oversubscribe the cores that are also used by the other engine systems
+		//	A barrier counts its unfinished jobs in a wi::jobsystem::context, and the thread waiting on it helps executing jobs
+		class JobSystemWicked final : public JobSystem
+		{
+			class BarrierImpl final : public Barrier
+			{
+			public:
+				wi::jobsystem::context ctx;
+
+				void AddJob(const JobHandle& inJob) override
+				{
+					ctx.counter.fetch_add(1, std::memory_order_relaxed);
+					if (!inJob.GetPtr()->SetBarrier(this))
+					{
+						ctx.counter.fetch_sub(1, std::memory_order_relaxed); // the job was already finished
+					}
+				}
+				void AddJobs(const JobHandle* inHandles, uint inNumHandles) override
+				{
+					for (uint i = 0; i < inNumHandles; ++i)
+					{
+						AddJob(inHandles[i]);
+					}
+				}
+
+			protected:
+				void OnJobFinished(Job* inJob) override
+				{
+					ctx.counter.fetch_sub(1, std::memory_order_release);
+				}
+			};
+
+			using AvailableJobs = FixedSizeFreeList<Job>;
+			AvailableJobs jobs;
+			wi::jobsystem::context ctx; // all queued jobs
+
+		public:
+			JobSystemWicked(uint inMaxJobs)
+			{
+				jobs.Init(inMaxJobs, inMaxJobs);
+			}
+
+			int GetMaxConcurrency() const override
+			{
+				return int(wi::jobsystem::GetThreadCount() + 1); // +1 for the thread that waits for the jobs
+			}
+
+			JobHandle CreateJob(const char* inName, ColorArg inColor, const JobFunction& inJobFunction, uint32 inNumDependencies = 0) override
+			{
+				uint32 index = jobs.ConstructObject(inName, inColor, this, inJobFunction, inNumDependencies);
+				while (index == AvailableJobs::cInvalidObjectIndex)
+				{
+					assert(0); // no jobs available, wait until some finish
+					std::this_thread::yield();
+					index = jobs.ConstructObject(inName, inColor, this, inJobFunction, inNumDependencies);
+				}
+				Job* job = &jobs.Get(index);
+				JobHandle handle(job); // keep a reference, because the job can be completed before returning
+				if (inNumDependencies == 0)
+				{
+					QueueJob(job);
+				}
+				return handle;
+			}
+
+			Barrier* CreateBarrier() override
+			{
+				return new BarrierImpl;
+			}
+
+			void DestroyBarrier(Barrier* inBarrier) override
+			{
+				delete static_cast<BarrierImpl*>(inBarrier);
+			}
+
+			void WaitForJobs(Barrier* inBarrier) override
+			{
+				BarrierImpl* barrier = static_cast<BarrierImpl*>(inBarrier);
+				while (wi::jobsystem::IsBusy(barrier->ctx))
+				{
+					// Unfinished barrier jobs are either queued or depend on queued jobs, so executing the queued jobs will finish them:
+					wi::jobsystem::Wait(ctx);
+					if (wi::jobsystem::IsBusy(barrier->ctx))
+					{
+						std::this_thread::yield();
+					}
+				}
+				std::atomic_thread_fence(std::memory_order_acquire);
+			}
+
+		protected:
+			void QueueJob(Job* inJob) override
+			{
+				inJob->AddRef(); // the reference is held until the job is executed
+				wi::jobsystem::Execute(ctx, [inJob](wi::jobsystem::JobArgs args) {
+					inJob->Execute();
+					inJob->Release();
+				});
+			}
+
+			void QueueJobs(Job** inJobs, uint inNumJobs) override
+			{
+				for (uint i = 0; i < inNumJobs; ++i)
+				{
+					QueueJob(inJobs[i]);
+				}
+			}
+
+			void FreeJob(Job* inJob) override
+			{
+				jobs.DestructObject(inJob);
+			}
+		};
+
+		// Jolt temp allocator that serves the allocations of a physics step from a growing arena
+		//	The arena is reset after each step, and it will settle to a single block that fits the largest step, so there is no malloc in the steady state
+		//	Jolt frees temp allocations in reverse order and orders them with job dependencies, so no locking is needed
+		class TempAllocatorWicked final : public TempAllocator
+		{
+			wi::allocator::GrowingLinearAllocator arena;
+
+		public:
+			TempAllocatorWicked(size_t page_size)
+			{
+				arena.init(page_size, JPH_RVECTOR_ALIGNMENT);
+			}
+
+			void* Allocate(uint inSize) override
+			{
+				return arena.allocate(inSize);
+			}
+
+			void Free(void* inAddress, uint inSize) override
+			{
+				if (inAddress != nullptr)
+				{
+					arena.free(inSize);
+				}
+			}
+
+			void Reset()
+			{
+				arena.reset();
+			}
+
+			size_t GetHighWaterMark() const
+			{
+				return arena.high_water_mark;
+			}
+		};
+		static std::atomic<size_t> temp_memory_high_water_mark{};
+
 		static std::atomic<uint32_t> collisionGroupID{}; // generate unique collision group for each ragdoll to enable collision between them
 
 		enum Layers : ObjectLayer
@@ -269,13 +425,31 @@ namespace wi::physics
 			ObjectVsBroadPhaseLayerFilterImpl object_vs_broadphase_layer_filter;
 			ObjectLayerPairFilterImpl object_vs_object_layer_filter;
 			PhysicsShapeCache physics_shape_cache;
+			TempAllocatorWicked temp_allocator{ 1024 * 1024 }; // grows when a large simulation needs more
 			float accumulator = 0;
 			float alpha = 0;
 			bool activate_all_rigid_bodies = false;
+			wi::jobsystem::context simulation_ctx; // asynchronous simulation steps that are running
+			uint32_t simulation_step_count = 1; // the number of steps that the last asynchronous simulation performed
+			bool wheel_transforms_cached = false; // vehicle wheel transforms are cached for the asynchronous simulation
 			float GetKinematicDT(float dt) const
 			{
 				return clamp(accumulator + dt, 0.0f, TIMESTEP * ACCURACY);
 			}
+			void Step()
+			{
+				static JobSystemWicked job_system(cMaxPhysicsJobs); // created on first use, after Jolt was initialized
+				wi::profiler::ScopedRangeCPU range("Physics Step");
+				physics_system.Update(TIMESTEP, COLLISION_STEPS, &temp_allocator, &job_system);
+				const size_t high_water_mark = temp_allocator.GetHighWaterMark();
+				size_t prev = temp_memory_high_water_mark.load(std::memory_order_relaxed);
+				while (prev < high_water_mark && !temp_memory_high_water_mark.compare_exchange_weak(prev, high_water_mark, std::memory_order_relaxed));
+				temp_allocator.Reset();
+			}
+			~PhysicsScene()
+			{
+				wi::jobsystem::Wait(simulation_ctx);
+			}
 		};
 		PhysicsScene& GetPhysicsScene(Scene& scene)
 		{
@@ -298,6 +472,20 @@ namespace wi::physics
 			return *(PhysicsScene*)scene.physics_scene.get();
 		}
 
+		// Waits for the asynchronous simulation of the physics scene, the physics objects must not be accessed while it is running
+		void WaitSimulation(const wi::allocator::shared_ptr<void>& physics_scene)
+		{
+			if (physics_scene != nullptr)
+			{
+				wi::jobsystem::Wait(((PhysicsScene*)physics_scene.get())->simulation_ctx);
+			}
+		}
+		PhysicsScene& SyncPhysicsScene(const wi::allocator::shared_ptr<void>& physics_scene)
+		{
+			WaitSimulation(physics_scene);
+			return *(PhysicsScene*)physics_scene.get();
+		}
+
 		struct RigidBody
 		{
 			wi::allocator::shared_ptr<void> physics_scene;
@@ -341,6 +529,8 @@ namespace wi::physics
 			VehicleConstraint* vehicle_constraint = nullptr;
 			Vec3 prev_wheel_positions[4] = { Vec3::sZero(), Vec3::sZero(), Vec3::sZero(), Vec3::sZero() };
 			Quat prev_wheel_rotations[4] = { Quat::sIdentity(), Quat::sIdentity(), Quat::sIdentity(), Quat::sIdentity() };
+			Vec3 wheel_positions[4] = { Vec3::sZero(), Vec3::sZero(), Vec3::sZero(), Vec3::sZero() };
+			Quat wheel_rotations[4] = { Quat::sIdentity(), Quat::sIdentity(), Quat::sIdentity(), Quat::sIdentity() };
 
 			// character:
 			Ref<Character> character = nullptr;
@@ -349,6 +539,7 @@ namespace wi::physics
 			{
 				if (physics_scene == nullptr || bodyID.IsInvalid())
 					return;
+				WaitSimulation(physics_scene);
 				PhysicsScene* jolt_physics_scene = (PhysicsScene*)physics_scene.get();
 				BodyInterface& body_interface = jolt_physics_scene->physics_system.GetBodyInterface(); // locking version because destructor can be called from any thread
 				body_interface.RemoveBody(bodyID);
@@ -408,6 +599,7 @@ namespace wi::physics
 			{
 				if (physics_scene == nullptr || bodyID.IsInvalid())
 					return;
+				WaitSimulation(physics_scene);
 				BodyInterface& body_interface = ((PhysicsScene*)physics_scene.get())->physics_system.GetBodyInterface(); // locking version because destructor can be called from any thread
 				body_interface.RemoveBody(bodyID);
 				body_interface.DestroyBody(bodyID);
@@ -434,6 +626,7 @@ namespace wi::physics
 			{
 				if (physics_scene == nullptr)
 					return;
+				WaitSimulation(physics_scene);
 				if (constraint != nullptr)
 				{
 					((PhysicsScene*)physics_scene.get())->physics_system.RemoveConstraint(constraint);
@@ -458,11 +651,15 @@ namespace wi::physics
 			{
 				physicscomponent.physicsobject = wi::allocator::make_shared<RigidBody>();
 			}
-			return *(RigidBody*)physicscomponent.physicsobject.get();
+			RigidBody& physicsobject = *(RigidBody*)physicscomponent.physicsobject.get();
+			WaitSimulation(physicsobject.physics_scene);
+			return physicsobject;
 		}
 		const RigidBody& GetRigidBody(const wi::scene::RigidBodyPhysicsComponent& physicscomponent)
 		{
-			return *(RigidBody*)physicscomponent.physicsobject.get();
+			const RigidBody& physicsobject = *(RigidBody*)physicscomponent.physicsobject.get();
+			WaitSimulation(physicsobject.physics_scene);
+			return physicsobject;
 		}
 		SoftBody& GetSoftBody(wi::scene::SoftBodyPhysicsComponent& physicscomponent)
 		{
@@ -470,11 +667,15 @@ namespace wi::physics
 			{
 				physicscomponent.physicsobject = wi::allocator::make_shared<SoftBody>();
 			}
-			return *(SoftBody*)physicscomponent.physicsobject.get();
+			SoftBody& physicsobject = *(SoftBody*)physicscomponent.physicsobject.get();
+			WaitSimulation(physicsobject.physics_scene);
+			return physicsobject;
 		}
 		const SoftBody& GetSoftBody(const wi::scene::SoftBodyPhysicsComponent& physicscomponent)
 		{
-			return *(SoftBody*)physicscomponent.physicsobject.get();
+			const SoftBody& physicsobject = *(SoftBody*)physicscomponent.physicsobject.get();
+			WaitSimulation(physicsobject.physics_scene);
+			return physicsobject;
 		}
 		Constraint& GetConstraint(wi::scene::PhysicsConstraintComponent& physicscomponent)
 		{
@@ -482,11 +683,62 @@ namespace wi::physics
 			{
 				physicscomponent.physicsobject = wi::allocator::make_shared<Constraint>();
 			}
-			return *(Constraint*)physicscomponent.physicsobject.get();
+			Constraint& physicsobject = *(Constraint*)physicscomponent.physicsobject.get();
+			WaitSimulation(physicsobject.physics_scene);
+			return physicsobject;
 		}
 		const Constraint& GetConstraint(const wi::scene::PhysicsConstraintComponent& physicscomponent)
 		{
-			return *(Constraint*)physicscomponent.physicsobject.get();
+			const Constraint& physicsobject = *(Constraint*)physicscomponent.physicsobject.get();
+			WaitSimulation(physicsobject.physics_scene);
+			return physicsobject;
+		}
+
+		// Returns the wheel entities of a vehicle in the order of the simulated wheels, and the number of wheels
+		uint32_t GetWheelEntities(const RigidBodyPhysicsComponent& physicscomponent, Entity wheel_entities[4])
+		{
+			if (physicscomponent.vehicle.type == RigidBodyPhysicsComponent::Vehicle::Type::Car)
+			{
+				wheel_entities[0] = physicscomponent.vehicle.wheel_entity_front_left;
+				wheel_entities[1] = physicscomponent.vehicle.wheel_entity_front_right;
+				wheel_entities[2] = physicscomponent.vehicle.wheel_entity_rear_left;
+				wheel_entities[3] = physicscomponent.vehicle.wheel_entity_rear_right;
+				return 4;
+			}
+			wheel_entities[0] = physicscomponent.vehicle.wheel_entity_front_left;
+			wheel_entities[1] = physicscomponent.vehicle.wheel_entity_rear_left;
+			return 2;
+		}
+
+		// Computes the interpolated wheel transforms of a vehicle from the simulation
+		void ComputeWheelTransforms(const Scene& scene, const PhysicsScene& physics_scene, const RigidBodyPhysicsComponent& physicscomponent, RigidBody& physicsobject)
+		{
+			Entity wheel_entities[4];
+			const uint32_t count = GetWheelEntities(physicscomponent, wheel_entities);
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				if (wheel_entities[i] == INVALID_ENTITY)
+					continue;
+
+				const TransformComponent* wheel_transform = scene.transforms.GetComponent(wheel_entities[i]);
+				if (wheel_transform == nullptr)
+					continue;
+
+				XMFLOAT4X4 localMatrix;
+				XMStoreFloat4x4(&localMatrix, wheel_transform->GetLocalMatrix());
+				Vec3 right = cast(wi::math::GetRight(localMatrix)).Normalized();
+				Vec3 up = cast(wi::math::GetUp(localMatrix)).Normalized();
+				Mat44 wheelmat = physicsobject.vehicle_constraint->GetWheelWorldTransform(i, right, up);
+				Vec3 wheelpos = wheelmat.GetTranslation();
+				Quat wheelrot = wheelmat.GetQuaternion();
+				if (IsInterpolationEnabled())
+				{
+					wheelpos = wheelpos * physics_scene.alpha + physicsobject.prev_wheel_positions[i] * (1 - physics_scene.alpha);
+					wheelrot = physicsobject.prev_wheel_rotations[i].SLERP(wheelrot, physics_scene.alpha);
+				}
+				physicsobject.wheel_positions[i] = wheelpos;
+				physicsobject.wheel_rotations[i] = wheelrot;
+			}
 		}
 
 		void AddRigidBody(
@@ -1832,6 +2084,7 @@ namespace wi::physics
 			{
 				if (physics_scene == nullptr)
 					return;
+				WaitSimulation(physics_scene);
 				PhysicsSystem& physics_system = ((PhysicsScene*)physics_scene.get())->physics_system;
 
 				const int count = (int)ragdoll->GetBodyCount();
@@ -1919,6 +2172,105 @@ namespace wi::physics
 			}
 		};
 
+#if WI_MEMORY_TRACKING && !defined(JPH_DISABLE_CUSTOM_ALLOCATOR)
+		// The default Jolt allocator is wrapped to account physics memory
+		//	Jolt doesn't provide the size when freeing, so every block has a header that stores it right before the returned pointer:
+		struct TrackedBlockHeader
+		{
+			size_t size = 0;
+			size_t offset = 0; // offset of the header end from the start of the underlying block
+		};
+		static constexpr size_t tracked_header_size = 16; // keeps the 16 byte alignment that Jolt requires from Allocate
+		static_assert(sizeof(TrackedBlockHeader) <= tracked_header_size);
+		static AllocateFunction default_allocate = nullptr;
+		static ReallocateFunction default_reallocate = nullptr;
+		static FreeFunction default_free = nullptr;
+		static AlignedAllocateFunction default_aligned_allocate = nullptr;
+		static AlignedFreeFunction default_aligned_free = nullptr;
+		inline TrackedBlockHeader* GetTrackedBlockHeader(void* block)
+		{
+			return (TrackedBlockHeader*)((uint8_t*)block - sizeof(TrackedBlockHeader));
+		}
+		inline void* InitTrackedBlock(void* base, size_t size, size_t offset)
+		{
+			if (base == nullptr)
+				return nullptr;
+			void* block = (uint8_t*)base + offset;
+			TrackedBlockHeader* header = GetTrackedBlockHeader(block);
+			header->size = size;
+			header->offset = offset;
+			return block;
+		}
+		void* TrackedAllocate(size_t size)
+		{
+			void* block = InitTrackedBlock(default_allocate(size + tracked_header_size), size, tracked_header_size);
+			if (block != nullptr)
+			{
+				wi::allocator::TrackAllocation(wi::allocator::MemoryTag::Physics, size);
+			}
+			return block;
+		}
+		void* TrackedReallocate(void* block, size_t old_size, size_t new_size)
+		{
+			if (block == nullptr)
+				return TrackedAllocate(new_size);
+			old_size = GetTrackedBlockHeader(block)->size;
+			void* base = (uint8_t*)block - tracked_header_size;
+			void* new_block = InitTrackedBlock(default_reallocate(base, old_size + tracked_header_size, new_size + tracked_header_size), new_size, tracked_header_size);
+			if (new_block != nullptr)
+			{
+				wi::allocator::TrackFree(wi::allocator::MemoryTag::Physics, old_size, 0);
+				wi::allocator::TrackAllocation(wi::allocator::MemoryTag::Physics, new_size, 0);
+			}
+			return new_block;
+		}
+		void TrackedFree(void* block)
+		{
+			if (block == nullptr)
+				return;
+			const TrackedBlockHeader* header = GetTrackedBlockHeader(block);
+			wi::allocator::TrackFree(wi::allocator::MemoryTag::Physics, header->size);
+			default_free((uint8_t*)block - header->offset);
+		}
+		void* TrackedAlignedAllocate(size_t size, size_t alignment)
+		{
+			const size_t offset = std::max(alignment, tracked_header_size);
+			void* block = InitTrackedBlock(default_aligned_allocate(size + offset, alignment), size, offset);
+			if (block != nullptr)
+			{
+				wi::allocator::TrackAllocation(wi::allocator::MemoryTag::Physics, size);
+			}
+			return block;
+		}
+		void TrackedAlignedFree(void* block)
+		{
+			if (block == nullptr)
+				return;
+			const TrackedBlockHeader* header = GetTrackedBlockHeader(block);
+			wi::allocator::TrackFree(wi::allocator::MemoryTag::Physics, header->size);
+			default_aligned_free((uint8_t*)block - header->offset);
+		}
+		void RegisterTrackedAllocator()
+		{
+			RegisterDefaultAllocator();
+			default_allocate = JPH::Allocate;
+			default_reallocate = JPH::Reallocate;
+			default_free = JPH::Free;
+			default_aligned_allocate = JPH::AlignedAllocate;
+			default_aligned_free = JPH::AlignedFree;
+			JPH::Allocate = TrackedAllocate;
+			JPH::Reallocate = TrackedReallocate;
+			JPH::Free = TrackedFree;
+			JPH::AlignedAllocate = TrackedAlignedAllocate;
+			JPH::AlignedFree = TrackedAlignedFree;
+		}
+#else
+		void RegisterTrackedAllocator()
+		{
+			RegisterDefaultAllocator();
+		}
+#endif // WI_MEMORY_TRACKING
+
 	}
 	using namespace jolt;
 
@@ -1926,7 +2278,7 @@ namespace wi::physics
 	{
 		wi::Timer timer;
 
-		RegisterDefaultAllocator();
+		RegisterTrackedAllocator();
 
 		Factory::sInstance = new Factory();
 
@@ -2096,6 +2448,11 @@ namespace wi::physics
 	bool IsInterpolationEnabled() { return INTERPOLATION; }
 	void SetInterpolationEnabled(bool value) { INTERPOLATION = value; }
 
+	bool IsAsyncSimulationEnabled() { return ASYNC_SIMULATION; }
+	void SetAsyncSimulationEnabled(bool value) { ASYNC_SIMULATION = value; }
+
+	void WaitAsyncSimulation(wi::scene::Scene& scene) { WaitSimulation(scene.physics_scene); }
+
 	bool IsDebugDrawEnabled() { return DEBUGDRAW_ENABLED; }
 	void SetDebugDrawEnabled(bool value) { DEBUGDRAW_ENABLED = value; }
 
@@ -2114,6 +2471,8 @@ namespace wi::physics
 	float GetCharacterCollisionTolerance() { return CHARACTER_COLLISION_TOLERANCE; }
 	void SetCharacterCollisionTolerance(float value) { CHARACTER_COLLISION_TOLERANCE = value; }
 
+	size_t GetTemporaryMemoryHighWaterMark() { return temp_memory_high_water_mark.load(std::memory_order_relaxed); }
+
 	void RunPhysicsUpdateSystem(
 		wi::jobsystem::context& ctx,
 		wi::scene::Scene& scene,
@@ -2132,6 +2491,7 @@ namespace wi::physics
 		auto range = wi::profiler::BeginRangeCPU("Physics");
 
 		PhysicsScene& physics_scene = GetPhysicsScene(scene);
+		wi::jobsystem::Wait(physics_scene.simulation_ctx); // sync point of the asynchronous simulation that was started in the previous update
 		physics_scene.physics_system.SetGravity(cast(scene.weather.gravity));
 
 		// First, do the creations when needed (AddRigidBody, AddSoftBody, etc):
@@ -2823,13 +3183,89 @@ namespace wi::physics
 
 		physics_scene.activate_all_rigid_bodies = false;
 
+		// Saves the locations before simulating, this is only needed for interpolation:
+		//	We don't only save it for dynamic objects that will be interpolated, because on the next frame maybe simulation doesn't run
+		//	but object types can change!
+		auto save_interpolation_state = [&]() {
+			wi::jobsystem::Dispatch(ctx, (uint32_t)scene.rigidbodies.GetCount(), dispatchGroupSize, [&scene, &physics_scene](wi::jobsystem::JobArgs args) {
+				RigidBodyPhysicsComponent& physicscomponent = scene.rigidbodies[args.jobIndex];
+				if (physicscomponent.physicsobject == nullptr)
+					return;
+				RigidBody& rb = GetRigidBody(physicscomponent);
+				if (rb.character != nullptr)
+				{
+					rb.character->PostSimulation(CHARACTER_COLLISION_TOLERANCE);
+				}
+				BodyInterface& body_interface = physics_scene.physics_system.GetBodyInterfaceNoLock();
+				Mat44 mat = body_interface.GetWorldTransform(rb.bodyID);
+				mat = mat * rb.additionalTransformInverse;
+				rb.prev_position = mat.GetTranslation();
+				rb.prev_rotation = mat.GetQuaternion().Normalized();
+
+				if (rb.vehicle_constraint != nullptr)
+				{
+					const Entity car_wheel_entities[] = {
+						physicscomponent.vehicle.wheel_entity_front_left,
+						physicscomponent.vehicle.wheel_entity_front_right,
+						physicscomponent.vehicle.wheel_entity_rear_left,
+						physicscomponent.vehicle.wheel_entity_rear_right,
+					};
+					const Entity motor_wheel_entities[] = {
+						physicscomponent.vehicle.wheel_entity_front_left,
+						physicscomponent.vehicle.wheel_entity_rear_left,
+					};
+					const uint32_t count = physicscomponent.vehicle.type == RigidBodyPhysicsComponent::Vehicle::Type::Car ? arraysize(car_wheel_entities) : arraysize(motor_wheel_entities);
+
+					for (uint32_t i = 0; i < count; ++i)
+					{
+						Entity wheel_entity = physicscomponent.vehicle.type == RigidBodyPhysicsComponent::Vehicle::Type::Car ? car_wheel_entities[i] : motor_wheel_entities[i];
+						if (wheel_entity == INVALID_ENTITY)
+							continue;
+
+						TransformComponent* wheel_transform = scene.transforms.GetComponent(wheel_entity);
+						if (wheel_transform != nullptr)
+						{
+							XMFLOAT4X4 localMatrix;
+							XMStoreFloat4x4(&localMatrix, wheel_transform->GetLocalMatrix());
+							Vec3 right = cast(wi::math::GetRight(localMatrix)).Normalized();
+							Vec3 up = cast(wi::math::GetUp(localMatrix)).Normalized();
+							Mat44 wheelmat = rb.vehicle_constraint->GetWheelWorldTransform(i, right, up);
+							rb.prev_wheel_positions[i] = wheelmat.GetTranslation();
+							rb.prev_wheel_rotations[i] = wheelmat.GetQuaternion();
+						}
+					}
+				}
+			});
+			wi::jobsystem::Dispatch(ctx, (uint32_t)scene.humanoids.GetCount(), 1, [&scene, &physics_scene](wi::jobsystem::JobArgs args) {
+				HumanoidComponent& humanoid = scene.humanoids[args.jobIndex];
+				if (humanoid.ragdoll == nullptr)
+					return;
+				Ragdoll& ragdoll = *(Ragdoll*)humanoid.ragdoll.get();
+				BodyInterface& body_interface = physics_scene.physics_system.GetBodyInterfaceNoLock();
+				int bodypart = 0;
+				for (auto& rb : ragdoll.rigidbodies)
+				{
+					TransformComponent* transform = scene.transforms.GetComponent(rb.entity);
+					if (transform == nullptr)
+						continue;
+					Mat44 mat = body_interface.GetWorldTransform(rb.bodyID);
+					ragdoll.prev_capsule_position[bodypart] = mat.GetTranslation();
+					ragdoll.prev_capsule_rotation[bodypart] = mat.GetQuaternion().Normalized();
+					mat = mat * rb.additionalTransformInverse;
+					mat = mat * rb.restBasis;
+					rb.prev_position = mat.GetTranslation();
+					rb.prev_rotation = mat.GetQuaternion().Normalized();
+					bodypart++;
+				}
+			});
+			wi::jobsystem::Wait(ctx);
+		};
+
 		// Perform internal simulation step:
-		if (IsSimulationEnabled())
+		const bool async_simulation = IsSimulationEnabled() && IsAsyncSimulationEnabled();
+		physics_scene.wheel_transforms_cached = async_simulation;
+		if (IsSimulationEnabled() && !async_simulation)
 		{
-			//static TempAllocatorImpl temp_allocator(10 * 1024 * 1024);
-			static TempAllocatorMalloc temp_allocator; // 10-100 MB was not enough for large simulation, I don't want to reserve more memory up front
-			static JobSystemThreadPool job_system(cMaxPhysicsJobs, cMaxPhysicsBarriers, thread::hardware_concurrency() - 1);
-
 			physics_scene.accumulator += dt;
 			physics_scene.accumulator = clamp(physics_scene.accumulator, 0.0f, TIMESTEP * ACCURACY);
 			while (physics_scene.accumulator >= TIMESTEP)
@@ -2837,84 +3273,11 @@ namespace wi::physics
 				const float next_accumulator = physics_scene.accumulator - TIMESTEP;
 				if (IsInterpolationEnabled() && next_accumulator < TIMESTEP)
 				{
-					// On the last step, save previous locations, this is only needed for interpolation:
-					//	We don't only save it for dynamic objects that will be interpolated, because on the next frame maybe simulation doesn't run
-					//	but object types can change!
-					wi::jobsystem::Dispatch(ctx, (uint32_t)scene.rigidbodies.GetCount(), dispatchGroupSize, [&scene, &physics_scene](wi::jobsystem::JobArgs args) {
-						RigidBodyPhysicsComponent& physicscomponent = scene.rigidbodies[args.jobIndex];
-						if (physicscomponent.physicsobject == nullptr)
-							return;
-						RigidBody& rb = GetRigidBody(physicscomponent);
-						if (rb.character != nullptr)
-						{
-							rb.character->PostSimulation(CHARACTER_COLLISION_TOLERANCE);
-						}
-						BodyInterface& body_interface = physics_scene.physics_system.GetBodyInterfaceNoLock();
-						Mat44 mat = body_interface.GetWorldTransform(rb.bodyID);
-						mat = mat * rb.additionalTransformInverse;
-						rb.prev_position = mat.GetTranslation();
-						rb.prev_rotation = mat.GetQuaternion().Normalized();
-
-						if (rb.vehicle_constraint != nullptr)
-						{
-							const Entity car_wheel_entities[] = {
-								physicscomponent.vehicle.wheel_entity_front_left,
-								physicscomponent.vehicle.wheel_entity_front_right,
-								physicscomponent.vehicle.wheel_entity_rear_left,
-								physicscomponent.vehicle.wheel_entity_rear_right,
-							};
-							const Entity motor_wheel_entities[] = {
-								physicscomponent.vehicle.wheel_entity_front_left,
-								physicscomponent.vehicle.wheel_entity_rear_left,
-							};
-							const uint32_t count = physicscomponent.vehicle.type == RigidBodyPhysicsComponent::Vehicle::Type::Car ? arraysize(car_wheel_entities) : arraysize(motor_wheel_entities);
-
-							for (uint32_t i = 0; i < count; ++i)
-							{
-								Entity wheel_entity = physicscomponent.vehicle.type == RigidBodyPhysicsComponent::Vehicle::Type::Car ? car_wheel_entities[i] : motor_wheel_entities[i];
-								if (wheel_entity == INVALID_ENTITY)
-									continue;
-
-								TransformComponent* wheel_transform = scene.transforms.GetComponent(wheel_entity);
-								if (wheel_transform != nullptr)
-								{
-									XMFLOAT4X4 localMatrix;
-									XMStoreFloat4x4(&localMatrix, wheel_transform->GetLocalMatrix());
-									Vec3 right = cast(wi::math::GetRight(localMatrix)).Normalized();
-									Vec3 up = cast(wi::math::GetUp(localMatrix)).Normalized();
-									Mat44 wheelmat = rb.vehicle_constraint->GetWheelWorldTransform(i, right, up);
-									rb.prev_wheel_positions[i] = wheelmat.GetTranslation();
-									rb.prev_wheel_rotations[i] = wheelmat.GetQuaternion();
-								}
-							}
-						}
-					});
-					wi::jobsystem::Dispatch(ctx, (uint32_t)scene.humanoids.GetCount(), 1, [&scene, &physics_scene](wi::jobsystem::JobArgs args) {
-						HumanoidComponent& humanoid = scene.humanoids[args.jobIndex];
-						if (humanoid.ragdoll == nullptr)
-							return;
-						Ragdoll& ragdoll = *(Ragdoll*)humanoid.ragdoll.get();
-						BodyInterface& body_interface = physics_scene.physics_system.GetBodyInterfaceNoLock();
-						int bodypart = 0;
-						for (auto& rb : ragdoll.rigidbodies)
-						{
-							TransformComponent* transform = scene.transforms.GetComponent(rb.entity);
-							if (transform == nullptr)
-								continue;
-							Mat44 mat = body_interface.GetWorldTransform(rb.bodyID);
-							ragdoll.prev_capsule_position[bodypart] = mat.GetTranslation();
-							ragdoll.prev_capsule_rotation[bodypart] = mat.GetQuaternion().Normalized();
-							mat = mat * rb.additionalTransformInverse;
-							mat = mat * rb.restBasis;
-							rb.prev_position = mat.GetTranslation();
-							rb.prev_rotation = mat.GetQuaternion().Normalized();
-							bodypart++;
-						}
-					});
-					wi::jobsystem::Wait(ctx);
+					// On the last step, save previous locations:
+					save_interpolation_state();
 				}
 
-				physics_scene.physics_system.Update(TIMESTEP, COLLISION_STEPS, &temp_allocator, &job_system);
+				physics_scene.Step();
 				physics_scene.accumulator = next_accumulator;
 			}
 			physics_scene.alpha = physics_scene.accumulator / TIMESTEP;
@@ -3160,8 +3523,53 @@ namespace wi::physics
 		}
 #endif // JPH_DEBUG_RENDERER
 
+		if (async_simulation)
+		{
+			// The vehicles can't be accessed while the next simulation is running, so their wheel transforms are cached now:
+			wi::jobsystem::Dispatch(ctx, (uint32_t)scene.rigidbodies.GetCount(), dispatchGroupSize, [&scene, &physics_scene](wi::jobsystem::JobArgs args) {
+				RigidBodyPhysicsComponent& physicscomponent = scene.rigidbodies[args.jobIndex];
+				if (physicscomponent.physicsobject == nullptr)
+					return;
+				RigidBody& physicsobject = GetRigidBody(physicscomponent);
+				if (physicsobject.vehicle_constraint == nullptr)
+					return;
+				ComputeWheelTransforms(scene, physics_scene, physicscomponent, physicsobject);
+			});
+		}
+
 		wi::jobsystem::Wait(ctx);
 
+		if (async_simulation)
+		{
+			// The simulation steps are running in the background until the next update, while the current results are rendered:
+			physics_scene.accumulator += dt;
+			physics_scene.accumulator = clamp(physics_scene.accumulator, 0.0f, TIMESTEP * ACCURACY);
+			uint32_t step_count = 0;
+			while (physics_scene.accumulator >= TIMESTEP)
+			{
+				physics_scene.accumulator -= TIMESTEP;
+				step_count++;
+			}
+			if (step_count > 0)
+			{
+				if (IsInterpolationEnabled())
+				{
+					// Locations are saved before all the steps, and the results will be interpolated across them:
+					save_interpolation_state();
+				}
+				physics_scene.simulation_step_count = step_count;
+				PhysicsScene* simulated_scene = &physics_scene;
+				wi::jobsystem::Execute(physics_scene.simulation_ctx, [simulated_scene, step_count](wi::jobsystem::JobArgs args) {
+					for (uint32_t i = 0; i < step_count; ++i)
+					{
+						simulated_scene->Step();
+					}
+				});
+			}
+			// This will interpolate to the same point in time as the synchronous simulation, which is within the last step:
+			physics_scene.alpha = (physics_scene.simulation_step_count - 1 + physics_scene.accumulator / TIMESTEP) / physics_scene.simulation_step_count;
+		}
+
 		wi::profiler::EndRange(range); // Physics
 	}
 
@@ -3539,7 +3947,7 @@ namespace wi::physics
 		if (ragdoll.rigidbodies[bodypart].bodyID.IsInvalid())
 			return;
 		RigidBody& physicsobject = ragdoll.rigidbodies[bodypart];
-		PhysicsScene& physics_scene = *(PhysicsScene*)physicsobject.physics_scene.get();
+		PhysicsScene& physics_scene = SyncPhysicsScene(physicsobject.physics_scene);
 		BodyInterface& body_interface = physics_scene.physics_system.GetBodyInterfaceNoLock();
 		body_interface.SetMotionType(physicsobject.bodyID, EMotionType::Dynamic, EActivation::Activate);
 		body_interface.AddImpulse(physicsobject.bodyID, cast(impulse));
@@ -3622,7 +4030,7 @@ namespace wi::physics
 		if (ragdoll.rigidbodies[bodypart].bodyID.IsInvalid())
 			return;
 		RigidBody& physicsobject = ragdoll.rigidbodies[bodypart];
-		PhysicsScene& physics_scene = *(PhysicsScene*)physicsobject.physics_scene.get();
+		PhysicsScene& physics_scene = SyncPhysicsScene(physicsobject.physics_scene);
 		BodyInterface& body_interface = physics_scene.physics_system.GetBodyInterfaceNoLock();
 		Vec3 at_world = at_local ? body_interface.GetCenterOfMassTransform(physicsobject.bodyID) * cast(at) : cast(at);
 		body_interface.SetMotionType(physicsobject.bodyID, EMotionType::Dynamic, EActivation::Activate);
@@ -3699,44 +4107,29 @@ namespace wi::physics
 			RigidBodyPhysicsComponent& physicscomponent = scene.rigidbodies[args.jobIndex];
 			if (physicscomponent.physicsobject == nullptr)
 				return;
-			RigidBody& physicsobject = GetRigidBody(physicscomponent);
+			RigidBody& physicsobject = *(RigidBody*)physicscomponent.physicsobject.get(); // not waiting for asynchronous simulation, the cached wheel transforms are used then
 			if (physicsobject.vehicle_constraint == nullptr)
 				return;
 
-			const Entity car_wheel_entities[] = {
-				physicscomponent.vehicle.wheel_entity_front_left,
-				physicscomponent.vehicle.wheel_entity_front_right,
-				physicscomponent.vehicle.wheel_entity_rear_left,
-				physicscomponent.vehicle.wheel_entity_rear_right,
-			};
-			const Entity motor_wheel_entities[] = {
-				physicscomponent.vehicle.wheel_entity_front_left,
-				physicscomponent.vehicle.wheel_entity_rear_left,
-			};
-			const uint32_t count = physicscomponent.vehicle.type == RigidBodyPhysicsComponent::Vehicle::Type::Car ? arraysize(car_wheel_entities) : arraysize(motor_wheel_entities);
+			if (!physics_scene.wheel_transforms_cached)
+			{
+				ComputeWheelTransforms(scene, physics_scene, physicscomponent, physicsobject);
+			}
 
+			Entity wheel_entities[4];
+			const uint32_t count = GetWheelEntities(physicscomponent, wheel_entities);
 			for (uint32_t i = 0; i < count; ++i)
 			{
-				Entity wheel_entity = physicscomponent.vehicle.type == RigidBodyPhysicsComponent::Vehicle::Type::Car ? car_wheel_entities[i] : motor_wheel_entities[i];
+				Entity wheel_entity = wheel_entities[i];
 				if (wheel_entity == INVALID_ENTITY)
 					continue;
 
 				TransformComponent* wheel_transform = scene.transforms.GetComponent(wheel_entity);
 				if (wheel_transform != nullptr)
 				{
-					XMFLOAT4X4 localMatrix;
-					XMStoreFloat4x4(&localMatrix, wheel_transform->GetLocalMatrix());
-					Vec3 right = cast(wi::math::GetRight(localMatrix)).Normalized();
-					Vec3 up = cast(wi::math::GetUp(localMatrix)).Normalized();
-					Mat44 wheelmat = physicsobject.vehicle_constraint->GetWheelWorldTransform(i, right, up);
-					Vec3 wheelpos = wheelmat.GetTranslation();
-					Quat wheelrot = wheelmat.GetQuaternion();
-					if (IsInterpolationEnabled())
-					{
-						wheelpos = wheelpos * physics_scene.alpha + physicsobject.prev_wheel_positions[i] * (1 - physics_scene.alpha);
-						wheelrot = physicsobject.prev_wheel_rotations[i].SLERP(wheelrot, physics_scene.alpha);
-					}
-					wheelmat = Mat44::sRotationTranslation(wheelrot, wheelpos) * Mat44::sScale(cast(wheel_transform->GetScale()));
+					const Vec3 wheelpos = physicsobject.wheel_positions[i];
+					const Quat wheelrot = physicsobject.wheel_rotations[i];
+					Mat44 wheelmat = Mat44::sRotationTranslation(wheelrot, wheelpos) * Mat44::sScale(cast(wheel_transform->GetScale()));
 					wheel_transform->world = cast(wheelmat);
 
 					scene.RefreshHierarchyTopdownFromParent(wheel_entity);
@@ -3821,7 +4214,7 @@ namespace wi::physics
 
 	void ResetPhysicsObjects(Scene& scene)
 	{
-		PhysicsScene& physics_scene = *(PhysicsScene*)scene.physics_scene.get();
+		PhysicsScene& physics_scene = SyncPhysicsScene(scene.physics_scene);
 		BodyInterface& body_interface = physics_scene.physics_system.GetBodyInterfaceNoLock();
 		BodyIDVector bodies;
 		physics_scene.physics_system.GetBodies(bodies);
@@ -3921,7 +4314,7 @@ namespace wi::physics
 		if (humanoid.ragdoll == nullptr)
 			return;
 		Ragdoll& ragdoll = *(Ragdoll*)humanoid.ragdoll.get();
-		PhysicsScene& physics_scene = *(PhysicsScene*)ragdoll.physics_scene.get();
+		PhysicsScene& physics_scene = SyncPhysicsScene(ragdoll.physics_scene);
 		BodyInterface& body_interface = physics_scene.physics_system.GetBodyInterfaceNoLock();
 		ObjectLayer layer = value ? Layers::GHOST : Layers::MOVING;
 		for (auto& rb : ragdoll.rigidbodies)
@@ -3978,7 +4371,7 @@ namespace wi::physics
 		if (scene.physics_scene == nullptr)
 			return result;
 
-		PhysicsScene& physics_scene = *(PhysicsScene*)scene.physics_scene.get();
+		PhysicsScene& physics_scene = SyncPhysicsScene(scene.physics_scene);
 
 		const float tmin = clamp(ray.TMin, 0.0f, 1000000.0f);
 		const float tmax = clamp(ray.TMax, 0.0f, 1000000.0f);
@@ -4061,7 +4454,7 @@ namespace wi::physics
 		{
 			if (physics_scene == nullptr || bodyB == nullptr)
 				return;
-			PhysicsScene& physics_scene = *((PhysicsScene*)this->physics_scene.get());
+			PhysicsScene& physics_scene = SyncPhysicsScene(this->physics_scene);
 			BodyInterface& body_interface = physics_scene.physics_system.GetBodyInterfaceNoLock();
 			if (bodyA != nullptr)
 			{
@@ -4088,7 +4481,7 @@ namespace wi::physics
 	{
 		if (scene.physics_scene == nullptr)
 			return;
-		PhysicsScene& physics_scene = *((PhysicsScene*)scene.physics_scene.get());
+		PhysicsScene& physics_scene = SyncPhysicsScene(scene.physics_scene);
 		BodyInterface& body_interface = physics_scene.physics_system.GetBodyInterfaceNoLock();
 
 		if (op.IsValid())
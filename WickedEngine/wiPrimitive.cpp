@@ -934,6 +934,32 @@ namespace wi::primitive
 		}
 		return true;
 	}
+	Frustum::BoxFrustumIntersect Frustum::CheckBoxMasked(const AABB& box, uint32_t& planeMask) const
+	{
+		if (!box.IsValid())
+			return BOX_FRUSTUM_OUTSIDE;
+		XMVECTOR max = XMLoadFloat3(&box._max);
+		XMVECTOR min = XMLoadFloat3(&box._min);
+		XMVECTOR zero = XMVectorZero();
+		for (uint32_t p = 0; p < 6; ++p)
+		{
+			if ((planeMask & (1u << p)) == 0)
+				continue;
+			XMVECTOR plane = XMLoadFloat4(&planes[p]);
+			XMVECTOR lt = XMVectorLess(plane, zero);
+			XMVECTOR furthestFromPlane = XMVectorSelect(max, min, lt);
+			if (XMVectorGetX(XMPlaneDotCoord(plane, furthestFromPlane)) < 0.0f)
+			{
+				return BOX_FRUSTUM_OUTSIDE;
+			}
+			XMVECTOR closestToPlane = XMVectorSelect(min, max, lt);
+			if (XMVectorGetX(XMPlaneDotCoord(plane, closestToPlane)) >= 0.0f)
+			{
+				planeMask &= ~(1u << p); // the whole box is on the inner side of this plane
+			}
+		}
+		return planeMask == 0 ? BOX_FRUSTUM_INSIDE : BOX_FRUSTUM_INTERSECTS;
+	}
 
 	const XMFLOAT4& Frustum::getNearPlane() const { return planes[0]; }
 	const XMFLOAT4& Frustum::getFarPlane() const { return planes[1]; }
@@ -241,6 +241,9 @@ namespace wi::primitive
 		};
 		BoxFrustumIntersect CheckBox(const AABB& box) const;
 		bool CheckBoxFast(const AABB& box) const;
+		// Fast box classification that only tests the planes in planeMask (bit i = planes[i])
+		//	The planes that fully contain the box are removed from planeMask, so the children of a box hierarchy only need to test the remaining planes
+		BoxFrustumIntersect CheckBoxMasked(const AABB& box, uint32_t& planeMask) const;
 
 		const XMFLOAT4& getNearPlane() const;
 		const XMFLOAT4& getFarPlane() const;
@@ -7,11 +7,8 @@ namespace wi::lua::primitive
 {
 	void Bind()
 	{
-		static bool initialized = false;
-		if (!initialized)
+		if (wi::lua::BindOnce("primitive"))
 		{
-			initialized = true;
-
 			lua_State* L = wi::lua::GetLuaState();
 
 			Luna<Ray_BindLua>::Register(L);
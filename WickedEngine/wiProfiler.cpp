@@ -9,6 +9,7 @@
 #include "wiBacklog.h"
 #include "wiRenderer.h"
 #include "wiEventHandler.h"
+#include "wiAllocator.h"
 
 #if __has_include("Superluminal/PerformanceAPI_capi.h")
 #include "Superluminal/PerformanceAPI_capi.h"
@@ -283,6 +284,27 @@ namespace wi::profiler
 
 		lock.unlock();
 	}
+	void AddRangeCPU(const char* name, float time)
+	{
+		if (!ENABLED || !initialized)
+			return;
+
+		range_id id = wi::helper::string_hash(name);
+
+		lock.lock();
+
+		size_t differentiator = 0;
+		while (ranges[id].in_use)
+		{
+			wi::helper::hash_combine(id, differentiator++);
+		}
+		ranges[id].in_use = true;
+		ranges[id].name = name;
+		ranges[id].time = time;
+
+		lock.unlock();
+	}
+
 
 
 	PipelineState pso_linestrip;
@@ -375,6 +397,7 @@ namespace wi::profiler
 			x.second.num_hits = 0;
 			x.second.total_time = 0;
 		}
+		ss << "Scratch high-water mark: " << std::fixed << float(double(wi::allocator::GetScratchHighWaterMark()) / 1024.0) << " KB" << std::endl;
 		ss << std::endl;
 
 		// Print GPU ranges:
@@ -36,6 +36,9 @@ namespace wi::profiler
 	// End a profiling range
 	void EndRange(range_id id);
 
+	// Add a CPU profiling range with a known duration in milliseconds, for values that are computed instead of measured between Begin/End
+	void AddRangeCPU(const char* name, float time);
+
 	// helper using RAII to avoid having to manually call BeginRangeCPU/EndRange at beginning/end
 	struct ScopedRangeCPU
 	{
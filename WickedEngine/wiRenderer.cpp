@@ -338,6 +338,49 @@ struct RenderQueue
 static thread_local RenderQueue renderQueue;
 static thread_local RenderQueue renderQueue_transparent;
 
+// Calls func(objectIndex) for the objects that can intersect with any of the shapes (Frustum or Sphere)
+//	If the scene has an object BVH, only objects in the intersecting subtrees are visited, otherwise every object is visited
+//	The func still needs to test the object's AABB for exact culling
+template<typename T, typename F>
+void ForEachObjectCandidate(const Scene& scene, const T* shapes, uint32_t shape_count, F&& func)
+{
+	if (!scene.IsObjectBVHValid())
+	{
+		for (size_t i = 0; i < scene.aabb_objects.size(); ++i)
+		{
+			func(i);
+		}
+		return;
+	}
+	static thread_local wi::vector<uint32_t> candidates;
+	candidates.clear();
+	for (uint32_t i = 0; i < shape_count; ++i)
+	{
+		if constexpr (std::is_same_v<T, Frustum>)
+		{
+			scene.object_bvh.IntersectsFrustum(shapes[i], [&](uint32_t objectIndex, bool inside) {
+				candidates.push_back(objectIndex);
+			});
+		}
+		else
+		{
+			scene.object_bvh.IntersectsLeaves(shapes[i], [&](uint32_t objectIndex) {
+				candidates.push_back(objectIndex);
+			});
+		}
+	}
+	if (shape_count > 1)
+	{
+		// The same object can be found by multiple shapes:
+		std::sort(candidates.begin(), candidates.end());
+		candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+	}
+	for (uint32_t objectIndex : candidates)
+	{
+		func(size_t(objectIndex));
+	}
+}
+
 enum OBJECT_MESH_SHADER_PSO
 {
 	OBJECT_MESH_SHADER_PSO_DISABLED,
@@ -779,6 +822,12 @@ bool LoadShader(
 		shaderbinaryfilename += "." + ext;
 	}
 
+	if (device != nullptr && device->GetShaderFormat() == ShaderFormat::NONE)
+	{
+		// Device doesn't consume shader binaries (for example the headless null device), so there is nothing to load or compile:
+		return device->CreateShader(stage, nullptr, 0, &shader);
+	}
+
 	if (device != nullptr)
 	{
 #ifdef SHADERDUMP_ENABLED
@@ -3757,89 +3806,143 @@ void UpdateVisibility(Visibility& vis)
 		// Cull objects:
 		const uint32_t object_loop = (uint32_t)std::min(vis.scene->aabb_objects.size(), vis.scene->objects.GetCount());
 		vis.visibleObjects.resize(object_loop);
-		wi::jobsystem::Dispatch(ctx, object_loop, groupSize, [&](wi::jobsystem::JobArgs args) {
 
-			// Setup stream compaction:
-			StreamCompaction& stream_compaction = *(StreamCompaction*)args.sharedmemory;
-			if (args.isFirstJobInGroup)
+		// This is performed for every object that passed the frustum culling:
+		auto object_visible = [&](uint32_t objectIndex, const AABB& aabb) {
+			const ObjectComponent& object = vis.scene->objects[objectIndex];
+			Scene::OcclusionResult& occlusion_result = vis.scene->occlusion_results_objects[objectIndex];
+			bool occluded = false;
+			if (vis.flags & Visibility::ALLOW_OCCLUSION_CULLING)
 			{
-				stream_compaction.count = 0; // first thread initializes local counter
+				occluded = occlusion_result.IsOccluded();
 			}
 
-			const AABB& aabb = vis.scene->aabb_objects[args.jobIndex];
-
-			if ((aabb.layerMask & vis.layerMask) && vis.frustum.CheckBoxFast(aabb))
+			if ((vis.flags & Visibility::ALLOW_REQUEST_REFLECTION) && object.IsRequestPlanarReflection() && !occluded)
 			{
-				// Local stream compaction:
-				stream_compaction.list[stream_compaction.count++] = args.groupIndex;
-
-				const ObjectComponent& object = vis.scene->objects[args.jobIndex];
-				Scene::OcclusionResult& occlusion_result = vis.scene->occlusion_results_objects[args.jobIndex];
-				bool occluded = false;
-				if (vis.flags & Visibility::ALLOW_OCCLUSION_CULLING)
+				// Planar reflection priority request:
+				float dist = wi::math::DistanceEstimated(vis.camera->Eye, object.center);
+				vis.locker.lock();
+				if (dist < vis.closestRefPlane)
 				{
-					occluded = occlusion_result.IsOccluded();
+					vis.closestRefPlane = dist;
+					XMVECTOR P = XMLoadFloat3(&object.center);
+					XMVECTOR N = XMVectorSet(0, 1, 0, 0);
+					N = XMVector3TransformNormal(N, XMLoadFloat4x4(&vis.scene->matrix_objects[objectIndex]));
+					N = XMVector3Normalize(N);
+					XMVECTOR _refPlane = XMPlaneFromPointNormal(P, N);
+					XMStoreFloat4(&vis.reflectionPlane, _refPlane);
+
+					vis.planar_reflection_visible = true;
 				}
+				vis.locker.unlock();
+			}
+
+			if (object.GetFilterMask() & FILTER_TRANSPARENT)
+			{
+				vis.transparents_visible.store(true);
+			}
+
+			if (object.mesh_blend_required)
+			{
+				vis.mesh_blend_visible.store(true);
+			}
 
-				if ((vis.flags & Visibility::ALLOW_REQUEST_REFLECTION) && object.IsRequestPlanarReflection() && !occluded)
+			if (vis.flags & Visibility::ALLOW_OCCLUSION_CULLING)
+			{
+				if (object.IsRenderable() && occlusion_result.occlusionQueries[vis.scene->queryheap_idx] < 0)
 				{
-					// Planar reflection priority request:
-					float dist = wi::math::DistanceEstimated(vis.camera->Eye, object.center);
-					vis.locker.lock();
-					if (dist < vis.closestRefPlane)
+					if (aabb.intersects(vis.camera->Eye))
+					{
+						// camera is inside the instance, mark it as visible in this frame:
+						occlusion_result.occlusionHistory |= 1;
+					}
+					else
 					{
-						vis.closestRefPlane = dist;
-						XMVECTOR P = XMLoadFloat3(&object.center);
-						XMVECTOR N = XMVectorSet(0, 1, 0, 0);
-						N = XMVector3TransformNormal(N, XMLoadFloat4x4(&vis.scene->matrix_objects[args.jobIndex]));
-						N = XMVector3Normalize(N);
-						XMVECTOR _refPlane = XMPlaneFromPointNormal(P, N);
-						XMStoreFloat4(&vis.reflectionPlane, _refPlane);
-
-						vis.planar_reflection_visible = true;
+						occlusion_result.occlusionQueries[vis.scene->queryheap_idx] = vis.scene->queryAllocator.fetch_add(1); // allocate new occlusion query from heap
 					}
-					vis.locker.unlock();
 				}
+			}
+		};
 
-				if (object.GetFilterMask() & FILTER_TRANSPARENT)
-				{
-					vis.transparents_visible.store(true);
-				}
+		if (vis.scene->IsObjectBVHValid() && vis.scene->object_bvh.leaf_indices.size() == object_loop)
+		{
+			// Hierarchical culling with the object BVH:
+			//	The tree traversal collects candidates on a single thread, which rejects or accepts whole subtrees
+			//	Then the candidates are processed in parallel like in the linear culling
+			wi::jobsystem::Execute(ctx, [&](wi::jobsystem::JobArgs args) {
+				static constexpr uint32_t candidate_inside = 1u << 31u; // candidate's subtree was fully inside, so only the AABB validity needs checking
+				vis.object_candidates.clear();
+				vis.scene->object_bvh.IntersectsFrustum(vis.frustum, [&](uint32_t objectIndex, bool inside) {
+					vis.object_candidates.push_back(inside ? (objectIndex | candidate_inside) : objectIndex);
+				});
 
-				if (object.mesh_blend_required)
-				{
-					vis.mesh_blend_visible.store(true);
-				}
+				wi::jobsystem::Dispatch(ctx, (uint32_t)vis.object_candidates.size(), groupSize, [&](wi::jobsystem::JobArgs args) {
 
-				if (vis.flags & Visibility::ALLOW_OCCLUSION_CULLING)
-				{
-					if (object.IsRenderable() && occlusion_result.occlusionQueries[vis.scene->queryheap_idx] < 0)
+					// Setup stream compaction:
+					StreamCompaction& stream_compaction = *(StreamCompaction*)args.sharedmemory;
+					if (args.isFirstJobInGroup)
 					{
-						if (aabb.intersects(vis.camera->Eye))
-						{
-							// camera is inside the instance, mark it as visible in this frame:
-							occlusion_result.occlusionHistory |= 1;
-						}
-						else
+						stream_compaction.count = 0; // first thread initializes local counter
+					}
+
+					const uint32_t candidate = vis.object_candidates[args.jobIndex];
+					const uint32_t objectIndex = candidate & ~candidate_inside;
+					const AABB& aabb = vis.scene->aabb_objects[objectIndex];
+
+					if ((aabb.layerMask & vis.layerMask) && ((candidate & candidate_inside) ? aabb.IsValid() : vis.frustum.CheckBoxFast(aabb)))
+					{
+						// Local stream compaction:
+						stream_compaction.list[stream_compaction.count++] = args.groupIndex;
+						object_visible(objectIndex, aabb);
+					}
+
+					// Global stream compaction:
+					if (args.isLastJobInGroup && stream_compaction.count > 0)
+					{
+						uint32_t prev_count = vis.object_counter.fetch_add(stream_compaction.count);
+						uint32_t groupOffset = args.groupID * groupSize;
+						for (uint32_t i = 0; i < stream_compaction.count; ++i)
 						{
-							occlusion_result.occlusionQueries[vis.scene->queryheap_idx] = vis.scene->queryAllocator.fetch_add(1); // allocate new occlusion query from heap
+							vis.visibleObjects[prev_count + i] = vis.object_candidates[groupOffset + stream_compaction.list[i]] & ~candidate_inside;
 						}
 					}
+
+				}, sharedmemory_size);
+			});
+		}
+		else
+		{
+			wi::jobsystem::Dispatch(ctx, object_loop, groupSize, [&](wi::jobsystem::JobArgs args) {
+
+				// Setup stream compaction:
+				StreamCompaction& stream_compaction = *(StreamCompaction*)args.sharedmemory;
+				if (args.isFirstJobInGroup)
+				{
+					stream_compaction.count = 0; // first thread initializes local counter
 				}
-			}
 
-			// Global stream compaction:
-			if (args.isLastJobInGroup && stream_compaction.count > 0)
-			{
-				uint32_t prev_count = vis.object_counter.fetch_add(stream_compaction.count);
-				uint32_t groupOffset = args.groupID * groupSize;
-				for (uint32_t i = 0; i < stream_compaction.count; ++i)
+				const AABB& aabb = vis.scene->aabb_objects[args.jobIndex];
+
+				if ((aabb.layerMask & vis.layerMask) && vis.frustum.CheckBoxFast(aabb))
 				{
-					vis.visibleObjects[prev_count + i] = groupOffset + stream_compaction.list[i];
+					// Local stream compaction:
+					stream_compaction.list[stream_compaction.count++] = args.groupIndex;
+					object_visible(args.jobIndex, aabb);
+				}
+
+				// Global stream compaction:
+				if (args.isLastJobInGroup && stream_compaction.count > 0)
+				{
+					uint32_t prev_count = vis.object_counter.fetch_add(stream_compaction.count);
+					uint32_t groupOffset = args.groupID * groupSize;
+					for (uint32_t i = 0; i < stream_compaction.count; ++i)
+					{
+						vis.visibleObjects[prev_count + i] = groupOffset + stream_compaction.list[i];
+					}
 				}
-			}
 
 			}, sharedmemory_size);
+		}
 	}
 
 	if (vis.flags & Visibility::ALLOW_DECALS)
@@ -5153,14 +5256,19 @@ void UpdateRenderData(
 
 	if (vis.scene->instanceBuffer.IsValid() && vis.scene->instanceArraySize > 0)
 	{
-		device->CopyBuffer(
-			&vis.scene->instanceBuffer,
-			0,
-			&vis.scene->instanceUploadBuffer[vis.scene->cpu_gpu_mapped_resource_index],
-			0,
-			vis.scene->instanceArraySize * sizeof(ShaderMeshInstance),
-			cmd
-		);
+		// Only the changed instances are copied:
+		for (const wi::ecs::IndexRange& range : vis.scene->instanceCopyRanges)
+		{
+			device->CopyBuffer(
+				&vis.scene->instanceBuffer,
+				range.offset * sizeof(ShaderMeshInstance),
+				&vis.scene->instanceUploadBuffer[vis.scene->cpu_gpu_mapped_resource_index],
+				range.offset * sizeof(ShaderMeshInstance),
+				range.count * sizeof(ShaderMeshInstance),
+				cmd
+			);
+		}
+		vis.scene->instanceCopyVersion = vis.scene->instanceCopyRangesVersion;
 		PushBarrier(GPUBarrier::Buffer(&vis.scene->instanceBuffer, ResourceState::COPY_DST, ResourceState::SHADER_RESOURCE));
 	}
 
@@ -5179,14 +5287,19 @@ void UpdateRenderData(
 
 	if (vis.scene->materialBuffer.IsValid() && vis.scene->materialArraySize > 0)
 	{
-		device->CopyBuffer(
-			&vis.scene->materialBuffer,
-			0,
-			&vis.scene->materialUploadBuffer[vis.scene->cpu_gpu_mapped_resource_index],
-			0,
-			vis.scene->materialArraySize * sizeof(ShaderMaterial),
-			cmd
-		);
+		// Only the changed materials are copied:
+		for (const wi::ecs::IndexRange& range : vis.scene->materialCopyRanges)
+		{
+			device->CopyBuffer(
+				&vis.scene->materialBuffer,
+				range.offset * sizeof(ShaderMaterial),
+				&vis.scene->materialUploadBuffer[vis.scene->cpu_gpu_mapped_resource_index],
+				range.offset * sizeof(ShaderMaterial),
+				range.count * sizeof(ShaderMaterial),
+				cmd
+			);
+		}
+		vis.scene->materialCopyVersion = vis.scene->materialCopyRangesVersion;
 		PushBarrier(GPUBarrier::Buffer(&vis.scene->materialBuffer, ResourceState::COPY_DST, ResourceState::SHADER_RESOURCE));
 	}
 
@@ -6769,9 +6882,13 @@ void DrawShadowmaps(
 			wi::graphics::Rect* scissors = (wi::graphics::Rect*)alloca(sizeof(wi::graphics::Rect) * cascade_count);
 			SHCAM* shcams = (SHCAM*)alloca(sizeof(SHCAM) * cascade_count);
 			CreateDirLightShadowCams(light, *vis.camera, shcams, cascade_count, shadow_rect, vis.scene->character_dedicated_shadows.data(), vis.scene->character_dedicated_shadows.size());
-
-			for (size_t i = 0; i < vis.scene->aabb_objects.size(); ++i)
+			Frustum* cascade_frusta = (Frustum*)alloca(sizeof(Frustum) * cascade_count);
+			for (uint32_t cascade = 0; cascade < cascade_count; ++cascade)
 			{
+				cascade_frusta[cascade] = shcams[cascade].frustum;
+			}
+
+			ForEachObjectCandidate(*vis.scene, cascade_frusta, cascade_count, [&](size_t i) {
 				const AABB& aabb = vis.scene->aabb_objects[i];
 				if (aabb.layerMask & vis.layerMask)
 				{
@@ -6780,7 +6897,7 @@ void DrawShadowmaps(
 					{
 						const float distanceSq = wi::math::DistanceSquared(EYE, object.center);
 						if (distanceSq > sqr(object.draw_distance + object.radius)) // Note: here I use draw_distance instead of fadeDeistance because this doesn't account for impostor switch fade
-							continue;
+							return;
 
 						// Determine which cascades the object is contained in:
 						uint8_t camera_mask = 0;
@@ -6798,7 +6915,7 @@ void DrawShadowmaps(
 							}
 						}
 						if (camera_mask == 0)
-							continue;
+							return;
 
 						RenderBatch batch;
 						batch.Create(object.mesh_index, uint32_t(i), 0, object.sort_bits, camera_mask, shadow_lod);
@@ -6814,7 +6931,7 @@ void DrawShadowmaps(
 						}
 					}
 				}
-			}
+			});
 
 			if (!renderQueue.empty() || !renderQueue_transparent.empty())
 			{
@@ -6902,8 +7019,7 @@ void DrawShadowmaps(
 			if (!cam_frustum.Intersects(shcam.boundingfrustum))
 				break;
 
-			for (size_t i = 0; i < vis.scene->aabb_objects.size(); ++i)
-			{
+			ForEachObjectCandidate(*vis.scene, &shcam.frustum, 1, [&](size_t i) {
 				const AABB& aabb = vis.scene->aabb_objects[i];
 				if ((aabb.layerMask & vis.layerMask) && shcam.frustum.CheckBoxFast(aabb))
 				{
@@ -6912,7 +7028,7 @@ void DrawShadowmaps(
 					{
 						const float distanceSq = wi::math::DistanceSquared(EYE, object.center);
 						if (distanceSq > sqr(object.draw_distance + object.radius)) // Note: here I use draw_distance instead of fadeDeistance because this doesn't account for impostor switch fade
-							continue;
+							return;
 
 						uint8_t shadow_lod = 0xFF;
 						if (shadow_lod_override)
@@ -6935,7 +7051,7 @@ void DrawShadowmaps(
 						}
 					}
 				}
-			}
+			});
 
 			if (predicationRequest && light.occlusionquery >= 0)
 			{
@@ -7056,8 +7172,7 @@ void DrawShadowmaps(
 				}
 			}
 
-			for (size_t i = 0; i < vis.scene->aabb_objects.size(); ++i)
-			{
+			ForEachObjectCandidate(*vis.scene, &boundingsphere, 1, [&](size_t i) {
 				const AABB& aabb = vis.scene->aabb_objects[i];
 				if ((aabb.layerMask & vis.layerMask) && boundingsphere.intersects(aabb))
 				{
@@ -7066,7 +7181,7 @@ void DrawShadowmaps(
 					{
 						const float distanceSq = wi::math::DistanceSquared(EYE, object.center);
 						if (distanceSq > sqr(object.draw_distance + object.radius)) // Note: here I use draw_distance instead of fadeDeistance because this doesn't account for impostor switch fade
-							continue;
+							return;
 
 						// Check for each frustum, if object is visible from it:
 						uint8_t camera_mask = 0;
@@ -7084,7 +7199,7 @@ void DrawShadowmaps(
 							}
 						}
 						if (camera_mask == 0)
-							continue;
+							return;
 
 						RenderBatch batch;
 						batch.Create(object.mesh_index, uint32_t(i), 0, object.sort_bits, camera_mask, shadow_lod);
@@ -7100,7 +7215,7 @@ void DrawShadowmaps(
 						}
 					}
 				}
-			}
+			});
 
 			if (predicationRequest && light.occlusionquery >= 0)
 			{
@@ -9304,8 +9419,7 @@ void RefreshEnvProbes(const Visibility& vis, CommandList cmd)
 			Sphere culler(probe.position, zFarP);
 
 			renderQueue.init();
-			for (size_t i = 0; i < vis.scene->aabb_objects.size(); ++i)
-			{
+			ForEachObjectCandidate(*vis.scene, &culler, 1, [&](size_t i) {
 				const AABB& aabb = vis.scene->aabb_objects[i];
 				if ((aabb.layerMask & vis.layerMask) && (aabb.layerMask & probe_aabb.layerMask) && culler.intersects(aabb))
 				{
@@ -9321,12 +9435,12 @@ void RefreshEnvProbes(const Visibility& vis, CommandList cmd)
 							}
 						}
 						if (camera_mask == 0)
-							continue;
+							return;
 
 						renderQueue.add(object.mesh_index, uint32_t(i), 0, object.sort_bits, camera_mask);
 					}
 				}
-			}
+			});
 
 			if (!renderQueue.empty())
 			{
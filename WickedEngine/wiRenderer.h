@@ -155,6 +155,7 @@ namespace wi::renderer
 		wi::rectpacker::State shadow_packer;
 		wi::rectpacker::Rect rain_blocker_shadow_rect;
 		wi::vector<wi::rectpacker::Rect> visibleLightShadowRects;
+		wi::vector<uint32_t> object_candidates; // temporary storage of hierarchical culling (when the scene has an object BVH)
 
 		std::atomic<uint32_t> object_counter;
 		std::atomic<uint32_t> light_counter;
@@ -42,6 +42,8 @@ namespace wi
 
 	struct ResourceInternal
 	{
+		static constexpr wi::allocator::MemoryTag memory_tag = wi::allocator::MemoryTag::Resource;
+
 		resourcemanager::Flags flags = resourcemanager::Flags::NONE;
 		wi::graphics::Texture texture;
 		int srgb_subresource = -1;
@@ -50,6 +52,7 @@ namespace wi
 		size_t script_hash = 0;
 		wi::video::Video video;
 		wi::vector<uint8_t> filedata;
+		wi::allocator::TrackedSize<wi::allocator::MemoryTag::Resource> filedata_tracked; // must be updated when filedata is modified
 		int font_style = -1;
 
 		// Original filename:
@@ -60,6 +63,7 @@ namespace wi
 		std::string container_filename;
 		size_t container_filesize = ~0ull;
 		size_t container_fileoffset = 0;
+		bool container_chunked = false; // container is an archive with chunked compression, the offset is within the uncompressed data
 		uint64_t timestamp = 0;
 
 		// Streaming parameters:
@@ -124,6 +128,7 @@ namespace wi
 		}
 		ResourceInternal* resourceinternal = (ResourceInternal*)internal_state.get();
 		resourceinternal->filedata = data;
+		resourceinternal->filedata_tracked.set(resourceinternal->filedata.capacity());
 	}
 	void Resource::SetFileData(wi::vector<uint8_t>&& data)
 	{
@@ -133,6 +138,7 @@ namespace wi
 		}
 		ResourceInternal* resourceinternal = (ResourceInternal*)internal_state.get();
 		resourceinternal->filedata = data;
+		resourceinternal->filedata_tracked.set(resourceinternal->filedata.capacity());
 	}
 	void Resource::SetTexture(const wi::graphics::Texture& texture, int srgb_subresource)
 	{
@@ -900,11 +906,22 @@ namespace wi
 				// file data can be discarded:
 				resource->filedata.clear();
 				resource->filedata.shrink_to_fit();
+				resource->filedata_tracked.set(0);
 			}
 
 			return success;
 		}
 
+		// Reads the file data of the resource from its container file
+		bool ReadContainerFile(const ResourceInternal* resource, wi::vector<uint8_t>& data, size_t size, size_t offset)
+		{
+			if (resource->container_chunked)
+			{
+				return wi::Archive::ReadFileRange(resource->container_filename, offset, size, data);
+			}
+			return wi::helper::FileRead(resource->container_filename, data, size, offset);
+		}
+
 		Resource Load(
 			const std::string& name,
 			Flags flags,
@@ -953,6 +970,7 @@ namespace wi
 					//	this must also happen when using IMPORT_DELAY!
 					resource->filedata.resize(filesize);
 					std::memcpy(resource->filedata.data(), filedata, filesize);
+					resource->filedata_tracked.set(resource->filedata.capacity());
 				}
 			}
 			else
@@ -978,11 +996,12 @@ namespace wi
 			{
 				if (resource->filedata.empty())
 				{
-					if (!wi::helper::FileRead(resource->container_filename, resource->filedata, resource->container_filesize, resource->container_fileoffset))
+					if (!ReadContainerFile(resource.get(), resource->filedata, resource->container_filesize, resource->container_fileoffset))
 					{
 						resource.reset();
 						return Resource();
 					}
+					resource->filedata_tracked.set(resource->filedata.capacity());
 				}
 				filedata = resource->filedata.data();
 				filesize = resource->filedata.size();
@@ -1223,8 +1242,8 @@ namespace wi
 							// If file data is not available, then open the file partially with the streaming file parameters:
 							size_t filesize = resource->container_filesize - mip_data_offset;
 							size_t fileoffset = resource->container_fileoffset + mip_data_offset;
-							if (!wi::helper::FileRead(
-								resource->container_filename,
+							if (!ReadContainerFile(
+								resource.get(),
 								streaming_file,
 								filesize,
 								fileoffset
@@ -1320,6 +1339,7 @@ namespace wi
 							resourceinternal->container_filename = resourceinternal->filename;
 							resourceinternal->container_fileoffset = 0;
 							resourceinternal->container_filesize = ~0ull;
+							resourceinternal->container_chunked = false;
 							wi::backlog::post("[resourcemanager] reload success: " + resourceinternal->filename);
 						}
 						else
@@ -1419,9 +1439,9 @@ namespace wi
 				wi::jobsystem::Execute(ctx, [i, &temp_resources, &seri, &archive, file_offset](wi::jobsystem::JobArgs args) {
 					auto& tmp_resource = temp_resources[i];
 					Flags flags = Flags::IMPORT_DELAY;
-					if (archive.IsCompressionEnabled())
+					if (archive.IsCompressionEnabled() && !archive.IsCompressionChunked())
 					{
-						// If compressed archive, cannot stream from it, retain file data in memory:
+						// If compressed archive is not chunked, cannot stream from it, retain file data in memory:
 						flags |= Flags::IMPORT_RETAIN_FILEDATA;
 					}
 					auto res = Load(
@@ -1432,6 +1452,15 @@ namespace wi
 						archive.GetSourceFileName(),
 						file_offset
 					);
+					if (archive.IsCompressionChunked() && res.IsValid())
+					{
+						// Chunked compressed archive can be streamed from with the offset in uncompressed data:
+						ResourceInternal* resourceinternal = (ResourceInternal*)res.internal_state.get();
+						if (resourceinternal->container_filename == archive.GetSourceFileName() && resourceinternal->container_fileoffset == file_offset)
+						{
+							resourceinternal->container_chunked = true;
+						}
+					}
 					static std::mutex seri_locker;
 					seri_locker.lock();
 					seri.resources.push_back(res);
@@ -1487,12 +1516,13 @@ namespace wi
 						if (resource->filedata.empty())
 						{
 							// Directly re-read the file part that is needed:
-							wi::helper::FileRead(
-								resource->container_filename,
+							ReadContainerFile(
+								resource.get(),
 								resource->filedata,
 								resource->container_filesize,
 								resource->container_fileoffset
 							);
+							resource->filedata_tracked.set(resource->filedata.capacity());
 						}
 
 						archive << name;
@@ -1508,15 +1538,17 @@ namespace wi
 							resource->container_filename = archive.GetSourceFileName();
 							resource->container_fileoffset = archive.GetPos() - resource->filedata.size();
 							resource->container_filesize = resource->filedata.size();
-							if (archive.IsCompressionEnabled())
+							resource->container_chunked = archive.IsCompressionChunked();
+							if (archive.IsCompressionEnabled() && !archive.IsCompressionChunked())
 							{
-								// Compressed archive: retain file data to keep resource streamable
+								// Compressed archive that is not chunked: retain file data to keep resource streamable
 								resource->flags |= Flags::IMPORT_RETAIN_FILEDATA;
 							}
 							if (!has_flag(resource->flags, Flags::IMPORT_RETAIN_FILEDATA))
 							{
 								resource->filedata.clear();
 								resource->filedata.shrink_to_fit();
+								resource->filedata_tracked.set(0);
 							}
 						}
 					}
@@ -31,6 +31,38 @@ namespace wi::scene
 {
 	static constexpr uint32_t small_subtask_groupsize = 256u;
 
+	// Changed GPU record ranges that are closer than this are copied together:
+	static constexpr size_t copy_range_merge_gap = 64;
+	// If there are more changed ranges than this, they are copied with a single range instead:
+	static constexpr size_t copy_range_max_count = 256;
+
+	// Gathers the ranges of GPU records that must be copied for a change tracked component manager
+	//	The records after the components (manager.GetCount() <= index < total_count) are always included, because they are rewritten every frame
+	template<typename T>
+	static void GatherCopyRanges(const ComponentManager<T>& manager, uint64_t version, size_t total_count, wi::vector<IndexRange>& ranges)
+	{
+		manager.GetChangedRanges(version, ranges, copy_range_merge_gap);
+		const size_t tail_offset = manager.GetCount();
+		if (total_count > tail_offset)
+		{
+			if (!ranges.empty() && ranges.back().offset + ranges.back().count + copy_range_merge_gap >= tail_offset)
+			{
+				ranges.back().count = total_count - ranges.back().offset;
+			}
+			else
+			{
+				ranges.push_back({ tail_offset, total_count - tail_offset });
+			}
+		}
+		if (ranges.size() > copy_range_max_count)
+		{
+			const size_t offset = ranges.front().offset;
+			const size_t count = ranges.back().offset + ranges.back().count - offset;
+			ranges.clear();
+			ranges.push_back({ offset, count });
+		}
+	}
+
 	void Scene::Update(float dt)
 	{
 		GraphicsDevice* device = wi::graphics::GetDevice();
@@ -72,6 +104,16 @@ namespace wi::scene
 
 		StartBuildTopDownHierarchy();
 
+		// Objects and materials are change tracked, so their GPU records are only written and copied when they are modified:
+		if (!objects.IsChangeTrackingEnabled())
+		{
+			objects.SetChangeTrackingEnabled(true);
+		}
+		if (!materials.IsChangeTrackingEnabled())
+		{
+			materials.SetChangeTrackingEnabled(true);
+		}
+
 		instanceArraySize = objects.GetCount() + hairs.GetCount() + emitters.GetCount();
 		if (impostors.GetCount() > 0)
 		{
@@ -106,7 +148,9 @@ namespace wi::scene
 			{
 				device->CreateBuffer(&desc, nullptr, &instanceUploadBuffer[i]);
 				device->SetName(&instanceUploadBuffer[i], "Scene::instanceUploadBuffer");
+				instanceUploadVersions[i] = 0;
 			}
+			instanceCopyVersion = 0;
 		}
 		instanceArrayMapped = (ShaderMeshInstance*)instanceUploadBuffer[cpu_gpu_mapped_resource_index].mapped_data;
 
@@ -144,7 +188,9 @@ namespace wi::scene
 			{
 				device->CreateBuffer(&desc, nullptr, &materialUploadBuffer[i]);
 				device->SetName(&materialUploadBuffer[i], "Scene::materialUploadBuffer");
+				materialUploadVersions[i] = 0;
 			}
+			materialCopyVersion = 0;
 		}
 		materialArrayMapped = (ShaderMaterial*)materialUploadBuffer[cpu_gpu_mapped_resource_index].mapped_data;
 
@@ -210,208 +256,244 @@ namespace wi::scene
 			queryAllocator.store(0);
 		}
 
-		if (dt > 0)
-		{
-			// Scan objects to check if lightmap rendering is requested:
-			lightmap_request_allocator.store(0);
-			lightmap_requests.reserve(objects.GetCount());
-			wi::jobsystem::Dispatch(ctx, (uint32_t)objects.GetCount(), small_subtask_groupsize, [this](wi::jobsystem::JobArgs args) {
-				ObjectComponent& object = objects[args.jobIndex];
-				if (object.IsLightmapRenderRequested())
-				{
-					uint32_t request_index = lightmap_request_allocator.fetch_add(1);
-					*(lightmap_requests.data() + request_index) = args.jobIndex;
-				}
-			});
-
-			// Scan mesh subset counts and skinning data sizes to allocate GPU geometry data:
-			geometryAllocator.store(0u);
-			skinningAllocator.store(0u);
-			wi::jobsystem::Dispatch(ctx, (uint32_t)meshes.GetCount(), small_subtask_groupsize, [&](wi::jobsystem::JobArgs args) {
-				MeshComponent& mesh = meshes[args.jobIndex];
-				mesh.geometryOffset = geometryAllocator.fetch_add((uint32_t)mesh.subsets.size());
-				skinningAllocator.fetch_add(uint32_t(mesh.morph_targets.size() * sizeof(MorphTargetGPU)));
-			});
-			wi::jobsystem::Dispatch(ctx, (uint32_t)armatures.GetCount(), small_subtask_groupsize, [&](wi::jobsystem::JobArgs args) {
-				ArmatureComponent& armature = armatures[args.jobIndex];
-				skinningAllocator.fetch_add(uint32_t(armature.boneCollection.size() * sizeof(ShaderTransform)));
-			});
-
-			wi::jobsystem::Execute(ctx, [&](wi::jobsystem::JobArgs args) {
-				// Must not keep inactive instances, so init them for safety:
-				ShaderMeshInstance inst;
-				inst.init();
-				for (uint32_t i = 0; i < instanceArraySize; ++i)
-				{
-					std::memcpy(instanceArrayMapped + i, &inst, sizeof(inst));
-				}
-			});
-		}
-
-		RunCharacterUpdateSystem(ctx);
-
-		RunAnimationUpdateSystem(ctx);
+		// The systems are scheduled with a task graph instead of waiting for all of them between every stage
+		//	Every system issues jobs into its own context and waits for them within its task, so the graph only continues with the dependent systems when it's finished
+		//	The dependencies express which data the systems are reading that were written by other systems
+		using Task = wi::jobsystem::TaskGraph::Task;
+		update_graph.Clear();
+		auto add_system = [this](const char* name, void(Scene::*system)(wi::jobsystem::context&), std::initializer_list<Task> dependencies) {
+			return update_graph.Add(name, [this, system](wi::jobsystem::JobArgs args) {
+				wi::jobsystem::context ctx;
+				(this->*system)(ctx);
+				wi::jobsystem::Wait(ctx);
+			}, dependencies);
+		};
 
-		wi::physics::RunPhysicsUpdateSystem(ctx, *this, dt);
+		const Task scan_task = update_graph.Add("Scan", [this, dt](wi::jobsystem::JobArgs args) {
+			wi::jobsystem::context ctx;
+			if (dt > 0)
+			{
+				// Scan objects to check if lightmap rendering is requested:
+				lightmap_request_allocator.store(0);
+				lightmap_requests.reserve(objects.GetCount());
+				wi::jobsystem::Dispatch(ctx, (uint32_t)objects.GetCount(), small_subtask_groupsize, [this](wi::jobsystem::JobArgs args) {
+					ObjectComponent& object = objects[args.jobIndex];
+					if (object.IsLightmapRenderRequested())
+					{
+						uint32_t request_index = lightmap_request_allocator.fetch_add(1);
+						*(lightmap_requests.data() + request_index) = args.jobIndex;
+					}
+				});
 
-		RunTransformUpdateSystem(ctx);
+				// Scan mesh subset counts and skinning data sizes to allocate GPU geometry data:
+				//	Geometries are allocated in mesh order, so the offsets that object instances refer to don't change between frames
+				uint32_t geometryOffset = 0;
+				uint32_t skinningSize = 0;
+				for (size_t i = 0; i < meshes.GetCount(); ++i)
+				{
+					MeshComponent& mesh = meshes[i];
+					mesh.geometryOffset = geometryOffset;
+					geometryOffset += (uint32_t)mesh.subsets.size();
+					skinningSize += uint32_t(mesh.morph_targets.size() * sizeof(MorphTargetGPU));
+				}
+				geometryAllocator.store(geometryOffset);
+				skinningAllocator.store(skinningSize);
+				wi::jobsystem::Dispatch(ctx, (uint32_t)armatures.GetCount(), small_subtask_groupsize, [&](wi::jobsystem::JobArgs args) {
+					ArmatureComponent& armature = armatures[args.jobIndex];
+					skinningAllocator.fetch_add(uint32_t(armature.boneCollection.size() * sizeof(ShaderTransform)));
+				});
 
-		wi::jobsystem::Wait(ctx); // dependencies
+				wi::jobsystem::Execute(ctx, [&](wi::jobsystem::JobArgs args) {
+					// Must not keep inactive instances, so init them for safety:
+					//	Object instances are always written by the object update system when they changed, so only the rest is initialized here
+					ShaderMeshInstance inst;
+					inst.init();
+					for (uint32_t i = (uint32_t)objects.GetCount(); i < instanceArraySize; ++i)
+					{
+						std::memcpy(instanceArrayMapped + i, &inst, sizeof(inst));
+					}
+				});
+			}
+			wi::jobsystem::Wait(ctx);
+		});
 
-		RunHierarchyUpdateSystem(ctx);
+		const Task character_task = add_system("Character", &Scene::RunCharacterUpdateSystem, {});
+		const Task animation_task = add_system("Animation", &Scene::RunAnimationUpdateSystem, { character_task });
+		const Task physics_task = update_graph.Add("Physics", [this, dt](wi::jobsystem::JobArgs args) {
+			wi::jobsystem::context ctx;
+			wi::physics::RunPhysicsUpdateSystem(ctx, *this, dt);
+			wi::jobsystem::Wait(ctx);
+		}, { animation_task });
+		const Task transform_task = add_system("Transform", &Scene::RunTransformUpdateSystem, { physics_task });
+		const Task hierarchy_task = add_system("Hierarchy", &Scene::RunHierarchyUpdateSystem, { transform_task });
 
-		// Lightmap requests are determined at this point, so we know if we need TLAS or not:
-		if (lightmap_request_allocator.load() > 0)
-		{
-			SetAccelerationStructureUpdateRequested(true);
-		}
+		// GPU data allocations only depend on the scan results:
+		const Task allocation_task = update_graph.Add("Allocation", [this, device](wi::jobsystem::JobArgs args) {
+			wi::jobsystem::context ctx;
 
-		// This must be after lightmap requests were determined:
-		TLAS_instancesMapped = nullptr;
-		if (instanceArraySize > 0 && IsAccelerationStructureUpdateRequested() && device->CheckCapability(GraphicsDeviceCapability::RAYTRACING))
-		{
-			GPUBufferDesc desc;
-			desc.stride = (uint32_t)device->GetTopLevelAccelerationStructureInstanceSize();
-			desc.size = desc.stride * instanceArraySize * 2; // *2 to grow fast
-			desc.usage = Usage::UPLOAD;
-			desc.alignment = 16ull; // vulkan
-			if (TLAS_instancesUpload->desc.size < desc.size)
+			// Lightmap requests are determined at this point, so we know if we need TLAS or not:
+			if (lightmap_request_allocator.load() > 0)
 			{
-				for (int i = 0; i < arraysize(TLAS_instancesUpload); ++i)
-				{
-					device->CreateBuffer(&desc, nullptr, &TLAS_instancesUpload[i]);
-					device->SetName(&TLAS_instancesUpload[i], "Scene::TLAS_instancesUpload");
-				}
+				SetAccelerationStructureUpdateRequested(true);
 			}
-			TLAS_instancesMapped = TLAS_instancesUpload[cpu_gpu_mapped_resource_index].mapped_data;
 
-			wi::jobsystem::Execute(ctx, [&](wi::jobsystem::JobArgs args) {
-				// Must not keep inactive TLAS instances, so zero them out for safety with invalid instances:
-				//	Note: instead of memsetting, I use WriteTopLevelAccelerationStructureInstance with null instance, so if device requires setup other than zeroing it will still work
-				const uint32_t instanceCount = uint32_t(TLAS_instancesUpload->desc.size / TLAS_instancesUpload->desc.stride);
-				const size_t instanceSize = device->GetTopLevelAccelerationStructureInstanceSize();
-				for (uint32_t i = 0; i < instanceCount; ++i)
+			// This must be after lightmap requests were determined:
+			TLAS_instancesMapped = nullptr;
+			if (instanceArraySize > 0 && IsAccelerationStructureUpdateRequested() && device->CheckCapability(GraphicsDeviceCapability::RAYTRACING))
+			{
+				GPUBufferDesc desc;
+				desc.stride = (uint32_t)device->GetTopLevelAccelerationStructureInstanceSize();
+				desc.size = desc.stride * instanceArraySize * 2; // *2 to grow fast
+				desc.usage = Usage::UPLOAD;
+				desc.alignment = 16ull; // vulkan
+				if (TLAS_instancesUpload->desc.size < desc.size)
 				{
-					device->WriteTopLevelAccelerationStructureInstance(nullptr, (uint8_t*)TLAS_instancesMapped + i * instanceSize);
+					for (int i = 0; i < arraysize(TLAS_instancesUpload); ++i)
+					{
+						device->CreateBuffer(&desc, nullptr, &TLAS_instancesUpload[i]);
+						device->SetName(&TLAS_instancesUpload[i], "Scene::TLAS_instancesUpload");
+					}
 				}
-			});
-		}
-
-		// GPU subset count allocation is ready at this point:
-		geometryArraySize = geometryAllocator.load();
-		geometryArraySize += hairs.GetCount();
-		geometryArraySize += emitters.GetCount();
-		if (impostors.GetCount() > 0)
-		{
-			impostorGeometryOffset = uint32_t(geometryArraySize);
-			geometryArraySize += 1;
-		}
-		if (weathers.GetCount() > 0 && weathers[0].rain_amount > 0)
-		{
-			rainGeometryOffset = uint32_t(geometryArraySize);
-			geometryArraySize += 1;
-		}
-		if (geometryUploadBuffer[0].desc.size < (geometryArraySize * sizeof(ShaderGeometry)))
-		{
-			GPUBufferDesc desc;
-			desc.stride = sizeof(ShaderGeometry);
-			desc.size = desc.stride * geometryArraySize * 2; // *2 to grow fast
-			desc.bind_flags = BindFlag::SHADER_RESOURCE;
-			desc.misc_flags = ResourceMiscFlag::BUFFER_STRUCTURED;
-			if (!device->CheckCapability(GraphicsDeviceCapability::CACHE_COHERENT_UMA))
-			{
-				// Non-UMA: separate Default usage buffer
-				device->CreateBuffer(&desc, nullptr, &geometryBuffer);
-				device->SetName(&geometryBuffer, "Scene::geometryBuffer");
+				TLAS_instancesMapped = TLAS_instancesUpload[cpu_gpu_mapped_resource_index].mapped_data;
 
-				// Upload buffer shouldn't be used by shaders with Non-UMA:
-				desc.bind_flags = BindFlag::NONE;
-				desc.misc_flags = ResourceMiscFlag::NONE;
+				wi::jobsystem::Execute(ctx, [&](wi::jobsystem::JobArgs args) {
+					// Must not keep inactive TLAS instances, so zero them out for safety with invalid instances:
+					//	Note: instead of memsetting, I use WriteTopLevelAccelerationStructureInstance with null instance, so if device requires setup other than zeroing it will still work
+					const uint32_t instanceCount = uint32_t(TLAS_instancesUpload->desc.size / TLAS_instancesUpload->desc.stride);
+					const size_t instanceSize = device->GetTopLevelAccelerationStructureInstanceSize();
+					for (uint32_t i = 0; i < instanceCount; ++i)
+					{
+						device->WriteTopLevelAccelerationStructureInstance(nullptr, (uint8_t*)TLAS_instancesMapped + i * instanceSize);
+					}
+				});
 			}
 
-			desc.usage = Usage::UPLOAD;
-			for (int i = 0; i < arraysize(geometryUploadBuffer); ++i)
+			// GPU subset count allocation is ready at this point:
+			geometryArraySize = geometryAllocator.load();
+			geometryArraySize += hairs.GetCount();
+			geometryArraySize += emitters.GetCount();
+			if (impostors.GetCount() > 0)
 			{
-				device->CreateBuffer(&desc, nullptr, &geometryUploadBuffer[i]);
-				device->SetName(&geometryUploadBuffer[i], "Scene::geometryUploadBuffer");
+				impostorGeometryOffset = uint32_t(geometryArraySize);
+				geometryArraySize += 1;
 			}
-		}
-		geometryArrayMapped = (ShaderGeometry*)geometryUploadBuffer[cpu_gpu_mapped_resource_index].mapped_data;
-
-		// Skinning data size is ready at this point:
-		skinningDataSize = skinningAllocator.load();
-		skinningAllocator.store(0);
-		if (skinningUploadBuffer[0].desc.size < skinningDataSize)
-		{
-			GPUBufferDesc desc;
-			desc.size = skinningDataSize * 2; // *2 to grow fast
-			desc.bind_flags = BindFlag::SHADER_RESOURCE;
-			desc.misc_flags = ResourceMiscFlag::BUFFER_RAW;
-			if (!device->CheckCapability(GraphicsDeviceCapability::CACHE_COHERENT_UMA))
+			if (weathers.GetCount() > 0 && weathers[0].rain_amount > 0)
 			{
-				// Non-UMA: separate Default usage buffer
-				device->CreateBuffer(&desc, nullptr, &skinningBuffer);
-				device->SetName(&skinningBuffer, "Scene::skinningBuffer");
-
-				// Upload buffer shouldn't be used by shaders with Non-UMA:
-				desc.bind_flags = BindFlag::NONE;
-				desc.misc_flags = ResourceMiscFlag::NONE;
+				rainGeometryOffset = uint32_t(geometryArraySize);
+				geometryArraySize += 1;
 			}
-
-			desc.usage = Usage::UPLOAD;
-			for (int i = 0; i < arraysize(skinningUploadBuffer); ++i)
+			if (geometryUploadBuffer[0].desc.size < (geometryArraySize * sizeof(ShaderGeometry)))
 			{
-				device->CreateBuffer(&desc, nullptr, &skinningUploadBuffer[i]);
-				device->SetName(&skinningUploadBuffer[i], "Scene::skinningUploadBuffer");
-			}
-		}
-		skinningDataMapped = skinningUploadBuffer[cpu_gpu_mapped_resource_index].mapped_data;
-
-		RunExpressionUpdateSystem(ctx);
-
-		RunMeshUpdateSystem(ctx);
-
-		RunVideoUpdateSystem(ctx);
-
-		RunMaterialUpdateSystem(ctx);
-
-		wi::jobsystem::Wait(ctx); // dependencies
-
-		WaitBuildTopDownHierarchy();
-
-		RunProceduralAnimationUpdateSystem(ctx);
-
-		wi::physics::OverrideWehicleWheelTransforms(*this);
-
-		RunArmatureUpdateSystem(ctx);
-
-		RunWeatherUpdateSystem(ctx);
-
-		wi::jobsystem::Wait(ctx); // dependencies
-
-		RunObjectUpdateSystem(ctx);
-
-		RunCameraUpdateSystem(ctx);
-
-		RunDecalUpdateSystem(ctx);
-
-		RunProbeUpdateSystem(ctx);
+				GPUBufferDesc desc;
+				desc.stride = sizeof(ShaderGeometry);
+				desc.size = desc.stride * geometryArraySize * 2; // *2 to grow fast
+				desc.bind_flags = BindFlag::SHADER_RESOURCE;
+				desc.misc_flags = ResourceMiscFlag::BUFFER_STRUCTURED;
+				if (!device->CheckCapability(GraphicsDeviceCapability::CACHE_COHERENT_UMA))
+				{
+					// Non-UMA: separate Default usage buffer
+					device->CreateBuffer(&desc, nullptr, &geometryBuffer);
+					device->SetName(&geometryBuffer, "Scene::geometryBuffer");
 
-		RunForceUpdateSystem(ctx);
+					// Upload buffer shouldn't be used by shaders with Non-UMA:
+					desc.bind_flags = BindFlag::NONE;
+					desc.misc_flags = ResourceMiscFlag::NONE;
+				}
 
-		RunLightUpdateSystem(ctx);
+				desc.usage = Usage::UPLOAD;
+				for (int i = 0; i < arraysize(geometryUploadBuffer); ++i)
+				{
+					device->CreateBuffer(&desc, nullptr, &geometryUploadBuffer[i]);
+					device->SetName(&geometryUploadBuffer[i], "Scene::geometryUploadBuffer");
+				}
+			}
+			geometryArrayMapped = (ShaderGeometry*)geometryUploadBuffer[cpu_gpu_mapped_resource_index].mapped_data;
 
-		RunParticleUpdateSystem(ctx);
+			// Skinning data size is ready at this point:
+			skinningDataSize = skinningAllocator.load();
+			skinningAllocator.store(0);
+			if (skinningUploadBuffer[0].desc.size < skinningDataSize)
+			{
+				GPUBufferDesc desc;
+				desc.size = skinningDataSize * 2; // *2 to grow fast
+				desc.bind_flags = BindFlag::SHADER_RESOURCE;
+				desc.misc_flags = ResourceMiscFlag::BUFFER_RAW;
+				if (!device->CheckCapability(GraphicsDeviceCapability::CACHE_COHERENT_UMA))
+				{
+					// Non-UMA: separate Default usage buffer
+					device->CreateBuffer(&desc, nullptr, &skinningBuffer);
+					device->SetName(&skinningBuffer, "Scene::skinningBuffer");
 
-		RunSoundUpdateSystem(ctx);
+					// Upload buffer shouldn't be used by shaders with Non-UMA:
+					desc.bind_flags = BindFlag::NONE;
+					desc.misc_flags = ResourceMiscFlag::NONE;
+				}
 
-		RunImpostorUpdateSystem(ctx);
+				desc.usage = Usage::UPLOAD;
+				for (int i = 0; i < arraysize(skinningUploadBuffer); ++i)
+				{
+					device->CreateBuffer(&desc, nullptr, &skinningUploadBuffer[i]);
+					device->SetName(&skinningUploadBuffer[i], "Scene::skinningUploadBuffer");
+				}
+			}
+			skinningDataMapped = skinningUploadBuffer[cpu_gpu_mapped_resource_index].mapped_data;
 
-		RunSpriteUpdateSystem(ctx);
+			wi::jobsystem::Wait(ctx);
+		}, { scan_task });
+
+		const Task video_task = add_system("Video", &Scene::RunVideoUpdateSystem, {});
+		const Task expression_task = add_system("Expression", &Scene::RunExpressionUpdateSystem, { hierarchy_task });
+		const Task mesh_task = add_system("Mesh", &Scene::RunMeshUpdateSystem, { expression_task, allocation_task });
+		const Task material_task = add_system("Material", &Scene::RunMaterialUpdateSystem, { expression_task, video_task });
+
+		// Object meshlets are allocated in object order, so unchanged object instances keep their meshlet offsets between frames
+		//	The other systems allocate their meshlets after the objects
+		const Task meshlet_task = update_graph.Add("Meshlet Allocation", [this](wi::jobsystem::JobArgs args) {
+			meshlet_offsets_objects.resize(objects.GetCount());
+			uint32_t meshletOffset = 0;
+			for (size_t i = 0; i < objects.GetCount(); ++i)
+			{
+				meshlet_offsets_objects[i] = meshletOffset;
+				const MeshComponent* mesh = meshes.GetComponent(objects[i].meshID);
+				if (mesh != nullptr)
+				{
+					meshletOffset += mesh->meshletCount;
+				}
+			}
+			meshletAllocator.store(meshletOffset);
+		}, { mesh_task });
 
-		RunFontUpdateSystem(ctx);
+		const Task procedural_animation_task = update_graph.Add("Procedural Animation", [this](wi::jobsystem::JobArgs args) {
+			WaitBuildTopDownHierarchy();
+			wi::jobsystem::context ctx;
+			RunProceduralAnimationUpdateSystem(ctx);
+			wi::jobsystem::Wait(ctx);
+			wi::physics::OverrideWehicleWheelTransforms(*this);
+		}, { mesh_task, material_task });
+
+		// Transforms are final from this point:
+		const Task armature_task = add_system("Armature", &Scene::RunArmatureUpdateSystem, { procedural_animation_task });
+		const Task weather_task = add_system("Weather", &Scene::RunWeatherUpdateSystem, { procedural_animation_task });
+		const Task object_task = add_system("Object", &Scene::RunObjectUpdateSystem, { armature_task, weather_task, meshlet_task });
+		update_graph.Add("Object BVH", [this](wi::jobsystem::JobArgs args) {
+			UpdateObjectBVH();
+		}, { object_task });
+		add_system("Camera", &Scene::RunCameraUpdateSystem, { procedural_animation_task });
+		add_system("Decal", &Scene::RunDecalUpdateSystem, { procedural_animation_task });
+		add_system("Probe", &Scene::RunProbeUpdateSystem, { procedural_animation_task });
+		add_system("Force", &Scene::RunForceUpdateSystem, { procedural_animation_task });
+		add_system("Light", &Scene::RunLightUpdateSystem, { weather_task });
+		add_system("Particle", &Scene::RunParticleUpdateSystem, { armature_task, weather_task, meshlet_task });
+		const Task sound_task = add_system("Sound", &Scene::RunSoundUpdateSystem, { procedural_animation_task });
+		add_system("Impostor", &Scene::RunImpostorUpdateSystem, { armature_task, weather_task, meshlet_task });
+		add_system("Sprite", &Scene::RunSpriteUpdateSystem, { video_task });
+		add_system("Font", &Scene::RunFontUpdateSystem, { sound_task });
+
+		update_graph.Run(ctx);
+		wi::jobsystem::Wait(ctx);
 
-		wi::jobsystem::Wait(ctx); // dependencies
+		update_critical_path_time = update_graph.GetCriticalPathTime();
+		wi::profiler::AddRangeCPU("Scene::Update critical path", update_critical_path_time);
 
 		// Merge parallel bounds computation (depends on object update system):
 		bounds = AABB();
@@ -420,6 +502,24 @@ namespace wi::scene
 			bounds = AABB::Merge(bounds, group_bound);
 		}
 
+		// Every object instance and material that changed is written into the mapped buffers at this point:
+		instanceUploadVersions[cpu_gpu_mapped_resource_index] = objects.GetChangeVersion();
+		materialUploadVersions[cpu_gpu_mapped_resource_index] = materials.GetChangeVersion();
+		if (instanceBuffer.IsValid())
+		{
+			// The ranges contain every change since the renderer last recorded the copies, so updates without rendering in between don't lose changes:
+			GatherCopyRanges(objects, instanceCopyVersion, instanceArraySize, instanceCopyRanges);
+			instanceCopyRangesVersion = objects.GetChangeVersion();
+		}
+		if (materialBuffer.IsValid())
+		{
+			GatherCopyRanges(materials, materialCopyVersion, materialArraySize, materialCopyRanges);
+			materialCopyRangesVersion = materials.GetChangeVersion();
+		}
+		// Modifications from now on will be picked up by the next update:
+		objects.AdvanceChangeVersion();
+		materials.AdvanceChangeVersion();
+
 		// Meshlet buffer:
 		uint32_t meshletCount = meshletAllocator.load();
 		if(meshletBuffer.desc.size < meshletCount * sizeof(ShaderMeshlet))
@@ -995,6 +1095,7 @@ namespace wi::scene
 		aabb_decals.clear();
 		aabb_probes.clear();
 		aabb_fonts.clear();
+		object_bvh = {};
 
 		matrix_objects.clear();
 		matrix_objects_prev.clear();
@@ -1129,7 +1230,11 @@ namespace wi::scene
 				aabb_colliders_gpu[collider.gpu_index] = aabb;
 			}
 		}
-		collider_bvh.Build(aabb_colliders_cpu, collider_count_cpu);
+		collider_bvh.Build(aabb_colliders_cpu, collider_count_cpu, wi::BVH::BuildMode::SAH);
+		if (IsColliderBVHWideEnabled())
+		{
+			collider_bvh.BuildWide();
+		}
 	}
 	Entity Scene::Instantiate(Scene& prefab, bool attached)
 	{
@@ -1945,6 +2050,12 @@ namespace wi::scene
 
 		wi::jobsystem::Dispatch(ctx, (uint32_t)animation_queue_count, 1, [&](wi::jobsystem::JobArgs args) {
 
+			wi::profiler::ScopedRangeCPU queue_range("Animation Queue");
+
+			// The animation data of every sampler is looked up once per animation, not for every channel:
+			static thread_local wi::vector<const AnimationDataComponent*> sampler_datas;
+			static thread_local wi::vector<float> decoded_keyframes;
+
 			AnimationQueue& animation_queue = animation_queues[args.jobIndex];
 			for (size_t animation_index = 0; animation_index < animation_queue.animations.size(); ++animation_index)
 			{
@@ -1953,16 +2064,36 @@ namespace wi::scene
 					continue;
 				animation.last_update_time = animation.timer;
 
+				sampler_datas.resize(animation.samplers.size());
+				for (size_t sampler_index = 0; sampler_index < animation.samplers.size(); ++sampler_index)
+				{
+					AnimationComponent::AnimationSampler& sampler = animation.samplers[sampler_index];
+					const Scene* data_scene = sampler.scene == nullptr ? this : (const Scene*)sampler.scene;
+					const AnimationDataComponent* animationdata = data_scene->animation_datas.GetComponent(sampler.data);
+					if (animationdata != nullptr && animationdata->keyframe_times.empty())
+					{
+						animationdata = nullptr;
+					}
+					sampler_datas[sampler_index] = animationdata;
+
+					// Revalidate the keyframe search cache if the keyframe data changed:
+					if (animationdata != nullptr && (sampler.cached_keyframe_times != animationdata->keyframe_times.data() || sampler.cached_keyframe_count != animationdata->keyframe_times.size()))
+					{
+						sampler.cached_keyframe_times = animationdata->keyframe_times.data();
+						sampler.cached_keyframe_count = animationdata->keyframe_times.size();
+						sampler.cached_keyframes_sorted = std::is_sorted(animationdata->keyframe_times.begin(), animationdata->keyframe_times.end());
+						sampler.cached_key = 0;
+					}
+				}
+
 				for (const AnimationComponent::AnimationChannel& channel : animation.channels)
 				{
 					assert(channel.samplerIndex < (int)animation.samplers.size());
-					const AnimationComponent::AnimationSampler& sampler = animation.samplers[channel.samplerIndex];
+					AnimationComponent::AnimationSampler& sampler = animation.samplers[channel.samplerIndex];
 					const Scene* data_scene = sampler.scene == nullptr ? this : (const Scene*)sampler.scene;
-					const AnimationDataComponent* animationdata = data_scene->animation_datas.GetComponent(sampler.data);
+					const AnimationDataComponent* animationdata = sampler_datas[channel.samplerIndex];
 					if (animationdata == nullptr)
 						continue;
-					if (animationdata->keyframe_times.empty())
-						continue;
 
 					const AnimationComponent::AnimationChannel::PathDataType path_data_type = channel.GetPathDataType();
 
@@ -1974,26 +2105,76 @@ namespace wi::scene
 					float timeRight = FLT_MAX;
 
 					// search for usable keyframes:
-					for (int k = 0; k < (int)animationdata->keyframe_times.size(); ++k)
-					{
-						const float time = animationdata->keyframe_times[k];
-						if (time < timeFirst)
+					const float* keyframe_times = animationdata->keyframe_times.data();
+					const int keyframe_count = (int)animationdata->keyframe_times.size();
+					if (sampler.cached_keyframes_sorted)
+					{
+						timeFirst = keyframe_times[0];
+						timeLast = keyframe_times[keyframe_count - 1];
+
+						// Find the first keyframe after the timer, starting from the one found in the previous update.
+						//	When playing forward, it's usually the same or the next one, otherwise binary search (for seeking, looping, reverse playback):
+						int key = std::min(std::max(sampler.cached_key, 0), keyframe_count);
+						auto is_upper_bound = [&](int k) {
+							return (k == 0 || keyframe_times[k - 1] <= animation.timer) && (k == keyframe_count || keyframe_times[k] > animation.timer);
+						};
+						if (!is_upper_bound(key))
+						{
+							if (key < keyframe_count && is_upper_bound(key + 1))
+							{
+								key++;
+							}
+							else
+							{
+								key = int(std::upper_bound(keyframe_times, keyframe_times + keyframe_count, animation.timer) - keyframe_times);
+							}
+						}
+						sampler.cached_key = key;
+
+						if (key > 0)
 						{
-							timeFirst = time;
+							// Among keyframes with equal times, the first one is used:
+							keyLeft = key - 1;
+							while (keyLeft > 0 && keyframe_times[keyLeft - 1] == keyframe_times[keyLeft])
+							{
+								keyLeft--;
+							}
+							timeLeft = keyframe_times[keyLeft];
 						}
-						if (time > timeLast)
+						if (timeLeft == animation.timer)
 						{
-							timeLast = time;
+							keyRight = keyLeft;
+							timeRight = timeLeft;
 						}
-						if (time <= animation.timer && time > timeLeft)
+						else if (key < keyframe_count)
 						{
-							timeLeft = time;
-							keyLeft = k;
+							keyRight = key;
+							timeRight = keyframe_times[key];
 						}
-						if (time >= animation.timer && time < timeRight)
+					}
+					else
+					{
+						for (int k = 0; k < keyframe_count; ++k)
 						{
-							timeRight = time;
-							keyRight = k;
+							const float time = keyframe_times[k];
+							if (time < timeFirst)
+							{
+								timeFirst = time;
+							}
+							if (time > timeLast)
+							{
+								timeLast = time;
+							}
+							if (time <= animation.timer && time > timeLeft)
+							{
+								timeLeft = time;
+								keyLeft = k;
+							}
+							if (time >= animation.timer && time < timeRight)
+							{
+								timeRight = time;
+								keyRight = k;
+							}
 						}
 					}
 					if (path_data_type != AnimationComponent::AnimationChannel::PathDataType::Event)
@@ -2236,6 +2417,25 @@ namespace wi::scene
 					else
 					{
 						// Path data interpolation:
+						const float* keyframe_data = animationdata->keyframe_data.data();
+						size_t keyframe_data_count = animationdata->keyframe_data.size();
+						size_t keyframe_data_keys = animationdata->keyframe_times.size();
+						if (animationdata->IsCompressed())
+						{
+							// Only the two keyframes that are used are decoded, and the keys are remapped to the decoded copy:
+							if (sampler.mode == AnimationComponent::AnimationSampler::Mode::CUBICSPLINE)
+								continue;
+							const uint32_t components = animationdata->compressed_components;
+							decoded_keyframes.resize(components * 2);
+							animationdata->DecodeKeyframe(keyLeft, decoded_keyframes.data());
+							animationdata->DecodeKeyframe(keyRight, decoded_keyframes.data() + components);
+							keyframe_data_keys = keyLeft == keyRight ? 1 : 2;
+							keyRight = keyLeft == keyRight ? 0 : 1;
+							keyLeft = 0;
+							keyframe_data = decoded_keyframes.data();
+							keyframe_data_count = components * keyframe_data_keys;
+						}
+
 						switch (sampler.mode)
 						{
 						default:
@@ -2248,34 +2448,34 @@ namespace wi::scene
 							default:
 							case AnimationComponent::AnimationChannel::PathDataType::Float:
 							{
-								assert(animationdata->keyframe_data.size() == animationdata->keyframe_times.size());
-								interpolator.f = animationdata->keyframe_data[key];
+								assert(keyframe_data_count == keyframe_data_keys);
+								interpolator.f = keyframe_data[key];
 							}
 							break;
 							case AnimationComponent::AnimationChannel::PathDataType::Float2:
 							{
-								assert(animationdata->keyframe_data.size() == animationdata->keyframe_times.size() * 2);
-								interpolator.f2 = ((const XMFLOAT2*)animationdata->keyframe_data.data())[key];
+								assert(keyframe_data_count == keyframe_data_keys * 2);
+								interpolator.f2 = ((const XMFLOAT2*)keyframe_data)[key];
 							}
 							break;
 							case AnimationComponent::AnimationChannel::PathDataType::Float3:
 							{
-								assert(animationdata->keyframe_data.size() == animationdata->keyframe_times.size() * 3);
-								interpolator.f3 = ((const XMFLOAT3*)animationdata->keyframe_data.data())[key];
+								assert(keyframe_data_count == keyframe_data_keys * 3);
+								interpolator.f3 = ((const XMFLOAT3*)keyframe_data)[key];
 							}
 							break;
 							case AnimationComponent::AnimationChannel::PathDataType::Float4:
 							{
-								assert(animationdata->keyframe_data.size() == animationdata->keyframe_times.size() * 4);
-								interpolator.f4 = ((const XMFLOAT4*)animationdata->keyframe_data.data())[key];
+								assert(keyframe_data_count == keyframe_data_keys * 4);
+								interpolator.f4 = ((const XMFLOAT4*)keyframe_data)[key];
 							}
 							break;
 							case AnimationComponent::AnimationChannel::PathDataType::Weights:
 							{
-								assert(animationdata->keyframe_data.size() == animationdata->keyframe_times.size() * animation.morph_weights_temp.size());
+								assert(keyframe_data_count == keyframe_data_keys * animation.morph_weights_temp.size());
 								for (size_t j = 0; j < animation.morph_weights_temp.size(); ++j)
 								{
-									animation.morph_weights_temp[j] = animationdata->keyframe_data[key * animation.morph_weights_temp.size() + j];
+									animation.morph_weights_temp[j] = keyframe_data[key * animation.morph_weights_temp.size() + j];
 								}
 							}
 							break;
@@ -2301,17 +2501,17 @@ namespace wi::scene
 							default:
 							case AnimationComponent::AnimationChannel::PathDataType::Float:
 							{
-								assert(animationdata->keyframe_data.size() == animationdata->keyframe_times.size());
-								float vLeft = animationdata->keyframe_data[keyLeft];
-								float vRight = animationdata->keyframe_data[keyRight];
+								assert(keyframe_data_count == keyframe_data_keys);
+								float vLeft = keyframe_data[keyLeft];
+								float vRight = keyframe_data[keyRight];
 								float vAnim = wi::math::Lerp(vLeft, vRight, t);
 								interpolator.f = vAnim;
 							}
 							break;
 							case AnimationComponent::AnimationChannel::PathDataType::Float2:
 							{
-								assert(animationdata->keyframe_data.size() == animationdata->keyframe_times.size() * 2);
-								const XMFLOAT2* data = (const XMFLOAT2*)animationdata->keyframe_data.data();
+								assert(keyframe_data_count == keyframe_data_keys * 2);
+								const XMFLOAT2* data = (const XMFLOAT2*)keyframe_data;
 								XMVECTOR vLeft = XMLoadFloat2(&data[keyLeft]);
 								XMVECTOR vRight = XMLoadFloat2(&data[keyRight]);
 								XMVECTOR vAnim = XMVectorLerp(vLeft, vRight, t);
@@ -2320,8 +2520,8 @@ namespace wi::scene
 							break;
 							case AnimationComponent::AnimationChannel::PathDataType::Float3:
 							{
-								assert(animationdata->keyframe_data.size() == animationdata->keyframe_times.size() * 3);
-								const XMFLOAT3* data = (const XMFLOAT3*)animationdata->keyframe_data.data();
+								assert(keyframe_data_count == keyframe_data_keys * 3);
+								const XMFLOAT3* data = (const XMFLOAT3*)keyframe_data;
 								XMVECTOR vLeft = XMLoadFloat3(&data[keyLeft]);
 								XMVECTOR vRight = XMLoadFloat3(&data[keyRight]);
 								XMVECTOR vAnim = XMVectorLerp(vLeft, vRight, t);
@@ -2330,8 +2530,8 @@ namespace wi::scene
 							break;
 							case AnimationComponent::AnimationChannel::PathDataType::Float4:
 							{
-								assert(animationdata->keyframe_data.size() == animationdata->keyframe_times.size() * 4);
-								const XMFLOAT4* data = (const XMFLOAT4*)animationdata->keyframe_data.data();
+								assert(keyframe_data_count == keyframe_data_keys * 4);
+								const XMFLOAT4* data = (const XMFLOAT4*)keyframe_data;
 								XMVECTOR vLeft = XMLoadFloat4(&data[keyLeft]);
 								XMVECTOR vRight = XMLoadFloat4(&data[keyRight]);
 								XMVECTOR vAnim;
@@ -2349,11 +2549,11 @@ namespace wi::scene
 							break;
 							case AnimationComponent::AnimationChannel::PathDataType::Weights:
 							{
-								assert(animationdata->keyframe_data.size() == animationdata->keyframe_times.size() * animation.morph_weights_temp.size());
+								assert(keyframe_data_count == keyframe_data_keys * animation.morph_weights_temp.size());
 								for (size_t j = 0; j < animation.morph_weights_temp.size(); ++j)
 								{
-									float vLeft = animationdata->keyframe_data[keyLeft * animation.morph_weights_temp.size() + j];
-									float vRight = animationdata->keyframe_data[keyRight * animation.morph_weights_temp.size() + j];
+									float vLeft = keyframe_data[keyLeft * animation.morph_weights_temp.size() + j];
+									float vRight = keyframe_data[keyRight * animation.morph_weights_temp.size() + j];
 									float vAnim = wi::math::Lerp(vLeft, vRight, t);
 									animation.morph_weights_temp[j] = vAnim;
 								}
@@ -2815,59 +3015,220 @@ namespace wi::scene
 	}
 	void Scene::RunHierarchyUpdateSystem(wi::jobsystem::context& ctx)
 	{
-		wi::jobsystem::Dispatch(ctx, (uint32_t)hierarchy.GetCount(), small_subtask_groupsize, [&](wi::jobsystem::JobArgs args) {
+		const uint32_t node_count = (uint32_t)hierarchy.GetCount();
 
-			HierarchyComponent& hier = hierarchy[args.jobIndex];
-			Entity entity = hierarchy.GetEntity(args.jobIndex);
+		// If none of the component managers changed structure, the gathered component indices are still valid, only reparenting needs to be checked:
+		const uint64_t structure_versions[] = { hierarchy.GetStructureVersion(), transforms.GetStructureVersion(), layers.GetStructureVersion() };
+		bool gather = node_count != hierarchy_nodes.size() || !std::equal(std::begin(structure_versions), std::end(structure_versions), std::begin(hierarchy_structure_versions));
+		std::copy(std::begin(structure_versions), std::end(structure_versions), std::begin(hierarchy_structure_versions));
+		if (!gather)
+		{
+			std::atomic_bool reparented{ false };
+			wi::jobsystem::Dispatch(ctx, node_count, small_subtask_groupsize, [&](wi::jobsystem::JobArgs args) {
+				if (hierarchy_nodes[args.jobIndex].parentID != hierarchy[args.jobIndex].parentID)
+				{
+					reparented.store(true, std::memory_order_relaxed);
+				}
+			});
+			wi::jobsystem::Wait(ctx);
+			gather = reparented.load();
+		}
+
+		// Gather the component indices of the nodes and detect whether the structure changed since the last update:
+		//	Changing parents, removing nodes or adding/removing transforms of nodes requires rebuilding the depth order and recomputing everything
+		std::atomic_bool structure_changed{ node_count != hierarchy_nodes.size() };
+		hierarchy_nodes.resize(node_count);
+		wi::jobsystem::Dispatch(ctx, gather ? node_count : 0, small_subtask_groupsize, [&](wi::jobsystem::JobArgs args) {
 
-			TransformComponent* transform_child = transforms.GetComponent(entity);
-			XMMATRIX worldmatrix;
-			if (transform_child != nullptr)
+			HierarchyNode& node = hierarchy_nodes[args.jobIndex];
+			const Entity entity = hierarchy.GetEntity(args.jobIndex);
+			const Entity parentID = hierarchy[args.jobIndex].parentID;
+			const size_t parent = hierarchy.GetIndex(parentID);
+			const size_t transform = transforms.GetIndex(entity);
+			size_t root_transform = ~0ull;
+			size_t root_layer = ~0ull;
+			if (parent == ~0ull)
 			{
-				worldmatrix = transform_child->GetLocalMatrix();
+				root_transform = transforms.GetIndex(parentID);
+				root_layer = layers.GetIndex(parentID);
 			}
 
-			LayerComponent* layer_child = layers.GetComponent(entity);
-			if (layer_child != nullptr)
+			if (
+				node.entity != entity ||
+				node.parentID != parentID ||
+				node.parent != (uint32_t)parent ||
+				(node.transform == ~0u) != (transform == ~0ull) ||
+				(node.root_transform == ~0u) != (root_transform == ~0ull)
+				)
 			{
-				layer_child->propagationMask = ~0u; // clear propagation mask to full
+				structure_changed.store(true, std::memory_order_relaxed);
 			}
 
-			if (transform_child == nullptr && layer_child == nullptr)
-				return;
+			node.entity = entity;
+			node.parentID = parentID;
+			node.parent = (uint32_t)parent;
+			node.transform = (uint32_t)transform;
+			node.layer = (uint32_t)layers.GetIndex(entity);
+			node.root_transform = (uint32_t)root_transform;
+			node.root_layer = (uint32_t)root_layer;
+		});
+		wi::jobsystem::Wait(ctx);
 
-			Entity parentID = hier.parentID;
-			while (parentID != INVALID_ENTITY)
+		const bool full_update = structure_changed.load();
+		if (full_update)
+		{
+			// Sort the nodes by depth, so that every parent is updated before its children:
+			wi::allocator::ScratchScope scratch;
+			wi::allocator::scratch_vector<uint32_t> depths(node_count, ~0u);
+			wi::allocator::scratch_vector<uint32_t> stack;
+			uint32_t max_depth = 0;
+			for (uint32_t i = 0; i < node_count; ++i)
 			{
-				TransformComponent* transform_parent = transforms.GetComponent(parentID);
-				if (transform_child != nullptr && transform_parent != nullptr)
+				uint32_t nodeIndex = i;
+				while (nodeIndex != ~0u && depths[nodeIndex] == ~0u)
 				{
-					worldmatrix *= transform_parent->GetLocalMatrix();
+					stack.push_back(nodeIndex);
+					nodeIndex = hierarchy_nodes[nodeIndex].parent;
 				}
+				uint32_t depth = nodeIndex == ~0u ? 0 : depths[nodeIndex] + 1;
+				while (!stack.empty())
+				{
+					depths[stack.back()] = depth++;
+					stack.pop_back();
+				}
+				max_depth = std::max(max_depth, depth);
+			}
+			hierarchy_levels.clear();
+			hierarchy_levels.resize(max_depth + 1);
+			for (uint32_t i = 0; i < node_count; ++i)
+			{
+				hierarchy_levels[depths[i]]++;
+			}
+			uint32_t offset = 0;
+			for (uint32_t& level : hierarchy_levels)
+			{
+				const uint32_t count = level;
+				level = offset;
+				offset += count;
+			}
+			hierarchy_order.resize(node_count);
+			for (uint32_t i = 0; i < node_count; ++i)
+			{
+				hierarchy_order[hierarchy_levels[depths[i]]++] = i;
+			}
+			// After the scatter, every offset points to the end of its level, which is the beginning of the next one:
+			hierarchy_levels.insert(hierarchy_levels.begin(), 0);
+		}
+
+		auto update_node = [&](uint32_t nodeIndex) {
+			HierarchyNode& node = hierarchy_nodes[nodeIndex];
 
-				LayerComponent* layer_parent = layers.GetComponent(parentID);
-				if (layer_child != nullptr && layer_parent != nullptr)
+			const HierarchyNode* parent = nullptr;
+			const TransformComponent* root_transform = nullptr;
+			bool parent_changed = full_update;
+			bool has_parent_world = false;
+			uint32_t parent_mask = ~0u;
+			if (node.parent != ~0u)
+			{
+				parent = &hierarchy_nodes[node.parent];
+				parent_changed |= parent->changed;
+				has_parent_world = parent->has_world;
+				parent_mask = parent->mask;
+			}
+			else
+			{
+				if (node.root_transform != ~0u)
+				{
+					root_transform = &transforms[node.root_transform];
+					parent_changed |= root_transform->IsHierarchyDirty();
+					has_parent_world = true;
+				}
+				if (node.root_layer != ~0u)
 				{
-					layer_child->propagationMask &= layer_parent->layerMask;
+					parent_mask = layers[node.root_layer].layerMask;
 				}
+			}
 
-				const HierarchyComponent* hier_recursive = hierarchy.GetComponent(parentID);
-				if (hier_recursive != nullptr)
+			if (node.transform != ~0u)
+			{
+				TransformComponent& transform = transforms[node.transform];
+				node.changed = parent_changed || transform.IsHierarchyDirty();
+				if (node.changed)
 				{
-					parentID = hier_recursive->parentID;
+					XMMATRIX W = transform.GetLocalMatrix();
+					if (parent != nullptr && has_parent_world)
+					{
+						W = W * XMLoadFloat4x4(&parent->world);
+					}
+					else if (root_transform != nullptr)
+					{
+						W = W * root_transform->GetLocalMatrix();
+					}
+					XMStoreFloat4x4(&node.world, W);
 				}
-				else
+				// The world matrix is written even if it was not recomputed, because other systems can overwrite it temporarily:
+				transform.world = node.world;
+				transform.SetHierarchyDirty(false);
+				node.has_world = true;
+			}
+			else
+			{
+				node.changed = parent_changed;
+				node.has_world = has_parent_world;
+				if (node.changed)
 				{
-					parentID = INVALID_ENTITY;
+					if (parent != nullptr && has_parent_world)
+					{
+						node.world = parent->world;
+					}
+					else if (root_transform != nullptr)
+					{
+						XMStoreFloat4x4(&node.world, root_transform->GetLocalMatrix());
+					}
 				}
 			}
 
-			if (transform_child != nullptr)
+			if (node.layer != ~0u)
+			{
+				LayerComponent& layer = layers[node.layer];
+				layer.propagationMask = parent_mask;
+				node.mask = parent_mask & layer.layerMask;
+			}
+			else
 			{
-				XMStoreFloat4x4(&transform_child->world, worldmatrix);
+				node.mask = parent_mask;
 			}
+		};
 
-		});
+		// Depth levels are processed in order, the nodes within a level are independent:
+		for (size_t level = 0; level + 1 < hierarchy_levels.size(); ++level)
+		{
+			const uint32_t level_offset = hierarchy_levels[level];
+			const uint32_t level_count = hierarchy_levels[level + 1] - level_offset;
+			if (level_count <= small_subtask_groupsize)
+			{
+				for (uint32_t i = 0; i < level_count; ++i)
+				{
+					update_node(hierarchy_order[level_offset + i]);
+				}
+			}
+			else
+			{
+				wi::jobsystem::Dispatch(ctx, level_count, small_subtask_groupsize, [&](wi::jobsystem::JobArgs args) {
+					update_node(hierarchy_order[level_offset + args.jobIndex]);
+				});
+				wi::jobsystem::Wait(ctx);
+			}
+		}
+
+		// Parents outside of the hierarchy can be shared by multiple nodes, so their dirty state is only cleared at the end:
+		for (const HierarchyNode& node : hierarchy_nodes)
+		{
+			if (node.root_transform != ~0u)
+			{
+				transforms[node.root_transform].SetHierarchyDirty(false);
+			}
+		}
 	}
 	void Scene::RunExpressionUpdateSystem(wi::jobsystem::context& ctx)
 	{
@@ -3336,14 +3697,18 @@ namespace wi::scene
 		});
 		wi::jobsystem::Wait(ctx);
 
+		// The temporary copy of transforms is allocated from the thread's scratch arena, it is freed when the scope ends:
+		wi::allocator::ScratchScope scratch;
+		wi::allocator::scratch_vector<TransformComponent> transforms_temp;
 		if (inverse_kinematics.GetCount() > 0 || humanoids.GetCount() > 0)
 		{
-			transforms_temp = transforms.GetComponentArray(); // make copy
+			const auto& transform_array = transforms.GetComponentArray();
+			transforms_temp.assign(transform_array.begin(), transform_array.end()); // make copy
 		}
 
 		std::atomic_bool recompute_hierarchy{ false };
 
-		wi::jobsystem::Dispatch(ctx,(uint32_t)inverse_kinematics.GetCount(),1,[this, &recompute_hierarchy](wi::jobsystem::JobArgs args){
+		wi::jobsystem::Dispatch(ctx,(uint32_t)inverse_kinematics.GetCount(),1,[this, &transforms_temp, &recompute_hierarchy](wi::jobsystem::JobArgs args){
 			const InverseKinematicsComponent& ik = inverse_kinematics[args.jobIndex];
 			if (ik.IsDisabled())
 				return;
@@ -3523,7 +3888,7 @@ namespace wi::scene
 
 		wi::jobsystem::Wait(ctx); // sync needed when there is IK on character arm/leg, and also arm/leg spacing!
 
-		wi::jobsystem::Dispatch(ctx, (uint32_t)humanoids.GetCount(), 1, [this, &recompute_hierarchy](wi::jobsystem::JobArgs args) {
+		wi::jobsystem::Dispatch(ctx, (uint32_t)humanoids.GetCount(), 1, [this, &transforms_temp, &recompute_hierarchy](wi::jobsystem::JobArgs args) {
 			Entity humanoidEntity = humanoids.GetEntity(args.jobIndex);
 			HumanoidComponent& humanoid = humanoids[args.jobIndex];
 
@@ -3834,7 +4199,11 @@ namespace wi::scene
 			// Issue the bvh rebuild on a background thread, the result will be used next frame...
 			collider_bvh_workload.priority = wi::jobsystem::Priority::Low;
 			wi::jobsystem::Execute(collider_bvh_workload, [this](wi::jobsystem::JobArgs args) {
-				collider_bvh_next.Build(aabb_colliders_cpu, collider_count_cpu);
+				collider_bvh_next.Build(aabb_colliders_cpu, collider_count_cpu, wi::BVH::BuildMode::SAH);
+				if (IsColliderBVHWideEnabled())
+				{
+					collider_bvh_next.BuildWide();
+				}
 			});
 		}
 
@@ -3844,13 +4213,7 @@ namespace wi::scene
 	{
 		// disable pointer-overflow UBSAN check because adding an offset to a nullptr is UB.
 		// we only calculate but never use the value in that case, so it should be fine
-		wi::jobsystem::Dispatch(ctx, (uint32_t)armatures.GetCount(), 1, [&](wi::jobsystem::JobArgs args) NO_SANITIZE("pointer-overflow") {
-
-			ArmatureComponent& armature = armatures[args.jobIndex];
-			Entity entity = armatures.GetEntity(args.jobIndex);
-			if (!transforms.Contains(entity))
-				return;
-			const TransformComponent& transform = *transforms.GetComponent(entity);
+		armature_view.Dispatch(ctx, 1, [&](Entity entity, ArmatureComponent& armature, const TransformComponent& transform) NO_SANITIZE("pointer-overflow") {
 
 			// The transform world matrices are in world space, but skinning needs them in armature-local space, 
 			//	so that the skin is reusable for instanced meshes.
@@ -4114,6 +4477,8 @@ namespace wi::scene
 	}
 	void Scene::RunMaterialUpdateSystem(wi::jobsystem::context& ctx)
 	{
+		materialArrayCPU.resize(materials.GetCount());
+
 		wi::jobsystem::Dispatch(ctx, (uint32_t)materials.GetCount(), small_subtask_groupsize, [&](wi::jobsystem::JobArgs args) {
 
 			MaterialComponent& material = materials[args.jobIndex];
@@ -4167,7 +4532,8 @@ namespace wi::scene
 			}
 			material.cached_clampSampler = device->GetDescriptorIndex(wi::renderer::GetSampler(wi::enums::SAMPLER_OBJECTSHADER_CLAMP));
 
-			material.WriteShaderMaterial(materialArrayMapped + args.jobIndex);
+			ShaderMaterial shadermaterial;
+			material.WriteShaderMaterial(&shadermaterial);
 
 			const VideoComponent* video = videos.GetComponent(entity);
 			if (video != nullptr)
@@ -4175,8 +4541,8 @@ namespace wi::scene
 				// Video attachment will overwrite texture slots on shader side:
 				Texture videoTexture = video->videoinstance.GetCurrentFrameTexture();
 				int descriptor = GetDevice()->GetDescriptorIndex(&videoTexture, SubresourceType::SRV, video->videoinstance.GetCurrentFrameTextureSRGBSubresource());
-				material.WriteShaderTextureSlot(materialArrayMapped + args.jobIndex, BASECOLORMAP, descriptor);
-				material.WriteShaderTextureSlot(materialArrayMapped + args.jobIndex, EMISSIVEMAP, descriptor);
+				material.WriteShaderTextureSlot(&shadermaterial, BASECOLORMAP, descriptor);
+				material.WriteShaderTextureSlot(&shadermaterial, EMISSIVEMAP, descriptor);
 			}
 
 			if (material.cameraSource != INVALID_ENTITY)
@@ -4186,11 +4552,22 @@ namespace wi::scene
 				{
 					// Camera attachment will overwrite texture slots on shader side:
 					int descriptor = GetDevice()->GetDescriptorIndex(&camera->render_to_texture.rendertarget_render, SubresourceType::SRV);
-					material.WriteShaderTextureSlot(materialArrayMapped + args.jobIndex, BASECOLORMAP, descriptor);
-					material.WriteShaderTextureSlot(materialArrayMapped + args.jobIndex, EMISSIVEMAP, descriptor);
+					material.WriteShaderTextureSlot(&shadermaterial, BASECOLORMAP, descriptor);
+					material.WriteShaderTextureSlot(&shadermaterial, EMISSIVEMAP, descriptor);
 				}
 			}
 
+			// The GPU material is only written if it changed since the mapped buffer was last written:
+			if (std::memcmp(&shadermaterial, materialArrayCPU.data() + args.jobIndex, sizeof(shadermaterial)) != 0)
+			{
+				materialArrayCPU[args.jobIndex] = shadermaterial;
+				materials.MarkIndexDirty(args.jobIndex);
+			}
+			if (materials.IsChanged(args.jobIndex, materialUploadVersions[cpu_gpu_mapped_resource_index]))
+			{
+				std::memcpy(materialArrayMapped + args.jobIndex, &shadermaterial, sizeof(shadermaterial));
+			}
+
 			if (textureStreamingFeedbackMapped != nullptr)
 			{
 				const uint32_t request_packed = textureStreamingFeedbackMapped[args.jobIndex];
@@ -4366,8 +4743,7 @@ namespace wi::scene
 		matrix_objects.resize(objects.GetCount());
 		matrix_objects_prev.resize(objects.GetCount());
 		occlusion_results_objects.resize(objects.GetCount());
-
-		meshletAllocator.store(0u);
+		instanceArrayCPU.resize(objects.GetCount());
 
 		parallel_bounds.clear();
 		parallel_bounds.resize((size_t)wi::jobsystem::DispatchGroupCount((uint32_t)objects.GetCount(), small_subtask_groupsize));
@@ -4419,6 +4795,8 @@ namespace wi::scene
 			object.fadeDistance = object.draw_distance;
 			object.mesh_blend_required = false;
 
+			ShaderMeshInstance inst = shader_mesh_instance_null;
+
 			if (object.meshID != INVALID_ENTITY && meshes.Contains(object.meshID) && transforms.Contains(entity))
 			{
 				// These will only be valid for a single frame:
@@ -4556,7 +4934,6 @@ namespace wi::scene
 				//XMStoreFloat4x4(&transformNormal, worldMatrixInverseTranspose);
 
 				// Create GPU instance data:
-				ShaderMeshInstance inst = shader_mesh_instance_null;
 				XMFLOAT4X4 worldMatrixPrev = matrix_objects[args.jobIndex];
 				matrix_objects_prev[args.jobIndex] = worldMatrixPrev;
 				XMStoreFloat4x4(matrix_objects.data() + args.jobIndex, W);
@@ -4589,7 +4966,7 @@ namespace wi::scene
 				inst.baseGeometryCount = (uint)mesh.subsets.size();
 				inst.geometryOffset = inst.baseGeometryOffset + first_subset;
 				inst.geometryCount = last_subset - first_subset;
-				inst.meshletOffset = meshletAllocator.fetch_add(mesh.meshletCount, std::memory_order_relaxed);
+				inst.meshletOffset = meshlet_offsets_objects[args.jobIndex];
 				inst.fadeDistance = object.fadeDistance;
 				inst.center = object.center;
 				inst.radius = object.radius;
@@ -4599,8 +4976,6 @@ namespace wi::scene
 				inst.SetUserStencilRef(object.userStencilRef);
 				inst.rimHighlight = wi::math::pack_half4(XMFLOAT4(object.rimHighlightColor.x * object.rimHighlightColor.w, object.rimHighlightColor.y * object.rimHighlightColor.w, object.rimHighlightColor.z * object.rimHighlightColor.w, object.rimHighlightFalloff));
 
-				std::memcpy(instanceArrayMapped + args.jobIndex, &inst, sizeof(inst)); // memcpy whole structure into mapped pointer to avoid read from uncached memory
-
 				if (TLAS_instancesMapped != nullptr)
 				{
 					// TLAS instance data:
@@ -4737,6 +5112,17 @@ namespace wi::scene
 				}
 			}
 
+			// The GPU instance is only written if it changed since the mapped buffer was last written:
+			if (std::memcmp(&inst, instanceArrayCPU.data() + args.jobIndex, sizeof(inst)) != 0)
+			{
+				instanceArrayCPU[args.jobIndex] = inst;
+				objects.MarkIndexDirty(args.jobIndex);
+			}
+			if (objects.IsChanged(args.jobIndex, instanceUploadVersions[cpu_gpu_mapped_resource_index]))
+			{
+				std::memcpy(instanceArrayMapped + args.jobIndex, &inst, sizeof(inst)); // memcpy whole structure into mapped pointer to avoid read from uncached memory
+			}
+
 		});
 	}
 	void Scene::RunCameraUpdateSystem(wi::jobsystem::context& ctx)
@@ -4757,13 +5143,11 @@ namespace wi::scene
 	{
 		aabb_decals.resize(decals.GetCount());
 
-		for (size_t i = 0; i < decals.GetCount(); ++i)
+		decal_view.Update();
+		for (size_t i = 0; i < decal_view.GetCount(); ++i)
 		{
-			DecalComponent& decal = decals[i];
-			Entity entity = decals.GetEntity(i);
-			if (!transforms.Contains(entity))
-				continue;
-			const TransformComponent& transform = *transforms.GetComponent(entity);
+			DecalComponent& decal = decal_view.Get<0>(i);
+			const TransformComponent& transform = decal_view.Get<1>(i);
 			decal.world = transform.world;
 
 			XMMATRIX W = XMLoadFloat4x4(&decal.world);
@@ -4779,11 +5163,11 @@ namespace wi::scene
 			XMStoreFloat3(&scale, S);
 			decal.range = std::max(scale.x, std::max(scale.y, scale.z)) * 2;
 
-			AABB& aabb = aabb_decals[i];
+			AABB& aabb = aabb_decals[decal_view.GetIndex<0>(i)];
 			aabb.createFromHalfWidth(XMFLOAT3(0, 0, 0), XMFLOAT3(1, 1, 1));
 			aabb = aabb.transform(transform.world);
 
-			const LayerComponent* layer = layers.GetComponent(entity);
+			const LayerComponent* layer = decal_view.Get<3>(i);
 			if (layer == nullptr)
 			{
 				aabb.layerMask = ~0;
@@ -4793,7 +5177,7 @@ namespace wi::scene
 				aabb.layerMask = layer->GetLayerMask();
 			}
 
-			const MaterialComponent& material = *materials.GetComponent(entity);
+			const MaterialComponent& material = decal_view.Get<2>(i);
 			decal.color = material.baseColor;
 			decal.emissive = material.GetEmissiveStrength();
 			decal.texture = material.textures[MaterialComponent::BASECOLORMAP].resource;
@@ -4812,13 +5196,11 @@ namespace wi::scene
 		if (dt == 0)
 			return;
 
-		for (size_t probeIndex = 0; probeIndex < probes.GetCount(); ++probeIndex)
+		probe_view.Update();
+		for (size_t i = 0; i < probe_view.GetCount(); ++i)
 		{
-			EnvironmentProbeComponent& probe = probes[probeIndex];
-			Entity entity = probes.GetEntity(probeIndex);
-			if (!transforms.Contains(entity))
-				continue;
-			const TransformComponent& transform = *transforms.GetComponent(entity);
+			EnvironmentProbeComponent& probe = probe_view.Get<0>(i);
+			const TransformComponent& transform = probe_view.Get<1>(i);
 
 			probe.position = transform.GetPosition();
 
@@ -4831,11 +5213,11 @@ namespace wi::scene
 			XMStoreFloat3(&scale, S);
 			probe.range = std::max(scale.x, std::max(scale.y, scale.z)) * 2;
 
-			AABB& aabb = aabb_probes[probeIndex];
+			AABB& aabb = aabb_probes[probe_view.GetIndex<0>(i)];
 			aabb.createFromHalfWidth(XMFLOAT3(0, 0, 0), XMFLOAT3(1, 1, 1));
 			aabb = aabb.transform(transform.world);
 
-			const LayerComponent* layer = layers.GetComponent(entity);
+			const LayerComponent* layer = probe_view.Get<2>(i);
 			if (layer == nullptr)
 			{
 				aabb.layerMask = ~0;
@@ -4863,13 +5245,7 @@ namespace wi::scene
 	}
 	void Scene::RunForceUpdateSystem(wi::jobsystem::context& ctx)
 	{
-		wi::jobsystem::Dispatch(ctx, (uint32_t)forces.GetCount(), small_subtask_groupsize, [&](wi::jobsystem::JobArgs args) {
-
-			ForceFieldComponent& force = forces[args.jobIndex];
-			Entity entity = forces.GetEntity(args.jobIndex);
-			if (!transforms.Contains(entity))
-				return;
-			const TransformComponent& transform = *transforms.GetComponent(entity);
+		force_view.Dispatch(ctx, small_subtask_groupsize, [&](Entity entity, ForceFieldComponent& force, const TransformComponent& transform) {
 
 			XMMATRIX W = XMLoadFloat4x4(&transform.world);
 			XMVECTOR S, R, T;
@@ -4884,18 +5260,17 @@ namespace wi::scene
 	{
 		aabb_lights.resize(lights.GetCount());
 
-		wi::jobsystem::Dispatch(ctx, (uint32_t)lights.GetCount(), small_subtask_groupsize, [&](wi::jobsystem::JobArgs args) {
+		light_view.Update();
+		wi::jobsystem::Dispatch(ctx, (uint32_t)light_view.GetCount(), small_subtask_groupsize, [&](wi::jobsystem::JobArgs args) {
 
-			LightComponent& light = lights[args.jobIndex];
-			Entity entity = lights.GetEntity(args.jobIndex);
-			if (!transforms.Contains(entity))
-				return;
-			const TransformComponent& transform = *transforms.GetComponent(entity);
-			AABB& aabb = aabb_lights[args.jobIndex];
+			const size_t lightIndex = light_view.GetIndex<0>(args.jobIndex);
+			LightComponent& light = light_view.Get<0>(args.jobIndex);
+			const TransformComponent& transform = light_view.Get<1>(args.jobIndex);
+			AABB& aabb = aabb_lights[lightIndex];
 
 			light.occlusionquery = -1;
 
-			const LayerComponent* layer = layers.GetComponent(entity);
+			const LayerComponent* layer = light_view.Get<2>(args.jobIndex);
 			if (layer == nullptr)
 			{
 				aabb.layerMask = ~0;
@@ -4921,9 +5296,9 @@ namespace wi::scene
 				XMStoreFloat3(&light.direction, XMVector3Normalize(XMVector3TransformNormal(XMVectorSet(0, 1, 0, 0), W)));
 				aabb.createFromHalfWidth(XMFLOAT3(0, 0, 0), XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX));
 				locker.lock();
-				if (args.jobIndex < weather.most_important_light_index)
+				if (lightIndex < weather.most_important_light_index)
 				{
-					weather.most_important_light_index = args.jobIndex;
+					weather.most_important_light_index = (uint32_t)lightIndex;
 					weather.sunColor = light.color;
 					weather.sunColor.x *= light.intensity;
 					weather.sunColor.y *= light.intensity;
@@ -4954,7 +5329,7 @@ namespace wi::scene
 			if (light.type == LightComponent::SPOT || light.type == LightComponent::POINT || light.type == LightComponent::RECTANGLE)
 			{
 				// Material can be used as mask texture for spot, rectangle and point lights:
-				const MaterialComponent* material = materials.GetComponent(entity);
+				const MaterialComponent* material = light_view.Get<3>(args.jobIndex);
 				if (material != nullptr && material->textures[MaterialComponent::BASECOLORMAP].resource.IsValid())
 				{
 					const Texture& tex = material->textures[MaterialComponent::BASECOLORMAP].resource.GetTexture();
@@ -4972,7 +5347,7 @@ namespace wi::scene
 			if (light.type == LightComponent::SPOT || light.type == LightComponent::RECTANGLE)
 			{
 				// Video attachment will overwrite texture mask for spotlight and rectangle light:
-				const VideoComponent* video = videos.GetComponent(entity);
+				const VideoComponent* video = light_view.Get<4>(args.jobIndex);
 				if (video != nullptr)
 				{
 					Texture videoTexture = video->videoinstance.GetCurrentFrameTexture();
@@ -5401,9 +5776,7 @@ namespace wi::scene
 		instance3D.listenerUp = camera.Up;
 		instance3D.listenerFront = camera.At;
 
-		for (size_t i = 0; i < sounds.GetCount(); ++i)
-		{
-			SoundComponent& sound = sounds[i];
+		sound_view.ForEach([&](Entity entity, SoundComponent& sound, const TransformComponent* transform) {
 
 			if (!sound.soundinstance.IsValid() && sound.soundResource.IsValid())
 			{
@@ -5413,8 +5786,6 @@ namespace wi::scene
 
 			if (!sound.IsDisable3D())
 			{
-				Entity entity = sounds.GetEntity(i);
-				const TransformComponent* transform = transforms.GetComponent(entity);
 				if (transform != nullptr)
 				{
 					instance3D.emitterPos = transform->GetPosition();
@@ -5432,7 +5803,7 @@ namespace wi::scene
 				wi::audio::Stop(&sound.soundinstance);
 			}
 			wi::audio::SetVolume(sound.volume, &sound.soundinstance);
-		}
+		});
 	}
 	void Scene::RunVideoUpdateSystem(wi::jobsystem::context& ctx)
 	{
@@ -5483,6 +5854,23 @@ namespace wi::scene
 		if (dt == 0)
 			return; // not allowed to be run when dt == 0 as it could be on separate thread!
 		auto range = wi::profiler::BeginRangeCPU("Script Components");
+
+		uint32_t compile_count = 0;
+		auto compile = [&](ScriptComponent& script) {
+			if (script.resource.IsValid() && (script.script.empty() || script.script_hash != script.resource.GetScriptHash()))
+			{
+				script.script.clear();
+				script.script_hash = script.resource.GetScriptHash();
+				script.script_pid = wi::lua::GeneratePID();
+				std::string str = script.resource.GetScript();
+				// The PID and the entity are given as arguments when running, so all instances of the script share the same bytecode from the bytecode cache:
+				wi::lua::AttachScriptParameters(str, script.filename, wi::lua::SCRIPT_PID_ARGUMENT, "local script_entity = select(2, ...); local function GetEntity() return script_entity; end;", "");
+				wi::lua::CompileText(str, script.script);
+				compile_count++;
+			}
+		};
+
+		bool any_independent = false;
 		for (size_t i = 0; i < scripts.GetCount(); ++i)
 		{
 			ScriptComponent& script = scripts[i];
@@ -5490,17 +5878,15 @@ namespace wi::scene
 
 			if (script.IsPlaying())
 			{
-				if (script.resource.IsValid() && (script.script.empty() || script.script_hash != script.resource.GetScriptHash()))
+				if (script.IsIndependent())
 				{
-					script.script.clear();
-					script.script_hash = script.resource.GetScriptHash();
-					std::string str = script.resource.GetScript();
-					wi::lua::AttachScriptParameters(str, script.filename, wi::lua::GeneratePID(), "local function GetEntity() return " + std::to_string(entity) + "; end;", "");
-					wi::lua::CompileText(str, script.script);
+					any_independent = true;
+					continue;
 				}
+				compile(script);
 				if (!script.script.empty())
 				{
-					wi::lua::RunBinaryData(script.script.data(), script.script.size(), script.filename.c_str());
+					wi::lua::RunBinaryData(script.script.data(), script.script.size(), script.filename.c_str(), script.script_pid, { (long long)entity });
 				}
 
 				if (script.IsPlayingOnlyOnce())
@@ -5509,13 +5895,62 @@ namespace wi::scene
 				}
 			}
 		}
+
+		if (any_independent)
+		{
+			// Independent scripts are distributed to the worker lua states by entity, so a script keeps its globals in the same state across frames.
+			//	They are gathered after the serial scripts, because those could have added or removed script components:
+			const uint32_t worker_count = wi::lua::GetWorkerStateCount();
+			script_worker_buckets.resize(worker_count);
+			for (auto& bucket : script_worker_buckets)
+			{
+				bucket.clear();
+			}
+			for (size_t i = 0; i < scripts.GetCount(); ++i)
+			{
+				ScriptComponent& script = scripts[i];
+				if (!script.IsPlaying() || !script.IsIndependent())
+					continue;
+				Entity entity = scripts.GetEntity(i);
+				compile(script); // compilation uses the main lua state, so it can't be done in parallel
+				if (!script.script.empty())
+				{
+					script_worker_buckets[entity % worker_count].push_back(std::make_pair(&script, entity));
+				}
+				if (script.IsPlayingOnlyOnce())
+				{
+					script.Stop();
+				}
+			}
+
+			wi::jobsystem::context script_ctx;
+			wi::jobsystem::Dispatch(script_ctx, worker_count, 1, [this](wi::jobsystem::JobArgs args) {
+				const auto& bucket = script_worker_buckets[args.jobIndex];
+				if (bucket.empty())
+					return;
+				wi::lua::BeginWorkerState(args.jobIndex);
+				for (auto& [script, entity] : bucket)
+				{
+					wi::lua::RunBinaryData(script->script.data(), script->script.size(), script->filename.c_str(), script->script_pid, { (long long)entity });
+				}
+				wi::lua::EndWorkerState();
+			});
+			wi::jobsystem::Wait(script_ctx);
+
+			// The scene changes that independent scripts requested are applied in a deterministic order:
+			wi::lua::FlushDeferredCommands();
+		}
+
+		if (compile_count > 0)
+		{
+			wilog("Script Components: compiled %u scripts [bytecode cache: %u hits, %u misses]", compile_count, wi::lua::GetBytecodeCacheHitCount(), wi::lua::GetBytecodeCacheMissCount());
+		}
+
 		wi::profiler::EndRange(range);
 	}
 	void Scene::RunSpriteUpdateSystem(wi::jobsystem::context& ctx)
 	{
-		wi::jobsystem::Dispatch(ctx, (uint32_t)sprites.GetCount(), small_subtask_groupsize, [&](wi::jobsystem::JobArgs args) {
-			Entity entity = sprites.GetEntity(args.jobIndex);
-			Sprite& sprite = sprites[args.jobIndex];
+		sprite_view.Dispatch(ctx, small_subtask_groupsize, [&](Entity entity, Sprite& sprite, const VideoComponent* videocomponent) {
 			if (sprite.params.isExtractNormalMapEnabled())
 			{
 				sprite.params.image_subresource = -1;
@@ -5529,7 +5964,6 @@ namespace wi::scene
 				sprite.params.mask_subresource = sprite.maskResource.GetTextureSRGBSubresource();
 			}
 
-			const VideoComponent* videocomponent = videos.GetComponent(entity);
 			if (videocomponent != nullptr && videocomponent->videoinstance.IsValid())
 			{
 				Texture videoTexture = videocomponent->videoinstance.GetCurrentFrameTexture();
@@ -5546,10 +5980,10 @@ namespace wi::scene
 	void Scene::RunFontUpdateSystem(wi::jobsystem::context& ctx)
 	{
 		aabb_fonts.resize(fonts.GetCount());
-		wi::jobsystem::Dispatch(ctx, (uint32_t)fonts.GetCount(), small_subtask_groupsize, [&](wi::jobsystem::JobArgs args) {
-			SpriteFont& font = fonts[args.jobIndex];
-			Entity entity = fonts.GetEntity(args.jobIndex);
-			const SoundComponent* sound = sounds.GetComponent(entity);
+		font_view.Update();
+		wi::jobsystem::Dispatch(ctx, (uint32_t)font_view.GetCount(), small_subtask_groupsize, [&](wi::jobsystem::JobArgs args) {
+			SpriteFont& font = font_view.Get<0>(args.jobIndex);
+			const SoundComponent* sound = font_view.Get<1>(args.jobIndex);
 			if (sound != nullptr && sound->soundResource.IsValid())
 			{
 				font.anim.typewriter.sound = sound->soundResource.GetSound();
@@ -5561,7 +5995,7 @@ namespace wi::scene
 				font.anim.typewriter.soundinstance = {};
 			}
 			font.Update(dt);
-			aabb_fonts[args.jobIndex] = font.GetAABB();
+			aabb_fonts[font_view.GetIndex<0>(args.jobIndex)] = font.GetAABB();
 		});
 	}
 	void Scene::RunCharacterUpdateSystem(wi::jobsystem::context& ctx)
@@ -6350,6 +6784,10 @@ namespace wi::scene
 	}
 
 	Scene::RayIntersectionResult Scene::Intersects(const Ray& ray, uint32_t filterMask, uint32_t layerMask, uint32_t lod) const
+	{
+		return IntersectsRay(ray, filterMask, layerMask, lod, nullptr);
+	}
+	Scene::RayIntersectionResult Scene::IntersectsRay(const Ray& ray, uint32_t filterMask, uint32_t layerMask, uint32_t lod, const RayBatchShared* shared) const
 	{
 		RayIntersectionResult result;
 
@@ -6406,9 +6844,10 @@ namespace wi::scene
 
 		if (filterMask & FILTER_OBJECT_ALL)
 		{
-			const size_t objectCount = std::min(objects.GetCount(), aabb_objects.size());
-			for (size_t objectIndex = 0; objectIndex < objectCount; ++objectIndex)
+			const size_t objectCount = shared != nullptr ? shared->object_candidate_count : std::min(objects.GetCount(), aabb_objects.size());
+			for (size_t candidateIndex = 0; candidateIndex < objectCount; ++candidateIndex)
 			{
+				const size_t objectIndex = shared != nullptr ? shared->object_candidates[candidateIndex] : candidateIndex;
 				const AABB& aabb = aabb_objects[objectIndex];
 				if ((layerMask & aabb.layerMask) == 0)
 					continue;
@@ -6429,7 +6868,7 @@ namespace wi::scene
 				const SoftBodyPhysicsComponent* softbody = softbodies.GetComponent(object.meshID);
 				const XMMATRIX objectMat = XMLoadFloat4x4(&matrix_objects[objectIndex]);
 				const XMMATRIX objectMatPrev = XMLoadFloat4x4(&matrix_objects_prev[objectIndex]);
-				const XMMATRIX objectMat_Inverse = XMMatrixInverse(nullptr, objectMat);
+				const XMMATRIX objectMat_Inverse = shared != nullptr ? XMLoadFloat4x4(&shared->object_inverse_matrices[objectIndex]) : XMMatrixInverse(nullptr, objectMat);
 				const XMVECTOR rayOrigin_local = XMVector3Transform(rayOrigin, objectMat_Inverse);
 				const XMVECTOR rayDirection_local = XMVector3Normalize(XMVector3TransformNormal(rayDirection, objectMat_Inverse));
 				const ArmatureComponent* armature = mesh->IsSkinned() ? armatures.GetComponent(mesh->armatureID) : nullptr;
@@ -6535,7 +6974,11 @@ namespace wi::scene
 				{
 					Ray ray_local = Ray(rayOrigin_local, rayDirection_local);
 
-					mesh->bvh.Intersects(ray_local, 0, [&](uint32_t index) {
+					// Subtrees behind the closest hit can be skipped, but only if the BVH matches the vertices (not deformed):
+					const bool closest_culling = softbody == nullptr && armature == nullptr;
+					const float local_distance_scale = 1.0f / XMVectorGetX(XMVector3Length(XMVector3TransformNormal(rayDirection_local, objectMat)));
+
+					mesh->bvh.IntersectsClosest(ray_local, [&](uint32_t index, float& TMax) {
 						const AABB& leaf = mesh->bvh_leaf_aabbs[index];
 						const uint32_t triangleIndex = leaf.layerMask;
 						const uint32_t subsetIndex = leaf.userdata;
@@ -6544,6 +6987,10 @@ namespace wi::scene
 							return;
 						const uint32_t indexOffset = subset.indexOffset;
 						intersect_triangle(subsetIndex, indexOffset, triangleIndex);
+						if (closest_culling)
+						{
+							TMax = std::min(TMax, result.distance * local_distance_scale);
+						}
 					});
 				}
 				else
@@ -6612,6 +7059,133 @@ namespace wi::scene
 
 		return result;
 	}
+	void Scene::IntersectsBatch(const Ray* rays, RayIntersectionResult* results, uint32_t count, uint32_t filterMask, uint32_t layerMask, uint32_t lod) const
+	{
+		if (count == 0)
+			return;
+
+		struct Batch
+		{
+			const Ray* rays;
+			RayIntersectionResult* results;
+			uint32_t count;
+			uint32_t filterMask;
+			uint32_t layerMask;
+			uint32_t lod;
+			uint32_t objectCount;
+			wi::allocator::scratch_vector<uint64_t> sorted_rays; // sort key in upper 32 bits, ray index in lower 32 bits
+			wi::allocator::scratch_vector<XMFLOAT4X4> object_inverse_matrices;
+		};
+		wi::allocator::ScratchScope scratch;
+		Batch batch;
+		batch.rays = rays;
+		batch.results = results;
+		batch.count = count;
+		batch.filterMask = filterMask;
+		batch.layerMask = layerMask;
+		batch.lod = lod;
+		batch.objectCount = (filterMask & FILTER_OBJECT_ALL) ? (uint32_t)std::min(objects.GetCount(), aabb_objects.size()) : 0;
+
+		wi::jobsystem::context ctx;
+
+		// The object inverse matrices are computed once instead of for every ray:
+		batch.object_inverse_matrices.resize(batch.objectCount);
+		wi::jobsystem::Dispatch(ctx, batch.objectCount, 256, [this, &batch](wi::jobsystem::JobArgs args) {
+			XMStoreFloat4x4(&batch.object_inverse_matrices[args.jobIndex], XMMatrixInverse(nullptr, XMLoadFloat4x4(&matrix_objects[args.jobIndex])));
+		});
+
+		// Sort the rays for coherence: first by direction octant, then by origin along a Morton curve inside the bounds of all origins
+		AABB origin_bounds;
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			origin_bounds.AddPoint(rays[i].origin);
+		}
+		const XMVECTOR bounds_min = XMLoadFloat3(&origin_bounds._min);
+		const XMVECTOR bounds_scale = XMVectorDivide(XMVectorReplicate(511.0f), XMVectorMax(XMVectorSubtract(XMLoadFloat3(&origin_bounds._max), bounds_min), XMVectorReplicate(0.0001f)));
+		auto expand_bits = [](uint32_t v) {
+			v = (v * 0x00010001u) & 0xFF0000FFu;
+			v = (v * 0x00000101u) & 0x0F00F00Fu;
+			v = (v * 0x00000011u) & 0xC30C30C3u;
+			v = (v * 0x00000005u) & 0x49249249u;
+			return v;
+		};
+		batch.sorted_rays.resize(count);
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			const Ray& ray = rays[i];
+			XMFLOAT3 cell;
+			XMStoreFloat3(&cell, XMVectorMultiply(XMVectorSubtract(XMLoadFloat3(&ray.origin), bounds_min), bounds_scale));
+			const uint32_t morton = expand_bits(uint32_t(cell.x)) | (expand_bits(uint32_t(cell.y)) << 1) | (expand_bits(uint32_t(cell.z)) << 2);
+			const uint32_t octant = (ray.direction.x < 0 ? 1 : 0) | (ray.direction.y < 0 ? 2 : 0) | (ray.direction.z < 0 ? 4 : 0);
+			// 3 bits octant + 27 bits morton (9 bits per axis) fit in the upper 32 bits of the key:
+			batch.sorted_rays[i] = (uint64_t((octant << 27) | morton) << 32ull) | uint64_t(i);
+		}
+		std::sort(batch.sorted_rays.begin(), batch.sorted_rays.end());
+
+		wi::jobsystem::Wait(ctx);
+
+		// Coherent groups of rays are processed together, they only need to test the objects that overlap the group's bounds:
+		static constexpr uint32_t packet_size = 64;
+		const uint32_t packet_count = (count + packet_size - 1) / packet_size;
+		wi::jobsystem::Dispatch(ctx, packet_count, 1, [this, &batch](wi::jobsystem::JobArgs args) {
+			const uint32_t first = args.jobIndex * packet_size;
+			const uint32_t last = std::min(first + packet_size, batch.count);
+
+			// The group bounds can only be computed if all rays are finite and their direction is normalized (so that TMax is a distance):
+			AABB packet_bounds;
+			bool packet_finite = true;
+			for (uint32_t i = first; i < last && packet_finite; ++i)
+			{
+				const Ray& ray = batch.rays[uint32_t(batch.sorted_rays[i])];
+				const XMVECTOR origin = XMLoadFloat3(&ray.origin);
+				const XMVECTOR direction = XMLoadFloat3(&ray.direction);
+				const float length = XMVectorGetX(XMVector3Length(direction));
+				packet_finite = ray.TMax < FLT_MAX && std::abs(length - 1) < 0.001f;
+				packet_bounds.AddPoint(origin);
+				packet_bounds.AddPoint(XMVectorAdd(origin, XMVectorScale(direction, ray.TMax * 1.001f)));
+			}
+
+			static thread_local wi::vector<uint32_t> candidates;
+			candidates.clear();
+			auto add_candidate = [&](uint32_t objectIndex) {
+				const AABB& aabb = aabb_objects[objectIndex];
+				if ((batch.layerMask & aabb.layerMask) == 0)
+					return;
+				if (packet_finite && !packet_bounds.intersects(aabb))
+					return;
+				const ObjectComponent& object = objects[objectIndex];
+				if (object.meshID == INVALID_ENTITY)
+					return;
+				if ((batch.filterMask & object.GetFilterMask()) == 0)
+					return;
+				candidates.push_back(objectIndex);
+			};
+			if (packet_finite && IsObjectBVHValid() && object_bvh.leaf_indices.size() == batch.objectCount)
+			{
+				object_bvh.IntersectsLeaves(packet_bounds, add_candidate);
+				std::sort(candidates.begin(), candidates.end()); // keep the same order as the linear search for equal distance hits
+			}
+			else
+			{
+				for (uint32_t objectIndex = 0; objectIndex < batch.objectCount; ++objectIndex)
+				{
+					add_candidate(objectIndex);
+				}
+			}
+
+			RayBatchShared shared;
+			shared.object_candidates = candidates.data();
+			shared.object_candidate_count = (uint32_t)candidates.size();
+			shared.object_inverse_matrices = batch.object_inverse_matrices.data();
+
+			for (uint32_t i = first; i < last; ++i)
+			{
+				const uint32_t rayIndex = uint32_t(batch.sorted_rays[i]);
+				batch.results[rayIndex] = IntersectsRay(batch.rays[rayIndex], batch.filterMask, batch.layerMask, batch.lod, &shared);
+			}
+		});
+		wi::jobsystem::Wait(ctx);
+	}
 	void Scene::IntersectsAll(wi::vector<RayIntersectionResult>& results, const Ray& ray, uint32_t filterMask, uint32_t layerMask, uint32_t lod) const
 	{
 		const XMVECTOR rayOrigin = XMLoadFloat3(&ray.origin);
@@ -9108,6 +9682,7 @@ namespace wi::scene
 
 								auto& animation_data = src_scene->animation_datas.Contains(sampler.data) ? *src_scene->animation_datas.GetComponent(sampler.data) : sampler.backwards_compatibility_data;
 								retarget_animation_data = animation_data;
+								retarget_animation_data.Decompress(); // baking works on the raw keyframe data
 
 								XMVECTOR S, R, T; // matrix decompose destinations
 
@@ -9175,6 +9750,97 @@ namespace wi::scene
 		return INVALID_ENTITY;
 	}
 
+	uint32_t Scene::CompressAnimations(float max_error)
+	{
+		// Gather the value layout of every animation data from the channels that reference it:
+		struct DataLayout
+		{
+			uint32_t components = 0;
+			bool rotation = false;
+			bool interpolate = false;
+			bool valid = true;
+		};
+		wi::unordered_map<Entity, DataLayout> layouts;
+		for (size_t i = 0; i < animations.GetCount(); ++i)
+		{
+			const AnimationComponent& animation = animations[i];
+			for (const AnimationComponent::AnimationChannel& channel : animation.channels)
+			{
+				if (channel.samplerIndex < 0 || channel.samplerIndex >= (int)animation.samplers.size())
+					continue;
+				const AnimationComponent::AnimationSampler& sampler = animation.samplers[channel.samplerIndex];
+				if (sampler.scene != nullptr || !animation_datas.Contains(sampler.data))
+					continue;
+
+				DataLayout layout;
+				switch (channel.GetPathDataType())
+				{
+				case AnimationComponent::AnimationChannel::PathDataType::Float:
+					layout.components = 1;
+					break;
+				case AnimationComponent::AnimationChannel::PathDataType::Float2:
+					layout.components = 2;
+					break;
+				case AnimationComponent::AnimationChannel::PathDataType::Float3:
+					layout.components = 3;
+					break;
+				case AnimationComponent::AnimationChannel::PathDataType::Float4:
+					layout.components = 4;
+					break;
+				case AnimationComponent::AnimationChannel::PathDataType::Weights:
+				{
+					const MeshComponent* mesh = meshes.GetComponent(channel.target);
+					if (mesh == nullptr)
+					{
+						const ObjectComponent* object = objects.GetComponent(channel.target);
+						if (object != nullptr)
+						{
+							mesh = meshes.GetComponent(object->meshID);
+						}
+					}
+					layout.components = mesh == nullptr ? 0 : (uint32_t)mesh->morph_targets.size();
+				}
+				break;
+				default:
+					break;
+				}
+				layout.rotation = channel.path == AnimationComponent::AnimationChannel::Path::ROTATION;
+				layout.interpolate = sampler.mode == AnimationComponent::AnimationSampler::Mode::LINEAR;
+				layout.valid = layout.components > 0 && sampler.mode != AnimationComponent::AnimationSampler::Mode::CUBICSPLINE;
+
+				// An animation data that is shared by channels with different layouts can't be compressed:
+				auto it = layouts.find(sampler.data);
+				if (it == layouts.end())
+				{
+					layouts[sampler.data] = layout;
+				}
+				else if (it->second.components != layout.components || it->second.rotation != layout.rotation || it->second.interpolate != layout.interpolate)
+				{
+					it->second.valid = false;
+				}
+				else
+				{
+					it->second.valid &= layout.valid;
+				}
+			}
+		}
+
+		uint32_t count = 0;
+		for (auto& it : layouts)
+		{
+			if (!it.second.valid)
+				continue;
+			AnimationDataComponent* animation_data = animation_datas.GetComponent(it.first);
+			if (animation_data == nullptr || animation_data->IsCompressed())
+				continue;
+			if (animation_data->Compress(it.second.components, it.second.rotation, it.second.interpolate, max_error))
+			{
+				count++;
+			}
+		}
+		return count;
+	}
+
 	XMMATRIX Scene::GetRestPose(wi::ecs::Entity entity) const
 	{
 		if (entity != INVALID_ENTITY)
@@ -9204,6 +9870,36 @@ namespace wi::scene
 		return XMMatrixIdentity();
 	}
 
+	void Scene::UpdateObjectBVH()
+	{
+		if (!IsObjectBVHEnabled())
+		{
+			if (object_bvh.IsValid())
+			{
+				object_bvh = {};
+			}
+			return;
+		}
+
+		auto range = wi::profiler::BeginRangeCPU("Object BVH");
+		const uint32_t object_count = (uint32_t)aabb_objects.size();
+		bool rebuild = !IsObjectBVHValid();
+		if (!rebuild)
+		{
+			object_bvh.Update(aabb_objects.data(), object_count);
+
+			// Refitting keeps the tree structure, which gets worse when objects move far from where they were at build time:
+			const float cost = object_bvh.GetCost();
+			rebuild = cost > object_bvh_build_cost * 2;
+		}
+		if (rebuild)
+		{
+			object_bvh.Build(aabb_objects.data(), object_count);
+			object_bvh_build_cost = object_bvh.GetCost();
+		}
+		wi::profiler::EndRange(range);
+	}
+
 	void Scene::StartBuildTopDownHierarchy()
 	{
 		WaitBuildTopDownHierarchy();
@@ -44,7 +44,7 @@ namespace wi::scene
 		wi::ecs::ComponentManager<ForceFieldComponent>& forces = componentLibrary.Register<ForceFieldComponent>("wi::scene::Scene::forces", 1); // version = 1
 		wi::ecs::ComponentManager<DecalComponent>& decals = componentLibrary.Register<DecalComponent>("wi::scene::Scene::decals", 1); // version = 1
 		wi::ecs::ComponentManager<AnimationComponent>& animations = componentLibrary.Register<AnimationComponent>("wi::scene::Scene::animations", 2); // version = 2
-		wi::ecs::ComponentManager<AnimationDataComponent>& animation_datas = componentLibrary.Register<AnimationDataComponent>("wi::scene::Scene::animation_datas");
+		wi::ecs::ComponentManager<AnimationDataComponent>& animation_datas = componentLibrary.Register<AnimationDataComponent>("wi::scene::Scene::animation_datas", 1); // version = 1
 		wi::ecs::ComponentManager<EmittedParticleSystem>& emitters = componentLibrary.Register<EmittedParticleSystem>("wi::scene::Scene::emitters", 2); // version = 2
 		wi::ecs::ComponentManager<HairParticleSystem>& hairs = componentLibrary.Register<HairParticleSystem>("wi::scene::Scene::hairs", 3); // version = 3
 		wi::ecs::ComponentManager<WeatherComponent>& weathers = componentLibrary.Register<WeatherComponent>("wi::scene::Scene::weathers", 6); // version = 6
@@ -70,9 +70,22 @@ namespace wi::scene
 		enum FLAGS
 		{
 			EMPTY = 0,
+			OBJECT_BVH = 1 << 0,
+			COLLIDER_BVH_WIDE = 1 << 1,
 		};
 		uint32_t flags = EMPTY;
 
+		// Enable/disable the object BVH (disabled by default)
+		//	When enabled, a bounding volume hierarchy is maintained over aabb_objects in every Update(), and the renderer will use it for hierarchical culling of objects
+		//	This is useful for scenes with many objects, when only a fraction of them is visible at the same time
+		void SetObjectBVHEnabled(bool value) { if (value) { flags |= OBJECT_BVH; } else { flags &= ~OBJECT_BVH; } }
+		bool IsObjectBVHEnabled() const { return flags & OBJECT_BVH; }
+
+		// Enable/disable the 4-wide layout of the collider BVH (disabled by default)
+		//	This makes CPU ray, sphere and capsule queries against colliders faster, but uses more memory and needs some additional time to build
+		void SetColliderBVHWideEnabled(bool value) { if (value) { flags |= COLLIDER_BVH_WIDE; } else { flags &= ~COLLIDER_BVH_WIDE; } }
+		bool IsColliderBVHWideEnabled() const { return flags & COLLIDER_BVH_WIDE; }
+
 		float time = 0;
 		CameraComponent camera; // only for LOD and 3D sound update; use GetCamera() or set RenderPath3D's camera to your own
 		wi::allocator::shared_ptr<void> physics_scene;
@@ -93,6 +106,37 @@ namespace wi::scene
 		wi::vector<wi::primitive::Sphere> character_dedicated_shadows;
 		wi::unordered_map<wi::ecs::Entity, wi::vector<wi::ecs::Entity>> topdown_hierarchy; // managed by BuildTopDownHierarchy() in every Update(), allows parent->children traversal
 		wi::jobsystem::context topdown_hierarchy_workload;
+
+		// Flattened hierarchy managed by RunHierarchyUpdateSystem(), in the same order as the hierarchy components:
+		//	The depth sorted order is only rebuilt when the structure of the hierarchy changes
+		struct HierarchyNode
+		{
+			wi::ecs::Entity entity = wi::ecs::INVALID_ENTITY;
+			wi::ecs::Entity parentID = wi::ecs::INVALID_ENTITY;
+			uint32_t parent = ~0u; // index of parent node, ~0u if the parent is not part of the hierarchy
+			uint32_t transform = ~0u; // index into transforms, ~0u if the node has no transform
+			uint32_t layer = ~0u; // index into layers, ~0u if the node has no layer
+			uint32_t root_transform = ~0u; // index into transforms for the parent if it's not part of the hierarchy
+			uint32_t root_layer = ~0u; // index into layers for the parent if it's not part of the hierarchy
+			uint32_t mask = ~0u; // layerMask accumulated from this node and its ancestors
+			bool has_world = false; // whether this node or any ancestor has a transform
+			bool changed = true; // whether world was recomputed in the last update
+			XMFLOAT4X4 world = wi::math::IDENTITY_MATRIX; // world matrix of this node, or the closest ancestor with a transform
+		};
+		wi::vector<HierarchyNode> hierarchy_nodes;
+		wi::vector<uint32_t> hierarchy_order; // node indices sorted by depth, parents are always before their children
+		wi::vector<uint32_t> hierarchy_levels; // offsets into hierarchy_order for the beginning of each depth level, and the end
+		uint64_t hierarchy_structure_versions[3] = {}; // hierarchy, transforms, layers structure versions at the last hierarchy update
+
+		// Cached component joins of the update systems, these only resolve entities again when the participating component managers change structure:
+		wi::ecs::View<ArmatureComponent, TransformComponent> armature_view{ armatures, transforms };
+		wi::ecs::View<ForceFieldComponent, TransformComponent> force_view{ forces, transforms };
+		wi::ecs::View<DecalComponent, TransformComponent, MaterialComponent, wi::ecs::Optional<LayerComponent>> decal_view{ decals, transforms, materials, layers };
+		wi::ecs::View<EnvironmentProbeComponent, TransformComponent, wi::ecs::Optional<LayerComponent>> probe_view{ probes, transforms, layers };
+		wi::ecs::View<LightComponent, TransformComponent, wi::ecs::Optional<LayerComponent>, wi::ecs::Optional<MaterialComponent>, wi::ecs::Optional<VideoComponent>> light_view{ lights, transforms, layers, materials, videos };
+		wi::ecs::View<SoundComponent, wi::ecs::Optional<TransformComponent>> sound_view{ sounds, transforms };
+		wi::ecs::View<wi::Sprite, wi::ecs::Optional<VideoComponent>> sprite_view{ sprites, videos };
+		wi::ecs::View<wi::SpriteFont, wi::ecs::Optional<SoundComponent>> font_view{ fonts, sounds };
 		uint32_t cpu_gpu_mapped_resource_index = 0;
 
 		// AABB culling streams:
@@ -102,9 +146,18 @@ namespace wi::scene
 		wi::vector<wi::primitive::AABB> aabb_decals;
 		wi::vector<wi::primitive::AABB> aabb_fonts;
 
+		// Object BVH over aabb_objects (only when IsObjectBVHEnabled()):
+		//	The tree is refitted every frame, and only rebuilt when the object count changes or the refitted tree degraded too much
+		wi::BVH object_bvh;
+		float object_bvh_build_cost = 0;
+		void UpdateObjectBVH();
+		// Returns true if the object_bvh can be used to cull aabb_objects in the current frame
+		bool IsObjectBVHValid() const { return object_bvh.IsValid() && object_bvh.leaf_indices.size() == aabb_objects.size(); }
+
 		// Separate stream of world matrices:
 		wi::vector<XMFLOAT4X4> matrix_objects;
 		wi::vector<XMFLOAT4X4> matrix_objects_prev;
+		wi::vector<uint32_t> meshlet_offsets_objects;
 
 		// Shader visible scene parameters:
 		ShaderScene shaderscene;
@@ -119,6 +172,12 @@ namespace wi::scene
 		ShaderMeshInstance* instanceArrayMapped = nullptr;
 		size_t instanceArraySize = 0;
 		wi::graphics::GPUBuffer instanceBuffer;
+		// Object instances are change tracked, so only the modified ones are written to the upload buffers and copied to the Non-UMA buffer:
+		wi::vector<ShaderMeshInstance> instanceArrayCPU; // the last written instance of every object, used to detect changes
+		uint64_t instanceUploadVersions[wi::graphics::GraphicsDevice::GetBufferCount()] = {}; // objects change version that each upload buffer is up to date with
+		mutable uint64_t instanceCopyVersion = 0; // objects change version that the Non-UMA buffer is up to date with, the renderer advances it when it records the copies
+		uint64_t instanceCopyRangesVersion = 0; // objects change version that instanceCopyRanges were gathered up to
+		wi::vector<wi::ecs::IndexRange> instanceCopyRanges; // instance ranges that must be copied to the Non-UMA buffer, they accumulate over updates until the renderer records the copies
 
 		// Geometries for bindless visiblity indexing:
 		//	contains in order:
@@ -137,6 +196,12 @@ namespace wi::scene
 		ShaderMaterial* materialArrayMapped = nullptr;
 		size_t materialArraySize = 0;
 		wi::graphics::GPUBuffer materialBuffer;
+		// Materials are change tracked the same way as object instances:
+		wi::vector<ShaderMaterial> materialArrayCPU;
+		uint64_t materialUploadVersions[wi::graphics::GraphicsDevice::GetBufferCount()] = {};
+		mutable uint64_t materialCopyVersion = 0;
+		uint64_t materialCopyRangesVersion = 0;
+		wi::vector<wi::ecs::IndexRange> materialCopyRanges;
 		wi::graphics::GPUBuffer textureStreamingFeedbackBuffer;
 		wi::graphics::GPUBuffer textureStreamingFeedbackBuffer_readback[wi::graphics::GraphicsDevice::GetBufferCount()];
 		const uint32_t* textureStreamingFeedbackMapped = nullptr;
@@ -268,7 +333,7 @@ namespace wi::scene
 
 		std::atomic<uint32_t> lightmap_request_allocator{ 0 };
 		wi::vector<uint32_t> lightmap_requests;
-		wi::vector<TransformComponent> transforms_temp;
+		wi::vector<wi::vector<std::pair<const ScriptComponent*, wi::ecs::Entity>>> script_worker_buckets; // independent scripts for each worker lua state, for one frame only!
 
 		// CPU/GPU Colliders:
 		wi::vector<uint8_t> collider_deinterleaved_data;
@@ -318,6 +383,10 @@ namespace wi::scene
 		void WaitBuildTopDownHierarchy() const;
 		void RefreshHierarchyTopdownFromParent(wi::ecs::Entity entity);
 
+		// The systems are scheduled by this graph within Update(), so that independent systems can overlap
+		wi::jobsystem::TaskGraph update_graph;
+		float update_critical_path_time = 0; // the longest chain of dependent systems in the last Update() in milliseconds
+
 		// Update all components by a given timestep (in seconds):
 		//	This is an expensive function, prefer to call it only once per frame!
 		virtual void Update(float dt);
@@ -493,6 +562,9 @@ namespace wi::scene
 
 		void RunAnimationUpdateSystem(wi::jobsystem::context& ctx);
 		void RunTransformUpdateSystem(wi::jobsystem::context& ctx);
+		// Computes world matrices and layer propagation masks of the hierarchy top-down, depth level by depth level
+		//	Subtrees whose transforms were not changed with SetDirty() reuse the world matrices from the previous update
+		//	This waits for ctx between depth levels, so it completes before returning
 		void RunHierarchyUpdateSystem(wi::jobsystem::context& ctx);
 		void RunExpressionUpdateSystem(wi::jobsystem::context& ctx);
 		void RunProceduralAnimationUpdateSystem(wi::jobsystem::context& ctx);
@@ -553,6 +625,16 @@ namespace wi::scene
 		//	lod				:	specify min level of detail for meshes
 		bool IntersectsFirst(const wi::primitive::Ray& ray, uint32_t filterMask = wi::enums::FILTER_OPAQUE, uint32_t layerMask = ~0, uint32_t lod = 0) const;
 
+		// Given an array of rays, finds the closest intersection for each of them, same as calling Intersects() for every ray
+		//	The rays are processed in parallel with the job system, in coherent groups that share object culling work
+		//	rays			:	array of rays with count elements
+		//	results			:	array of results with count elements, results[i] will be filled for rays[i]
+		//	count			:	number of rays
+		//	filterMask		:	filter based on type
+		//	layerMask		:	filter based on layer
+		//	lod				:	specify min level of detail for meshes
+		void IntersectsBatch(const wi::primitive::Ray* rays, RayIntersectionResult* results, uint32_t count, uint32_t filterMask = wi::enums::FILTER_OPAQUE, uint32_t layerMask = ~0, uint32_t lod = 0) const;
+
 		// Given a ray, finds all intersections against all mesh instances or collliders
 		void IntersectsAll(wi::vector<RayIntersectionResult>& results, const wi::primitive::Ray& ray, uint32_t filterMask = wi::enums::FILTER_OPAQUE, uint32_t layerMask = ~0, uint32_t lod = 0) const;
 
@@ -597,6 +679,14 @@ namespace wi::scene
 		//	returns entity ID of the new animation or INVALID_ENTITY if retargeting was not successful
 		wi::ecs::Entity RetargetAnimation(wi::ecs::Entity dst, wi::ecs::Entity src, bool bake_data, const Scene* src_scene = nullptr);
 
+		// Compresses the animation datas of all animations with AnimationDataComponent::Compress()
+		//	The value type of an animation data is determined by the animation channels that use it, animation datas that are not used by any channel are not compressed
+		//	Event channels and CUBICSPLINE samplers are not compressed
+		//	max_error	:	the maximum absolute error of any value component at any keyframe time (for rotations this is the error of quaternion components)
+		//
+		//	returns the number of animation datas that were compressed
+		uint32_t CompressAnimations(float max_error = 0.0005f);
+
 		// If you don't know which armature the bone is contained in, this function can be used to find the first such armature and return the bone's rest matrix
 		//	If not found, and entity has a transform, it returns transform matrix
 		//	Otherwise, returns identity matrix
@@ -635,6 +725,15 @@ namespace wi::scene
 	private:
 		void UpdateHumanoidFacings();
 
+		// Data that is shared by a group of rays in IntersectsBatch()
+		struct RayBatchShared
+		{
+			const uint32_t* object_candidates = nullptr; // object indices that the rays can intersect
+			uint32_t object_candidate_count = 0;
+			const XMFLOAT4X4* object_inverse_matrices = nullptr; // inverse of matrix_objects
+		};
+		RayIntersectionResult IntersectsRay(const wi::primitive::Ray& ray, uint32_t filterMask, uint32_t layerMask, uint32_t lod, const RayBatchShared* shared) const;
+
 	};
 
 	// Returns skinned vertex position
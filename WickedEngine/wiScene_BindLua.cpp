@@ -52,6 +52,20 @@ int CreateEntity_BindLua(lua_State* L)
 	wi::lua::SSetLongLong(L, entity);
 	return 1;
 }
+int DestroyEntity_BindLua(lua_State* L)
+{
+	int argc = wi::lua::SGetArgCount(L);
+	if (argc > 0)
+	{
+		Entity entity = (Entity)wi::lua::SGetLongLong(L, 1);
+		DestroyEntity(entity);
+	}
+	else
+	{
+		wi::lua::SError(L, "DestroyEntity(Entity entity) not enough arguments!");
+	}
+	return 0;
+}
 
 int GetCamera(lua_State* L)
 {
@@ -65,6 +79,11 @@ int GetScene(lua_State* L)
 }
 int LoadModel(lua_State* L)
 {
+	if (wi::lua::IsWorkerState())
+	{
+		wi::lua::SError(L, "LoadModel() can't be used by independent scripts!");
+		return 0;
+	}
 	int argc = wi::lua::SGetArgCount(L);
 	if (argc > 0)
 	{
@@ -477,14 +496,12 @@ MetadataPreset = {
 
 void Bind()
 {
-	static bool initialized = false;
-	if (!initialized)
+	if (wi::lua::BindOnce("scene"))
 	{
-		initialized = true;
-
 		lua_State* L = wi::lua::GetLuaState();
 
 		wi::lua::RegisterFunc("CreateEntity", CreateEntity_BindLua);
+		wi::lua::RegisterFunc("DestroyEntity", DestroyEntity_BindLua);
 
 		wi::lua::RegisterFunc("GetCamera", GetCamera);
 		wi::lua::RegisterFunc("GetScene", GetScene);
@@ -717,8 +734,29 @@ Luna<Scene_BindLua>::PropertyType Scene_BindLua::properties[] = {
 	{ NULL, NULL }
 };
 
+bool Scene_BindLua::IsStructuralChangeAllowed(lua_State* L, const char* function) const
+{
+	if (owning == nullptr && wi::lua::IsWorkerState())
+	{
+		wi::lua::SError(L, std::string("Scene::") + function + "() can't be used by independent scripts on a shared scene!");
+		return false;
+	}
+	return true;
+}
+void Scene_BindLua::DeferStructuralChange(std::function<void()>&& command) const
+{
+	if (owning != nullptr)
+	{
+		command();
+		return;
+	}
+	wi::lua::DeferCommand(std::move(command));
+}
+
 int Scene_BindLua::Update(lua_State* L)
 {
+	if (!IsStructuralChangeAllowed(L, "Update"))
+		return 0;
 	int argc = wi::lua::SGetArgCount(L);
 	if (argc > 0)
 	{
@@ -733,11 +771,15 @@ int Scene_BindLua::Update(lua_State* L)
 }
 int Scene_BindLua::Clear(lua_State* L)
 {
-	scene->Clear();
+	DeferStructuralChange([scene = scene] {
+		scene->Clear();
+	});
 	return 0;
 }
 int Scene_BindLua::Merge(lua_State* L)
 {
+	if (!IsStructuralChangeAllowed(L, "Merge"))
+		return 0;
 	int argc = wi::lua::SGetArgCount(L);
 	if (argc > 0)
 	{
@@ -759,6 +801,8 @@ int Scene_BindLua::Merge(lua_State* L)
 }
 int Scene_BindLua::Instantiate(lua_State* L)
 {
+	if (!IsStructuralChangeAllowed(L, "Instantiate"))
+		return 0;
 	int argc = wi::lua::SGetArgCount(L);
 	if (argc > 0)
 	{
@@ -847,7 +891,9 @@ int Scene_BindLua::Entity_Remove(lua_State* L)
 			}
 		}
 
-		scene->Entity_Remove(entity, recursive, keep_sorted);
+		DeferStructuralChange([scene = scene, entity, recursive, keep_sorted] {
+			scene->Entity_Remove(entity, recursive, keep_sorted);
+		});
 	}
 	else
 	{
@@ -891,6 +937,8 @@ int Scene_BindLua::Entity_Remove_Async(lua_State* L)
 }
 int Scene_BindLua::Entity_Duplicate(lua_State* L)
 {
+	if (!IsStructuralChangeAllowed(L, "Entity_Duplicate"))
+		return 0;
 	int argc = wi::lua::SGetArgCount(L);
 	if (argc > 0)
 	{
@@ -927,6 +975,8 @@ int Scene_BindLua::Entity_IsDescendant(lua_State* L)
 
 int Scene_BindLua::UpdateHierarchy(lua_State* L)
 {
+	if (!IsStructuralChangeAllowed(L, "UpdateHierarchy"))
+		return 0;
 	wi::jobsystem::context ctx;
 	scene->RunHierarchyUpdateSystem(ctx);
 	wi::jobsystem::Wait(ctx);
@@ -1130,6 +1180,8 @@ int Scene_BindLua::IntersectsFirst(lua_State* L)
 
 int Scene_BindLua::Component_CreateName(lua_State* L)
 {
+	if (!IsStructuralChangeAllowed(L, "Component_CreateName"))
+		return 0;
 	int argc = wi::lua::SGetArgCount(L);
 	if (argc > 0)
 	{
@@ -1147,6 +1199,8 @@ int Scene_BindLua::Component_CreateName(lua_State* L)
 }
 int Scene_BindLua::Component_CreateLayer(lua_State* L)
 {
+	if (!IsStructuralChangeAllowed(L, "Component_CreateLayer"))
+		return 0;
 	int argc = wi::lua::SGetArgCount(L);
 	if (argc > 0)
 	{
@@ -1164,6 +1218,8 @@ int Scene_BindLua::Component_CreateLayer(lua_State* L)
 }
 int Scene_BindLua::Component_CreateTransform(lua_State* L)
 {
+	if (!IsStructuralChangeAllowed(L, "Component_CreateTransform"))
+		return 0;
 	int argc = wi::lua::SGetArgCount(L);
 	if (argc > 0)
 	{
@@ -1181,6 +1237,8 @@ int Scene_BindLua::Component_CreateTransform(lua_State* L)
 }
 int Scene_BindLua::Component_CreateCamera(lua_State* L)
 {
+	if (!IsStructuralChangeAllowed(L, "Component_CreateCamera"))
+		return 0;
 	int argc = wi::lua::SGetArgCount(L);
 	if (argc > 0)
 	{
@@ -1198,6 +1256,8 @@ int Scene_BindLua::Component_CreateCamera(lua_State* L)
 }
 int Scene_BindLua::Component_CreateLight(lua_State* L)
 {
+	if (!IsStructuralChangeAllowed(L, "Component_CreateLight"))
+		return 0;
 	int argc = wi::lua::SGetArgCount(L);
 	if (argc > 0)
 	{
@@ -1215,6 +1275,8 @@ int Scene_BindLua::Component_CreateLight(lua_State* L)
 }
 int Scene_BindLua::Component_CreateEmitter(lua_State* L)
 {
+	if (!IsStructuralChangeAllowed(L, "Component_CreateEmitter"))
+		return 0;
 	int argc = wi::lua::SGetArgCount(L);
 	if (argc > 0)
 	{
@@ -1232,6 +1294,8 @@ int Scene_BindLua::Component_CreateEmitter(lua_State* L)
 }
 int Scene_BindLua::Component_CreateHairParticleSystem(lua_State* L)
 {
+	if (!IsStructuralChangeAllowed(L, "Component_CreateHairParticleSystem"))
+		return 0;
 	int argc = wi::lua::SGetArgCount(L);
 	if (argc > 0)
 	{
@@ -1249,6 +1313,8 @@ int Scene_BindLua::Component_CreateHairParticleSystem(lua_State* L)
 }
 int Scene_BindLua::Component_CreateObject(lua_State* L)
 {
+	if (!IsStructuralChangeAllowed(L, "Component_CreateObject"))
+		return 0;
 	int argc = wi::lua::SGetArgCount(L);
 	if (argc > 0)
 	{
@@ -1266,6 +1332,8 @@ int Scene_BindLua::Component_CreateObject(lua_State* L)
 }
 int Scene_BindLua::Component_CreateMaterial(lua_State* L)
 {
+	if (!IsStructuralChangeAllowed(L, "Component_CreateMaterial"))
+		return 0;
 	int argc = wi::lua::SGetArgCount(L);
 	if (argc > 0)
 	{
@@ -1283,6 +1351,8 @@ int Scene_BindLua::Component_CreateMaterial(lua_State* L)
 }
 int Scene_BindLua::Component_CreateInverseKinematics(lua_State* L)
 {
+	if (!IsStructuralChangeAllowed(L, "Component_CreateInverseKinematics"))
+		return 0;
 	int argc = wi::lua::SGetArgCount(L);
 	if (argc > 0)
 	{
@@ -1300,6 +1370,8 @@ int Scene_BindLua::Component_CreateInverseKinematics(lua_State* L)
 }
 int Scene_BindLua::Component_CreateSpring(lua_State* L)
 {
+	if (!IsStructuralChangeAllowed(L, "Component_CreateSpring"))
+		return 0;
 	int argc = wi::lua::SGetArgCount(L);
 	if (argc > 0)
 	{
@@ -1317,6 +1389,8 @@ int Scene_BindLua::Component_CreateSpring(lua_State* L)
 }
 int Scene_BindLua::Component_CreateScript(lua_State* L)
 {
+	if (!IsStructuralChangeAllowed(L, "Component_CreateScript"))
+		return 0;
 	int argc = wi::lua::SGetArgCount(L);
 	if (argc > 0)
 	{
@@ -1334,6 +1408,8 @@ int Scene_BindLua::Component_CreateScript(lua_State* L)
 }
 int Scene_BindLua::Component_CreateRigidBodyPhysics(lua_State* L)
 {
+	if (!IsStructuralChangeAllowed(L, "Component_CreateRigidBodyPhysics"))
+		return 0;
 	int argc = wi::lua::SGetArgCount(L);
 	if (argc > 0)
 	{
@@ -1351,6 +1427,8 @@ int Scene_BindLua::Component_CreateRigidBodyPhysics(lua_State* L)
 }
 int Scene_BindLua::Component_CreateSoftBodyPhysics(lua_State* L)
 {
+	if (!IsStructuralChangeAllowed(L, "Component_CreateSoftBodyPhysics"))
+		return 0;
 	int argc = wi::lua::SGetArgCount(L);
 	if (argc > 0)
 	{
@@ -1368,6 +1446,8 @@ int Scene_BindLua::Component_CreateSoftBodyPhysics(lua_State* L)
 }
 int Scene_BindLua::Component_CreateForceField(lua_State* L)
 {
+	if (!IsStructuralChangeAllowed(L, "Component_CreateForceField"))
+		return 0;
 	int argc = wi::lua::SGetArgCount(L);
 	if (argc > 0)
 	{
@@ -1385,6 +1465,8 @@ int Scene_BindLua::Component_CreateForceField(lua_State* L)
 }
 int Scene_BindLua::Component_CreateWeather(lua_State* L)
 {
+	if (!IsStructuralChangeAllowed(L, "Component_CreateWeather"))
+		return 0;
 	int argc = wi::lua::SGetArgCount(L);
 	if (argc > 0)
 	{
@@ -1402,6 +1484,8 @@ int Scene_BindLua::Component_CreateWeather(lua_State* L)
 }
 int Scene_BindLua::Component_CreateSound(lua_State* L)
 {
+	if (!IsStructuralChangeAllowed(L, "Component_CreateSound"))
+		return 0;
 	int argc = wi::lua::SGetArgCount(L);
 	if (argc > 0)
 	{
@@ -1419,6 +1503,8 @@ int Scene_BindLua::Component_CreateSound(lua_State* L)
 }
 int Scene_BindLua::Component_CreateVideo(lua_State* L)
 {
+	if (!IsStructuralChangeAllowed(L, "Component_CreateVideo"))
+		return 0;
 	int argc = wi::lua::SGetArgCount(L);
 	if (argc > 0)
 	{
@@ -1436,6 +1522,8 @@ int Scene_BindLua::Component_CreateVideo(lua_State* L)
 }
 int Scene_BindLua::Component_CreateCollider(lua_State* L)
 {
+	if (!IsStructuralChangeAllowed(L, "Component_CreateCollider"))
+		return 0;
 	int argc = wi::lua::SGetArgCount(L);
 	if (argc > 0)
 	{
@@ -1453,6 +1541,8 @@ int Scene_BindLua::Component_CreateCollider(lua_State* L)
 }
 int Scene_BindLua::Component_CreateExpression(lua_State* L)
 {
+	if (!IsStructuralChangeAllowed(L, "Component_CreateExpression"))
+		return 0;
 	int argc = wi::lua::SGetArgCount(L);
 	if (argc > 0)
 	{
@@ -1470,6 +1560,8 @@ int Scene_BindLua::Component_CreateExpression(lua_State* L)
 }
 int Scene_BindLua::Component_CreateHumanoid(lua_State* L)
 {
+	if (!IsStructuralChangeAllowed(L, "Component_CreateHumanoid"))
+		return 0;
 	int argc = wi::lua::SGetArgCount(L);
 	if (argc > 0)
 	{
@@ -1487,6 +1579,8 @@ int Scene_BindLua::Component_CreateHumanoid(lua_State* L)
 }
 int Scene_BindLua::Component_CreateDecal(lua_State* L)
 {
+	if (!IsStructuralChangeAllowed(L, "Component_CreateDecal"))
+		return 0;
 	int argc = wi::lua::SGetArgCount(L);
 	if (argc > 0)
 	{
@@ -1504,6 +1598,8 @@ int Scene_BindLua::Component_CreateDecal(lua_State* L)
 }
 int Scene_BindLua::Component_CreateSprite(lua_State* L)
 {
+	if (!IsStructuralChangeAllowed(L, "Component_CreateSprite"))
+		return 0;
 	int argc = wi::lua::SGetArgCount(L);
 	if (argc > 0)
 	{
@@ -1521,6 +1617,8 @@ int Scene_BindLua::Component_CreateSprite(lua_State* L)
 }
 int Scene_BindLua::Component_CreateFont(lua_State* L)
 {
+	if (!IsStructuralChangeAllowed(L, "Component_CreateFont"))
+		return 0;
 	int argc = wi::lua::SGetArgCount(L);
 	if (argc > 0)
 	{
@@ -1538,6 +1636,8 @@ int Scene_BindLua::Component_CreateFont(lua_State* L)
 }
 int Scene_BindLua::Component_CreateVoxelGrid(lua_State* L)
 {
+	if (!IsStructuralChangeAllowed(L, "Component_CreateVoxelGrid"))
+		return 0;
 	int argc = wi::lua::SGetArgCount(L);
 	if (argc > 0)
 	{
@@ -1555,6 +1655,8 @@ int Scene_BindLua::Component_CreateVoxelGrid(lua_State* L)
 }
 int Scene_BindLua::Component_CreateMetadata(lua_State* L)
 {
+	if (!IsStructuralChangeAllowed(L, "Component_CreateMetadata"))
+		return 0;
 	int argc = wi::lua::SGetArgCount(L);
 	if (argc > 0)
 	{
@@ -1572,6 +1674,8 @@ int Scene_BindLua::Component_CreateMetadata(lua_State* L)
 }
 int Scene_BindLua::Component_CreateCharacter(lua_State* L)
 {
+	if (!IsStructuralChangeAllowed(L, "Component_CreateCharacter"))
+		return 0;
 	int argc = wi::lua::SGetArgCount(L);
 	if (argc > 0)
 	{
@@ -2884,10 +2988,12 @@ int Scene_BindLua::Component_RemoveName(lua_State* L)
 	if (argc > 0)
 	{
 		Entity entity = (Entity)wi::lua::SGetLongLong(L, 1);
-		if(scene->names.Contains(entity))
-		{
-			scene->names.Remove(entity);
-		}
+		DeferStructuralChange([scene = scene, entity] {
+			if (scene->names.Contains(entity))
+			{
+				scene->names.Remove(entity);
+			}
+		});
 	}
 	else
 	{
@@ -2901,10 +3007,12 @@ int Scene_BindLua::Component_RemoveLayer(lua_State* L)
 	if (argc > 0)
 	{
 		Entity entity = (Entity)wi::lua::SGetLongLong(L, 1);
-		if(scene->layers.Contains(entity))
-		{
-			scene->layers.Remove(entity);
-		}
+		DeferStructuralChange([scene = scene, entity] {
+			if (scene->layers.Contains(entity))
+			{
+				scene->layers.Remove(entity);
+			}
+		});
 	}
 	else
 	{
@@ -2918,10 +3026,12 @@ int Scene_BindLua::Component_RemoveTransform(lua_State* L)
 	if (argc > 0)
 	{
 		Entity entity = (Entity)wi::lua::SGetLongLong(L, 1);
-		if(scene->transforms.Contains(entity))
-		{
-			scene->transforms.Remove(entity);
-		}
+		DeferStructuralChange([scene = scene, entity] {
+			if (scene->transforms.Contains(entity))
+			{
+				scene->transforms.Remove(entity);
+			}
+		});
 	}
 	else
 	{
@@ -2935,10 +3045,12 @@ int Scene_BindLua::Component_RemoveCamera(lua_State* L)
 	if (argc > 0)
 	{
 		Entity entity = (Entity)wi::lua::SGetLongLong(L, 1);
-		if(scene->cameras.Contains(entity))
-		{
-			scene->cameras.Remove(entity);
-		}
+		DeferStructuralChange([scene = scene, entity] {
+			if (scene->cameras.Contains(entity))
+			{
+				scene->cameras.Remove(entity);
+			}
+		});
 	}
 	else
 	{
@@ -2952,10 +3064,12 @@ int Scene_BindLua::Component_RemoveAnimation(lua_State* L)
 	if (argc > 0)
 	{
 		Entity entity = (Entity)wi::lua::SGetLongLong(L, 1);
-		if(scene->animations.Contains(entity))
-		{
-			scene->animations.Remove(entity);
-		}
+		DeferStructuralChange([scene = scene, entity] {
+			if (scene->animations.Contains(entity))
+			{
+				scene->animations.Remove(entity);
+			}
+		});
 	}
 	else
 	{
@@ -2969,10 +3083,12 @@ int Scene_BindLua::Component_RemoveAnimationData(lua_State* L)
 	if (argc > 0)
 	{
 		Entity entity = (Entity)wi::lua::SGetLongLong(L, 1);
-		if (scene->animation_datas.Contains(entity))
-		{
-			scene->animation_datas.Remove(entity);
-		}
+		DeferStructuralChange([scene = scene, entity] {
+			if (scene->animation_datas.Contains(entity))
+			{
+				scene->animation_datas.Remove(entity);
+			}
+		});
 	}
 	else
 	{
@@ -2986,10 +3102,12 @@ int Scene_BindLua::Component_RemoveMaterial(lua_State* L)
 	if (argc > 0)
 	{
 		Entity entity = (Entity)wi::lua::SGetLongLong(L, 1);
-		if(scene->materials.Contains(entity))
-		{
-			scene->materials.Remove(entity);
-		}
+		DeferStructuralChange([scene = scene, entity] {
+			if (scene->materials.Contains(entity))
+			{
+				scene->materials.Remove(entity);
+			}
+		});
 	}
 	else
 	{
@@ -3003,10 +3121,12 @@ int Scene_BindLua::Component_RemoveMesh(lua_State* L)
 	if (argc > 0)
 	{
 		Entity entity = (Entity)wi::lua::SGetLongLong(L, 1);
-		if(scene->meshes.Contains(entity))
-		{
-			scene->meshes.Remove(entity);
-		}
+		DeferStructuralChange([scene = scene, entity] {
+			if (scene->meshes.Contains(entity))
+			{
+				scene->meshes.Remove(entity);
+			}
+		});
 	}
 	else
 	{
@@ -3020,10 +3140,12 @@ int Scene_BindLua::Component_RemoveEmitter(lua_State* L)
 	if (argc > 0)
 	{
 		Entity entity = (Entity)wi::lua::SGetLongLong(L, 1);
-		if(scene->emitters.Contains(entity))
-		{
-			scene->emitters.Remove(entity);
-		}
+		DeferStructuralChange([scene = scene, entity] {
+			if (scene->emitters.Contains(entity))
+			{
+				scene->emitters.Remove(entity);
+			}
+		});
 	}
 	else
 	{
@@ -3037,10 +3159,12 @@ int Scene_BindLua::Component_RemoveHairParticleSystem(lua_State* L)
 	if (argc > 0)
 	{
 		Entity entity = (Entity)wi::lua::SGetLongLong(L, 1);
-		if(scene->hairs.Contains(entity))
-		{
-			scene->hairs.Remove(entity);
-		}
+		DeferStructuralChange([scene = scene, entity] {
+			if (scene->hairs.Contains(entity))
+			{
+				scene->hairs.Remove(entity);
+			}
+		});
 	}
 	else
 	{
@@ -3054,10 +3178,12 @@ int Scene_BindLua::Component_RemoveLight(lua_State* L)
 	if (argc > 0)
 	{
 		Entity entity = (Entity)wi::lua::SGetLongLong(L, 1);
-		if(scene->lights.Contains(entity))
-		{
-			scene->lights.Remove(entity);
-		}
+		DeferStructuralChange([scene = scene, entity] {
+			if (scene->lights.Contains(entity))
+			{
+				scene->lights.Remove(entity);
+			}
+		});
 	}
 	else
 	{
@@ -3071,10 +3197,12 @@ int Scene_BindLua::Component_RemoveObject(lua_State* L)
 	if (argc > 0)
 	{
 		Entity entity = (Entity)wi::lua::SGetLongLong(L, 1);
-		if(scene->objects.Contains(entity))
-		{
-			scene->objects.Remove(entity);
-		}
+		DeferStructuralChange([scene = scene, entity] {
+			if (scene->objects.Contains(entity))
+			{
+				scene->objects.Remove(entity);
+			}
+		});
 	}
 	else
 	{
@@ -3088,10 +3216,12 @@ int Scene_BindLua::Component_RemoveInverseKinematics(lua_State* L)
 	if (argc > 0)
 	{
 		Entity entity = (Entity)wi::lua::SGetLongLong(L, 1);
-		if(scene->inverse_kinematics.Contains(entity))
-		{
-			scene->inverse_kinematics.Remove(entity);
-		}
+		DeferStructuralChange([scene = scene, entity] {
+			if (scene->inverse_kinematics.Contains(entity))
+			{
+				scene->inverse_kinematics.Remove(entity);
+			}
+		});
 	}
 	else
 	{
@@ -3105,10 +3235,12 @@ int Scene_BindLua::Component_RemoveSpring(lua_State* L)
 	if (argc > 0)
 	{
 		Entity entity = (Entity)wi::lua::SGetLongLong(L, 1);
-		if(scene->springs.Contains(entity))
-		{
-			scene->springs.Remove(entity);
-		}
+		DeferStructuralChange([scene = scene, entity] {
+			if (scene->springs.Contains(entity))
+			{
+				scene->springs.Remove(entity);
+			}
+		});
 	}
 	else
 	{
@@ -3122,10 +3254,12 @@ int Scene_BindLua::Component_RemoveScript(lua_State* L)
 	if (argc > 0)
 	{
 		Entity entity = (Entity)wi::lua::SGetLongLong(L, 1);
-		if(scene->scripts.Contains(entity))
-		{
-			scene->scripts.Remove(entity);
-		}
+		DeferStructuralChange([scene = scene, entity] {
+			if (scene->scripts.Contains(entity))
+			{
+				scene->scripts.Remove(entity);
+			}
+		});
 	}
 	else
 	{
@@ -3139,10 +3273,12 @@ int Scene_BindLua::Component_RemoveRigidBodyPhysics(lua_State* L)
 	if (argc > 0)
 	{
 		Entity entity = (Entity)wi::lua::SGetLongLong(L, 1);
-		if(scene->rigidbodies.Contains(entity))
-		{
-			scene->rigidbodies.Remove(entity);
-		}
+		DeferStructuralChange([scene = scene, entity] {
+			if (scene->rigidbodies.Contains(entity))
+			{
+				scene->rigidbodies.Remove(entity);
+			}
+		});
 	}
 	else
 	{
@@ -3156,10 +3292,12 @@ int Scene_BindLua::Component_RemoveSoftBodyPhysics(lua_State* L)
 	if (argc > 0)
 	{
 		Entity entity = (Entity)wi::lua::SGetLongLong(L, 1);
-		if(scene->softbodies.Contains(entity))
-		{
-			scene->softbodies.Remove(entity);
-		}
+		DeferStructuralChange([scene = scene, entity] {
+			if (scene->softbodies.Contains(entity))
+			{
+				scene->softbodies.Remove(entity);
+			}
+		});
 	}
 	else
 	{
@@ -3173,10 +3311,12 @@ int Scene_BindLua::Component_RemoveForceField(lua_State* L)
 	if (argc > 0)
 	{
 		Entity entity = (Entity)wi::lua::SGetLongLong(L, 1);
-		if(scene->forces.Contains(entity))
-		{
-			scene->forces.Remove(entity);
-		}
+		DeferStructuralChange([scene = scene, entity] {
+			if (scene->forces.Contains(entity))
+			{
+				scene->forces.Remove(entity);
+			}
+		});
 	}
 	else
 	{
@@ -3190,10 +3330,12 @@ int Scene_BindLua::Component_RemoveWeather(lua_State* L)
 	if (argc > 0)
 	{
 		Entity entity = (Entity)wi::lua::SGetLongLong(L, 1);
-		if(scene->weathers.Contains(entity))
-		{
-			scene->weathers.Remove(entity);
-		}
+		DeferStructuralChange([scene = scene, entity] {
+			if (scene->weathers.Contains(entity))
+			{
+				scene->weathers.Remove(entity);
+			}
+		});
 	}
 	else
 	{
@@ -3207,10 +3349,12 @@ int Scene_BindLua::Component_RemoveSound(lua_State* L)
 	if (argc > 0)
 	{
 		Entity entity = (Entity)wi::lua::SGetLongLong(L, 1);
-		if(scene->sounds.Contains(entity))
-		{
-			scene->sounds.Remove(entity);
-		}
+		DeferStructuralChange([scene = scene, entity] {
+			if (scene->sounds.Contains(entity))
+			{
+				scene->sounds.Remove(entity);
+			}
+		});
 	}
 	else
 	{
@@ -3224,10 +3368,12 @@ int Scene_BindLua::Component_RemoveVideo(lua_State* L)
 	if (argc > 0)
 	{
 		Entity entity = (Entity)wi::lua::SGetLongLong(L, 1);
-		if(scene->videos.Contains(entity))
-		{
-			scene->videos.Remove(entity);
-		}
+		DeferStructuralChange([scene = scene, entity] {
+			if (scene->videos.Contains(entity))
+			{
+				scene->videos.Remove(entity);
+			}
+		});
 	}
 	else
 	{
@@ -3241,10 +3387,12 @@ int Scene_BindLua::Component_RemoveCollider(lua_State* L)
 	if (argc > 0)
 	{
 		Entity entity = (Entity)wi::lua::SGetLongLong(L, 1);
-		if(scene->colliders.Contains(entity))
-		{
-			scene->colliders.Remove(entity);
-		}
+		DeferStructuralChange([scene = scene, entity] {
+			if (scene->colliders.Contains(entity))
+			{
+				scene->colliders.Remove(entity);
+			}
+		});
 	}
 	else
 	{
@@ -3258,10 +3406,12 @@ int Scene_BindLua::Component_RemoveExpression(lua_State* L)
 	if (argc > 0)
 	{
 		Entity entity = (Entity)wi::lua::SGetLongLong(L, 1);
-		if (scene->expressions.Contains(entity))
-		{
-			scene->expressions.Remove(entity);
-		}
+		DeferStructuralChange([scene = scene, entity] {
+			if (scene->expressions.Contains(entity))
+			{
+				scene->expressions.Remove(entity);
+			}
+		});
 	}
 	else
 	{
@@ -3275,10 +3425,12 @@ int Scene_BindLua::Component_RemoveHumanoid(lua_State* L)
 	if (argc > 0)
 	{
 		Entity entity = (Entity)wi::lua::SGetLongLong(L, 1);
-		if (scene->humanoids.Contains(entity))
-		{
-			scene->humanoids.Remove(entity);
-		}
+		DeferStructuralChange([scene = scene, entity] {
+			if (scene->humanoids.Contains(entity))
+			{
+				scene->humanoids.Remove(entity);
+			}
+		});
 	}
 	else
 	{
@@ -3292,10 +3444,12 @@ int Scene_BindLua::Component_RemoveDecal(lua_State* L)
 	if (argc > 0)
 	{
 		Entity entity = (Entity)wi::lua::SGetLongLong(L, 1);
-		if (scene->decals.Contains(entity))
-		{
-			scene->decals.Remove(entity);
-		}
+		DeferStructuralChange([scene = scene, entity] {
+			if (scene->decals.Contains(entity))
+			{
+				scene->decals.Remove(entity);
+			}
+		});
 	}
 	else
 	{
@@ -3309,10 +3463,12 @@ int Scene_BindLua::Component_RemoveSprite(lua_State* L)
 	if (argc > 0)
 	{
 		Entity entity = (Entity)wi::lua::SGetLongLong(L, 1);
-		if (scene->sprites.Contains(entity))
-		{
-			scene->sprites.Remove(entity);
-		}
+		DeferStructuralChange([scene = scene, entity] {
+			if (scene->sprites.Contains(entity))
+			{
+				scene->sprites.Remove(entity);
+			}
+		});
 	}
 	else
 	{
@@ -3326,10 +3482,12 @@ int Scene_BindLua::Component_RemoveFont(lua_State* L)
 	if (argc > 0)
 	{
 		Entity entity = (Entity)wi::lua::SGetLongLong(L, 1);
-		if (scene->fonts.Contains(entity))
-		{
-			scene->fonts.Remove(entity);
-		}
+		DeferStructuralChange([scene = scene, entity] {
+			if (scene->fonts.Contains(entity))
+			{
+				scene->fonts.Remove(entity);
+			}
+		});
 	}
 	else
 	{
@@ -3343,10 +3501,12 @@ int Scene_BindLua::Component_RemoveVoxelGrid(lua_State* L)
 	if (argc > 0)
 	{
 		Entity entity = (Entity)wi::lua::SGetLongLong(L, 1);
-		if (scene->voxel_grids.Contains(entity))
-		{
-			scene->voxel_grids.Remove(entity);
-		}
+		DeferStructuralChange([scene = scene, entity] {
+			if (scene->voxel_grids.Contains(entity))
+			{
+				scene->voxel_grids.Remove(entity);
+			}
+		});
 	}
 	else
 	{
@@ -3360,10 +3520,12 @@ int Scene_BindLua::Component_RemoveMetadata(lua_State* L)
 	if (argc > 0)
 	{
 		Entity entity = (Entity)wi::lua::SGetLongLong(L, 1);
-		if (scene->metadatas.Contains(entity))
-		{
-			scene->metadatas.Remove(entity);
-		}
+		DeferStructuralChange([scene = scene, entity] {
+			if (scene->metadatas.Contains(entity))
+			{
+				scene->metadatas.Remove(entity);
+			}
+		});
 	}
 	else
 	{
@@ -3377,10 +3539,12 @@ int Scene_BindLua::Component_RemoveCharacter(lua_State* L)
 	if (argc > 0)
 	{
 		Entity entity = (Entity)wi::lua::SGetLongLong(L, 1);
-		if (scene->characters.Contains(entity))
-		{
-			scene->characters.Remove(entity);
-		}
+		DeferStructuralChange([scene = scene, entity] {
+			if (scene->characters.Contains(entity))
+			{
+				scene->characters.Remove(entity);
+			}
+		});
 	}
 	else
 	{
@@ -3402,7 +3566,9 @@ int Scene_BindLua::Component_Attach(lua_State* L)
 			child_already_in_local_space = wi::lua::SGetBool(L, 3);
 		}
 
-		scene->Component_Attach(entity, parent, child_already_in_local_space);
+		DeferStructuralChange([scene = scene, entity, parent, child_already_in_local_space] {
+			scene->Component_Attach(entity, parent, child_already_in_local_space);
+		});
 	}
 	else
 	{
@@ -3417,7 +3583,9 @@ int Scene_BindLua::Component_Detach(lua_State* L)
 	{
 		Entity entity = (Entity)wi::lua::SGetLongLong(L, 1);
 
-		scene->Component_Detach(entity);
+		DeferStructuralChange([scene = scene, entity] {
+			scene->Component_Detach(entity);
+		});
 	}
 	else
 	{
@@ -3432,7 +3600,9 @@ int Scene_BindLua::Component_DetachChildren(lua_State* L)
 	{
 		Entity parent = (Entity)wi::lua::SGetLongLong(L, 1);
 
-		scene->Component_DetachChildren(parent);
+		DeferStructuralChange([scene = scene, parent] {
+			scene->Component_DetachChildren(parent);
+		});
 	}
 	else
 	{
@@ -3476,6 +3646,8 @@ int Scene_BindLua::SetWeather(lua_State* L)
 
 int Scene_BindLua::RetargetAnimation(lua_State* L)
 {
+	if (!IsStructuralChangeAllowed(L, "RetargetAnimation"))
+		return 0;
 	int argc = wi::lua::SGetArgCount(L);
 	if (argc > 2)
 	{
@@ -6373,6 +6545,8 @@ Luna<ScriptComponent_BindLua>::FunctionType ScriptComponent_BindLua::methods[] =
 	lunamethod(ScriptComponent_BindLua, IsPlaying),
 	lunamethod(ScriptComponent_BindLua, SetPlayOnce),
 	lunamethod(ScriptComponent_BindLua, Stop),
+	lunamethod(ScriptComponent_BindLua, SetIndependent),
+	lunamethod(ScriptComponent_BindLua, IsIndependent),
 	{ NULL, NULL }
 };
 Luna<ScriptComponent_BindLua>::PropertyType ScriptComponent_BindLua::properties[] = {
@@ -6418,6 +6592,22 @@ int ScriptComponent_BindLua::Stop(lua_State* L)
 	component->Stop();
 	return 0;
 }
+int ScriptComponent_BindLua::SetIndependent(lua_State* L)
+{
+	int argc = wi::lua::SGetArgCount(L);
+	bool value = true;
+	if (argc > 0)
+	{
+		value = wi::lua::SGetBool(L, 1);
+	}
+	component->SetIndependent(value);
+	return 0;
+}
+int ScriptComponent_BindLua::IsIndependent(lua_State* L)
+{
+	wi::lua::SSetBool(L, component->IsIndependent());
+	return 1;
+}
 
 
 
@@ -5,6 +5,7 @@
 #include "wiMath_BindLua.h"
 
 #include <memory>
+#include <functional>
 
 namespace wi::lua::scene
 {
@@ -33,6 +34,11 @@ namespace wi::lua::scene
 		Scene_BindLua(wi::scene::Scene* scene) :scene(scene) {}
 		Scene_BindLua(lua_State* L) : owning(std::make_unique<wi::scene::Scene>()), scene(owning.get()) {}
 
+		// Independent scripts are running in parallel, so they can't change the structure of a shared scene immediately
+		//	A scene that was created by the script is not shared, so it can be always changed immediately
+		bool IsStructuralChangeAllowed(lua_State* L, const char* function) const;
+		void DeferStructuralChange(std::function<void()>&& command) const;
+
 		int Update(lua_State* L);
 		int Clear(lua_State* L);
 		int Merge(lua_State* L);
@@ -985,6 +991,8 @@ namespace wi::lua::scene
 		int IsPlaying(lua_State* L);
 		int SetPlayOnce(lua_State* L);
 		int Stop(lua_State* L);
+		int SetIndependent(lua_State* L);
+		int IsIndependent(lua_State* L);
 	};
 
 	class RigidBodyPhysicsComponent_BindLua
@@ -1443,6 +1443,8 @@ namespace wi::scene
 		{
 			CreateStreamoutRenderData();
 		}
+
+		tracked_memory.set(GetMemoryUsageCPU());
 	}
 	void MeshComponent::CreateStreamoutRenderData()
 	{
@@ -1595,7 +1597,13 @@ namespace wi::scene
 				bvh_leaf_aabbs.push_back(aabb);
 			}
 		}
-		bvh.Build(bvh_leaf_aabbs.data(), (uint32_t)bvh_leaf_aabbs.size());
+		bvh.Build(bvh_leaf_aabbs.data(), (uint32_t)bvh_leaf_aabbs.size(), wi::BVH::BuildMode::SAH);
+		if (IsBVHWideEnabled())
+		{
+			bvh.BuildWide();
+		}
+
+		tracked_memory.set(GetMemoryUsageCPU());
 	}
 	void MeshComponent::ComputeNormals(COMPUTE_NORMALS compute)
 	{
@@ -2020,6 +2028,7 @@ namespace wi::scene
 		return
 			bvh.nodes.size() * sizeof(BVH::Node) +
 			bvh.leaf_indices.size() * sizeof(uint32_t) +
+			bvh.wide_nodes.size() * sizeof(BVH::WideNode) +
 			bvh_leaf_aabbs.size() * sizeof(wi::primitive::AABB);
 	}
 	size_t MeshComponent::GetClusterCount() const
@@ -2317,6 +2326,255 @@ namespace wi::scene
 		return ComputeTextureMemorySizeInBytes(texture.desc);
 	}
 
+	static constexpr float ANIMATION_ROTATION_QUANTIZATION_RANGE = 0.70710678f; // the smallest three components of a normalized quaternion are in [-1/sqrt(2), 1/sqrt(2)]
+	static constexpr float ANIMATION_ROTATION_QUANTIZATION_STEP = 2 * ANIMATION_ROTATION_QUANTIZATION_RANGE / 32767.0f; // 15 bits per component, the remaining bits store the index of the dropped component
+	static constexpr uint8_t ANIMATION_ROTATION_SWIZZLES[4][4] = {
+		{ 3, 0, 1, 2 },
+		{ 0, 3, 1, 2 },
+		{ 0, 1, 3, 2 },
+		{ 0, 1, 2, 3 },
+	};
+	static void QuantizeRotation(const XMFLOAT4& value, uint16_t* result)
+	{
+		XMFLOAT4 q;
+		XMStoreFloat4(&q, XMQuaternionNormalize(XMLoadFloat4(&value)));
+		float* components = (float*)&q;
+		uint32_t largest = 0;
+		for (uint32_t i = 1; i < 4; ++i)
+		{
+			if (std::abs(components[i]) > std::abs(components[largest]))
+			{
+				largest = i;
+			}
+		}
+		const float sign = components[largest] < 0 ? -1.0f : 1.0f; // q and -q are the same rotation, the dropped component is made positive
+		uint32_t j = 0;
+		for (uint32_t i = 0; i < 4; ++i)
+		{
+			if (i == largest)
+				continue;
+			const float normalized = (components[i] * sign + ANIMATION_ROTATION_QUANTIZATION_RANGE) / ANIMATION_ROTATION_QUANTIZATION_STEP;
+			const uint32_t quantized = (uint32_t)std::round(wi::math::Clamp(normalized, 0.0f, 32767.0f));
+			result[j++] = uint16_t(quantized << 1u);
+		}
+		result[0] |= largest & 1u;
+		result[1] |= (largest >> 1u) & 1u;
+	}
+	static XMVECTOR DecodeRotation(const uint16_t* data)
+	{
+		const uint32_t largest = (data[0] & 1u) | ((data[1] & 1u) << 1u);
+		XMVECTOR V = XMVectorSet(float(data[0] >> 1u), float(data[1] >> 1u), float(data[2] >> 1u), 0);
+		V = XMVectorMultiplyAdd(V, XMVectorReplicate(ANIMATION_ROTATION_QUANTIZATION_STEP), XMVectorReplicate(-ANIMATION_ROTATION_QUANTIZATION_RANGE));
+		V = XMVectorSelect(V, XMVectorZero(), XMVectorSelectControl(0, 0, 0, 1));
+		const XMVECTOR W = XMVectorSqrt(XMVectorMax(XMVectorZero(), XMVectorSubtract(XMVectorSplatOne(), XMVector3Dot(V, V))));
+		V = XMVectorSelect(V, W, XMVectorSelectControl(0, 0, 0, 1));
+		const uint8_t* swizzle = ANIMATION_ROTATION_SWIZZLES[largest];
+		return XMVectorSwizzle(V, swizzle[0], swizzle[1], swizzle[2], swizzle[3]);
+	}
+	// Maximum absolute component difference of two quaternions, considering that q and -q are the same rotation:
+	static float RotationError(XMVECTOR A, XMVECTOR B)
+	{
+		const XMVECTOR D0 = XMVectorAbs(XMVectorSubtract(A, B));
+		const XMVECTOR D1 = XMVectorAbs(XMVectorAdd(A, B));
+		const float e0 = std::max(std::max(XMVectorGetX(D0), XMVectorGetY(D0)), std::max(XMVectorGetZ(D0), XMVectorGetW(D0)));
+		const float e1 = std::max(std::max(XMVectorGetX(D1), XMVectorGetY(D1)), std::max(XMVectorGetZ(D1), XMVectorGetW(D1)));
+		return std::min(e0, e1);
+	}
+	bool AnimationDataComponent::Compress(uint32_t components, bool rotation, bool interpolate, float max_error)
+	{
+		if (IsCompressed())
+			return true;
+		const size_t key_count = keyframe_times.size();
+		if (components == 0 || key_count == 0 || keyframe_data.size() != key_count * components)
+			return false;
+		if (rotation && components != 4)
+			return false;
+		if (!std::is_sorted(keyframe_times.begin(), keyframe_times.end()))
+			return false;
+
+		// Quantize every keyframe, the quantization must be within the error limit by itself:
+		const uint32_t stride = rotation ? 3 : components;
+		decltype(compressed_data) quantized(key_count * stride);
+		decltype(compressed_range) range;
+		if (rotation)
+		{
+			for (size_t key = 0; key < key_count; ++key)
+			{
+				QuantizeRotation(((const XMFLOAT4*)keyframe_data.data())[key], &quantized[key * stride]);
+			}
+		}
+		else
+		{
+			range.resize(components * 2);
+			for (uint32_t c = 0; c < components; ++c)
+			{
+				float range_min = FLT_MAX;
+				float range_max = -FLT_MAX;
+				for (size_t key = 0; key < key_count; ++key)
+				{
+					range_min = std::min(range_min, keyframe_data[key * components + c]);
+					range_max = std::max(range_max, keyframe_data[key * components + c]);
+				}
+				const float step = (range_max - range_min) / 65535.0f;
+				if (!std::isfinite(step) || step * 0.5f > max_error)
+					return false;
+				range[c] = range_min;
+				range[components + c] = step;
+				for (size_t key = 0; key < key_count; ++key)
+				{
+					quantized[key * stride + c] = step > 0 ? (uint16_t)std::round(wi::math::Clamp((keyframe_data[key * components + c] - range_min) / step, 0.0f, 65535.0f)) : 0;
+				}
+			}
+		}
+
+		// Swap in the quantized representation, so that DecodeKeyframe() can be used to evaluate the error:
+		AnimationDataComponent compressed;
+		compressed._flags = _flags | COMPRESSED | (rotation ? COMPRESSED_ROTATION : 0);
+		compressed.compressed_components = components;
+		compressed.compressed_data = std::move(quantized);
+		compressed.compressed_range = std::move(range);
+
+		wi::vector<float> decoded(key_count * components);
+		for (size_t key = 0; key < key_count; ++key)
+		{
+			compressed.DecodeKeyframe(key, &decoded[key * components]);
+		}
+
+		// The error of the sampled value against the original keyframe:
+		auto keyframe_error = [&](size_t key, const float* value) {
+			const float* original = &keyframe_data[key * components];
+			if (rotation)
+			{
+				return RotationError(XMLoadFloat4((const XMFLOAT4*)value), XMLoadFloat4((const XMFLOAT4*)original));
+			}
+			float error = 0;
+			for (uint32_t c = 0; c < components; ++c)
+			{
+				error = std::max(error, std::abs(value[c] - original[c]));
+			}
+			return error;
+		};
+
+		// Every keyframe could be kept, so the quantization error of every keyframe must be within the limit:
+		for (size_t key = 0; key < key_count; ++key)
+		{
+			if (keyframe_error(key, &decoded[key * components]) > max_error)
+				return false;
+		}
+
+		// Checks whether all the keyframes between first and last can be interpolated from the first and last:
+		//	This uses the same interpolation as the AnimationUpdateSystem, with the decoded values
+		wi::vector<float> interpolated(components);
+		auto can_remove_between = [&](size_t first, size_t last) {
+			const float time_first = keyframe_times[first];
+			const float time_last = keyframe_times[last];
+			if (time_last <= time_first)
+				return false;
+			const float* value_first = &decoded[first * components];
+			const float* value_last = &decoded[last * components];
+			for (size_t key = first + 1; key < last; ++key)
+			{
+				const float t = saturate((keyframe_times[key] - time_first) / (time_last - time_first));
+				if (rotation)
+				{
+					XMVECTOR Q = XMQuaternionSlerp(XMLoadFloat4((const XMFLOAT4*)value_first), XMLoadFloat4((const XMFLOAT4*)value_last), t);
+					Q = XMQuaternionNormalize(Q);
+					XMStoreFloat4((XMFLOAT4*)interpolated.data(), Q);
+				}
+				else
+				{
+					for (uint32_t c = 0; c < components; ++c)
+					{
+						interpolated[c] = wi::math::Lerp(value_first[c], value_last[c], t);
+					}
+				}
+				if (keyframe_error(key, interpolated.data()) > max_error)
+					return false;
+			}
+			return true;
+		};
+
+		// Greedy keyframe reduction: extend each segment as long as the keyframes inside it can be interpolated:
+		wi::vector<size_t> kept;
+		kept.push_back(0);
+		if (key_count > 1)
+		{
+			size_t anchor = 0;
+			for (size_t key = 2; key < key_count; ++key)
+			{
+				if (!interpolate || !can_remove_between(anchor, key))
+				{
+					anchor = key - 1;
+					kept.push_back(anchor);
+				}
+			}
+			kept.push_back(key_count - 1);
+		}
+
+		compressed.keyframe_times.reserve(kept.size());
+		decltype(compressed_data) reduced;
+		reduced.reserve(kept.size() * stride);
+		for (size_t key : kept)
+		{
+			compressed.keyframe_times.push_back(keyframe_times[key]);
+			for (uint32_t i = 0; i < stride; ++i)
+			{
+				reduced.push_back(compressed.compressed_data[key * stride + i]);
+			}
+		}
+		compressed.compressed_data = std::move(reduced);
+
+		*this = std::move(compressed);
+		return true;
+	}
+	void AnimationDataComponent::Decompress()
+	{
+		if (!IsCompressed())
+			return;
+		keyframe_data.resize(keyframe_times.size() * compressed_components);
+		for (size_t key = 0; key < keyframe_times.size(); ++key)
+		{
+			DecodeKeyframe(key, &keyframe_data[key * compressed_components]);
+		}
+		_flags &= ~(COMPRESSED | COMPRESSED_ROTATION);
+		compressed_components = 0;
+		compressed_data.clear();
+		compressed_range.clear();
+	}
+	void AnimationDataComponent::DecodeKeyframe(size_t key, float* result) const
+	{
+		assert(IsCompressed());
+		if (_flags & COMPRESSED_ROTATION)
+		{
+			XMStoreFloat4((XMFLOAT4*)result, DecodeRotation(&compressed_data[key * 3]));
+			return;
+		}
+		const uint16_t* data = &compressed_data[key * compressed_components];
+		const float* range_min = compressed_range.data();
+		const float* range_step = compressed_range.data() + compressed_components;
+		for (uint32_t c = 0; c < compressed_components; c += 4)
+		{
+			// Four components are decoded at once, the last ones are masked if needed:
+			const uint32_t count = std::min(4u, compressed_components - c);
+			XMFLOAT4 quantized = {};
+			XMFLOAT4 minimum = {};
+			XMFLOAT4 step = {};
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				((float*)&quantized)[i] = float(data[c + i]);
+				((float*)&minimum)[i] = range_min[c + i];
+				((float*)&step)[i] = range_step[c + i];
+			}
+			XMFLOAT4 value;
+			XMStoreFloat4(&value, XMVectorMultiplyAdd(XMLoadFloat4(&quantized), XMLoadFloat4(&step), XMLoadFloat4(&minimum)));
+			std::memcpy(result + c, &value, sizeof(float) * count);
+		}
+	}
+	size_t AnimationDataComponent::GetMemorySizeInBytes() const
+	{
+		return keyframe_times.size() * sizeof(float) + keyframe_data.size() * sizeof(float) + compressed_data.size() * sizeof(uint16_t) + compressed_range.size() * sizeof(float);
+	}
+
 	AnimationComponent::AnimationChannel::PathDataType AnimationComponent::AnimationChannel::GetPathDataType() const
 	{
 		switch (path)
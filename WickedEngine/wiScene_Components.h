@@ -48,10 +48,11 @@ namespace wi::scene
 		{
 			EMPTY = 0,
 			DIRTY = 1 << 0,
+			HIERARCHY_DIRTY = 1 << 1,
 		};
 
 		XMFLOAT3 scale_local = XMFLOAT3(1, 1, 1);
-		uint32_t _flags = DIRTY;
+		uint32_t _flags = DIRTY | HIERARCHY_DIRTY;
 		XMFLOAT4 rotation_local = XMFLOAT4(0, 0, 0, 1);	// this is a quaternion
 		XMFLOAT3 translation_local = XMFLOAT3(0, 0, 0);
 
@@ -63,9 +64,14 @@ namespace wi::scene
 		//	- or by calling SetDirty() and letting the TransformUpdateSystem handle the updating
 		XMFLOAT4X4 world = wi::math::IDENTITY_MATRIX;
 
-		constexpr void SetDirty(bool value = true) { if (value) { _flags |= DIRTY; } else { _flags &= ~DIRTY; } }
+		constexpr void SetDirty(bool value = true) { if (value) { _flags |= DIRTY | HIERARCHY_DIRTY; } else { _flags &= ~DIRTY; } }
 		constexpr bool IsDirty() const { return _flags & DIRTY; }
 
+		// The hierarchy dirty state is set together with the dirty state, but it is only cleared by the HierarchyUpdateSystem
+		//	This way, the HierarchyUpdateSystem can skip unchanged subtrees even if UpdateTransform() was called in the meantime
+		constexpr void SetHierarchyDirty(bool value = true) { if (value) { _flags |= HIERARCHY_DIRTY; } else { _flags &= ~HIERARCHY_DIRTY; } }
+		constexpr bool IsHierarchyDirty() const { return _flags & HIERARCHY_DIRTY; }
+
 		XMFLOAT3 GetPosition() const;
 		XMFLOAT4 GetRotation() const;
 		XMFLOAT3 GetScale() const;
@@ -665,6 +671,7 @@ namespace wi::scene
 			DOUBLE_SIDED_SHADOW = 1 << 7,
 			BVH_ENABLED = 1 << 8,
 			QUANTIZED_POSITIONS_DISABLED = 1 << 9,
+			BVH_WIDE = 1 << 10,
 		};
 		// *uint32_t _flags is moved down for better struct padding...
 
@@ -777,6 +784,9 @@ namespace wi::scene
 		};
 		wi::vector<SubsetClusterRange> cluster_ranges;
 
+		// The CPU-side geometry size (GetMemoryUsageCPU()) is accounted with the Mesh memory tag when the render data or BVH is created:
+		wi::allocator::TrackedSize<wi::allocator::MemoryTag::Mesh> tracked_memory;
+
 		RigidBodyPhysicsComponent precomputed_rigidbody_physics_shape; // you can precompute a physics shape here if you need without using a real rigid body component yet
 
 		uint32_t _flags = RENDERABLE; // *this is serialized but put here for better struct padding
@@ -799,6 +809,10 @@ namespace wi::scene
 		//	false: BVH will be deleted immediately if it exists
 		void SetBVHEnabled(bool value) { if (value) { _flags |= BVH_ENABLED; if (!bvh.IsValid()) { BuildBVH(); } } else { _flags &= ~BVH_ENABLED; bvh = {}; bvh_leaf_aabbs.clear(); } }
 
+		// Enable/disable the 4-wide layout of the CPU-side BVH, this makes ray and sphere queries faster but uses more memory
+		//	It only takes effect if the BVH is enabled
+		void SetBVHWideEnabled(bool value) { if (value) { _flags |= BVH_WIDE; if (bvh.IsValid() && !bvh.IsWide()) { bvh.BuildWide(); } } else { _flags &= ~BVH_WIDE; bvh.wide_nodes.clear(); } }
+
 		// Disable quantization of position GPU data. You can use this if you notice inaccuracy in positions.
 		//	This should be enabled for connecting meshes like terrain chunks if their AABB is not consistent with each other
 		constexpr void SetQuantizedPositionsDisabled(bool value) { if (value) { _flags |= QUANTIZED_POSITIONS_DISABLED; } else { _flags &= ~QUANTIZED_POSITIONS_DISABLED; } }
@@ -808,6 +822,7 @@ namespace wi::scene
 		constexpr bool IsDoubleSidedShadow() const { return _flags & DOUBLE_SIDED_SHADOW; }
 		constexpr bool IsDynamic() const { return _flags & DYNAMIC; }
 		constexpr bool IsBVHEnabled() const { return _flags & BVH_ENABLED; }
+		constexpr bool IsBVHWideEnabled() const { return _flags & BVH_WIDE; }
 		constexpr bool IsQuantizedPositionsDisabled() const { return _flags & QUANTIZED_POSITIONS_DISABLED; }
 
 		constexpr float GetTessellationFactor() const { return tessellationFactor; }
@@ -1632,11 +1647,40 @@ namespace wi::scene
 		enum FLAGS
 		{
 			EMPTY = 0,
+			COMPRESSED = 1 << 0,
+			COMPRESSED_ROTATION = 1 << 1,
 		};
 		uint32_t _flags = EMPTY;
 
-		wi::vector<float> keyframe_times;
-		wi::vector<float> keyframe_data;
+		// Keyframe arrays are accounted with the Animation memory tag:
+		wi::allocator::tagged_vector<float, wi::allocator::MemoryTag::Animation> keyframe_times;
+		wi::allocator::tagged_vector<float, wi::allocator::MemoryTag::Animation> keyframe_data;
+
+		// Compressed representation (only when IsCompressed()):
+		//	keyframe_times contains the remaining keyframes after reduction, keyframe_data is empty
+		//	compressed_data contains 16-bit quantized values for each keyframe:
+		//		rotations are stored with the smallest three quaternion components (3 values per keyframe)
+		//		other values are stored relative to their range (compressed_components values per keyframe)
+		//	compressed_range contains the minimum of each component, followed by the quantization step of each component (not used for rotations)
+		uint32_t compressed_components = 0;
+		wi::allocator::tagged_vector<uint16_t, wi::allocator::MemoryTag::Animation> compressed_data;
+		wi::allocator::tagged_vector<float, wi::allocator::MemoryTag::Animation> compressed_range;
+
+		constexpr bool IsCompressed() const { return _flags & COMPRESSED; }
+
+		// Compresses the keyframes with quantization and by removing keyframes that can be interpolated from their neighbours
+		//	components: number of float values per keyframe (for example 3 for translation, 4 for rotation)
+		//	rotation: the keyframes are quaternions, interpolated with slerp
+		//	interpolate: keyframes will be interpolated linearly, so they can be reduced (otherwise they are only quantized)
+		//	max_error: the maximum absolute error of any value component at any keyframe time
+		//	returns false if the data can't be compressed within max_error (in this case the data is not modified)
+		bool Compress(uint32_t components, bool rotation, bool interpolate, float max_error);
+		// Restores the uncompressed keyframe_data from the compressed representation (the removed keyframes and precision are not restored)
+		void Decompress();
+		// Decodes compressed_components values of a compressed keyframe into result
+		void DecodeKeyframe(size_t key, float* result) const;
+		// Returns the memory used by the keyframes in bytes
+		size_t GetMemorySizeInBytes() const;
 
 		void Serialize(wi::Archive& archive, wi::ecs::EntitySerializer& seri);
 	};
@@ -1758,6 +1802,12 @@ namespace wi::scene
 
 			// Non-serialized attributes:
 			const void* scene = nullptr; // if animation data is in a different scene (if retargetting from a separate scene)
+
+			// Keyframe search cache, managed by the AnimationUpdateSystem:
+			const float* cached_keyframe_times = nullptr; // identifies the keyframe data that the cache is valid for
+			size_t cached_keyframe_count = 0;
+			bool cached_keyframes_sorted = false; // if keyframe times are not in increasing order, they will be searched linearly
+			int cached_key = 0; // index of the first keyframe after the timer in the last update
 		};
 		struct RetargetSourceData
 		{
@@ -2076,19 +2126,25 @@ namespace wi::scene
 			EMPTY = 0,
 			PLAYING = 1 << 0,
 			PLAY_ONCE = 1 << 1,
+			INDEPENDENT = 1 << 2,
 		};
 		uint32_t _flags = EMPTY;
 
 		// Non-serialized attributes:
 		wi::Resource resource;
 		size_t script_hash = 0;
+		uint32_t script_pid = 0;
 
 		constexpr void Play() { _flags |= PLAYING; }
 		constexpr void SetPlayOnce(bool once = true) { if (once) { _flags |= PLAY_ONCE; } else { _flags &= ~PLAY_ONCE; } }
 		constexpr void Stop() { _flags &= ~PLAYING; }
+		// Independent scripts are run in parallel on worker lua states, they can't depend on other scripts of the scene
+		//	Structural scene changes (removing entities or components, attaching) are deferred until all independent scripts finished
+		constexpr void SetIndependent(bool value = true) { if (value) { _flags |= INDEPENDENT; } else { _flags &= ~INDEPENDENT; } }
 
 		constexpr bool IsPlaying() const { return _flags & PLAYING; }
 		constexpr bool IsPlayingOnlyOnce() const { return _flags & PLAY_ONCE; }
+		constexpr bool IsIndependent() const { return _flags & INDEPENDENT; }
 
 		void CreateFromFile(const std::string& filename);
 
@@ -2701,3 +2757,14 @@ namespace wi::scene
 		void Serialize(wi::Archive& archive, wi::ecs::EntitySerializer& seri);
 	};
 }
+
+namespace wi::allocator
+{
+	// Component memory accounting of the subsystems (everything else is accounted as Scene memory):
+	template<> struct memory_tag<wi::scene::MeshComponent> { static constexpr MemoryTag value = MemoryTag::Mesh; };
+	template<> struct memory_tag<wi::scene::AnimationComponent> { static constexpr MemoryTag value = MemoryTag::Animation; };
+	template<> struct memory_tag<wi::scene::AnimationDataComponent> { static constexpr MemoryTag value = MemoryTag::Animation; };
+	template<> struct memory_tag<wi::scene::RigidBodyPhysicsComponent> { static constexpr MemoryTag value = MemoryTag::Physics; };
+	template<> struct memory_tag<wi::scene::SoftBodyPhysicsComponent> { static constexpr MemoryTag value = MemoryTag::Physics; };
+	template<> struct memory_tag<wi::scene::PhysicsConstraintComponent> { static constexpr MemoryTag value = MemoryTag::Physics; };
+}
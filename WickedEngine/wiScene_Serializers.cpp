@@ -1585,13 +1585,31 @@ namespace wi::scene
 		{
 			archive >> _flags;
 			archive >> keyframe_times;
-			archive >> keyframe_data;
+			if (seri.GetVersion() >= 1 && IsCompressed())
+			{
+				archive >> compressed_components;
+				archive >> compressed_data;
+				archive >> compressed_range;
+			}
+			else
+			{
+				archive >> keyframe_data;
+			}
 		}
 		else
 		{
 			archive << _flags;
 			archive << keyframe_times;
-			archive << keyframe_data;
+			if (IsCompressed())
+			{
+				archive << compressed_components;
+				archive << compressed_data;
+				archive << compressed_range;
+			}
+			else
+			{
+				archive << keyframe_data;
+			}
 		}
 	}
 	void WeatherComponent::Serialize(wi::Archive& archive, EntitySerializer& seri)